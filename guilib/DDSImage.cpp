@@ -24,9 +24,13 @@
 #include "lib/libsquish/squish.h"
 #include "utils/log.h"
 #include <string.h>
+#include <vector>
+#include <algorithm>
 
 #ifndef NO_XBMC_FILESYSTEM
 #include "FileSystem/File.h"
+#include "utils/Thread.h"
+#include "utils/CPUInfo.h"
 using namespace XFILE;
 #else
 #include "SimpleFS.h"
@@ -118,9 +122,9 @@ bool CDDSImage::ReadFile(const std::string &inputFile)
   return true;
 }
 
-bool CDDSImage::Create(const std::string &outputFile, unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *brga, double maxMSE)
+bool CDDSImage::Create(const std::string &outputFile, unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *brga, double maxMSE, bool fast)
 {
-  if (!Compress(width, height, pitch, brga, maxMSE))
+  if (!Compress(width, height, pitch, brga, maxMSE, fast))
   { // use ARGB
     Allocate(width, height, XB_FMT_A8R8G8B8);
     for (unsigned int i = 0; i < height; i++)
@@ -160,16 +164,106 @@ unsigned int CDDSImage::GetStorageRequirements(unsigned int width, unsigned int
   }
 }
 
-bool CDDSImage::Compress(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *brga, double maxMSE)
+// a band of rows of an image, compressed on its own thread
+class CDDSBand
+#ifndef NO_XBMC_FILESYSTEM
+  : public IRunnable
+#endif
 {
+public:
+  void Run()
+  {
+    squish::CompressImage(argb, width, height, pitch, dxt, flags);
+    squish::ComputeMSE(argb, width, height, pitch, dxt, flags, colorMSE, alphaMSE);
+  }
+
+  unsigned char const *argb;
+  unsigned char *dxt;
+  unsigned int width;
+  unsigned int height;
+  unsigned int pitch;
+  int flags;
+  double colorMSE;
+  double alphaMSE;
+};
+
+// smallest band of rows worth handing to another thread
+#define DDS_MIN_BAND_HEIGHT 64
+
+void CDDSImage::CompressImage(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *brga, unsigned char *dxt, int flags, double &colorMSE, double &alphaMSE)
+{
+  unsigned int bands = 1;
+#ifndef NO_XBMC_FILESYSTEM
+  bands = std::max(1, std::min(g_cpuInfo.getCPUCount(), (int)(height / DDS_MIN_BAND_HEIGHT)));
+#endif
+
+  // bands are whole rows of 4x4 blocks, so the compressed bands follow on from each other
+  unsigned int blockRows = (height + 3) / 4;
+  unsigned int rowSize = ((width + 3) / 4) * ((flags & squish::kDxt1) ? 8 : 16);
+  std::vector<CDDSBand> band(bands);
+  unsigned int row = 0;
+  for (unsigned int i = 0; i < bands; i++)
+  {
+    unsigned int rows = blockRows / bands + (i < blockRows % bands ? 1 : 0);
+    band[i].argb = brga + row * 4 * pitch;
+    band[i].dxt = dxt + row * rowSize;
+    band[i].width = width;
+    band[i].height = std::min(rows * 4, height - row * 4);
+    band[i].pitch = pitch;
+    band[i].flags = flags;
+    row += rows;
+  }
+
+#ifndef NO_XBMC_FILESYSTEM
+  std::vector<CThread*> threads;
+  for (unsigned int i = 1; i < bands; i++)
+  {
+    CThread *thread = new CThread(&band[i]);
+    thread->Create();
+    threads.push_back(thread);
+  }
+  band[0].Run();
+  for (unsigned int i = 0; i < threads.size(); i++)
+  {
+    threads[i]->StopThread(true);
+    delete threads[i];
+  }
+#else
+  for (unsigned int i = 0; i < bands; i++)
+    band[i].Run();
+#endif
+
+  // the error over the whole image, weighting each band by its size
+  colorMSE = alphaMSE = 0;
+  for (unsigned int i = 0; i < bands; i++)
+  {
+    colorMSE += band[i].colorMSE * band[i].height;
+    alphaMSE += band[i].alphaMSE * band[i].height;
+  }
+  colorMSE /= height;
+  alphaMSE /= height;
+}
+
+bool CDDSImage::Compress(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *brga, double maxMSE, bool fast)
+{
+  if (!width || !height)
+    return false;
+
   // first try DXT1, which is only 4bits/pixel
   Allocate(width, height, XB_FMT_DXT1);
 
-  squish::CompressImage(brga, width, height, pitch, m_data, squish::kDxt1 | squish::kSourceBGRA);
   const char *fourCC = NULL;
-
   double colorMSE, alphaMSE;
-  squish::ComputeMSE(brga, width, height, pitch, m_data, squish::kDxt1 | squish::kSourceBGRA, colorMSE, alphaMSE);
+  int colorFit = squish::kColourClusterFit;
+  if (fast)
+  {
+    CompressImage(width, height, pitch, brga, m_data, squish::kDxt1 | squish::kSourceBGRA | squish::kColourRangeFit, colorMSE, alphaMSE);
+    if (!maxMSE || (colorMSE < maxMSE && alphaMSE < maxMSE))
+      colorFit = squish::kColourRangeFit;
+  }
+  if (colorFit == squish::kColourClusterFit)
+    CompressImage(width, height, pitch, brga, m_data, squish::kDxt1 | squish::kSourceBGRA | colorFit, colorMSE, alphaMSE);
+
   if (!maxMSE || (colorMSE < maxMSE && alphaMSE < maxMSE))
     fourCC = "DXT1";
   else
@@ -188,14 +282,12 @@ bool CDDSImage::Compress(unsigned int width, unsigned int height, unsigned int p
     if (alphaMSE > 0)
     { // try DXT3 and DXT5 - use whichever is better (color is the same as DXT1, but alpha will be different)
       Allocate(width, height, XB_FMT_DXT3);
-      squish::CompressImage(brga, width, height, pitch, m_data, squish::kDxt3 | squish::kSourceBGRA);
-      squish::ComputeMSE(brga, width, height, pitch, m_data, squish::kDxt3 | squish::kSourceBGRA, colorMSE, alphaMSE);
+      CompressImage(width, height, pitch, brga, m_data, squish::kDxt3 | squish::kSourceBGRA | colorFit, colorMSE, alphaMSE);
       if (colorMSE < maxMSE)
       { // color is fine, test DXT5 as well
         double dxt5MSE;
         unsigned char *data2 = new unsigned char[GetStorageRequirements(width, height, XB_FMT_DXT5)];
-        squish::CompressImage(brga, width, height, pitch, data2, squish::kDxt5 | squish::kSourceBGRA);
-        squish::ComputeMSE(brga, width, height, pitch, data2, squish::kDxt5 | squish::kSourceBGRA, colorMSE, dxt5MSE);
+        CompressImage(width, height, pitch, brga, data2, squish::kDxt5 | squish::kSourceBGRA | colorFit, colorMSE, dxt5MSE);
         if (alphaMSE < maxMSE && alphaMSE < dxt5MSE)
           fourCC = "DXT3";
         else if (dxt5MSE < maxMSE)
@@ -46,9 +46,10 @@ public:
    \param pitch pitch of the pixel buffer
    \param argb pixel buffer
    \param maxMSE maximum mean square error to allow, ignored if 0 (the default)
+   \param fast try the fast but lower quality colour fit first, such as for thumbs
    \return true on successful image creation, false otherwise
    */
-  bool Create(const std::string &file, unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *argb, double maxMSE = 0);
+  bool Create(const std::string &file, unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *argb, double maxMSE = 0, bool fast = false);
   
   /*! \brief Decompress a DXT1/3/5 image to the given buffer
    Assumes the buffer has been allocated to at least width*height*4
@@ -73,9 +74,19 @@ private:
    \param pitch pitch of the pixel buffer
    \param argb pixel buffer
    \param maxMSE maximum mean square error to allow, ignored if 0 (the default)
+   \param fast try the fast but lower quality colour fit first, falling back to the default fit if it isn't within maxMSE
    \return true on successful compression within the given maxMSE, false otherwise
    */
-  bool Compress(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *argb, double maxMSE = 0);
+  bool Compress(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *argb, double maxMSE = 0, bool fast = false);
+
+  /*! \brief Compress an ARGB buffer with squish and measure the error, splitting the blocks across threads
+   Large images are cut into bands of whole block rows, each compressed on its own thread.
+   \param dxt buffer for the compressed blocks
+   \param flags the squish flags
+   \param colorMSE [out] the mean square error of the color channels
+   \param alphaMSE [out] the mean square error of the alpha channel
+   */
+  static void CompressImage(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *argb, unsigned char *dxt, int flags, double &colorMSE, double &alphaMSE);
 
   unsigned int GetStorageRequirements(unsigned int width, unsigned int height, unsigned int format) const;
   enum {
@@ -509,6 +509,18 @@ int CGUIBaseContainer::GetSelectedItem() const
   return CorrectOffset(m_offset, m_cursor);
 }
 
+bool CGUIBaseContainer::GetVisibleRange(int &first, int &last) const
+{
+  if (!m_layout || m_items.empty())
+    return false;
+
+  // as in Render(), including the partially visible item at the end
+  int offset = (int)floorf(m_scrollOffset / m_layout->Size(m_orientation));
+  first = std::max(0, CorrectOffset(offset, 0));
+  last = std::min((int)m_items.size(), CorrectOffset(offset + m_itemsPerPage + 1, 0)) - 1;
+  return first <= last;
+}
+
 CGUIListItemPtr CGUIBaseContainer::GetListItem(int offset, unsigned int flag) const
 {
   if (!m_items.size())
@@ -67,6 +67,13 @@ public:
   virtual void SaveStates(std::vector<CControlState> &states);
   virtual int GetSelectedItem() const;
 
+  /*! \brief Get the range of items in view, as of the last render.
+   \param first [out] index of the first item in view
+   \param last [out] index of the last item in view
+   \return false if there's nothing in view
+   */
+  bool GetVisibleRange(int &first, int &last) const;
+
   virtual void DoRender(unsigned int currentTime);
   void LoadLayout(TiXmlElement *layout);
   void LoadContent(TiXmlElement *content);
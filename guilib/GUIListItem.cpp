@@ -22,6 +22,7 @@
 #include "GUIListItem.h"
 #include "GUIListItemLayout.h"
 #include "utils/Archive.h"
+#include "StringUtils.h"
 
 CGUIListItem::CGUIListItem(const CGUIListItem& item)
 {
@@ -69,7 +70,10 @@ void CGUIListItem::SetLabel(const CStdString& strLabel)
     return;
   m_strLabel = strLabel;
   if (m_sortLabel.IsEmpty())
+  {
     m_sortLabel = strLabel;
+    m_sortKey.clear();
+  }
   SetInvalid();
 }
 
@@ -94,7 +98,10 @@ const CStdString& CGUIListItem::GetLabel2() const
 
 void CGUIListItem::SetSortLabel(const CStdString &label)
 {
+  if (m_sortLabel == label)
+    return;
   m_sortLabel = label;
+  m_sortKey.clear();
   // no need to invalidate - this is never shown in the UI
 }
 
@@ -103,6 +110,13 @@ const CStdString& CGUIListItem::GetSortLabel() const
   return m_sortLabel;
 }
 
+const CStdString& CGUIListItem::GetSortKey() const
+{
+  if (m_sortKey.IsEmpty() && !m_sortLabel.IsEmpty())
+    StringUtils::AlphaNumericSortKey(m_sortLabel.c_str(), m_sortKey);
+  return m_sortKey;
+}
+
 void CGUIListItem::SetThumbnailImage(const CStdString& strThumbnail)
 {
   if (m_strThumbnailImage == strThumbnail)
@@ -195,6 +209,7 @@ const CGUIListItem& CGUIListItem::operator =(const CGUIListItem& item)
   m_strLabel2 = item.m_strLabel2;
   m_strLabel = item.m_strLabel;
   m_sortLabel = item.m_sortLabel;
+  m_sortKey = item.m_sortKey;
   FreeMemory();
   m_bSelected = item.m_bSelected;
   m_strIcon = item.m_strIcon;
@@ -231,6 +246,7 @@ void CGUIListItem::Serialize(CArchive &ar)
     ar >> m_strLabel;
     ar >> m_strLabel2;
     ar >> m_sortLabel;
+    m_sortKey.clear();
     ar >> m_strThumbnailImage;
     ar >> m_strIcon;
     ar >> m_bSelected;
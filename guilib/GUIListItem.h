@@ -81,6 +81,12 @@ public:
   void SetSortLabel(const CStdString &label);
   const CStdString &GetSortLabel() const;
 
+  /*! \brief Binary form of the sort label that can be compared with StringUtils::CompareSortKeys
+   Built on first use and kept until the sort label changes.
+   \sa StringUtils::AlphaNumericSortKey
+   */
+  const CStdString &GetSortKey() const;
+
   void Select(bool bOnOff);
   bool IsSelected() const;
 
@@ -145,6 +151,7 @@ protected:
   PropertyMap m_mapProperties;
 private:
   CStdString m_sortLabel;     // text for sorting
+  mutable CStdString m_sortKey; // binary key for m_sortLabel, built on demand
   CStdString m_strLabel;      // text of column1
 };
 #endif
@@ -191,6 +191,9 @@ void CAdvancedSettings::Initialize()
   m_bMusicLibraryHideAllItems = false;
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryAlbumsSortByArtistThenYear = false;
+  m_bMusicLibrarySnapshot = false;
+  m_iMusicLibraryPartyModeWeighting = 0;
+  m_iMusicLibraryPartyModeRefresh = 10;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_strMusicLibraryAlbumFormatRight = "";
@@ -208,6 +211,11 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoScannerIgnoreErrors = false;
 
+  m_iScraperCacheTTL = 0;
+  m_bScraperReplay = false;
+  m_iScraperHostInterval = 100;
+  m_iScraperThreads = 2;
+
   m_bUseEvilB = true;
 
   m_iTuxBoxStreamtsPort = 31339;
@@ -238,6 +246,8 @@ void CAdvancedSettings::Initialize()
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
+  m_webserverThreadPoolSize = 4;
+
   m_fullScreen = m_startFullScreen = false;
 
   m_playlistRetries = 100;
@@ -273,6 +283,13 @@ void CAdvancedSettings::Initialize()
   m_measureRefreshrate = false;
 
   m_cacheMemBufferSize = (1048576 * 5);
+
+  m_pythonPluginIdleTimeout = 0;
+
+  m_logAsync = false;
+  m_logRingSize = 4096;
+  m_logMaxSize = 0;
+  m_pythonPluginIdleTimeouts.clear();
 }
 
 bool CAdvancedSettings::Load()
@@ -440,6 +457,18 @@ bool CAdvancedSettings::Load()
     XMLUtils::GetBoolean(pElement, "prioritiseapetags", m_prioritiseAPEv2tags);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "albumssortbyartistthenyear", m_bMusicLibraryAlbumsSortByArtistThenYear);
+    XMLUtils::GetBoolean(pElement, "snapshot", m_bMusicLibrarySnapshot);
+    CStdString weighting;
+    if (XMLUtils::GetString(pElement, "partymodeweighting", weighting))
+    {
+      if (weighting.Equals("rating"))
+        m_iMusicLibraryPartyModeWeighting = 1;
+      else if (weighting.Equals("playcount"))
+        m_iMusicLibraryPartyModeWeighting = 2;
+      else
+        m_iMusicLibraryPartyModeWeighting = 0;
+    }
+    XMLUtils::GetInt(pElement, "partymoderefresh", m_iMusicLibraryPartyModeRefresh, 1, 1440);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
@@ -465,6 +494,15 @@ bool CAdvancedSettings::Load()
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
   }
 
+  pElement = pRootElement->FirstChildElement("scraper");
+  if (pElement)
+  {
+    XMLUtils::GetInt(pElement, "cachettl", m_iScraperCacheTTL, 0, 24 * 365);
+    XMLUtils::GetBoolean(pElement, "replay", m_bScraperReplay);
+    XMLUtils::GetInt(pElement, "hostinterval", m_iScraperHostInterval, 0, 10000);
+    XMLUtils::GetInt(pElement, "threads", m_iScraperThreads, 0, 8);
+  }
+
   // Backward-compatibility of ExternalPlayer config
   pElement = pRootElement->FirstChildElement("externalplayer");
   if (pElement)
@@ -504,6 +542,10 @@ bool CAdvancedSettings::Load()
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
   }
 
+  pElement = pRootElement->FirstChildElement("webserver");
+  if (pElement)
+    XMLUtils::GetInt(pElement, "threadpoolsize", m_webserverThreadPoolSize, 1, 32);
+
   pElement = pRootElement->FirstChildElement("samba");
   if (pElement)
   {
@@ -536,6 +578,14 @@ bool CAdvancedSettings::Load()
     }
     g_advancedSettings.m_logLevel = std::max(g_advancedSettings.m_logLevel, g_advancedSettings.m_logLevelHint);
   }
+
+  pElement = pRootElement->FirstChildElement("logging");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "async", m_logAsync);
+    XMLUtils::GetInt(pElement, "ringsize", m_logRingSize, 64, 65536);
+    XMLUtils::GetInt(pElement, "maxsize", m_logMaxSize, 0, 1024);
+  }
   XMLUtils::GetString(pRootElement, "cddbaddress", m_cddbAddress);
 
   XMLUtils::GetBoolean(pRootElement, "handlemounting", m_handleMounting);
@@ -755,6 +805,21 @@ bool CAdvancedSettings::Load()
 
   XMLUtils::GetBoolean(pRootElement, "measurerefreshrate", m_measureRefreshrate);
 
+  pElement = pRootElement->FirstChildElement("python");
+  if (pElement)
+  {
+    XMLUtils::GetInt(pElement, "pluginidletimeout", m_pythonPluginIdleTimeout, 0, 3600);
+    // <plugin id="plugin.video.foo">120</plugin> overrides the idle timeout per add-on
+    TiXmlElement* pPlugin = pElement->FirstChildElement("plugin");
+    while (pPlugin)
+    {
+      const char* id = pPlugin->Attribute("id");
+      if (id && pPlugin->FirstChild())
+        m_pythonPluginIdleTimeouts[id] = std::max(0, atoi(pPlugin->FirstChild()->Value()));
+      pPlugin = pPlugin->NextSiblingElement("plugin");
+    }
+  }
+
   TiXmlElement* pDatabase = pRootElement->FirstChildElement("videodatabase");
   if (pDatabase)
   {
@@ -765,6 +830,11 @@ bool CAdvancedSettings::Load()
     XMLUtils::GetString(pDatabase, "user", m_databaseVideo.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseVideo.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseVideo.name);
+    XMLUtils::GetString(pDatabase, "journalmode", m_databaseVideo.journalMode);
+    XMLUtils::GetString(pDatabase, "synchronous", m_databaseVideo.synchronous);
+    XMLUtils::GetInt(pDatabase, "cachesize", m_databaseVideo.cacheSize, 0, 1000000);
+    XMLUtils::GetInt(pDatabase, "mmapsize", m_databaseVideo.mmapSize, 0, 2047);
+    XMLUtils::GetBoolean(pDatabase, "readonlylistings", m_databaseVideo.readOnlyListings);
   }
 
   pDatabase = pRootElement->FirstChildElement("musicdatabase");
@@ -776,6 +846,11 @@ bool CAdvancedSettings::Load()
     XMLUtils::GetString(pDatabase, "user", m_databaseMusic.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseMusic.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseMusic.name);
+    XMLUtils::GetString(pDatabase, "journalmode", m_databaseMusic.journalMode);
+    XMLUtils::GetString(pDatabase, "synchronous", m_databaseMusic.synchronous);
+    XMLUtils::GetInt(pDatabase, "cachesize", m_databaseMusic.cacheSize, 0, 1000000);
+    XMLUtils::GetInt(pDatabase, "mmapsize", m_databaseMusic.mmapSize, 0, 2047);
+    XMLUtils::GetBoolean(pDatabase, "readonlylistings", m_databaseMusic.readOnlyListings);
   }
 
   // load in the GUISettings overrides:
@@ -796,6 +871,14 @@ void CAdvancedSettings::Clear()
   m_pictureExcludeFromListingRegExps.clear();
 }
 
+unsigned int CAdvancedSettings::GetPythonIdleTimeout(const CStdString &addonID) const
+{
+  std::map<CStdString, int>::const_iterator it = m_pythonPluginIdleTimeouts.find(addonID);
+  if (it != m_pythonPluginIdleTimeouts.end())
+    return it->second * 1000;
+  return m_pythonPluginIdleTimeout * 1000;
+}
+
 void CAdvancedSettings::GetCustomTVRegexps(TiXmlElement *pRootElement, SETTINGS_TVSHOWLIST& settings)
 {
   int iAction = 0; // overwrite
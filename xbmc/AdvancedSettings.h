@@ -21,18 +21,27 @@
  */
 
 #include <vector>
+#include <map>
 #include "StdString.h"
 
 class TiXmlElement;
 
 struct DatabaseSettings
 {
+  DatabaseSettings() : journalMode("delete"), synchronous("normal"), cacheSize(4096), mmapSize(0), readOnlyListings(false) {}
   CStdString type;
   CStdString host;
   CStdString port;
   CStdString user;
   CStdString pass;
   CStdString name;
+  // sqlite tuning, ignored for mysql. wal is stored in the database file and doesn't work on
+  // network filesystems or with sqlite before 3.7.0, so it and read only listings are opt-in
+  CStdString journalMode;  ///< journal_mode of the database file (wal, delete, truncate, persist)
+  CStdString synchronous;  ///< synchronous level of each connection (off, normal, full)
+  int cacheSize;           ///< page cache of each connection, in pages
+  int mmapSize;            ///< how much of the database file to memory map, in MB (0 to disable)
+  bool readOnlyListings;   ///< whether library listings get their own read only connection
 };
 
 struct TVShowRegexp
@@ -63,6 +72,12 @@ class CAdvancedSettings
     static void GetCustomRegexpReplacers(TiXmlElement *pRootElement, CStdStringArray& settings);
     static void GetCustomExtensions(TiXmlElement *pRootElement, CStdString& extensions);
 
+    /*! \brief Time to keep a plugin's python interpreter warm between invocations
+     \param addonID the id of the plugin
+     \return idle timeout in ms, 0 if the plugin should get a fresh interpreter each run
+     */
+    unsigned int GetPythonIdleTimeout(const CStdString &addonID) const;
+
     // multipath testing
     bool m_useMultipaths;
 
@@ -138,6 +153,9 @@ class CAdvancedSettings
     int m_busyDialogDelay;
     int m_logLevel;
     int m_logLevelHint;
+    bool m_logAsync;         ///< hand log lines to a background writer instead of writing them inline
+    int m_logRingSize;       ///< number of log lines the asynchronous writer can buffer before dropping
+    int m_logMaxSize;        ///< size in MB at which xbmc.log is rotated to xbmc.old.log, 0 to disable
     CStdString m_cddbAddress;
 
     bool m_handleMounting;
@@ -184,6 +202,9 @@ class CAdvancedSettings
     int m_iMusicLibraryRecentlyAddedItems;
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryAlbumsSortByArtistThenYear;
+    bool m_bMusicLibrarySnapshot;
+    int m_iMusicLibraryPartyModeWeighting;  ///< 0 = none, 1 = by rating, 2 = by play count
+    int m_iMusicLibraryPartyModeRefresh;    ///< minutes before party mode refetches its songs
     CStdString m_strMusicLibraryAlbumFormat;
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
@@ -202,6 +223,11 @@ class CAdvancedSettings
 
     bool m_bVideoScannerIgnoreErrors;
 
+    int m_iScraperCacheTTL;       ///< hours that fetched pages are cached for, 0 to not cache them
+    bool m_bScraperReplay;        ///< answer fetches only from the page cache
+    int m_iScraperHostInterval;   ///< ms between fetches from the same host
+    int m_iScraperThreads;        ///< lookups run ahead of the video scanner to fill the page cache
+
     bool m_bUseEvilB;
     std::vector<CStdString> m_vecTokens; // cleaning strings tied to language
     //TuxBox
@@ -234,6 +260,8 @@ class CAdvancedSettings
     int m_curlretries;
     bool m_curlDisableIPV6;
 
+    int m_webserverThreadPoolSize;
+
     bool m_fullScreen;
     bool m_startFullScreen;
     bool m_alwaysOnTop;  /* makes xbmc to run always on top .. osx/win32 only .. */
@@ -271,6 +299,9 @@ class CAdvancedSettings
     DatabaseSettings m_databaseVideo; // advanced video database setup
 
     unsigned int m_cacheMemBufferSize;
+
+    int m_pythonPluginIdleTimeout; // seconds, 0 disables the interpreter pool
+    std::map<CStdString, int> m_pythonPluginIdleTimeouts; // per add-on overrides
 };
 
 extern CAdvancedSettings g_advancedSettings;
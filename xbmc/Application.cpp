@@ -63,6 +63,7 @@
 #include "FileSystem/DllLibCurl.h"
 #include "FileSystem/MythSession.h"
 #include "FileSystem/PluginDirectory.h"
+#include "FileSystem/PluginResultCache.h"
 #ifdef HAS_FILESYSTEM_SAP
 #include "FileSystem/SAPDirectory.h"
 #endif
@@ -255,6 +256,7 @@
 #include "utils/JobManager.h"
 #include "utils/SaveFileStateJob.h"
 #include "utils/AlarmClock.h"
+#include "MusicDatabaseSnapshot.h"
 
 #ifdef _LINUX
 #include "XHandle.h"
@@ -1001,6 +1003,9 @@ bool CApplication::Initialize()
     CDirectory::Create("special://xbmc/sounds");
   }
 
+  // plugin listings whose add-on was updated or reconfigured are never looked up again
+  CPluginResultCache::Get().Prune();
+
   StartServices();
 
   // Init DPMS, before creating the corresponding setting control.
@@ -3320,6 +3325,9 @@ void CApplication::Stop()
       m_pPlayer = NULL;
     }
 
+    // save the play counts and ratings the music library snapshot picked up this session
+    CMusicDatabaseSnapshot::Get().Flush();
+
 #if HAS_FILESYTEM_DAAP
     CLog::Log(LOGNOTICE, "stop daap clients");
     g_DaapClient.Release();
@@ -24,6 +24,7 @@
 #include "AdvancedSettings.h"
 #include "utils/SingleLock.h"
 #include "utils/log.h"
+#include "utils/TimeUtils.h"
 
 using namespace std;
 
@@ -38,6 +39,10 @@ CBackgroundInfoLoader::CBackgroundInfoLoader(int nThreads)
   m_nRequestedThreads = nThreads;
   m_bStartCalled = false;
   m_nActiveThreads = 0;
+  m_nextItem = 0;
+  m_hasRange = false;
+  m_rangeFirst = m_rangeLast = -1;
+  m_rangeTime = 0;
 }
 
 CBackgroundInfoLoader::~CBackgroundInfoLoader()
@@ -54,28 +59,18 @@ void CBackgroundInfoLoader::Run()
 {
   try
   {
+    CSingleLock lock(m_lock);
     if (m_vecItems.size() > 0)
     {
+      if (!m_bStartCalled)
       {
-        CSingleLock lock(m_lock);
-        if (!m_bStartCalled)
-        {
-          OnLoaderStart();
-          m_bStartCalled = true;
-        }
+        OnLoaderStart();
+        m_bStartCalled = true;
       }
 
       while (!m_bStop)
       {
-        CSingleLock lock(m_lock);
-        CFileItemPtr pItem;
-        vector<CFileItemPtr>::iterator iter = m_vecItems.begin();
-        if (iter != m_vecItems.end())
-        {
-          pItem = *iter;
-          m_vecItems.erase(iter);
-        }
-
+        CFileItemPtr pItem = GetNextItem();
         if (pItem == NULL)
           break;
 
@@ -93,12 +88,21 @@ void CBackgroundInfoLoader::Run()
         {
           CLog::Log(LOGERROR, "%s::LoadItem - Unhandled exception for item %s", __FUNCTION__, pItem->m_strPath.c_str());
         }
+
+        lock.Enter();
+        if (m_visible.erase(pItem.get()) && m_visible.empty())
+          CLog::Log(LOGDEBUG, "%s - items in view loaded in %u ms", __FUNCTION__, CTimeUtils::GetTimeMS() - m_rangeTime);
       }
     }
 
-    CSingleLock lock(m_lock);
-    if (m_nActiveThreads == 1)
+    // the lock is held from finding nothing left to load until this worker is counted out, so
+    // SetVisibleRange() either sees it still active before that or restarts the workers after.
+    // Items out of range may still be waiting, in which case we're only idle
+    if (m_nActiveThreads == 1 && m_bStartCalled && (m_bStop || m_pending.empty()))
+    {
       OnLoaderFinish();
+      m_bStartCalled = false;
+    }
     m_nActiveThreads--;
 
   }
@@ -119,20 +123,43 @@ void CBackgroundInfoLoader::Load(CFileItemList& items)
   EnterCriticalSection(m_lock);
 
   for (int nItem=0; nItem < items.Size(); nItem++)
+  {
     m_vecItems.push_back(items[nItem]);
+    m_pending.insert(items[nItem].get());
+  }
 
   m_pVecItems = &items;
   m_bStop = false;
   m_bStartCalled = false;
+  m_nextItem = 0;
 
   int nThreads = m_nRequestedThreads;
   if (nThreads == -1)
     nThreads = (m_vecItems.size() / (ITEMS_PER_THREAD+1)) + 1;
 
+  StartWorkers(nThreads);
+
+  LeaveCriticalSection(m_lock);
+}
+
+void CBackgroundInfoLoader::StartWorkers(int nThreads)
+{
   if (nThreads > g_advancedSettings.m_bgInfoLoaderMaxThreads)
     nThreads = g_advancedSettings.m_bgInfoLoaderMaxThreads;
 
-  m_nActiveThreads = nThreads;
+  // with none active, the workers from before have all left Run(), so reap them rather than
+  // keep a thread object for each time the loader went idle and was restarted
+  if (m_nActiveThreads == 0)
+  {
+    for (unsigned int i = 0; i < m_workers.size(); i++)
+    {
+      m_workers[i]->StopThread();
+      delete m_workers[i];
+    }
+    m_workers.clear();
+  }
+
+  m_nActiveThreads += nThreads;
   for (int i=0; i < nThreads; i++)
   {
     CThread *pThread = new CThread(this);
@@ -143,8 +170,95 @@ void CBackgroundInfoLoader::Load(CFileItemList& items)
     pThread->SetName("Background Loader");
     m_workers.push_back(pThread);
   }
+}
 
-  LeaveCriticalSection(m_lock);
+CFileItemPtr CBackgroundInfoLoader::GetNextItem()
+{
+  // items in range first, in order of priority
+  for (vector<CFileItemPtr>::const_iterator it = m_inRange.begin(); it != m_inRange.end(); ++it)
+  {
+    if (m_pending.erase(it->get()))
+      return *it;
+  }
+
+  // the rest wait until they come into range
+  if (m_hasRange)
+    return CFileItemPtr();
+
+  while (m_nextItem < m_vecItems.size())
+  {
+    CFileItemPtr pItem = m_vecItems[m_nextItem++];
+    if (m_pending.erase(pItem.get()))
+      return pItem;
+  }
+  return CFileItemPtr();
+}
+
+void CBackgroundInfoLoader::SetVisibleRange(int first, int last)
+{
+  CSingleLock lock(m_lock);
+  if (!m_pVecItems || m_bStop)
+    return;
+
+  if ((first != m_rangeFirst || last != m_rangeLast) && !UpdateRange(first, last))
+    return;
+
+  // restart the workers if they went idle with items in range still waiting. This is checked
+  // even when the range hasn't changed, so that a view which isn't scrolled still gets loaded
+  if (m_nActiveThreads == 0 && !m_pending.empty())
+  {
+    int pending = 0;
+    for (vector<CFileItemPtr>::const_iterator it = m_inRange.begin(); it != m_inRange.end(); ++it)
+      pending += m_pending.count(it->get());
+    if (pending)
+      StartWorkers(m_nRequestedThreads == -1 ? (pending / (ITEMS_PER_THREAD+1)) + 1 : m_nRequestedThreads);
+  }
+}
+
+bool CBackgroundInfoLoader::UpdateRange(int first, int last)
+{
+  int size = m_pVecItems->Size();
+  if (first < 0 || last < first || first >= size)
+    return false;
+  if (last >= size)
+    last = size - 1;
+
+  // look ahead two pages in the direction of scrolling, and one page the other way
+  int page = last - first + 1;
+  bool forward = m_rangeFirst < 0 || first >= m_rangeFirst;
+  int ahead = forward ? std::min(size - 1, last + 2 * page) : std::max(0, first - 2 * page);
+  int behind = forward ? std::max(0, first - page) : std::min(size - 1, last + page);
+
+  m_inRange.clear();
+  m_visible.clear();
+  for (int i = first; i <= last; i++)
+  {
+    CFileItemPtr pItem = m_pVecItems->Get(i);
+    m_inRange.push_back(pItem);
+    if (m_pending.find(pItem.get()) != m_pending.end())
+      m_visible.insert(pItem.get());
+  }
+  if (forward)
+  {
+    for (int i = last + 1; i <= ahead; i++)
+      m_inRange.push_back(m_pVecItems->Get(i));
+    for (int i = first - 1; i >= behind; i--)
+      m_inRange.push_back(m_pVecItems->Get(i));
+  }
+  else
+  {
+    for (int i = first - 1; i >= ahead; i--)
+      m_inRange.push_back(m_pVecItems->Get(i));
+    for (int i = last + 1; i <= behind; i++)
+      m_inRange.push_back(m_pVecItems->Get(i));
+  }
+
+  m_hasRange = true;
+  m_rangeFirst = first;
+  m_rangeLast = last;
+  m_rangeTime = CTimeUtils::GetTimeMS();
+
+  return true;
 }
 
 void CBackgroundInfoLoader::StopAsync()
@@ -164,7 +278,21 @@ void CBackgroundInfoLoader::StopThread()
   }
 
   m_workers.clear();
+
+  // workers may have gone idle with items out of range still waiting
+  if (m_bStartCalled)
+  {
+    OnLoaderFinish();
+    m_bStartCalled = false;
+  }
+
   m_vecItems.clear();
+  m_pending.clear();
+  m_inRange.clear();
+  m_visible.clear();
+  m_nextItem = 0;
+  m_hasRange = false;
+  m_rangeFirst = m_rangeLast = -1;
   m_pVecItems = NULL;
   m_nActiveThreads = 0;
 }
@@ -26,6 +26,7 @@
 #include "utils/CriticalSection.h"
 
 #include <vector>
+#include <set>
 #include "boost/shared_ptr.hpp"
 
 class CFileItem; typedef boost::shared_ptr<CFileItem> CFileItemPtr;
@@ -56,6 +57,15 @@ public:
 
   void SetNumOfWorkers(int nThreads); // -1 means auto compute num of required threads
 
+  /*! \brief Tell the loader which items of the list are in view, so those are loaded first.
+   Once a range has been set, only the items in view and a lookahead of the items around them
+   (mostly in the direction of scrolling) are loaded; the rest wait until they come into range.
+   Cheap to call every frame.
+   \param first index of the first item in view in the list passed to Load()
+   \param last index of the last item in view
+   */
+  void SetVisibleRange(int first, int last);
+
 protected:
   virtual void OnLoaderStart() {};
   virtual void OnLoaderFinish() {};
@@ -64,6 +74,20 @@ protected:
   std::vector<CFileItemPtr> m_vecItems; // FileItemList would delete the items and we only want to keep a reference.
   CCriticalSection m_lock;
 
+private:
+  CFileItemPtr GetNextItem();
+  void StartWorkers(int nThreads);
+  bool UpdateRange(int first, int last);
+
+  unsigned int m_nextItem;             ///< next item of m_vecItems to load in list order
+  std::set<CFileItem*> m_pending;      ///< items not loaded yet
+  std::vector<CFileItemPtr> m_inRange; ///< items in view, then the lookahead, most wanted first
+  std::set<CFileItem*> m_visible;      ///< items in view that are not loaded yet
+  bool m_hasRange;
+  int m_rangeFirst;
+  int m_rangeLast;
+  unsigned int m_rangeTime;            ///< when the current range was set, for timing how long the items in view take
+
   bool m_bStartCalled;
   volatile bool m_bStop;
   int  m_nRequestedThreads;
@@ -27,6 +27,13 @@
 #include "FileSystem/SpecialProtocol.h"
 #include "AutoPtrHandle.h"
 #include "utils/log.h"
+#include "utils/CharsetConverter.h"
+#include "utils/TimeUtils.h"
+#include "utils/SingleLock.h"
+#include "FileItem.h"
+
+#include <algorithm>
+#include <map>
 
 using namespace AUTOPTR;
 using namespace dbiplus;
@@ -38,6 +45,10 @@ CDatabase::CDatabase(void)
   m_bOpen = false;
   m_iRefCount = 0;
   m_sqlite = true;
+  m_readOnly = false;
+  m_searchIndex = false;
+  m_stringPoolHits = 0;
+  m_stringPoolShared = 0;
 }
 
 CDatabase::~CDatabase(void)
@@ -106,6 +117,57 @@ CStdString CDatabase::PrepareSQL(CStdString strStmt, ...) const
   return strResult;
 }
 
+int CDatabase::GetRowCount(const CStdString &table, const CStdString &where)
+{
+  if (NULL == m_pDB.get()) return -1;
+  if (NULL == m_pDS.get()) return -1;
+
+  try
+  {
+    CStdString sql = "select count(1) from " + table + " " + where;
+    if (!m_pDS->query(sql.c_str())) return -1;
+    int count = m_pDS->eof() ? 0 : m_pDS->fv(0).get_asInt();
+    m_pDS->close();
+    return count;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, where.c_str());
+  }
+  return -1;
+}
+
+bool CDatabase::PrepareLimits(const CStdString &table, const CStdString &where, const DatabaseSortColumn *columns, const char *idColumn, DatabaseLimits &limits, CStdString &order, CStdString &limit)
+{
+  order.clear();
+  if (limits.sortMethod != SORT_METHOD_NONE)
+  {
+    const DatabaseSortColumn *column = columns;
+    while (column->column && column->method != limits.sortMethod)
+      column++;
+    if (!column->column)
+      return false; // no column for this sort, so it has to be done on the whole listing
+
+    // mysql compares text case insensitively by default, sqlite needs to be told to
+    const char *direction = limits.sortOrder == SORT_ORDER_DESC ? "desc" : "asc";
+    order.Format("order by %s%s %s, %s %s", column->column, (column->text && m_sqlite) ? " collate nocase" : "",
+                 direction, idColumn, direction);
+  }
+
+  int total = GetRowCount(table, where);
+  if (total < 0)
+    return false;
+
+  int end   = limits.end < 0 || limits.end > total ? total : limits.end;
+  int start = limits.start < 0 ? 0 : limits.start > end ? end : limits.start;
+  limit.Format(" limit %i,%i", start, end - start);
+
+  limits.start = start;
+  limits.end   = end;
+  limits.total = total;
+  return true;
+}
+
 bool CDatabase::Open()
 {
   DatabaseSettings db_fallback;
@@ -142,10 +204,16 @@ bool CDatabase::Open(DatabaseSettings &dbSettings)
     dbSettings.host = _P(g_settings.GetDatabaseFolder());
   }
 
+  // read only connections are just an sqlite optimisation
+  if (!m_sqlite || !dbSettings.readOnlyListings)
+    m_readOnly = false;
+
   // create the appropriate database structure
   if (dbSettings.type.Equals("sqlite3"))
   {
-    m_pDB.reset( new SqliteDatabase() ) ;
+    SqliteDatabase *sqlite = new SqliteDatabase();
+    sqlite->setReadOnly(m_readOnly);
+    m_pDB.reset(sqlite);
   }
   else if (dbSettings.type.Equals("mysql"))
   {
@@ -176,7 +244,14 @@ bool CDatabase::Open(DatabaseSettings &dbSettings)
   m_pDS.reset(m_pDB->CreateDataset());
   m_pDS2.reset(m_pDB->CreateDataset());
 
-  if (m_pDB->connect() != DB_CONNECTION_OK)
+  int connected = m_pDB->connect();
+  if (m_readOnly && (connected != DB_CONNECTION_OK || !m_pDB->exists()))
+  { // nothing to read yet, the tables have to be created first
+    CLog::Log(LOGDEBUG, "%s - %s needs creating, opening it read/write", __FUNCTION__, dbSettings.name.c_str());
+    connected = ReopenReadWrite();
+  }
+
+  if (connected != DB_CONNECTION_OK)
   {
     CLog::Log(LOGERROR, "Unable to open database at host: %s db: %s (old version?)", dbSettings.host.c_str(), dbSettings.name.c_str());
     return false;
@@ -209,6 +284,17 @@ bool CDatabase::Open(DatabaseSettings &dbSettings)
   if (m_pDS->num_rows() > 0)
     version = m_pDS->fv("idVersion").get_asInt();
 
+  if (version < GetMinVersion() && m_readOnly)
+  {
+    CLog::Log(LOGDEBUG, "%s - %s needs updating, opening it read/write", __FUNCTION__, dbSettings.name.c_str());
+    if (ReopenReadWrite() != DB_CONNECTION_OK)
+    {
+      CLog::Log(LOGERROR, "Unable to reopen database %s for updating", dbSettings.name.c_str());
+      Close();
+      return false;
+    }
+  }
+
   if (version < GetMinVersion())
   {
     CLog::Log(LOGNOTICE, "Attempting to update the database %s from version %i to %i", dbSettings.name.c_str(), version, GetMinVersion());
@@ -230,11 +316,9 @@ bool CDatabase::Open(DatabaseSettings &dbSettings)
 
   // sqlite3 post connection operations
   if (dbSettings.type.Equals("sqlite3"))
-  {
-    m_pDS->exec("PRAGMA cache_size=4096\n");
-    m_pDS->exec("PRAGMA synchronous='NORMAL'\n");
-    m_pDS->exec("PRAGMA count_changes='OFF'\n");
-  }
+    TuneSqlite(dbSettings);
+
+  OpenSearchIndex();
 
   m_iRefCount++;
   return true;
@@ -245,6 +329,57 @@ bool CDatabase::IsOpen()
   return m_bOpen;
 }
 
+bool CDatabase::OpenReadOnly()
+{
+  if (IsOpen())
+    return Open();
+
+  m_readOnly = true;
+  if (Open())
+    return true;
+
+  m_readOnly = false;
+  return false;
+}
+
+int CDatabase::ReopenReadWrite()
+{
+  m_readOnly = false;
+  ((SqliteDatabase *)m_pDB.get())->setReadOnly(false);
+  return m_pDB->connect();
+}
+
+void CDatabase::TuneSqlite(const DatabaseSettings &dbSettings)
+{
+  CStdString strSQL;
+  try
+  {
+    strSQL = PrepareSQL("PRAGMA cache_size=%i\n", dbSettings.cacheSize);
+    m_pDS->exec(strSQL.c_str());
+    strSQL = PrepareSQL("PRAGMA synchronous='%s'\n", dbSettings.synchronous.c_str());
+    m_pDS->exec(strSQL.c_str());
+    m_pDS->exec("PRAGMA count_changes='OFF'\n");
+
+    // the journal mode is stored in the file, so only a writer may change it.  In wal mode
+    // readers no longer wait for a scan's write transactions to commit.  Versions of sqlite
+    // without wal (< 3.7.0) or mmap (< 3.7.17) just ignore the pragmas.
+    if (!m_readOnly && !dbSettings.journalMode.IsEmpty())
+    {
+      strSQL = PrepareSQL("PRAGMA journal_mode=%s\n", dbSettings.journalMode.c_str());
+      m_pDS->exec(strSQL.c_str());
+    }
+    if (dbSettings.mmapSize > 0)
+    {
+      strSQL = PrepareSQL("PRAGMA mmap_size=%lld\n", (long long)dbSettings.mmapSize << 20);
+      m_pDS->exec(strSQL.c_str());
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - unable to tune %s (%s)", __FUNCTION__, dbSettings.name.c_str(), strSQL.c_str());
+  }
+}
+
 void CDatabase::Close()
 {
   if (!m_bOpen)
@@ -258,6 +393,7 @@ void CDatabase::Close()
 
   m_iRefCount--;
   m_bOpen = false;
+  m_readOnly = false;
 
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
@@ -265,6 +401,7 @@ void CDatabase::Close()
   m_pDB.reset();
   m_pDS.reset();
   m_pDS2.reset();
+  m_stringPool.clear();
 }
 
 bool CDatabase::Compress(bool bForce /* =true */)
@@ -381,3 +518,266 @@ bool CDatabase::UpdateVersionNumber()
   return true;
 }
 
+// accent free lower case forms of U+00C0 - U+00FF and U+0100 - U+017F, '.' where there is none
+static const char foldLatin1[]         = "aaaaaa.ceeeeiiiidnooooo.ouuuuy..aaaaaa.ceeeeiiiidnooooo.ouuuuy.y";
+static const char foldLatinExtendedA[] = "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiii..jjkk.llllllllllnnnnnnnnnoooooo..rrrrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+CStdString CDatabase::FoldSearchText(const CStdString &text)
+{
+  CStdStringW wide;
+  g_charsetConverter.utf8ToW(text, wide, false);
+  wide.ToLower();
+  for (unsigned int i = 0; i < wide.size(); i++)
+  {
+    unsigned int c = wide[i];
+    if (c >= 0xC0 && c < 0x100 && foldLatin1[c - 0xC0] != '.')
+      wide[i] = foldLatin1[c - 0xC0];
+    else if (c >= 0x100 && c < 0x180 && foldLatinExtendedA[c - 0x100] != '.')
+      wide[i] = foldLatinExtendedA[c - 0x100];
+  }
+  CStdString folded;
+  g_charsetConverter.wToUTF8(wide, folded);
+  return folded;
+}
+
+int CDatabase::GetSearchScore(const CStdString &search, const CStdString &title)
+{
+  CStdString folded = FoldSearchText(title);
+  int score = 1;
+  if (folded == search)
+    score = 3;
+  else if (folded.Left(search.size()) == search)
+    score = 2;
+  return score * 1000 - std::min((int)folded.size(), 999);
+}
+
+static bool SortBySearchScore(const CFileItemPtr &left, const CFileItemPtr &right)
+{
+  return left->GetPropertyInt("searchscore") > right->GetPropertyInt("searchscore");
+}
+
+void CDatabase::SortSearchResults(CFileItemList &items)
+{
+  std::vector<CFileItemPtr> sorted;
+  for (int i = 0; i < items.Size(); i++)
+    sorted.push_back(items[i]);
+  std::stable_sort(sorted.begin(), sorted.end(), SortBySearchScore);
+  items.ClearItems();
+  for (unsigned int i = 0; i < sorted.size(); i++)
+    items.Add(sorted[i]);
+}
+
+CStdString CDatabase::GetSearchIndexMatch(const CStdString &search) const
+{
+  // split the search into words the same way the fts3 "simple" tokenizer does: ascii letters
+  // and digits along with all non-ascii bytes make up words, and every word is a prefix query
+  CStdString folded = FoldSearchText(search);
+  CStdString match, word;
+  for (unsigned int i = 0; i <= folded.size(); i++)
+  {
+    unsigned char c = i < folded.size() ? folded[i] : ' ';
+    if (c >= 0x80 || isalnum(c))
+      word += c;
+    else if (!word.IsEmpty())
+    {
+      if (!match.IsEmpty())
+        match += " ";
+      match += word + "*";
+      word.Empty();
+    }
+  }
+  return match;
+}
+
+// whether each database has a search index, so that it's only looked up on the first Open()
+static CCriticalSection g_searchIndexSection;
+static std::map<CStdString, bool> g_searchIndexes;
+
+void CDatabase::OpenSearchIndex()
+{
+  m_searchIndex = false;
+  if (!m_sqlite || !UsesSearchIndex())
+    return;
+
+  CStdString database;
+  CUtil::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase(), database);
+  CSingleLock lock(g_searchIndexSection);
+  std::map<CStdString, bool>::const_iterator it = g_searchIndexes.find(database);
+  if (it != g_searchIndexes.end())
+  {
+    m_searchIndex = it->second;
+    return;
+  }
+
+  // the index is created with the tables, unless sqlite has no full text search
+  try
+  {
+    m_pDS->query("select name from sqlite_master where type='table' and name='searchindex'\n");
+    m_searchIndex = m_pDS->num_rows() > 0;
+    m_pDS->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  g_searchIndexes[database] = m_searchIndex;
+  if (!m_searchIndex)
+    CLog::Log(LOGINFO, "%s - %s has no search index, falling back to LIKE queries", __FUNCTION__, database.c_str());
+}
+
+void CDatabase::CreateSearchIndex()
+{
+  m_searchIndex = false;
+  if (!m_sqlite || !UsesSearchIndex())
+    return;
+
+  try
+  {
+    m_pDS->exec("DROP TABLE IF EXISTS searchindex\n");
+    m_pDS->exec("CREATE VIRTUAL TABLE searchindex USING fts3(content)\n");
+    m_searchIndex = true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGINFO, "%s - sqlite has no full text search, falling back to LIKE queries", __FUNCTION__);
+  }
+
+  if (m_searchIndex)
+  {
+    unsigned int time = CTimeUtils::GetTimeMS();
+    PopulateSearchIndex();
+    CLog::Log(LOGINFO, "%s - created search index in %u ms", __FUNCTION__, CTimeUtils::GetTimeMS() - time);
+  }
+
+  CStdString database;
+  CUtil::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase(), database);
+  CSingleLock lock(g_searchIndexSection);
+  g_searchIndexes[database] = m_searchIndex;
+}
+
+void CDatabase::AddToSearchIndex(int type, int id, const CStdString &title)
+{
+  if (!m_searchIndex || NULL == m_pDS.get())
+    return;
+
+  CStdString strSQL;
+  try
+  {
+    strSQL = PrepareSQL("delete from searchindex where docid=%i*16+%i", id, type);
+    m_pDS->exec(strSQL.c_str());
+    strSQL = PrepareSQL("insert into searchindex (docid, content) values (%i*16+%i, '%s')", id, type, FoldSearchText(title).c_str());
+    m_pDS->exec(strSQL.c_str());
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed (%s)", __FUNCTION__, strSQL.c_str());
+  }
+}
+
+void CDatabase::FillSearchIndex(int type, const CStdString &sql)
+{
+  if (!m_searchIndex || NULL == m_pDS.get())
+    return;
+
+  try
+  {
+    // read everything first, as the inserts need the dataset
+    std::vector< std::pair<int, CStdString> > rows;
+    if (!m_pDS->query(sql.c_str()))
+      return;
+    while (!m_pDS->eof())
+    {
+      rows.push_back(std::make_pair(m_pDS->fv(0).get_asInt(), CStdString(m_pDS->fv(1).get_asString())));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    for (unsigned int i = 0; i < rows.size(); i++)
+    {
+      CStdString strSQL = PrepareSQL("insert into searchindex (docid, content) values (%i*16+%i, '%s')", rows[i].first, type, FoldSearchText(rows[i].second).c_str());
+      m_pDS->exec(strSQL.c_str());
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, sql.c_str());
+  }
+}
+
+void CDatabase::RemoveFromSearchIndex(int type, int id)
+{
+  if (!m_searchIndex || NULL == m_pDS.get())
+    return;
+
+  try
+  {
+    CStdString strSQL = PrepareSQL("delete from searchindex where docid=%i*16+%i", id, type);
+    m_pDS->exec(strSQL.c_str());
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%i, %i) failed", __FUNCTION__, type, id);
+  }
+}
+
+void CDatabase::PruneSearchIndex(int type, const CStdString &table, const CStdString &idColumn)
+{
+  if (!m_searchIndex || NULL == m_pDS.get())
+    return;
+
+  CStdString strSQL;
+  try
+  {
+    strSQL = PrepareSQL("delete from searchindex where (docid & 15)=%i and (docid >> 4) not in (select %s from %s)", type, idColumn.c_str(), table.c_str());
+    m_pDS->exec(strSQL.c_str());
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed (%s)", __FUNCTION__, strSQL.c_str());
+  }
+}
+
+CStdString CDatabase::GetSearchIndexFilter(int type, const CStdString &idColumn, const CStdString &search)
+{
+  if (!m_searchIndex)
+    return "";
+
+  CStdString match = GetSearchIndexMatch(search);
+  if (match.IsEmpty())
+    return "";
+
+  return PrepareSQL("%s in (select docid >> 4 from searchindex where content match '%s' and (docid & 15)=%i)", idColumn.c_str(), match.c_str(), type);
+}
+
+void CDatabase::LogSearchTime(const char *function, const CStdString &search, int results, unsigned int time)
+{
+  if (g_advancedSettings.m_logLevel < LOG_LEVEL_DEBUG)
+    return;
+
+  // counting the index is a scan, so only done when someone is looking
+  if (m_searchIndex)
+    CLog::Log(LOGDEBUG, "%s (%s) found %i items among %i indexed in %u ms", function, search.c_str(), results, GetRowCount("searchindex", ""), time);
+  else
+    CLog::Log(LOGDEBUG, "%s (%s) found %i items without the search index in %u ms", function, search.c_str(), results, time);
+}
+
+const CStdString &CDatabase::InternString(const CStdString &value)
+{
+  std::pair<std::set<CStdString>::iterator, bool> ret = m_stringPool.insert(value);
+  if (!ret.second)
+  {
+    m_stringPoolHits++;
+    m_stringPoolShared += value.size();
+  }
+  return *ret.first;
+}
+
+void CDatabase::LogListingTime(const char *function, int items, unsigned int time)
+{
+  if (g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG)
+    CLog::Log(LOGDEBUG, "%s listed %i items in %u ms, %u repeated values (%"PRIu64" bytes) shared among %u distinct ones",
+              function, items, time, m_stringPoolHits, m_stringPoolShared, (unsigned int)m_stringPool.size());
+  m_stringPool.clear();
+  m_stringPoolHits = 0;
+  m_stringPoolShared = 0;
+}
@@ -24,10 +24,42 @@
 #include "StdString.h"
 #include "lib/sqLite/mysqldataset.h"
 #include "lib/sqLite/sqlitedataset.h"
+#include "SortFileItem.h"
 
 #include <memory>
+#include <set>
 
 struct DatabaseSettings; // forward
+class CFileItemList;
+
+/*!
+ \brief Sorting and paging of a library listing, to be done by the database.
+
+ The caller fills in the sort and the [start, end) window it wants. Listing functions
+ that can do both in SQL return just that window and set total to the size of the
+ whole listing. total is left at -1 if the whole listing was returned instead (e.g.
+ there is no column for the sort method), and the caller must sort and slice it.
+ */
+struct DatabaseLimits
+{
+  DatabaseLimits() : sortMethod(SORT_METHOD_NONE), sortOrder(SORT_ORDER_ASC), start(0), end(-1), total(-1) {}
+  SORT_METHOD sortMethod;
+  SORT_ORDER  sortOrder;
+  int start;
+  int end;    ///< one past the last row wanted, or -1 for all remaining rows
+  int total;  ///< number of rows in the whole listing, set once the limits have been applied
+};
+
+/*!
+ \brief Maps a sort method onto the column (or expression) a listing is ordered by.
+ Tables of these are terminated by an entry with a NULL column.
+ */
+struct DatabaseSortColumn
+{
+  SORT_METHOD method;
+  const char *column;
+  bool        text;   ///< whether to compare case insensitively
+};
 
 class CDatabase
 {
@@ -41,6 +73,13 @@ public:
 
   bool Open(DatabaseSettings &db);
 
+  /*! \brief Open a read only connection, for listings which may run while a scan is writing.
+   Falls back to a read/write connection if the database needs creating or updating, isn't
+   sqlite, or read only listings are disabled in its advancedsettings.
+   \sa DatabaseSettings
+   */
+  bool OpenReadOnly();
+
   void BeginTransaction();
   virtual bool CommitTransaction();
   void RollbackTransaction();
@@ -49,6 +88,23 @@ public:
   static CStdString FormatSQL(CStdString strStmt, ...);
   CStdString PrepareSQL(CStdString strStmt, ...) const;
 
+  /*! \brief Fold text for searching: lower case, with the accents stripped from latin letters.
+   */
+  static CStdString FoldSearchText(const CStdString &text);
+
+  /*! \brief Rank how well a title matches a search.
+   Exact matches rank above title prefixes, which rank above matches of words within the title.
+   Shorter titles rank above longer ones.
+   \param search the search, as returned by FoldSearchText()
+   \param title the title of the matched item
+   \return the score, higher is better
+   */
+  static int GetSearchScore(const CStdString &search, const CStdString &title);
+
+  /*! \brief Order search results best first, by their "searchscore" property.
+   */
+  static void SortSearchResults(CFileItemList &items);
+
 protected:
   void Split(const CStdString& strFileNameAndPath, CStdString& strPath, CStdString& strFileName);
   uint32_t ComputeCRC(const CStdString &text);
@@ -60,8 +116,99 @@ protected:
   virtual int GetMinVersion() const=0;
   virtual const char *GetDefaultDBName() const=0;
 
+  /*! \brief Count the rows of a listing.
+   \param table the table or view being listed
+   \param where the (formatted) join and where clauses of the listing
+   \return the number of rows, or -1 on failure
+   */
+  int GetRowCount(const CStdString &table, const CStdString &where);
+
+  /*! \brief Turn the sort and window of a DatabaseLimits into SQL for a listing.
+   Counts the listing so the window can be clamped to it, and sets limits.total.
+   \param table the table or view being listed
+   \param where the (formatted) join and where clauses of the listing
+   \param columns the columns the listing may be sorted by
+   \param idColumn unique column used to keep the order stable between pages
+   \param limits the sort and window wanted
+   \param order [out] the ORDER BY clause, empty if no sort was asked for
+   \param limit [out] the LIMIT clause
+   \return false if the limits can't be applied in SQL, in which case limits is untouched
+   */
+  bool PrepareLimits(const CStdString &table, const CStdString &where, const DatabaseSortColumn *columns, const char *idColumn, DatabaseLimits &limits, CStdString &order, CStdString &limit);
+
+  /*! \brief Whether the full text search index is available.
+   The index is an sqlite FTS3 table holding the folded titles of the searchable items, keyed on
+   their type and id. It isn't available on mysql, or if sqlite was built without FTS3, in which
+   case searches should fall back to LIKE queries.
+   */
+  bool HasSearchIndex() const { return m_searchIndex; };
+
+  /*! \brief Whether this database keeps a search index. Only those that are searched opt in.
+   */
+  virtual bool UsesSearchIndex() const { return false; };
+
+  /*! \brief Fill the search index from the tables, by calling AddToSearchIndex() for each item.
+   Called within a transaction when the index is first created.
+   */
+  virtual void PopulateSearchIndex() {};
+
+  /*! \brief Create the search index and fill it, if sqlite has full text search.
+   Called from CreateTables() and from UpdateOldVersion() when the version that adds it is reached.
+   */
+  void CreateSearchIndex();
+
+  /*! \brief Add an item to the search index, replacing any previous entry for it.
+   \param type the type of the item (0-15)
+   \param id the id of the item in its own table
+   \param title the text to be searched
+   */
+  void AddToSearchIndex(int type, int id, const CStdString &title);
+  void RemoveFromSearchIndex(int type, int id);
+
+  /*! \brief Add the items returned by a query to the search index, for use by PopulateSearchIndex().
+   \param type the type of the items (0-15)
+   \param sql query returning the id and the title of each item
+   */
+  void FillSearchIndex(int type, const CStdString &sql);
+
+  /*! \brief Remove the entries of a type whose items no longer exist.
+   \param type the type the items were indexed under
+   \param table the table holding the items
+   \param idColumn the id column of that table
+   */
+  void PruneSearchIndex(int type, const CStdString &table, const CStdString &idColumn);
+
+  /*! \brief Build the SQL condition restricting a listing to the items of a type that match a search.
+   Each word of the search matches words of the title starting with it, ignoring case and accents.
+   \param type the type the items were indexed under
+   \param idColumn the id column of the listing
+   \param search the search
+   \return the condition, or an empty string if there is no search index
+   */
+  CStdString GetSearchIndexFilter(int type, const CStdString &idColumn, const CStdString &search);
+
+  /*! \brief Log the time a search took against the size of the search index, at debug log level.
+   Keeps an eye on how searches scale with the size of the library.
+   */
+  void LogSearchTime(const char *function, const CStdString &search, int results, unsigned int time);
+
+  /*! \brief Share a value which repeats across the rows of a listing, such as a genre, studio or path.
+   Copies of the returned string share their buffer with the pooled one on reference counted string
+   implementations, so a large listing holds each distinct value once. The pool is emptied at the
+   end of each listing by LogListingTime(), so it doesn't grow with every listing made on the connection.
+   \param value the value read from the dataset
+   \return the pooled copy of the value
+   */
+  const CStdString &InternString(const CStdString &value);
+
+  /*! \brief Log the time a listing took and the memory the string pool shared, at debug log level.
+   Empties the pool and resets its statistics for the next listing. The listed items keep their copies.
+   */
+  void LogListingTime(const char *function, int items, unsigned int time);
+
   bool m_bOpen;
   bool m_sqlite; ///< \brief whether we use sqlite (defaults to true)
+  bool m_readOnly; ///< \brief whether the connection is read only, see OpenReadOnly()
 
   std::auto_ptr<dbiplus::Database> m_pDB;
   std::auto_ptr<dbiplus::Dataset> m_pDS;
@@ -69,6 +216,16 @@ protected:
 
 private:
   bool UpdateVersionNumber();
+  void OpenSearchIndex();
+  int ReopenReadWrite();
+  void TuneSqlite(const DatabaseSettings &dbSettings);
+  CStdString GetSearchIndexMatch(const CStdString &search) const;
+
+  bool m_searchIndex;
+
+  std::set<CStdString> m_stringPool;
+  unsigned int m_stringPoolHits;
+  uint64_t m_stringPoolShared; ///< \brief bytes not duplicated thanks to the pool since the last LogListingTime()
 
   int m_iRefCount;
 };
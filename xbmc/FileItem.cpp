@@ -42,6 +42,9 @@
 #include "utils/TuxBoxUtil.h"
 #include "VideoInfoTag.h"
 #include "utils/SingleLock.h"
+#include "utils/Thread.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
 #include "MusicInfoTag.h"
 #include "PictureInfoTag.h"
 #include "Artist.h"
@@ -1411,10 +1414,85 @@ void CFileItemList::Reserve(int iCount)
   m_items.reserve(iCount);
 }
 
+// lists smaller than this aren't worth the cost of spinning up threads to sort
+#define PARALLEL_SORT_THRESHOLD 4096
+#define PARALLEL_SORT_MAX_THREADS 8
+
+static void SortItemRange(IVECFILEITEMS begin, IVECFILEITEMS end, FILEITEMLISTCOMPARISONFUNC func)
+{
+  // build the sort keys up front, so the comparisons only ever read them
+  for (IVECFILEITEMS it = begin; it != end; ++it)
+  {
+    if (*it)
+      (*it)->GetSortKey();
+  }
+  std::stable_sort(begin, end, func);
+}
+
+/*!
+ \brief Sorts one slice of a CFileItemList as part of a parallel merge sort.
+ */
+class CFileItemSortThread : public CThread
+{
+public:
+  CFileItemSortThread(IVECFILEITEMS begin, IVECFILEITEMS end, FILEITEMLISTCOMPARISONFUNC func)
+    : m_begin(begin), m_end(end), m_func(func)
+  {
+  }
+
+protected:
+  virtual void Process()
+  {
+    SortItemRange(m_begin, m_end, m_func);
+  }
+
+private:
+  IVECFILEITEMS              m_begin;
+  IVECFILEITEMS              m_end;
+  FILEITEMLISTCOMPARISONFUNC m_func;
+};
+
 void CFileItemList::Sort(FILEITEMLISTCOMPARISONFUNC func)
 {
   CSingleLock lock(m_lock);
-  std::stable_sort(m_items.begin(), m_items.end(), func);
+
+  unsigned int slices = std::min(g_cpuInfo.getCPUCount(), PARALLEL_SORT_MAX_THREADS);
+  if (m_items.size() < PARALLEL_SORT_THRESHOLD || slices < 2)
+  {
+    SortItemRange(m_items.begin(), m_items.end(), func);
+    return;
+  }
+
+  unsigned int startTime = CTimeUtils::GetTimeMS();
+
+  // sort each slice on its own thread (the last one on ours), then merge them back together.
+  // Merging adjacent slices in order keeps the sort stable.
+  std::vector<IVECFILEITEMS> bounds;
+  for (unsigned int i = 0; i < slices; i++)
+    bounds.push_back(m_items.begin() + m_items.size() * i / slices);
+  bounds.push_back(m_items.end());
+
+  std::vector<CFileItemSortThread *> threads;
+  for (unsigned int i = 0; i < slices - 1; i++)
+  {
+    CFileItemSortThread *thread = new CFileItemSortThread(bounds[i], bounds[i + 1], func);
+    thread->Create();
+    threads.push_back(thread);
+  }
+  SortItemRange(bounds[slices - 1], bounds[slices], func);
+  for (unsigned int i = 0; i < threads.size(); i++)
+  {
+    threads[i]->StopThread();
+    delete threads[i];
+  }
+
+  for (unsigned int width = 1; width < slices; width *= 2)
+  {
+    for (unsigned int i = 0; i + width < slices; i += 2 * width)
+      std::inplace_merge(bounds[i], bounds[i + width], bounds[std::min(i + 2 * width, slices)], func);
+  }
+
+  CLog::Log(LOGDEBUG, "%s - sorted %"PRIuS" items on %u threads in %u ms", __FUNCTION__, m_items.size(), slices, CTimeUtils::GetTimeMS() - startTime);
 }
 
 void CFileItemList::FillSortFields(FILEITEMFILLFUNC func)
@@ -57,6 +57,16 @@ bool DllLibCurlGlobal::Load()
     return false;
   }
 
+  /* sessions each keep their own connections, but share one dns cache */
+  m_share = share_init();
+  if (m_share)
+  {
+    share_setopt(m_share, CURLSHOPT_LOCKFUNC, share_lock);
+    share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  }
+
   /* check idle will clean up the last one */
   g_curlReferences = 2;
 
@@ -71,7 +81,12 @@ void DllLibCurlGlobal::Unload()
     if (!IsLoaded())
       return;
 
-    // close libcurl
+    // close libcurl, once nothing is using the share
+    if (m_share)
+    {
+      share_cleanup(m_share);
+      m_share = NULL;
+    }
     global_cleanup();
 
     DllDynamic::Unload();
@@ -99,6 +114,11 @@ void DllLibCurlGlobal::CheckIdle()
     {
       CLog::Log(LOGINFO, "%s - Closing session to %s://%s (easy=%p, multi=%p)\n", __FUNCTION__, it->m_protocol.c_str(), it->m_hostname.c_str(), (void*)it->m_easy, (void*)it->m_multi);
 
+      std::map<CStdString, SHostStats>::const_iterator stats = m_hostStats.find(it->m_hostname);
+      if (stats != m_hostStats.end() && stats->second.m_requests)
+        CLog::Log(LOGDEBUG, "%s - %s: %u requests on %u connections, %.0f ms average latency", __FUNCTION__, it->m_hostname.c_str(),
+                  stats->second.m_requests, stats->second.m_connects, stats->second.m_latency * 1000 / stats->second.m_requests);
+
       // It's important to clean up multi *before* cleaning up easy, because the multi cleanup
       // code accesses stuff in the easy's structure.
       if(it->m_multi)
@@ -271,3 +291,43 @@ void DllLibCurlGlobal::easy_duplicate(CURL_HANDLE* easy, CURLM* multi, CURL_HAND
   }
   return;
 }
+
+void DllLibCurlGlobal::easy_record(CURL_HANDLE* easy_handle, const char* hostname)
+{
+  if (!easy_handle || !hostname)
+    return;
+
+  /* number of connections this request had to open, 0 if it reused one */
+  long connects = 0;
+  double latency = 0.0;
+  if (easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &connects) != CURLE_OK)
+    connects = 0;
+  if (easy_getinfo(easy_handle, CURLINFO_STARTTRANSFER_TIME, &latency) != CURLE_OK)
+    latency = 0.0;
+
+  CSingleLock lock(m_critSection);
+  SHostStats &stats = m_hostStats[hostname];
+  stats.m_requests++;
+  stats.m_connects += connects;
+  stats.m_latency += latency;
+}
+
+bool DllLibCurlGlobal::GetHostStats(const CStdString &hostname, SHostStats &stats)
+{
+  CSingleLock lock(m_critSection);
+  std::map<CStdString, SHostStats>::const_iterator it = m_hostStats.find(hostname);
+  if (it == m_hostStats.end())
+    return false;
+  stats = it->second;
+  return true;
+}
+
+void DllLibCurlGlobal::share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+  EnterCriticalSection(((DllLibCurlGlobal*)userptr)->m_shareSection);
+}
+
+void DllLibCurlGlobal::share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr)
+{
+  LeaveCriticalSection(((DllLibCurlGlobal*)userptr)->m_shareSection);
+}
@@ -23,6 +23,8 @@
 #include "DynamicDll.h"
 #include "utils/CriticalSection.h"
 
+#include <map>
+
 /* put types of curl in namespace to avoid namespace pollution */
 namespace XCURL
 {
@@ -53,6 +55,9 @@ namespace XCURL
     virtual void multi_cleanup(CURL_HANDLE * handle )=0;
     virtual struct curl_slist* slist_append(struct curl_slist *, const char *)=0;
     virtual void  slist_free_all(struct curl_slist *)=0;
+    virtual CURLSH * share_init(void)=0;
+    //virtual CURLSHcode share_setopt(CURLSH *share, CURLSHoption option, ...)=0;
+    virtual CURLSHcode share_cleanup(CURLSH *share)=0;
   };
 
   class DllLibCurl : public DllDynamic, DllLibCurlInterface
@@ -77,6 +82,9 @@ namespace XCURL
     DEFINE_METHOD1(void, multi_cleanup, (CURLM *p1))
     DEFINE_METHOD2(struct curl_slist*, slist_append, (struct curl_slist * p1, const char * p2))
     DEFINE_METHOD1(void, slist_free_all, (struct curl_slist * p1))
+    DEFINE_METHOD0(CURLSH *, share_init)
+    DEFINE_METHOD_FP(CURLSHcode, share_setopt, (CURLSH *p1, CURLSHoption p2, ...))
+    DEFINE_METHOD1(CURLSHcode, share_cleanup, (CURLSH *p1))
     BEGIN_METHOD_RESOLVE()
       RESOLVE_METHOD_RENAME(curl_global_init, global_init)
       RESOLVE_METHOD_RENAME(curl_global_cleanup, global_cleanup)
@@ -97,6 +105,9 @@ namespace XCURL
       RESOLVE_METHOD_RENAME(curl_multi_cleanup, multi_cleanup)
       RESOLVE_METHOD_RENAME(curl_slist_append, slist_append)
       RESOLVE_METHOD_RENAME(curl_slist_free_all, slist_free_all)
+      RESOLVE_METHOD_RENAME(curl_share_init, share_init)
+      RESOLVE_METHOD_RENAME_FP(curl_share_setopt, share_setopt)
+      RESOLVE_METHOD_RENAME(curl_share_cleanup, share_cleanup)
     END_METHOD_RESOLVE()
 
   };
@@ -104,6 +115,8 @@ namespace XCURL
   class DllLibCurlGlobal : public DllLibCurl
   {
   public:
+    DllLibCurlGlobal() : m_share(NULL) {}
+
     /* extend interface with buffered functions */
     void easy_aquire(const char *protocol, const char *hostname, CURL_HANDLE** easy_handle, CURLM** multi_handle);
     void easy_release(CURL_HANDLE** easy_handle, CURLM** multi_handle);
@@ -111,6 +124,12 @@ namespace XCURL
     CURL_HANDLE* easy_duphandle(CURL_HANDLE* easy_handle);
     void CheckIdle();
 
+    /* handle shared by all sessions, which holds the dns cache */
+    CURLSH* share_handle() { return m_share; }
+
+    /* record the connection reuse and latency of a request made on a session */
+    void easy_record(CURL_HANDLE* easy_handle, const char* hostname);
+
     /* overloaded load and unload with reference counter */
     virtual bool Load();
     virtual void Unload();
@@ -128,8 +147,26 @@ namespace XCURL
 
     typedef std::vector<SSession> VEC_CURLSESSIONS;
 
+    /* structure holding the request counters of a host */
+    typedef struct SHostStats
+    {
+      unsigned int  m_requests;       // requests made
+      unsigned int  m_connects;       // connections opened for them, the rest reused one
+      double        m_latency;        // total seconds from the requests to their first bytes
+    } SHostStats;
+
+    bool GetHostStats(const CStdString &hostname, SHostStats &stats);
+
     VEC_CURLSESSIONS m_sessions;
     CCriticalSection m_critSection;
+
+  private:
+    static void share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr);
+
+    CURLSH*          m_share;
+    CCriticalSection m_shareSection;
+    std::map<CStdString, SHostStats> m_hostStats;
   };
 }
 
@@ -361,6 +361,10 @@ void CFileCurl::SetCommonOptions(CReadState* state)
 
   g_curlInterface.easy_reset(h);
 
+  // resolve through the dns cache shared by all sessions
+  if (g_curlInterface.share_handle())
+    g_curlInterface.easy_setopt(h, CURLOPT_SHARE, g_curlInterface.share_handle());
+
   g_curlInterface.easy_setopt(h, CURLOPT_DEBUGFUNCTION, debug_callback);
 
   if( g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG )
@@ -844,6 +848,7 @@ bool CFileCurl::Open(const CURL& url)
   SetRequestHeaders(m_state);
 
   long response = m_state->Connect(m_bufferSize);
+  g_curlInterface.easy_record(m_state->m_easyHandle, url2.GetHostName().c_str());
   if( response < 0 || response >= 400)
     return false;
 
@@ -960,6 +965,7 @@ bool CFileCurl::Exists(const CURL& url)
   }
 
   CURLcode result = g_curlInterface.easy_perform(m_state->m_easyHandle);
+  g_curlInterface.easy_record(m_state->m_easyHandle, url2.GetHostName().c_str());
   g_curlInterface.easy_release(&m_state->m_easyHandle, NULL);
 
   if (result == CURLE_WRITE_ERROR || result == CURLE_OK)
@@ -1087,7 +1093,7 @@ int CFileCurl::Stat(const CURL& url, struct __stat64* buffer)
   }
 
   CURLcode result = g_curlInterface.easy_perform(m_state->m_easyHandle);
-
+  g_curlInterface.easy_record(m_state->m_easyHandle, url2.GetHostName().c_str());
 
   if(result == CURLE_HTTP_RETURNED_ERROR)
   {
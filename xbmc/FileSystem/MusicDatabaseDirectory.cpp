@@ -29,6 +29,10 @@
 #include "TextureManager.h"
 #include "LocalizeStrings.h"
 #include "utils/log.h"
+#include "AdvancedSettings.h"
+#include "utils/TimeUtils.h"
+#include "GUIWindowManager.h"
+#include "GUIDialogMusicScan.h"
 
 using namespace std;
 using namespace XFILE;
@@ -49,7 +53,15 @@ bool CMusicDatabaseDirectory::GetDirectory(const CStdString& strPath, CFileItemL
   if (!pNode.get())
     return false;
 
+  unsigned int time = CTimeUtils::GetTimeMS();
   bool bResult = pNode->GetChilds(items);
+  if (g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG)
+  {
+    // listings share the database with the scanner, so note whether one was running
+    CGUIDialogMusicScan* dialog = (CGUIDialogMusicScan*)g_windowManager.GetWindow(WINDOW_DIALOG_MUSIC_SCAN);
+    CLog::Log(LOGDEBUG, "%s - %u items in %u ms for %s%s", __FUNCTION__, (unsigned int)items.Size(),
+              CTimeUtils::GetTimeMS() - time, strPath.c_str(), (dialog && dialog->IsScanning()) ? " (scan running)" : "");
+  }
   for (int i=0;i<items.Size();++i)
   {
     CFileItemPtr item = items[i];
@@ -145,7 +157,7 @@ bool CMusicDatabaseDirectory::GetLabel(const CStdString& strDirectory, CStdStrin
   CDirectoryNode::GetDatabaseInfo(strDirectory, params);
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   // get genre
@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeAlbumCompilations::GetChildType()
 bool CDirectoryNodeAlbumCompilations::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
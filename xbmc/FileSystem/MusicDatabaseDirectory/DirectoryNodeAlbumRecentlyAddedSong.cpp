@@ -33,7 +33,7 @@ CDirectoryNodeAlbumRecentlyAddedSong::CDirectoryNodeAlbumRecentlyAddedSong(const
 bool CDirectoryNodeAlbumRecentlyAddedSong::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
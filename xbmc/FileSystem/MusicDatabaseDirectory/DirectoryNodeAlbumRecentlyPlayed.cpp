@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeAlbumRecentlyPlayed::GetChildType()
 bool CDirectoryNodeAlbumRecentlyPlayed::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   VECALBUMS albums;
@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeAlbumTop100::GetChildType()
 bool CDirectoryNodeAlbumTop100::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   VECALBUMS albums;
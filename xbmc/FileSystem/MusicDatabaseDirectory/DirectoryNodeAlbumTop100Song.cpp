@@ -33,7 +33,7 @@ CDirectoryNodeAlbumTop100Song::CDirectoryNodeAlbumTop100Song(const CStdString& s
 bool CDirectoryNodeAlbumTop100Song::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
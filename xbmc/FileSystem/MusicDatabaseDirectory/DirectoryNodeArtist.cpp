@@ -40,7 +40,7 @@ NODE_TYPE CDirectoryNodeArtist::GetChildType()
 bool CDirectoryNodeArtist::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeGenre::GetChildType()
 bool CDirectoryNodeGenre::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -63,7 +63,7 @@ bool CDirectoryNodeOverview::GetContent(CFileItemList& items)
   vector< pair<int, int> > rootItems;
   CMusicDatabase musicDatabase;
   bool showSingles = false;
-  if (musicDatabase.Open())
+  if (musicDatabase.OpenReadOnly())
   {
     if (musicDatabase.GetSongsCount("where idAlbum in (select idAlbum from album where strAlbum='')") > 0)
       showSingles = true;
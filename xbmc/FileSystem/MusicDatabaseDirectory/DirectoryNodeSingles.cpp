@@ -34,7 +34,7 @@ CDirectoryNodeSingles::CDirectoryNodeSingles(const CStdString& strName, CDirecto
 bool CDirectoryNodeSingles::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
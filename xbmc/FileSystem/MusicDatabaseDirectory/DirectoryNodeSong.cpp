@@ -34,7 +34,7 @@ CDirectoryNodeSong::CDirectoryNodeSong(const CStdString& strName, CDirectoryNode
 bool CDirectoryNodeSong::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -33,7 +33,7 @@ CDirectoryNodeSongTop100::CDirectoryNodeSongTop100(const CStdString& strName, CD
 bool CDirectoryNodeSongTop100::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
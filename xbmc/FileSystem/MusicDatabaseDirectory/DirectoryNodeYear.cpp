@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeYear::GetChildType()
 bool CDirectoryNodeYear::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeYearAlbum::GetChildType()
 bool CDirectoryNodeYearAlbum::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -34,7 +34,7 @@ CDirectoryNodeYearSong::CDirectoryNodeYearSong(const CStdString& strName, CDirec
 bool CDirectoryNodeYearSong::GetContent(CFileItemList& items)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -50,7 +50,7 @@ bool CMusicSearchDirectory::GetDirectory(const CStdString& strPath, CFileItemLis
   items.m_strPath = strPath;
   unsigned int time = CTimeUtils::GetTimeMS();
   CMusicDatabase db;
-  db.Open();
+  db.OpenReadOnly();
   db.Search(search, items);
   db.Close();
   CLog::Log(LOGDEBUG, "%s (%s) took %u ms",
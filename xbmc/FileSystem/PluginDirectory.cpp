@@ -22,6 +22,7 @@
 
 #include "system.h"
 #include "PluginDirectory.h"
+#include "PluginResultCache.h"
 #include "Util.h"
 #include "addons/AddonManager.h"
 #include "addons/IAddon.h"
@@ -39,6 +40,9 @@
 #include "utils/TimeUtils.h"
 #include "StringUtils.h"
 #include "Application.h"
+#include "AdvancedSettings.h"
+#include "GUIUserMessages.h"
+#include "utils/JobManager.h"
 
 using namespace XFILE;
 using namespace std;
@@ -47,11 +51,49 @@ using namespace ADDON;
 vector<CPluginDirectory *> CPluginDirectory::globalHandles;
 CCriticalSection CPluginDirectory::m_handleLock;
 
+namespace XFILE
+{
+  /*!
+   \brief Re-runs a plugin in the background to refresh a stale cached listing
+   */
+  class CPluginRefreshJob : public CJob
+  {
+  public:
+    CPluginRefreshJob(const CStdString &strPath, const CStdString &cacheKey)
+      : m_strPath(strPath), m_cacheKey(cacheKey) {}
+
+    virtual bool DoWork()
+    {
+      CPluginDirectory dir;
+      dir.m_background = true;
+      bool success = dir.StartScript(m_strPath, true);
+      if (success && dir.m_cacheTTL)
+      {
+        CPluginResultCache::Get().Store(m_cacheKey, *dir.m_listItems, dir.m_cacheTTL);
+
+        // let the window showing this listing pick up the new one
+        CGUIMessage message(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE_PATH);
+        message.SetStringParam(m_strPath);
+        g_windowManager.SendThreadMessage(message);
+      }
+      CPluginResultCache::Get().EndRefresh(m_cacheKey);
+      return success;
+    }
+    virtual const char *GetType() const { return "pluginrefresh"; };
+
+  private:
+    CStdString m_strPath;
+    CStdString m_cacheKey;
+  };
+}
+
 CPluginDirectory::CPluginDirectory()
 {
   m_fetchComplete = CreateEvent(NULL, false, false, NULL);
   m_listItems = new CFileItemList;
   m_fileResult = new CFileItem;
+  m_background = false;
+  m_cacheTTL = 0;
 }
 
 CPluginDirectory::~CPluginDirectory(void)
@@ -105,6 +147,8 @@ bool CPluginDirectory::StartScript(const CStdString& strPath, bool retrievingDir
   m_cancelled = false;
   m_success = false;
   m_totalItems = 0;
+  m_cacheTTL = 0;
+  m_startTime = CTimeUtils::GetTimeMS();
 
   // setup our parameters to send the script
   CStdString strHandle;
@@ -119,7 +163,7 @@ bool CPluginDirectory::StartScript(const CStdString& strPath, bool retrievingDir
   bool success = false;
 #ifdef HAS_PYTHON
   CStdString file = m_addon->LibPath();
-  if (g_pythonParser.evalFile(file, argv) >= 0)
+  if (g_pythonParser.evalFilePooled(file, argv, g_advancedSettings.GetPythonIdleTimeout(m_addon->ID())) >= 0)
   { // wait for our script to finish
     CStdString scriptName = m_addon->Name();
     success = WaitOnScriptResult(file, scriptName, retrievingDir);
@@ -188,7 +232,7 @@ bool CPluginDirectory::AddItems(int handle, const CFileItemList *items, int tota
   return !dir->m_cancelled;
 }
 
-void CPluginDirectory::EndOfDirectory(int handle, bool success, bool replaceListing, bool cacheToDisc)
+void CPluginDirectory::EndOfDirectory(int handle, bool success, bool replaceListing, bool cacheToDisc, unsigned int cacheTTL)
 {
   CSingleLock lock(m_handleLock);
   if (handle < 0 || handle >= (int)globalHandles.size())
@@ -200,6 +244,7 @@ void CPluginDirectory::EndOfDirectory(int handle, bool success, bool replaceList
 
   // set cache to disc
   dir->m_listItems->SetCacheToDisc(cacheToDisc ? CFileItemList::CACHE_IF_SLOW : CFileItemList::CACHE_NEVER);
+  dir->m_cacheTTL = cacheToDisc ? cacheTTL : 0;
 
   dir->m_success = success;
   dir->m_listItems->SetReplaceListing(replaceListing);
@@ -207,6 +252,9 @@ void CPluginDirectory::EndOfDirectory(int handle, bool success, bool replaceList
   if (!dir->m_listItems->HasSortDetails())
     dir->m_listItems->AddSortMethod(SORT_METHOD_NONE, 552, LABEL_MASKS("%L", "%D"));
 
+  CLog::Log(LOGDEBUG, "%s - %s returned %i items in %u ms", __FUNCTION__, dir->m_addon ? dir->m_addon->ID().c_str() : "plugin",
+            dir->m_listItems->Size(), CTimeUtils::GetTimeMS() - dir->m_startTime);
+
   // set the event to mark that we're done
   SetEvent(dir->m_fetchComplete);
 }
@@ -388,7 +436,27 @@ bool CPluginDirectory::GetDirectory(const CStdString& strPath, CFileItemList& it
 {
   CURL url(strPath);
 
+  // serve the listing from the plugin cache if the plugin allowed it
+  CStdString cacheKey;
+  AddonPtr addon;
+  if (CAddonMgr::Get().GetAddon(url.GetHostName(), addon, ADDON_PLUGIN))
+  {
+    cacheKey = CPluginResultCache::GetKey(strPath, addon);
+    CFileItemList cached;
+    CPluginResultCache::STATE state = CPluginResultCache::Get().Lookup(cacheKey, cached);
+    if (state != CPluginResultCache::MISS)
+    {
+      CLog::Log(LOGDEBUG, "%s - using %s cached listing for %s", __FUNCTION__, state == CPluginResultCache::FRESH ? "fresh" : "stale", strPath.c_str());
+      if (state == CPluginResultCache::STALE && CPluginResultCache::Get().BeginRefresh(cacheKey))
+        CJobManager::GetInstance().AddJob(new CPluginRefreshJob(strPath, cacheKey), NULL);
+      items.Assign(cached, true);
+      return true;
+    }
+  }
+
   bool success = StartScript(strPath, true);
+  if (success && m_cacheTTL && !cacheKey.IsEmpty())
+    CPluginResultCache::Get().Store(cacheKey, *m_listItems, m_cacheTTL);
 
   // append the items to the list
   items.Assign(*m_listItems, true); // true to keep the current items
@@ -472,7 +540,7 @@ bool CPluginDirectory::WaitOnScriptResult(const CStdString &scriptPath, const CS
     }
 
     // check whether we should pop up the progress dialog
-    if (!progressBar && CTimeUtils::GetTimeMS() - startTime > timeBeforeProgressBar)
+    if (!progressBar && !m_background && CTimeUtils::GetTimeMS() - startTime > timeBeforeProgressBar)
     { // loading takes more then 1.5 secs, show a progress dialog
       progressBar = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
 
@@ -50,7 +50,7 @@ public:
   // callbacks from python
   static bool AddItem(int handle, const CFileItem *item, int totalItems);
   static bool AddItems(int handle, const CFileItemList *items, int totalItems);
-  static void EndOfDirectory(int handle, bool success, bool replaceListing, bool cacheToDisc);
+  static void EndOfDirectory(int handle, bool success, bool replaceListing, bool cacheToDisc, unsigned int cacheTTL = 0);
   static void AddSortMethod(int handle, SORT_METHOD sortMethod, const CStdString &label2Mask);
   static CStdString GetSetting(int handle, const CStdString &key);
   static void SetSetting(int handle, const CStdString &key, const CStdString &value);
@@ -60,6 +60,8 @@ public:
   static void SetLabel2(int handle, const CStdString& ident);  
 
 private:
+  friend class CPluginRefreshJob;
+
   ADDON::AddonPtr m_addon;
   bool StartScript(const CStdString& strPath, bool retrievingDir);
   bool WaitOnScriptResult(const CStdString &scriptPath, const CStdString &scriptName, bool retrievingDir);
@@ -76,5 +78,8 @@ private:
   bool          m_cancelled;    // set to true when we are cancelled
   bool          m_success;      // set by script in EndOfDirectory
   int    m_totalItems;   // set by script in AddDirectoryItem
+  unsigned int  m_startTime;    // time the script was started, for timing the listing
+  unsigned int  m_cacheTTL;     // set by script in EndOfDirectory, seconds the listing may be cached for
+  bool          m_background;   // set when refreshing a cached listing, so no progress is shown
 };
 }
@@ -0,0 +1,294 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "PluginResultCache.h"
+#include "FileItem.h"
+#include "FileSystem/File.h"
+#include "FileSystem/Directory.h"
+#include "addons/Addon.h"
+#include "utils/Archive.h"
+#include "utils/SingleLock.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "Util.h"
+#include "tinyXML/tinyxml.h"
+
+using namespace std;
+using namespace XFILE;
+
+// number of listings kept in memory; the rest are only on disc
+#define MAX_CACHED_LISTINGS 20
+// bump whenever the layout of the cache files changes
+#define PLUGIN_CACHE_VERSION 1
+
+CPluginResultCache::CEntry::CEntry()
+{
+  m_items = new CFileItemList;
+  m_expires = 0;
+  m_ttl = 0;
+  m_lastAccess = 0;
+}
+
+CPluginResultCache::CEntry::~CEntry()
+{
+  delete m_items;
+}
+
+CPluginResultCache::CPluginResultCache()
+{
+  m_accessCounter = 0;
+}
+
+CPluginResultCache::~CPluginResultCache()
+{
+  Clear();
+}
+
+CPluginResultCache &CPluginResultCache::Get()
+{
+  static CPluginResultCache sCache;
+  return sCache;
+}
+
+CStdString CPluginResultCache::GetKey(const CStdString &strPath, const ADDON::AddonPtr &addon)
+{
+  XBMC::XBMC_MD5 md5;
+  md5.append(strPath);
+  if (addon)
+  {
+    md5.append(addon->ID());
+    md5.append(addon->Version().str);
+
+    // hash the current value of every setting the add-on declares. HasSettings()
+    // loads them, along with the user's values, on a freshly fetched add-on
+    TiXmlElement *settings = addon->HasSettings() ? addon->GetSettingsXML() : NULL;
+    if (settings)
+    {
+      const TiXmlElement *category = settings->FirstChildElement("category");
+      if (!category)
+        category = settings;
+      while (category)
+      {
+        const TiXmlElement *setting = category->FirstChildElement("setting");
+        while (setting)
+        {
+          const char *id = setting->Attribute("id");
+          if (id)
+          {
+            md5.append(id);
+            md5.append(addon->GetSetting(id));
+          }
+          setting = setting->NextSiblingElement("setting");
+        }
+        category = category->NextSiblingElement("category");
+      }
+    }
+  }
+  CStdString key;
+  md5.getDigest(key);
+  return key;
+}
+
+CPluginResultCache::STATE CPluginResultCache::Lookup(const CStdString &key, CFileItemList &items)
+{
+  CSingleLock lock(m_cs);
+
+  CEntry *entry = NULL;
+  MAPENTRIES::iterator i = m_entries.find(key);
+  if (i != m_entries.end())
+    entry = i->second;
+  else
+  {
+    entry = LoadEntry(key);
+    if (!entry)
+      return MISS;
+    CheckIfFull();
+    m_entries.insert(make_pair(key, entry));
+  }
+
+  time_t now = time(NULL);
+  if (now >= entry->m_expires + (time_t)entry->m_ttl)
+  { // too old to even serve while refreshing
+    CLog::Log(LOGDEBUG, "%s - expired listing for %s", __FUNCTION__, entry->m_items->m_strPath.c_str());
+    CFile::Delete(GetCacheFile(key));
+    delete entry;
+    m_entries.erase(key);
+    return MISS;
+  }
+
+  entry->m_lastAccess = m_accessCounter++;
+  items.Copy(*entry->m_items);
+  return now < entry->m_expires ? FRESH : STALE;
+}
+
+void CPluginResultCache::Store(const CStdString &key, const CFileItemList &items, unsigned int ttl)
+{
+  if (!ttl)
+    return;
+
+  CEntry *entry = new CEntry;
+  entry->m_items->Copy(items);
+  entry->m_ttl = ttl;
+  entry->m_expires = time(NULL) + ttl;
+
+  CFile file;
+  if (file.OpenForWrite(GetCacheFile(key), true))
+  {
+    CArchive ar(&file, CArchive::store);
+    ar << (int)PLUGIN_CACHE_VERSION;
+    ar << (int64_t)entry->m_expires;
+    ar << entry->m_ttl;
+    ar << *entry->m_items;
+    ar.Close();
+    file.Close();
+  }
+
+  CSingleLock lock(m_cs);
+  MAPENTRIES::iterator i = m_entries.find(key);
+  if (i != m_entries.end())
+  {
+    delete i->second;
+    m_entries.erase(i);
+  }
+  else
+    CheckIfFull();
+  entry->m_lastAccess = m_accessCounter++;
+  m_entries.insert(make_pair(key, entry));
+  CLog::Log(LOGDEBUG, "%s - cached %i items of %s for %u seconds", __FUNCTION__, items.Size(), items.m_strPath.c_str(), ttl);
+}
+
+bool CPluginResultCache::BeginRefresh(const CStdString &key)
+{
+  CSingleLock lock(m_cs);
+  return m_refreshing.insert(key).second;
+}
+
+void CPluginResultCache::EndRefresh(const CStdString &key)
+{
+  CSingleLock lock(m_cs);
+  m_refreshing.erase(key);
+}
+
+void CPluginResultCache::Clear()
+{
+  CSingleLock lock(m_cs);
+  for (MAPENTRIES::iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+    delete i->second;
+  m_entries.clear();
+}
+
+void CPluginResultCache::Prune()
+{
+  CFileItemList items;
+  CDirectory::GetDirectory("special://temp/", items, ".fi", false);
+  int deleted = 0;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    if (items[i]->m_bIsFolder || !CUtil::GetFileName(items[i]->m_strPath).Left(7).Equals("plugin-"))
+      continue;
+    if (IsExpired(items[i]->m_strPath))
+    {
+      CFile::Delete(items[i]->m_strPath);
+      deleted++;
+    }
+  }
+  if (deleted)
+    CLog::Log(LOGDEBUG, "%s - deleted %i expired listings", __FUNCTION__, deleted);
+}
+
+bool CPluginResultCache::IsExpired(const CStdString &cacheFile)
+{
+  CFile file;
+  if (!file.Open(cacheFile))
+    return false;
+
+  // only the header is read, files of another version are never served
+  CArchive ar(&file, CArchive::load);
+  int version = 0;
+  int64_t expires = 0;
+  unsigned int ttl = 0;
+  ar >> version;
+  if (version == PLUGIN_CACHE_VERSION)
+  {
+    ar >> expires;
+    ar >> ttl;
+  }
+  ar.Close();
+  file.Close();
+
+  return version != PLUGIN_CACHE_VERSION || time(NULL) >= (time_t)expires + (time_t)ttl;
+}
+
+CStdString CPluginResultCache::GetCacheFile(const CStdString &key) const
+{
+  CStdString cacheFile;
+  cacheFile.Format("special://temp/plugin-%s.fi", key.c_str());
+  return cacheFile;
+}
+
+CPluginResultCache::CEntry *CPluginResultCache::LoadEntry(const CStdString &key) const
+{
+  CFile file;
+  if (!file.Open(GetCacheFile(key)))
+    return NULL;
+
+  CEntry *entry = new CEntry;
+  CArchive ar(&file, CArchive::load);
+  int version = 0;
+  ar >> version;
+  if (version == PLUGIN_CACHE_VERSION)
+  {
+    int64_t expires = 0;
+    ar >> expires;
+    ar >> entry->m_ttl;
+    ar >> *entry->m_items;
+    entry->m_expires = (time_t)expires;
+  }
+  ar.Close();
+  file.Close();
+
+  if (version != PLUGIN_CACHE_VERSION)
+  {
+    delete entry;
+    return NULL;
+  }
+  return entry;
+}
+
+void CPluginResultCache::CheckIfFull()
+{
+  // must be called with m_cs held
+  if (m_entries.size() < MAX_CACHED_LISTINGS)
+    return;
+
+  // drop the least recently used listing from memory - it stays on disc
+  MAPENTRIES::iterator oldest = m_entries.end();
+  for (MAPENTRIES::iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+  {
+    if (oldest == m_entries.end() || i->second->m_lastAccess < oldest->second->m_lastAccess)
+      oldest = i;
+  }
+  if (oldest != m_entries.end())
+  {
+    delete oldest->second;
+    m_entries.erase(oldest);
+  }
+}
@@ -0,0 +1,114 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include "utils/CriticalSection.h"
+#include "addons/IAddon.h"
+
+#include <map>
+#include <set>
+
+class CFileItemList;
+
+namespace XFILE
+{
+  /*!
+   \brief Cache of plugin directory listings
+
+   Plugins opt in to the cache by passing a cacheTTL to xbmcplugin.endOfDirectory (with cacheToDisc
+   left on). Listings are keyed on the plugin url, the add-on version and the add-on's settings, so
+   updating the add-on or changing its settings never serves an old listing. The full list is kept,
+   including the sort methods and content type the plugin set.
+
+   Once a listing is older than its TTL it is considered stale: it is still served for another TTL,
+   but the caller is expected to refresh it in the background (see BeginRefresh/EndRefresh).
+   */
+  class CPluginResultCache
+  {
+  public:
+    enum STATE { MISS = 0, FRESH, STALE };
+
+    static CPluginResultCache &Get();
+
+    /*! \brief Build the cache key for a plugin url
+     \param strPath the plugin:// url being listed
+     \param addon the plugin add-on
+     \return the key to use for Lookup/Store
+     */
+    static CStdString GetKey(const CStdString &strPath, const ADDON::AddonPtr &addon);
+
+    /*! \brief Fetch a cached listing
+     \param key the key from GetKey
+     \param items [out] the cached listing, if any
+     \return MISS if there is no usable listing, FRESH if within its TTL, STALE if it should be refreshed
+     */
+    STATE Lookup(const CStdString &key, CFileItemList &items);
+
+    /*! \brief Cache a listing
+     \param key the key from GetKey
+     \param items the listing to cache
+     \param ttl time in seconds the listing is fresh for
+     */
+    void Store(const CStdString &key, const CFileItemList &items, unsigned int ttl);
+
+    /*! \brief Claim the background refresh of a stale listing
+     \return true if the caller should refresh, false if a refresh is already running
+     \sa EndRefresh
+     */
+    bool BeginRefresh(const CStdString &key);
+    void EndRefresh(const CStdString &key);
+
+    void Clear();
+
+    /*! \brief Delete the cache files of listings that have expired.
+     Listings are only deleted from disc when they are looked up after they expire, and keys change with
+     the add-on version and settings, so files nobody asks for again are removed here. Called at startup.
+     */
+    void Prune();
+
+  private:
+    CPluginResultCache();
+    ~CPluginResultCache();
+
+    class CEntry
+    {
+    public:
+      CEntry();
+      ~CEntry();
+      CFileItemList *m_items;
+      time_t         m_expires;
+      unsigned int   m_ttl;
+      unsigned int   m_lastAccess;
+    };
+
+    CStdString GetCacheFile(const CStdString &key) const;
+    CEntry *LoadEntry(const CStdString &key) const;
+    static bool IsExpired(const CStdString &cacheFile);
+    void CheckIfFull();
+
+    typedef std::map<CStdString, CEntry*> MAPENTRIES;
+    MAPENTRIES m_entries;
+    std::set<CStdString> m_refreshing;
+    unsigned int m_accessCounter;
+    CCriticalSection m_cs;
+  };
+}
@@ -27,6 +27,7 @@
 #include "FileSystem/Directory.h"
 #include "FileSystem/File.h"
 #include "FileItem.h"
+#include "utils/TimeUtils.h"
 
 namespace XFILE
 {
@@ -41,6 +42,7 @@ namespace XFILE
   bool CSmartPlaylistDirectory::GetDirectory(const CStdString& strPath, CFileItemList& items)
   {
     // Load in the SmartPlaylist and get the WHERE query
+    unsigned int time = CTimeUtils::GetTimeMS();
     CSmartPlaylist playlist;
     if (!playlist.Load(strPath))
       return false;
@@ -89,7 +91,7 @@ namespace XFILE
       if (playlist.GetType().Equals("mixed"))
         playlist.SetType("songs");
 
-      CStdString whereOrder = playlist.GetWhereClause(db) + " " + playlist.GetOrderClause(db);
+      CStdString whereOrder = db.GetSongsWhereClause(playlist) + " " + playlist.GetOrderClause(db);
       success = db.GetSongsByWhere("", whereOrder, items);
       items.SetContent("songs");
       db.Close();
@@ -117,6 +119,7 @@ namespace XFILE
       CFileItemPtr item = items[i];
       item->m_iprogramCount = i;  // hack for playlist order
     }
+    CLog::Log(LOGDEBUG, "%s - listed %i items of %s in %u ms", __FUNCTION__, items.Size(), strPath.c_str(), CTimeUtils::GetTimeMS() - time);
     if (playlist.GetType().Equals("mixed"))
       return success || success2;
     else if (playlist.GetType().Equals("musicvideos"))
@@ -134,12 +137,7 @@ namespace XFILE
   CStdString CSmartPlaylistDirectory::GetPlaylistByName(const CStdString& name, const CStdString& playlistType)
   {
     CFileItemList list;
-    bool filesExist = false;
-    if (playlistType == "songs" || playlistType == "albums")
-      filesExist = CDirectory::GetDirectory("special://musicplaylists/", list, "*.xsp");
-    else // all others are video
-      filesExist = CDirectory::GetDirectory("special://videoplaylists/", list, "*.xsp");
-    if (filesExist)
+    if (CDirectory::GetDirectory(GetPlaylistFolder(playlistType), list, "*.xsp"))
     {
       for (int i = 0; i < list.Size(); i++)
       {
@@ -153,6 +151,14 @@ namespace XFILE
     return "";
   }
 
+  CStdString CSmartPlaylistDirectory::GetPlaylistFolder(const CStdString& playlistType)
+  {
+    if (playlistType == "songs" || playlistType == "albums")
+      return "special://musicplaylists/";
+    // all others are video
+    return "special://videoplaylists/";
+  }
+
   bool CSmartPlaylistDirectory::Remove(const char *strPath)
   {
     return XFILE::CFile::Delete(strPath);
@@ -36,5 +36,6 @@ namespace XFILE
     virtual bool Remove(const char *strPath);
 
     static CStdString GetPlaylistByName(const CStdString& name, const CStdString& playlistType);
+    static CStdString GetPlaylistFolder(const CStdString& playlistType);
   };
 }
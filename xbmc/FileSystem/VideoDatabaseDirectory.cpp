@@ -30,6 +30,10 @@
 #include "Crc32.h"
 #include "LocalizeStrings.h"
 #include "utils/log.h"
+#include "AdvancedSettings.h"
+#include "utils/TimeUtils.h"
+#include "GUIWindowManager.h"
+#include "GUIDialogVideoScan.h"
 
 using namespace std;
 using namespace XFILE;
@@ -50,7 +54,15 @@ bool CVideoDatabaseDirectory::GetDirectory(const CStdString& strPath, CFileItemL
   if (!pNode.get())
     return false;
 
+  unsigned int time = CTimeUtils::GetTimeMS();
   bool bResult = pNode->GetChilds(items);
+  if (g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG)
+  {
+    // listings share the database with the scanner, so note whether one was running
+    CGUIDialogVideoScan* dialog = (CGUIDialogVideoScan*)g_windowManager.GetWindow(WINDOW_DIALOG_VIDEO_SCAN);
+    CLog::Log(LOGDEBUG, "%s - %u items in %u ms for %s%s", __FUNCTION__, (unsigned int)items.Size(),
+              CTimeUtils::GetTimeMS() - time, strPath.c_str(), (dialog && dialog->IsScanning()) ? " (scan running)" : "");
+  }
   for (int i=0;i<items.Size();++i)
   {
     CFileItemPtr item = items[i];
@@ -144,7 +156,7 @@ bool CVideoDatabaseDirectory::GetLabel(const CStdString& strDirectory, CStdStrin
   CDirectoryNode::GetDatabaseInfo(strDirectory, params);
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   // get genre
@@ -34,7 +34,7 @@ CDirectoryNodeEpisodes::CDirectoryNodeEpisodes(const CStdString& strName, CDirec
 bool CDirectoryNodeEpisodes::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
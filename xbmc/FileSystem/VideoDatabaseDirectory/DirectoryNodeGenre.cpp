@@ -46,7 +46,7 @@ NODE_TYPE CDirectoryNodeGenre::GetChildType()
 bool CDirectoryNodeGenre::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
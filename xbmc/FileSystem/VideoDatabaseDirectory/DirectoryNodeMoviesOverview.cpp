@@ -65,7 +65,7 @@ bool CDirectoryNodeMoviesOverview::GetContent(CFileItemList& items)
   vecRoot.push_back(make_pair("5", 20348));  // Directors
   vecRoot.push_back(make_pair("6", 20388));  // Studios
   CVideoDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
   {
     if (db.HasSets())
       vecRoot.push_back(make_pair("7", 20434));  // Sets
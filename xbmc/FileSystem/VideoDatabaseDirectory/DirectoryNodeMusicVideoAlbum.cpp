@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeMusicVideoAlbum::GetChildType()
 bool CDirectoryNodeMusicVideoAlbum::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
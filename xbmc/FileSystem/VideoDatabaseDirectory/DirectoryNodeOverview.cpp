@@ -56,7 +56,7 @@ NODE_TYPE CDirectoryNodeOverview::GetChildType()
 bool CDirectoryNodeOverview::GetContent(CFileItemList& items)
 {
   CVideoDatabase database;
-  database.Open();
+  database.OpenReadOnly();
   bool hasMovies = database.HasContent(VIDEODB_CONTENT_MOVIES);
   bool hasTvShows = database.HasContent(VIDEODB_CONTENT_TVSHOWS);
   bool hasMusicVideos = database.HasContent(VIDEODB_CONTENT_MUSICVIDEOS);
@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeRecentlyAddedEpisodes::GetChildType()
 bool CDirectoryNodeRecentlyAddedEpisodes::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeRecentlyAddedMovies::GetChildType()
 bool CDirectoryNodeRecentlyAddedMovies::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
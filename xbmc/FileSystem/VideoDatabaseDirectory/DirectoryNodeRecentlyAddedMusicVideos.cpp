@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeRecentlyAddedMusicVideos::GetChildType()
 bool CDirectoryNodeRecentlyAddedMusicVideos::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CStdString strBaseDir=BuildPath();
@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeSeasons::GetChildType()
 bool CDirectoryNodeSeasons::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -41,7 +41,7 @@ NODE_TYPE CDirectoryNodeSets::GetChildType()
 bool CDirectoryNodeSets::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -46,7 +46,7 @@ NODE_TYPE CDirectoryNodeStudio::GetChildType()
 bool CDirectoryNodeStudio::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
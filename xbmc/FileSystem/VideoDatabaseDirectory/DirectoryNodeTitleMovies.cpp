@@ -34,7 +34,7 @@ CDirectoryNodeTitleMovies::CDirectoryNodeTitleMovies(const CStdString& strName,
 bool CDirectoryNodeTitleMovies::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
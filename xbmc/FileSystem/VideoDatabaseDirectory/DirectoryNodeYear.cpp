@@ -46,7 +46,7 @@ NODE_TYPE CDirectoryNodeYear::GetChildType()
 bool CDirectoryNodeYear::GetContent(CFileItemList& items)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -23,7 +23,6 @@
 #include "FlacTag.h"
 #include "Util.h"
 #include "Picture.h"
-#include "FileSystem/File.h"
 #include "utils/log.h"
 #include "utils/EndianSwap.h"
 
@@ -49,12 +48,11 @@ bool CFlacTag::Read(const CStdString& strFile)
 {
   CVorbisTag::Read(strFile);
 
-  CFile file;
-  if (!file.Open(strFile))
+  // the metadata blocks are at the start of the file, so they're normally
+  // all within the head of the file read when it's opened
+  if (!m_reader.Open(strFile))
     return false;
 
-  m_file = &file;
-
   // format is:
   // fLaC METABLOCK ... METABLOCK
   // METABLOCK has format:
@@ -65,33 +63,30 @@ bool CFlacTag::Read(const CStdString& strFile)
   // first find our FLAC header
   int iPos = ReadFlacHeader(); // position in the file
   if (!iPos) return false;
-  // Find vorbis header
-  m_file->Seek(iPos, SEEK_SET); // past the fLaC header and STREAMINFO buffer (compulsory)
+  // Find vorbis header, past the fLaC header and STREAMINFO buffer (compulsory)
   // see what type it is:
   bool foundTag = false;
   unsigned int cover = 0;
   unsigned int second_cover = 0;
   unsigned int third_cover = 0;
-  do
+  while (iPos + 4 <= m_reader.GetLength())
   {
-    unsigned int metaBlock = ReadUnsigned();
+    unsigned int metaBlock = m_reader.ReadUnsignedBE(iPos);
     if ((metaBlock & 0x7F000000) == 0x4000000) // found a VORBIS_COMMENT tag
-    { // read it in
+    { // parse it straight from the buffer
       unsigned int size = (metaBlock & 0xffffff);
-      char *tag = new char[size];
+      const char *tag = m_reader.GetData(iPos + 4, size);
       if (tag)
       {
-        m_file->Read((void*)tag, size);
         // Process this tag info
         ProcessVorbisComment(tag,size);
         foundTag = true;
-        delete[] tag;
       }
     }
     else if ((metaBlock & 0x7F000000) == 0x6000000) // found a PICTURE tag - see if it's the cover
     {
-      // read the type of the image
-      unsigned int picType = ReadUnsigned();
+      // read the type of the image, the image itself is only read if it's needed
+      unsigned int picType = m_reader.ReadUnsignedBE(iPos + 4);
       if (picType == 3 && !cover)  // 3 == Cover (front)
         cover = iPos + 8;
       else if (picType == 0 && !second_cover) // 0 == Other
@@ -99,12 +94,10 @@ bool CFlacTag::Read(const CStdString& strFile)
       else
         third_cover = iPos + 8;
     }
-    else if (metaBlock & 0x80000000)  // break if it's the last one
+    if (metaBlock & 0x80000000)  // break if it's the last one
       break;
     iPos += (metaBlock & 0xffffff) + 4;
-    m_file->Seek(iPos, SEEK_SET);
   }
-  while (true);
 
   if (!cover)
     cover = second_cover;
@@ -119,37 +112,30 @@ bool CFlacTag::Read(const CStdString& strFile)
 
   if (cover && !CUtil::ThumbExists(strCoverArt))
   {
-    char info[1024];
-    m_file->Seek(cover, SEEK_SET);
+    int64_t pos = cover;
 
     // read the mime type
-    unsigned int size = ReadUnsigned();
-    m_file->Read(info, min(size, (unsigned int) 1023));
-    info[min(size, (unsigned int) 1023)] = 0;
-    if (size > 1023)
-      m_file->Seek(size - 1023, SEEK_CUR);
-    CStdString mimeType = info;
-
-    // now the description
-    size = ReadUnsigned();
-    m_file->Read(info, min(size, (unsigned int) 1023));
-    info[min(size, (unsigned int) 1023)] = 0;
-    if (size > 1023)
-      m_file->Seek(size - 1023, SEEK_CUR);
+    unsigned int size = m_reader.ReadUnsignedBE(pos);
+    const char *info = m_reader.GetData(pos + 4, min(size, (unsigned int) 1023));
+    CStdString mimeType;
+    if (info)
+      mimeType.assign(info, min(size, (unsigned int) 1023));
+    pos += size + 4;
+
+    // skip the description
+    size = m_reader.ReadUnsignedBE(pos);
+    pos += size + 4;
 
     int nPos = mimeType.Find('/');
     if (nPos > -1)
       mimeType.Delete(0, nPos + 1);
 
-    // and now our actual image info
-    unsigned int picInfo[4];
-    m_file->Read(picInfo, 16);
-
-    unsigned int picSize = ReadUnsigned();
-    BYTE *picData = new BYTE[picSize];
+    // skip width, height, depth and colours, and on to our actual image
+    pos += 16;
+    unsigned int picSize = m_reader.ReadUnsignedBE(pos);
+    const BYTE *picData = (const BYTE *)m_reader.GetData(pos + 4, picSize);
     if (picData)
     {
-      m_file->Read(picData, picSize);
       if (CPicture::CreateThumbnailFromMemory(picData, picSize, mimeType, strCoverArt))
       {
         CUtil::ThumbCacheAdd(strCoverArt, true);
@@ -159,29 +145,28 @@ bool CFlacTag::Read(const CStdString& strFile)
         CUtil::ThumbCacheAdd(strCoverArt, false);
         CLog::Log(LOGERROR, "%s Unable to create album art for %s (extension=%s, size=%d)", __FUNCTION__, m_musicInfoTag.GetURL().c_str(), mimeType.c_str(), picSize);
       }
-      delete[] picData;
     }
   }
+  m_reader.Close();
   return foundTag;
 }
 
 // read the duration information from the STREAM_INFO metadata block
 int CFlacTag::ReadFlacHeader(void)
 {
-  unsigned char buffer[8];
   // Check to see if we have a STREAM_INFO header:
   int iPos = FindFlacHeader();
   if (!iPos) return 0;
   // Okay, we have found the correct start of a fLaC file
-  m_file->Seek(iPos, SEEK_SET);  // seek to right after the "fLaC" header string
-  m_file->Read(buffer, 4);    // read the header bit
-  if ((buffer[0]&0x7F) != 0) return 0; // no Flac header details at all!
+  const unsigned char *buffer = (const unsigned char *)m_reader.GetData(iPos, 4); // the header bit
+  if (!buffer || (buffer[0]&0x7F) != 0) return 0; // no Flac header details at all!
   // get details out of the stream
-  m_file->Seek(iPos + 14, SEEK_SET);  // seek to the frequency and duration data
-  m_file->Read(buffer, 8);    // read 64 bits of data
+  buffer = (const unsigned char *)m_reader.GetData(iPos + 14, 8); // the frequency and duration data
+  if (!buffer) return 0;
   int iFreq = (buffer[0] << 12) | (buffer[1] << 4) | (buffer[2] >> 4);
   int64_t iNumSamples = ( (int64_t) (buffer[3] & 0x0F) << 32) | ( (int64_t) buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7];
-  m_musicInfoTag.SetDuration((int)((iNumSamples) / iFreq));
+  if (iFreq)
+    m_musicInfoTag.SetDuration((int)((iNumSamples) / iFreq));
   return iPos + 38;
 }
 
@@ -193,39 +178,40 @@ int CFlacTag::ReadFlacHeader(void)
 
 int CFlacTag::FindFlacHeader(void)
 {
-  char tag[BYTES_TO_CHECK_FOR_BAD_TAGS];
-  m_file->Read( (void*) tag, BYTES_TO_CHECK_FOR_BAD_TAGS );
-
-  // Find flac header "fLaC"
-  int i = 0;
-  while ( i < BYTES_TO_CHECK_FOR_BAD_TAGS )
-  {
-    if ( tag[i] == 'f' && tag[i + 1] == 'L' && tag[i + 2] == 'a' && tag[i + 3] == 'C')
-    {
-      return i + 4;
-    }
-    i++;
-  }
-
-  return 0;
+  int64_t iPos = m_reader.Find(0, BYTES_TO_CHECK_FOR_BAD_TAGS, "fLaC", 4);
+  if (iPos < 0)
+    return 0;
+  return (int)iPos + 4;
 }
 
 void CFlacTag::ProcessVorbisComment(const char *pBuffer, size_t bufsize)
 {
   unsigned int Pos = 0;      // position in the buffer
+  if (bufsize < 8)
+    return;
   unsigned int I1 = Endian_SwapLE32(*(unsigned int*)(pBuffer + Pos)); // length of vendor string
+  if (I1 > bufsize - 8)
+  {
+    CLog::Log(LOGWARNING,"flac tag overflow");
+    return;
+  }
   Pos += I1 + 4;     // just pass the vendor string
   unsigned int Count = Endian_SwapLE32(*(unsigned int*)(pBuffer + Pos)); // number of comments
   Pos += 4;    // Start of the first comment
   char C1[CHUNK_SIZE];
   for (unsigned int I2 = 0; I2 < Count; I2++) // Run through the comments
   {
-    if (Pos >= bufsize)
+    if (Pos + 4 > bufsize)
     {
       CLog::Log(LOGWARNING,"flac tag overflow");
       return;
     }
     I1 = Endian_SwapLE32(*(unsigned int*)(pBuffer + Pos));   // Length of comment
+    if (I1 > bufsize - Pos - 4)
+    {
+      CLog::Log(LOGWARNING,"flac tag overflow");
+      return;
+    }
     if (I1 < CHUNK_SIZE)
     {
       strncpy(C1, pBuffer + Pos + 4, I1);
@@ -239,11 +225,3 @@ void CFlacTag::ProcessVorbisComment(const char *pBuffer, size_t bufsize)
     Pos += I1 + 4;
   }
 }
-
-unsigned int CFlacTag::ReadUnsigned()
-{
-  unsigned char size[4];
-  m_file->Read(size, 4);
-  return ((unsigned int)size[0] << 24) + ((unsigned int)size[1] << 16) + ((unsigned int)size[2] << 8) + (unsigned int)size[3];
-}
-
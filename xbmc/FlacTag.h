@@ -26,6 +26,7 @@
 // CFlacTag in 2003 by JMarshall
 //------------------------------
 #include "VorbisTag.h"
+#include "TagFileReader.h"
 
 namespace MUSIC_INFO
 {
@@ -40,11 +41,10 @@ public:
   virtual bool Read(const CStdString& strFile);
 
 protected:
-  XFILE::CFile* m_file;
+  CTagFileReader m_reader;
   void ProcessVorbisComment(const char *pBuffer, size_t bufsize);
   int ReadFlacHeader(void);    // returns the position after the STREAM_INFO metadata
   int FindFlacHeader(void);    // returns the offset in the file of the fLaC data
-  unsigned int ReadUnsigned();  // reads a 32 bit unsigned int
 };
 }
 
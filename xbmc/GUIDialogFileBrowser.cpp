@@ -489,6 +489,12 @@ void CGUIDialogFileBrowser::FrameMove()
       CONTROL_DISABLE(CONTROL_FLIP);
     }
   }
+
+  // load the thumbs of the images in view first
+  int first, last;
+  if (m_browsingForImages && m_viewControl.GetVisibleRange(first, last))
+    m_thumbLoader.SetVisibleRange(first, last);
+
   CGUIDialog::FrameMove();
 }
 
@@ -173,6 +173,17 @@ int CGUIViewControl::GetSelectedItem() const
   return GetSelectedItem(m_visibleViews[m_currentView]);
 }
 
+bool CGUIViewControl::GetVisibleRange(int &first, int &last) const
+{
+  if (m_currentView < 0 || m_currentView >= (int)m_visibleViews.size())
+    return false; // no valid current view!
+
+  const CGUIControl *view = m_visibleViews[m_currentView];
+  if (!view->IsContainer())
+    return false;
+  return ((const CGUIBaseContainer *)view)->GetVisibleRange(first, last);
+}
+
 void CGUIViewControl::SetSelectedItem(int item)
 {
   if (!m_fileItems || item < 0 || item >= m_fileItems->Size())
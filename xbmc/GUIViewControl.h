@@ -53,6 +53,12 @@ public:
 
   int GetCurrentControl() const;
 
+  /*! \brief Get the range of items in view in the current view control.
+   \return false if the current view isn't a container or has nothing in view
+   \sa CGUIBaseContainer::GetVisibleRange
+   */
+  bool GetVisibleRange(int &first, int &last) const;
+
   void Clear();
 
 protected:
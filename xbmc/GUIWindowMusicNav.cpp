@@ -782,6 +782,12 @@ void CGUIWindowMusicNav::FrameMove()
     SET_CONTROL_LABEL(CONTROL_LABELEMPTY,g_localizeStrings.Get(745)+'\n'+g_localizeStrings.Get(746));
   else
     SET_CONTROL_LABEL(CONTROL_LABELEMPTY,"");
+
+  // load the thumbs of the items in view first
+  int first, last;
+  if (m_viewControl.GetVisibleRange(first, last))
+    m_thumbLoader.SetVisibleRange(first, last);
+
   CGUIWindowMusicBase::FrameMove();
 }
 
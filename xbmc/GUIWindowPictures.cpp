@@ -62,6 +62,16 @@ CGUIWindowPictures::~CGUIWindowPictures(void)
 {
 }
 
+void CGUIWindowPictures::FrameMove()
+{
+  // load the thumbs of the items in view first
+  int first, last;
+  if (m_viewControl.GetVisibleRange(first, last))
+    m_thumbLoader.SetVisibleRange(first, last);
+
+  CGUIMediaWindow::FrameMove();
+}
+
 bool CGUIWindowPictures::OnMessage(CGUIMessage& message)
 {
   switch ( message.GetMessage() )
@@ -36,6 +36,7 @@ public:
   CGUIWindowPictures(void);
   virtual ~CGUIWindowPictures(void);
   virtual bool OnMessage(CGUIMessage& message);
+  virtual void FrameMove();
 
 protected:
   virtual void OnInfo(int item);
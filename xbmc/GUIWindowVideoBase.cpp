@@ -108,6 +108,16 @@ bool CGUIWindowVideoBase::OnAction(const CAction &action)
   return CGUIMediaWindow::OnAction(action);
 }
 
+void CGUIWindowVideoBase::FrameMove()
+{
+  // load the thumbs of the items in view first
+  int first, last;
+  if (m_viewControl.GetVisibleRange(first, last))
+    m_thumbLoader.SetVisibleRange(first, last);
+
+  CGUIMediaWindow::FrameMove();
+}
+
 bool CGUIWindowVideoBase::OnMessage(CGUIMessage& message)
 {
   switch ( message.GetMessage() )
@@ -425,6 +435,13 @@ bool CGUIWindowVideoBase::ShowIMDB(CFileItem *item, const ScraperPtr &info2)
   {
     bHasInfo = true;
     movieDetails = *item->GetVideoInfoTag();
+    // listings leave out the thumb and fanart urls, which the dialog offers to choose from
+    if (movieDetails.m_iDbId > -1)
+    {
+      m_database.Open();
+      m_database.GetScraperXml(movieDetails, item->m_bIsFolder);
+      m_database.Close();
+    }
   }
   
   bool needsRefresh = false;
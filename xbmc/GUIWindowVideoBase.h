@@ -33,6 +33,7 @@ public:
   virtual ~CGUIWindowVideoBase(void);
   virtual bool OnMessage(CGUIMessage& message);
   virtual bool OnAction(const CAction &action);
+  virtual void FrameMove();
 
   void PlayMovie(const CFileItem *item);
   int  GetResumeItemOffset(const CFileItem *item);
@@ -57,6 +57,7 @@
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 #include "TextureCache.h"
+#include "SmartPlaylist.h"
 #include "addons/AddonInstaller.h"
 
 using namespace std;
@@ -68,10 +69,33 @@ using ADDON::AddonPtr;
 #define RECENTLY_PLAYED_LIMIT 25
 #define MIN_FULL_SEARCH_LENGTH 3
 
+// types of the items in the search index
+#define MUSIC_SEARCH_ARTIST 1
+#define MUSIC_SEARCH_ALBUM  2
+#define MUSIC_SEARCH_SONG   3
+
+// snapshot matches above this many songs are left to the database, as a list of
+// ids that long would take the query past sqlite's limit on its length
+#define MAX_SNAPSHOT_IDS    5000
+
 #ifdef HAS_DVD_DRIVE
 using namespace CDDB;
 #endif
 
+// Only sorts whose order in SQL is the same as CFileItemList::Sort() are pushed down.
+// Text is sorted naturally there ("Track 9" before "Track 10"), and most sorts break ties
+// on other fields (artist by album then track, year by label), which SQL can't reproduce,
+// so those are left to sort the whole listing in memory.
+static const DatabaseSortColumn songSortColumns[] = {
+  { SORT_METHOD_TRACKNUM,    "songview.iTrack",     false },
+  { SORT_METHOD_DURATION,    "songview.iDuration",  false },
+  { SORT_METHOD_NONE,        NULL,                  false }
+};
+
+static const DatabaseSortColumn albumSortColumns[] = {
+  { SORT_METHOD_NONE,        NULL,                  false }
+};
+
 CMusicDatabase::CMusicDatabase(void)
 {
 }
@@ -188,6 +212,8 @@ bool CMusicDatabase::CreateTables()
 
     // Add 'Karaoke' genre
     AddGenre( "Karaoke" );
+
+    CreateSearchIndex();
   }
   catch (...)
   {
@@ -297,6 +323,8 @@ void CMusicDatabase::AddSong(const CSong& song, bool bCheck)
 
       m_pDS->exec(strSQL.c_str());
       idSong = (int)m_pDS->lastinsertid();
+      AddToSearchIndex(MUSIC_SEARCH_SONG, idSong, song.strTitle);
+      CMusicDatabaseSnapshot::Get().Invalidate();
     }
 
     // add extra artists and genres
@@ -363,6 +391,7 @@ int CMusicDatabase::AddAlbum(const CStdString& strAlbum1, int idArtist, const CS
       album.idArtist = idArtist;
       album.strArtist = strArtist;
       m_albumCache.insert(pair<CStdString, CAlbumCache>(album.strAlbum + album.strArtist, album));
+      AddToSearchIndex(MUSIC_SEARCH_ALBUM, album.idAlbum, strAlbum);
       return album.idAlbum;
     }
     else
@@ -476,6 +505,7 @@ int CMusicDatabase::AddArtist(const CStdString& strArtist1)
       m_pDS->exec(strSQL.c_str());
       int idArtist = (int)m_pDS->lastinsertid();
       m_artistCache.insert(pair<CStdString, int>(strArtist1, idArtist));
+      AddToSearchIndex(MUSIC_SEARCH_ARTIST, idArtist, strArtist);
       return idArtist;
     }
     else
@@ -674,13 +704,11 @@ CSong CMusicDatabase::GetSongFromDataset(bool bWithMusicDbPath/*=false*/)
   CSong song;
   song.idSong = m_pDS->fv(song_idSong).get_asInt();
   // get the full artist string
-  song.strArtist = m_pDS->fv(song_strArtist).get_asString();
-  song.strArtist += m_pDS->fv(song_strExtraArtists).get_asString();
+  song.strArtist = InternString(m_pDS->fv(song_strArtist).get_asString() + m_pDS->fv(song_strExtraArtists).get_asString());
   // and the full genre string
-  song.strGenre = m_pDS->fv(song_strGenre).get_asString();
-  song.strGenre += m_pDS->fv(song_strExtraGenres).get_asString();
+  song.strGenre = InternString(m_pDS->fv(song_strGenre).get_asString() + m_pDS->fv(song_strExtraGenres).get_asString());
   // and the rest...
-  song.strAlbum = m_pDS->fv(song_strAlbum).get_asString();
+  song.strAlbum = InternString(m_pDS->fv(song_strAlbum).get_asString());
   song.iTrack = m_pDS->fv(song_iTrack).get_asInt() ;
   song.iDuration = m_pDS->fv(song_iDuration).get_asInt() ;
   song.iYear = m_pDS->fv(song_iYear).get_asInt() ;
@@ -696,7 +724,7 @@ CSong CMusicDatabase::GetSongFromDataset(bool bWithMusicDbPath/*=false*/)
   song.strMusicBrainzTRMID = m_pDS->fv(song_strMusicBrainzTRMID).get_asString();
   song.rating = m_pDS->fv(song_rating).get_asChar();
   song.strComment = m_pDS->fv(song_comment).get_asString();
-  song.strThumb = m_pDS->fv(song_strThumb).get_asString();
+  song.strThumb = InternString(m_pDS->fv(song_strThumb).get_asString());
   song.iKaraokeNumber = m_pDS->fv(song_iKarNumber).get_asInt();
   song.strKaraokeLyrEncoding = m_pDS->fv(song_strKarEncoding).get_asString();
   song.iKaraokeDelay = m_pDS->fv(song_iKarDelay).get_asInt();
@@ -718,39 +746,45 @@ CSong CMusicDatabase::GetSongFromDataset(bool bWithMusicDbPath/*=false*/)
 
 void CMusicDatabase::GetFileItemFromDataset(CFileItem* item, const CStdString& strMusicDBbasePath)
 {
+  // NOTE: the get_text() results are only valid until the next get_text() call, so are
+  //       copied out straight away
   // get the full artist string
-  CStdString strArtist=m_pDS->fv(song_strArtist).get_asString();
-  strArtist += m_pDS->fv(song_strExtraArtists).get_asString();
-  item->GetMusicInfoTag()->SetArtist(strArtist);
+  CStdString strArtist=m_pDS->get_text(song_strArtist);
+  strArtist += m_pDS->get_text(song_strExtraArtists);
+  item->GetMusicInfoTag()->SetArtist(InternString(strArtist));
   // and the full genre string
-  CStdString strGenre = m_pDS->fv(song_strGenre).get_asString();
-  strGenre += m_pDS->fv(song_strExtraGenres).get_asString();
-  item->GetMusicInfoTag()->SetGenre(strGenre);
+  CStdString strGenre = m_pDS->get_text(song_strGenre);
+  strGenre += m_pDS->get_text(song_strExtraGenres);
+  item->GetMusicInfoTag()->SetGenre(InternString(strGenre));
   // and the rest...
-  item->GetMusicInfoTag()->SetAlbum(m_pDS->fv(song_strAlbum).get_asString());
-  item->GetMusicInfoTag()->SetTrackAndDiskNumber(m_pDS->fv(song_iTrack).get_asInt());
-  item->GetMusicInfoTag()->SetDuration(m_pDS->fv(song_iDuration).get_asInt());
-  item->GetMusicInfoTag()->SetDatabaseId(m_pDS->fv(song_idSong).get_asInt());
+  item->GetMusicInfoTag()->SetAlbum(InternString(m_pDS->get_text(song_strAlbum)));
+  item->GetMusicInfoTag()->SetTrackAndDiskNumber(m_pDS->get_int(song_iTrack));
+  item->GetMusicInfoTag()->SetDuration(m_pDS->get_int(song_iDuration));
+  int idSong = m_pDS->get_int(song_idSong);
+  item->GetMusicInfoTag()->SetDatabaseId(idSong);
   SYSTEMTIME stTime;
-  stTime.wYear = (WORD)m_pDS->fv(song_iYear).get_asInt();
+  stTime.wYear = (WORD)m_pDS->get_int(song_iYear);
   item->GetMusicInfoTag()->SetReleaseDate(stTime);
-  item->GetMusicInfoTag()->SetTitle(m_pDS->fv(song_strTitle).get_asString());
-  item->SetLabel(m_pDS->fv(song_strTitle).get_asString());
+  CStdString strTitle = m_pDS->get_text(song_strTitle);
+  item->GetMusicInfoTag()->SetTitle(strTitle);
+  item->SetLabel(strTitle);
   //song.iTimesPlayed = m_pDS->fv(song_iTimesPlayed).get_asInt();
-  item->m_lStartOffset = m_pDS->fv(song_iStartOffset).get_asInt();
-  item->m_lEndOffset = m_pDS->fv(song_iEndOffset).get_asInt();
-  item->GetMusicInfoTag()->SetMusicBrainzTrackID(m_pDS->fv(song_strMusicBrainzTrackID).get_asString());
-  item->GetMusicInfoTag()->SetMusicBrainzArtistID(m_pDS->fv(song_strMusicBrainzArtistID).get_asString());
-  item->GetMusicInfoTag()->SetMusicBrainzAlbumID(m_pDS->fv(song_strMusicBrainzAlbumID).get_asString());
-  item->GetMusicInfoTag()->SetMusicBrainzAlbumArtistID(m_pDS->fv(song_strMusicBrainzAlbumArtistID).get_asString());
-  item->GetMusicInfoTag()->SetMusicBrainzTRMID(m_pDS->fv(song_strMusicBrainzTRMID).get_asString());
+  item->m_lStartOffset = m_pDS->get_int(song_iStartOffset);
+  item->m_lEndOffset = m_pDS->get_int(song_iEndOffset);
+  item->GetMusicInfoTag()->SetMusicBrainzTrackID(m_pDS->get_text(song_strMusicBrainzTrackID));
+  item->GetMusicInfoTag()->SetMusicBrainzArtistID(m_pDS->get_text(song_strMusicBrainzArtistID));
+  item->GetMusicInfoTag()->SetMusicBrainzAlbumID(m_pDS->get_text(song_strMusicBrainzAlbumID));
+  item->GetMusicInfoTag()->SetMusicBrainzAlbumArtistID(m_pDS->get_text(song_strMusicBrainzAlbumArtistID));
+  item->GetMusicInfoTag()->SetMusicBrainzTRMID(m_pDS->get_text(song_strMusicBrainzTRMID));
   item->GetMusicInfoTag()->SetRating(m_pDS->fv(song_rating).get_asChar());
-  item->GetMusicInfoTag()->SetComment(m_pDS->fv(song_comment).get_asString());
+  item->GetMusicInfoTag()->SetComment(m_pDS->get_text(song_comment));
+  CStdString strPath = m_pDS->get_text(song_strPath);
+  CStdString strFileName = m_pDS->get_text(song_strFileName);
   CStdString strRealPath;
-  CUtil::AddFileToFolder(m_pDS->fv(song_strPath).get_asString(), m_pDS->fv(song_strFileName).get_asString(), strRealPath);
+  CUtil::AddFileToFolder(strPath, strFileName, strRealPath);
   item->GetMusicInfoTag()->SetURL(strRealPath);
   item->GetMusicInfoTag()->SetLoaded(true);
-  CStdString strThumb=m_pDS->fv(song_strThumb).get_asString();
+  const CStdString &strThumb = InternString(m_pDS->get_text(song_strThumb));
   if (strThumb != "NONE")
     item->SetThumbnailImage(strThumb);
   // Get filename with full path
@@ -760,9 +794,8 @@ void CMusicDatabase::GetFileItemFromDataset(CFileItem* item, const CStdString& s
   }
   else
   {
-    CStdString strFileName=m_pDS->fv(song_strFileName).get_asString();
     CStdString strExt=CUtil::GetExtension(strFileName);
-    item->m_strPath.Format("%s%ld%s", strMusicDBbasePath.c_str(), m_pDS->fv(song_idSong).get_asInt(), strExt.c_str());
+    item->m_strPath.Format("%s%ld%s", strMusicDBbasePath.c_str(), idSong, strExt.c_str());
   }
 }
 
@@ -958,11 +991,15 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    // Exclude "Various Artists"
-    int idVariousArtist = AddArtist(g_localizeStrings.Get(340));
+    // Exclude "Various Artists". Searches may be on a read only connection, so it's only
+    // looked up - if there is none, nothing is excluded
+    int idVariousArtist = GetArtistByName(g_localizeStrings.Get(340));
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString filter = GetSearchIndexFilter(MUSIC_SEARCH_ARTIST, "idArtist", search);
+    if (!filter.IsEmpty())
+      strSQL = "select * from artist where " + filter + PrepareSQL(" and idArtist <> %i ", idVariousArtist);
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from artist "
                                 "where (strArtist like '%s%%' or strArtist like '%% %s%%') and idArtist <> %i "
                                 , search.c_str(), search.c_str(), idVariousArtist );
@@ -979,6 +1016,7 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
     }
 
     CStdString artistLabel(g_localizeStrings.Get(557)); // Artist
+    CStdString folded = FoldSearchText(search);
     while (!m_pDS->eof())
     {
       CStdString path;
@@ -989,6 +1027,9 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
       pItem->SetLabel(label);
       label.Format("A %s", m_pDS->fv(1).get_asString()); // sort label is stored in the title tag
       pItem->GetMusicInfoTag()->SetTitle(label);
+      pItem->SetProperty("searchtype", "artist");
+      pItem->SetProperty("searchid", m_pDS->fv(0).get_asInt());
+      pItem->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(1).get_asString()));
       pItem->SetCachedArtistThumb();
       artists.Add(pItem);
       m_pDS->next();
@@ -1531,6 +1572,7 @@ bool CMusicDatabase::IncrTop100CounterByFileName(const CStdString& strFileName)
 
     CStdString sql=PrepareSQL("UPDATE song SET iTimesPlayed=iTimesPlayed+1, lastplayed=CURRENT_TIMESTAMP where idSong=%i", idSong);
     m_pDS->exec(sql.c_str());
+    CMusicDatabaseSnapshot::Get().IncrementTimesPlayed(idSong);
     return true;
   }
   catch (...)
@@ -1590,7 +1632,8 @@ void CMusicDatabase::EmptyCache()
 
 bool CMusicDatabase::Search(const CStdString& search, CFileItemList &items)
 {
-  unsigned int time = CTimeUtils::GetTimeMS();
+  unsigned int start = CTimeUtils::GetTimeMS();
+  unsigned int time = start;
   // first grab all the artists that match
   SearchArtists(search, items);
   CLog::Log(LOGDEBUG, "%s Artist search in %i ms",
@@ -1605,6 +1648,10 @@ bool CMusicDatabase::Search(const CStdString& search, CFileItemList &items)
   SearchSongs(search, items);
   CLog::Log(LOGDEBUG, "%s Songs search in %i ms",
             __FUNCTION__, CTimeUtils::GetTimeMS() - time); time = CTimeUtils::GetTimeMS();
+
+  // best matches first, whatever their type
+  SortSearchResults(items);
+  LogSearchTime(__FUNCTION__, search, items.Size(), CTimeUtils::GetTimeMS() - start);
   return true;
 }
 
@@ -1616,7 +1663,10 @@ bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
     if (NULL == m_pDS.get()) return false;
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString filter = GetSearchIndexFilter(MUSIC_SEARCH_SONG, "idSong", search);
+    if (!filter.IsEmpty())
+      strSQL = "select * from songview where " + filter + " limit 1000";
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
@@ -1625,10 +1675,14 @@ bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
     if (m_pDS->num_rows() == 0) return false;
 
     CStdString songLabel = g_localizeStrings.Get(179); // Song
+    CStdString folded = FoldSearchText(search);
     while (!m_pDS->eof())
     {
       CFileItemPtr item(new CFileItem);
       GetFileItemFromDataset(item.get(), "musicdb://4/");
+      item->SetProperty("searchtype", "song");
+      item->SetProperty("searchid", (int)item->GetMusicInfoTag()->GetDatabaseId());
+      item->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(song_strTitle).get_asString()));
       items.Add(item);
       m_pDS->next();
     }
@@ -1652,7 +1706,10 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
     if (NULL == m_pDS.get()) return false;
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString filter = GetSearchIndexFilter(MUSIC_SEARCH_ALBUM, "idAlbum", search);
+    if (!filter.IsEmpty())
+      strSQL = "select * from albumview where " + filter;
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
@@ -1660,6 +1717,7 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
     if (!m_pDS->query(strSQL.c_str())) return false;
 
     CStdString albumLabel(g_localizeStrings.Get(558)); // Album
+    CStdString folded = FoldSearchText(search);
     while (!m_pDS->eof())
     {
       CAlbum album = GetAlbumFromDataset(m_pDS.get());
@@ -1671,6 +1729,9 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
       pItem->SetLabel(label);
       label.Format("B %s", album.strAlbum); // sort label is stored in the title tag
       pItem->GetMusicInfoTag()->SetTitle(label);
+      pItem->SetProperty("searchtype", "album");
+      pItem->SetProperty("searchid", (int)album.idAlbum);
+      pItem->SetProperty("searchscore", GetSearchScore(folded, album.strAlbum));
       albums.Add(pItem);
       m_pDS->next();
     }
@@ -1876,6 +1937,7 @@ bool CMusicDatabase::CleanupSongsByIds(const CStdString &strSongIds)
       strSQL = "delete from karaokedata where idSong in " + strSongsToDelete;
       m_pDS->exec(strSQL.c_str());
       m_pDS->close();
+      CMusicDatabaseSnapshot::Get().Invalidate();
     }
     return true;
   }
@@ -1958,6 +2020,7 @@ bool CMusicDatabase::CleanupAlbums()
     m_pDS->exec(strSQL.c_str());
     strSQL = "delete from exgenrealbum where idAlbum in " + strAlbumIds;
     m_pDS->exec(strSQL.c_str());
+    CMusicDatabaseSnapshot::Get().Invalidate();
     return true;
   }
   catch (...)
@@ -2107,6 +2170,21 @@ bool CMusicDatabase::CleanupGenres()
   return false;
 }
 
+void CMusicDatabase::CleanupSearchIndex()
+{
+  // songs, albums and artists are removed in bulk, so drop whatever they leave behind in the index
+  PruneSearchIndex(MUSIC_SEARCH_SONG, "song", "idSong");
+  PruneSearchIndex(MUSIC_SEARCH_ALBUM, "album", "idAlbum");
+  PruneSearchIndex(MUSIC_SEARCH_ARTIST, "artist", "idArtist");
+}
+
+void CMusicDatabase::PopulateSearchIndex()
+{
+  FillSearchIndex(MUSIC_SEARCH_ARTIST, "select idArtist, strArtist from artist");
+  FillSearchIndex(MUSIC_SEARCH_ALBUM, "select idAlbum, strAlbum from album");
+  FillSearchIndex(MUSIC_SEARCH_SONG, "select idSong, strTitle from song");
+}
+
 bool CMusicDatabase::CleanupOrphanedItems()
 {
   // paths aren't cleaned up here - they're cleaned up in RemoveSongsFromPath()
@@ -2116,6 +2194,7 @@ bool CMusicDatabase::CleanupOrphanedItems()
   if (!CleanupArtists()) return false;
   if (!CleanupGenres()) return false;
   if (!CleanupThumbs()) return false;
+  CleanupSearchIndex();
   return true;
 }
 
@@ -2172,6 +2251,7 @@ int CMusicDatabase::Cleanup(CGUIDialogProgress *pDlgProgress)
     RollbackTransaction();
     return ERROR_REORG_GENRE;
   }
+  CleanupSearchIndex();
   // commit transaction
   pDlgProgress->SetLine(1, 328);
   pDlgProgress->SetPercentage(90);
@@ -2492,6 +2572,22 @@ bool CMusicDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    vector< pair<int, CStdString> > genres;
+    if (GetSnapshot() && CMusicDatabaseSnapshot::Get().GetGenres(genres))
+    {
+      for (vector< pair<int, CStdString> >::const_iterator it = genres.begin(); it != genres.end(); ++it)
+      {
+        CFileItemPtr pItem(new CFileItem(it->second));
+        pItem->GetMusicInfoTag()->SetGenre(it->second);
+        CStdString strDir;
+        strDir.Format("%ld/", it->first);
+        pItem->m_strPath=strBaseDir + strDir;
+        pItem->m_bIsFolder=true;
+        items.Add(pItem);
+      }
+      return !genres.empty();
+    }
+
     // get primary genres for songs
     CStdString strSQL="select * from genre "
                       "where (idGenre IN ("
@@ -2545,6 +2641,24 @@ bool CMusicDatabase::GetYearsNav(const CStdString& strBaseDir, CFileItemList& it
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    vector<int> years;
+    if (GetSnapshot() && CMusicDatabaseSnapshot::Get().GetYears(years))
+    {
+      for (vector<int>::const_iterator it = years.begin(); it != years.end(); ++it)
+      {
+        CStdString strYear;
+        strYear.Format("%i", *it);
+        CFileItemPtr pItem(new CFileItem(strYear));
+        SYSTEMTIME stTime;
+        stTime.wYear = (WORD)*it;
+        pItem->GetMusicInfoTag()->SetReleaseDate(stTime);
+        pItem->m_strPath=strBaseDir + strYear + "/";
+        pItem->m_bIsFolder=true;
+        items.Add(pItem);
+      }
+      return !years.empty();
+    }
+
     // get years from album list
     CStdString strSQL="select distinct iYear from album where iYear <> 0";
 
@@ -2810,15 +2924,8 @@ bool CMusicDatabase::GetAlbumFromSong(const CSong &song, CAlbum &album)
   return false;
 }
 
-bool CMusicDatabase::GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist, int start, int end)
+bool CMusicDatabase::GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist, DatabaseLimits *limits)
 {
-  //Create limit
-  CStdString limit;
-  if (start >= 0 && end >= 0)
-  {
-    limit.Format(" limit %i,%i", start, end);
-  }
-
   // where clause
   CStdString strWhere;
   if (idGenre!=-1)
@@ -2834,7 +2941,7 @@ bool CMusicDatabase::GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& i
                             "join exgenresong on song.idSong=exgenresong.idSong "
                           "where exgenresong.idGenre=%i"
                           ")"
-                        ") " + limit
+                        ") "
                         , idGenre, idGenre);
   }
 
@@ -2866,18 +2973,18 @@ bool CMusicDatabase::GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& i
                               "select exartistalbum.idAlbum from exartistalbum " // All albums where extra album artists fit
                               "where exartistalbum.idArtist=%i"
                             ")"
-                          ") " + limit
+                          ") "
                           , idArtist, idArtist, idArtist, idArtist);
   }
   else
   { // no artist given, so exclude any single albums (aka empty tagged albums)
     if (strWhere.IsEmpty())
-      strWhere += "where albumview.strAlbum <> ''" + limit;
+      strWhere += "where albumview.strAlbum <> ''";
     else
-      strWhere += "and albumview.strAlbum <> ''" + limit;
+      strWhere += "and albumview.strAlbum <> ''";
   }
 
-  bool bResult = GetAlbumsByWhere(strBaseDir, strWhere, "", items);
+  bool bResult = GetAlbumsByWhere(strBaseDir, strWhere, "", items, limits);
   if (bResult && idArtist != -1)
   {
     CStdString strArtist;
@@ -2890,7 +2997,7 @@ bool CMusicDatabase::GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& i
   return bResult;
 }
 
-bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const CStdString &where, const CStdString &order, CFileItemList &items)
+bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const CStdString &where, const CStdString &order, CFileItemList &items, DatabaseLimits *limits)
 {
   if (NULL == m_pDB.get()) return false;
   if (NULL == m_pDS.get()) return false;
@@ -2898,6 +3005,9 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const CStdStrin
   try
   {
     CStdString sql = "select * from albumview " + where + order;
+    CStdString sqlOrder, sqlLimit;
+    if (limits && PrepareLimits("albumview", where, albumSortColumns, "albumview.idAlbum", *limits, sqlOrder, sqlLimit))
+      sql = "select * from albumview " + where + (sqlOrder.IsEmpty() ? order : " " + sqlOrder) + sqlLimit;
 
     // run query
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, sql.c_str());
@@ -2906,7 +3016,8 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const CStdStrin
     if (iRowsFound == 0)
     {
       m_pDS->close();
-      return false;
+      // a page past the end is still a listing, the caller needs its total
+      return limits && limits->total >= 0;
     }
 
     items.Reserve(iRowsFound);
@@ -2942,7 +3053,7 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const CStdStrin
   return false;
 }
 
-bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString &whereClause, CFileItemList &items)
+bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString &whereClause, CFileItemList &items, DatabaseLimits *limits)
 {
   if (NULL == m_pDB.get()) return false;
   if (NULL == m_pDS.get()) return false;
@@ -2952,21 +3063,22 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString
     unsigned int time = CTimeUtils::GetTimeMS();
     // We don't use PrepareSQL here, as the WHERE clause is already formatted.
     CStdString strSQL = "select * from songview " + whereClause;
+    CStdString sqlOrder, sqlLimit;
+    if (limits && PrepareLimits("songview", whereClause, songSortColumns, "songview.idSong", *limits, sqlOrder, sqlLimit))
+      strSQL += " " + sqlOrder + sqlLimit;
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
-    // run query
-    if (!m_pDS->query(strSQL.c_str()))
+    // run query - rows are read from a cursor as we go, rather than all up front
+    if (!m_pDS->query_cursor(strSQL.c_str()))
       return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
+    if (m_pDS->eof())
     {
       m_pDS->close();
-      return false;
+      // a page past the end is still a listing, the caller needs its total
+      return limits && limits->total >= 0;
     }
 
-    // get data from returned rows
-    items.Reserve(items.Size() + iRowsFound);
     // get songs from returned subtable
-    int count = 0;
+    int count = (limits && limits->total >= 0) ? limits->start : 0;
     while (!m_pDS->eof())
     {
       try
@@ -2987,7 +3099,7 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString
     }
     // cleanup
     m_pDS->close();
-    CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, whereClause.c_str(), CTimeUtils::GetTimeMS() - time);
+    LogListingTime(__FUNCTION__, items.Size(), CTimeUtils::GetTimeMS() - time);
     return true;
   }
   catch (...)
@@ -3005,7 +3117,7 @@ bool CMusicDatabase::GetSongsByYear(const CStdString& baseDir, CFileItemList& it
   return GetSongsByWhere(baseDir, where, items);
 }
 
-bool CMusicDatabase::GetSongsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist,int idAlbum)
+bool CMusicDatabase::GetSongsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist,int idAlbum, DatabaseLimits *limits)
 {
   CStdString strWhere;
 
@@ -3060,7 +3172,7 @@ bool CMusicDatabase::GetSongsNav(const CStdString& strBaseDir, CFileItemList& it
   }
 
   // run query
-  bool bResult = GetSongsByWhere(strBaseDir, strWhere, items);
+  bool bResult = GetSongsByWhere(strBaseDir, strWhere, items, limits);
   if (bResult && idArtist != -1)
   {
     CStdString strArtist;
@@ -3101,6 +3213,12 @@ bool CMusicDatabase::UpdateOldVersion(int version)
       // ensure these scrapers are installed
       CAddonInstaller::InstallFromXBMCRepo(scrapers);
     }
+    if (version < 16)
+    {
+      BeginTransaction();
+      CreateSearchIndex();
+      CommitTransaction();
+    }
   }
   catch (...)
   {
@@ -3188,6 +3306,199 @@ unsigned int CMusicDatabase::GetSongIDs(const CStdString& strWhere, vector<pair<
   return 0;
 }
 
+bool CMusicDatabase::GetSongIDs(const CSmartPlaylist *playlist, vector<pair<int,int> > &songIDs)
+{
+  vector<int> ids;
+  if (!GetSnapshot() || !CMusicDatabaseSnapshot::Get().GetSongIDs(playlist, ids))
+    return false;
+
+  songIDs.clear();
+  songIDs.reserve(ids.size());
+  for (vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    songIDs.push_back(make_pair<int,int>(1, *it));
+  return true;
+}
+
+bool CMusicDatabase::GetSongRatingsAndPlayCounts(const vector<pair<int,int> > &songIDs, vector<int> &ratings, vector<int> &playCounts)
+{
+  if (GetSnapshot() && CMusicDatabaseSnapshot::Get().GetRatingsAndPlayCounts(songIDs, ratings, playCounts))
+    return true;
+
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    // a single pass over the song table is cheaper than looking the songs up one by one
+    if (!m_pDS->query("select idSong, rating, iTimesPlayed from song")) return false;
+    map<int, pair<int,int> > stats;
+    while (!m_pDS->eof())
+    {
+      CStdString rating = m_pDS->fv(1).get_asString();
+      stats[m_pDS->fv(0).get_asInt()] = make_pair(rating.IsEmpty() ? 0 : rating[0] - '0', m_pDS->fv(2).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    ratings.assign(songIDs.size(), 0);
+    playCounts.assign(songIDs.size(), 0);
+    for (unsigned int i = 0; i < songIDs.size(); i++)
+    {
+      map<int, pair<int,int> >::const_iterator it = stats.find(songIDs[i].second);
+      if (songIDs[i].first == 1 && it != stats.end())
+      {
+        ratings[i] = it->second.first;
+        playCounts[i] = it->second.second;
+      }
+    }
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+CStdString CMusicDatabase::GetSongsWhereClause(CSmartPlaylist &playlist)
+{
+  vector<int> ids;
+  if (!playlist.GetRules().empty() && GetSnapshot() && CMusicDatabaseSnapshot::Get().GetSongIDs(&playlist, ids) &&
+      ids.size() <= MAX_SNAPSHOT_IDS)
+  {
+    if (ids.empty())
+      return "where 0";
+    CStdString where = "where songview.idSong in (";
+    for (vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    {
+      CStdString id;
+      id.Format("%i,", *it);
+      where += id;
+    }
+    where[where.size() - 1] = ')';
+    return where;
+  }
+  return playlist.GetWhereClause(*this);
+}
+
+bool CMusicDatabase::GetSnapshot()
+{
+  if (!g_advancedSettings.m_bMusicLibrarySnapshot || !m_sqlite || NULL == m_pDB.get() || NULL == m_pDS.get())
+    return false;
+
+  CStdString database;
+  CUtil::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase(), database);
+  CMusicDatabaseSnapshot &snapshot = CMusicDatabaseSnapshot::Get();
+  if (snapshot.IsCurrent(database))
+    return true;
+
+  // the scanner invalidates the snapshot with every song it adds, so don't rebuild it until it's done
+  CGUIDialogMusicScan* dlgMusicScan = (CGUIDialogMusicScan*)g_windowManager.GetWindow(WINDOW_DIALOG_MUSIC_SCAN);
+  if (InTransaction() || (dlgMusicScan && dlgMusicScan->IsScanning()))
+    return false;
+
+  unsigned int time = CTimeUtils::GetTimeMS();
+  CMusicDatabaseSnapshot::Stamp stamp;
+  if (!GetSnapshotStamp(stamp))
+    return false;
+  if (snapshot.Load(database, stamp))
+  {
+    CLog::Log(LOGDEBUG, "%s - loaded the snapshot of %"PRId64" songs in %u ms", __FUNCTION__, stamp.songs, CTimeUtils::GetTimeMS() - time);
+    return true;
+  }
+
+  CMusicDatabaseSnapshot::Columns columns;
+  if (!FillSnapshot(columns))
+    return false;
+  snapshot.Set(database, stamp, columns);
+  snapshot.Flush();
+  CLog::Log(LOGDEBUG, "%s - built the snapshot of %"PRId64" songs in %u ms", __FUNCTION__, stamp.songs, CTimeUtils::GetTimeMS() - time);
+  return true;
+}
+
+bool CMusicDatabase::GetSnapshotStamp(CMusicDatabaseSnapshot::Stamp &stamp)
+{
+  try
+  {
+    if (!m_pDS->query("select count(*), max(idSong), total(iYear), total(iTimesPlayed), total(rating) from song"))
+      return false;
+    if (!m_pDS->eof())
+    {
+      stamp.songs = m_pDS->fv(0).get_asInt();
+      stamp.maxSong = m_pDS->fv(1).get_asInt();
+      stamp.years = (int64_t)m_pDS->fv(2).get_asDouble();
+      stamp.plays = (int64_t)m_pDS->fv(3).get_asDouble();
+      stamp.ratings = (int64_t)m_pDS->fv(4).get_asDouble();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CMusicDatabase::FillSnapshot(CMusicDatabaseSnapshot::Columns &columns)
+{
+  try
+  {
+    columns.Clear();
+
+    if (!m_pDS->query_cursor("select idSong, idAlbum, idArtist, idGenre, iYear, iDuration, iTrack, iTimesPlayed, rating from song order by idSong"))
+      return false;
+    while (!m_pDS->eof())
+    {
+      columns.idSong.push_back(m_pDS->get_int(0));
+      columns.idAlbum.push_back(m_pDS->get_int(1));
+      columns.idArtist.push_back(m_pDS->get_int(2));
+      columns.idGenre.push_back(m_pDS->get_int(3));
+      columns.year.push_back(m_pDS->get_int(4));
+      columns.duration.push_back(m_pDS->get_int(5));
+      columns.track.push_back(m_pDS->get_int(6));
+      columns.timesPlayed.push_back(m_pDS->get_int(7));
+      char rating = m_pDS->fv(8).get_asChar();
+      columns.rating.push_back(rating >= '0' && rating <= '9' ? rating : '0');
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query_cursor("select idSong, idGenre from exgenresong order by idSong"))
+      return false;
+    while (!m_pDS->eof())
+    {
+      columns.extraGenres.push_back(make_pair(m_pDS->get_int(0), m_pDS->get_int(1)));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select distinct iYear from album where iYear <> 0 order by iYear"))
+      return false;
+    while (!m_pDS->eof())
+    {
+      columns.albumYears.push_back(m_pDS->get_int(0));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select idGenre, strGenre from genre"))
+      return false;
+    while (!m_pDS->eof())
+    {
+      columns.genres[m_pDS->get_int(0)] = m_pDS->fv(1).get_asString();
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
 int CMusicDatabase::GetSongsCount(const CStdString& strWhere)
 {
   try
@@ -3782,6 +4093,7 @@ bool CMusicDatabase::RemoveSongsFromPath(const CStdString &path, CSongMap &songs
       m_pDS->exec(sql.c_str());
       sql = "delete from karaokedata where idSong in " + songIds;
       m_pDS->exec(sql.c_str());
+      CMusicDatabaseSnapshot::Get().Invalidate();
     }
     // and remove the path as well (it'll be re-added later on with the new hash if it's non-empty)
     sql = PrepareSQL("delete from path where strPath like '%s%s'", path.c_str(), (exact?"":"%"));
@@ -3840,6 +4152,7 @@ bool CMusicDatabase::SetSongRating(const CStdString &filePath, char rating)
 
     CStdString sql = PrepareSQL("update song set rating='%c' where idSong = %i", rating, songID);
     m_pDS->exec(sql.c_str());
+    CMusicDatabaseSnapshot::Get().SetRating(songID, rating);
     return true;
   }
   catch (...)
@@ -26,6 +26,7 @@
 #include "Database.h"
 #include "Album.h"
 #include "addons/Scraper.h"
+#include "MusicDatabaseSnapshot.h"
 
 class CArtist;
 class CFileItem;
@@ -158,17 +159,38 @@ public:
   bool GetGenresNav(const CStdString& strBaseDir, CFileItemList& items);
   bool GetYearsNav(const CStdString& strBaseDir, CFileItemList& items);
   bool GetArtistsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, bool albumArtistsOnly);
-  bool GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist, int start, int end);
+  bool GetAlbumsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist, DatabaseLimits *limits = NULL);
   bool GetAlbumsByYear(const CStdString &strBaseDir, CFileItemList& items, int year);
-  bool GetSongsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist,int idAlbum);
+  bool GetSongsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idArtist,int idAlbum, DatabaseLimits *limits = NULL);
   bool GetSongsByYear(const CStdString& baseDir, CFileItemList& items, int year);
-  bool GetSongsByWhere(const CStdString &baseDir, const CStdString &whereClause, CFileItemList& items);
-  bool GetAlbumsByWhere(const CStdString &baseDir, const CStdString &where, const CStdString &order, CFileItemList &items);
+  bool GetSongsByWhere(const CStdString &baseDir, const CStdString &whereClause, CFileItemList& items, DatabaseLimits *limits = NULL);
+  bool GetAlbumsByWhere(const CStdString &baseDir, const CStdString &where, const CStdString &order, CFileItemList &items, DatabaseLimits *limits = NULL);
   bool GetRandomSong(CFileItem* item, int& idSong, const CStdString& strWhere);
   int GetKaraokeSongsCount();
   int GetSongsCount(const CStdString& strWhere = "");
   unsigned int GetSongIDs(const CStdString& strWhere, std::vector<std::pair<int,int> > &songIDs);
 
+  /*! \brief Get the ids of the songs matching a smart playlist, from the library snapshot.
+   \param playlist the playlist, or NULL for all songs
+   \param songIDs [out] the matching songs
+   \return false if the snapshot can't answer, in which case use the SQL where clause of the playlist
+   \sa CMusicDatabaseSnapshot
+   */
+  bool GetSongIDs(const CSmartPlaylist *playlist, std::vector<std::pair<int,int> > &songIDs);
+
+  /*! \brief Get the rating and play count of songs, for weighting random picks.
+   \param songIDs the songs, as returned by GetSongIDs()
+   \param ratings [out] the rating (0-5) of each song, in the order of songIDs
+   \param playCounts [out] the play count of each song, in the order of songIDs
+   */
+  bool GetSongRatingsAndPlayCounts(const std::vector<std::pair<int,int> > &songIDs, std::vector<int> &ratings, std::vector<int> &playCounts);
+
+  /*! \brief Get the where clause selecting the songs of a smart playlist.
+   Lists the matching ids when the library snapshot can evaluate the rules, which saves sqlite
+   joining the genre tables for them. Otherwise the same as CSmartPlaylist::GetWhereClause().
+   */
+  CStdString GetSongsWhereClause(CSmartPlaylist &playlist);
+
   bool GetAlbumPath(int idAlbum, CStdString &path);
   bool SaveAlbumThumb(int idAlbum, const CStdString &thumb);
   bool GetAlbumThumb(int idAlbum, CStdString &thumb);
@@ -214,7 +236,8 @@ protected:
   std::map<CStdString, CAlbumCache> m_albumCache;
 
   virtual bool CreateTables();
-  virtual int GetMinVersion() const { return 15; };
+  virtual int GetMinVersion() const { return 16; };
+  virtual bool UsesSearchIndex() const { return true; };
   const char *GetDefaultDBName() const { return "MyMusic7"; };
 
   int AddAlbum(const CStdString& strAlbum1, int idArtist, const CStdString &extraArtists, const CStdString &strArtist1, int idThumb, int idGenre, const CStdString &extraGenres, int year);
@@ -242,11 +265,20 @@ private:
   bool CleanupArtists();
   bool CleanupGenres();
   virtual bool UpdateOldVersion(int version);
+  virtual void PopulateSearchIndex();
+  void CleanupSearchIndex();
   bool SearchArtists(const CStdString& search, CFileItemList &artists);
   bool SearchAlbums(const CStdString& search, CFileItemList &albums);
   bool SearchSongs(const CStdString& strSearch, CFileItemList &songs);
   int GetSongIDFromPath(const CStdString &filePath);
 
+  /*! \brief Make sure the library snapshot holds this database, loading or building it if need be.
+   \return true if CMusicDatabaseSnapshot::Get() can answer for this database
+   */
+  bool GetSnapshot();
+  bool GetSnapshotStamp(CMusicDatabaseSnapshot::Stamp &stamp);
+  bool FillSnapshot(CMusicDatabaseSnapshot::Columns &columns);
+
   // Fields should be ordered as they
   // appear in the songview
   enum _SongFields
@@ -0,0 +1,485 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "MusicDatabaseSnapshot.h"
+#include "SmartPlaylist.h"
+#include "StringUtils.h"
+#include "FileSystem/File.h"
+#include "utils/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <set>
+
+using namespace std;
+using namespace XFILE;
+
+#define SNAPSHOT_MAGIC   "XMLS"
+#define SNAPSHOT_VERSION 1
+
+// the file is a header followed by the columns as raw arrays, so it loads with one read per column
+struct SnapshotHeader
+{
+  char     magic[4];
+  uint32_t version;
+  CMusicDatabaseSnapshot::Stamp stamp;
+  uint32_t songs;
+  uint32_t extraGenres;
+  uint32_t albumYears;
+  uint32_t genres;
+};
+
+bool CMusicDatabaseSnapshot::Stamp::operator==(const Stamp &right) const
+{
+  return songs == right.songs && maxSong == right.maxSong && years == right.years &&
+         plays == right.plays && ratings == right.ratings;
+}
+
+void CMusicDatabaseSnapshot::Columns::Clear()
+{
+  idSong.clear();
+  idAlbum.clear();
+  idArtist.clear();
+  idGenre.clear();
+  year.clear();
+  duration.clear();
+  track.clear();
+  timesPlayed.clear();
+  rating.clear();
+  extraGenres.clear();
+  albumYears.clear();
+  genres.clear();
+}
+
+CMusicDatabaseSnapshot::CMusicDatabaseSnapshot()
+{
+  m_valid = false;
+  m_dirty = false;
+}
+
+CMusicDatabaseSnapshot &CMusicDatabaseSnapshot::Get()
+{
+  static CMusicDatabaseSnapshot s_snapshot;
+  return s_snapshot;
+}
+
+CStdString CMusicDatabaseSnapshot::GetSnapshotFile(const CStdString &database)
+{
+  return database + ".snapshot";
+}
+
+bool CMusicDatabaseSnapshot::IsCurrent(const CStdString &database) const
+{
+  CSingleLock lock(m_section);
+  return m_valid && m_database == database;
+}
+
+void CMusicDatabaseSnapshot::Set(const CStdString &database, const Stamp &stamp, Columns &columns)
+{
+  CSingleLock lock(m_section);
+  m_columns.idSong.swap(columns.idSong);
+  m_columns.idAlbum.swap(columns.idAlbum);
+  m_columns.idArtist.swap(columns.idArtist);
+  m_columns.idGenre.swap(columns.idGenre);
+  m_columns.year.swap(columns.year);
+  m_columns.duration.swap(columns.duration);
+  m_columns.track.swap(columns.track);
+  m_columns.timesPlayed.swap(columns.timesPlayed);
+  m_columns.rating.swap(columns.rating);
+  m_columns.extraGenres.swap(columns.extraGenres);
+  m_columns.albumYears.swap(columns.albumYears);
+  m_columns.genres.swap(columns.genres);
+  m_database = database;
+  m_stamp = stamp;
+  m_valid = true;
+  m_dirty = true;
+}
+
+template<typename T>
+static bool ReadColumn(CFile &file, vector<T> &column, uint32_t size)
+{
+  column.resize(size);
+  if (!size)
+    return true;
+  return file.Read(&column[0], size * sizeof(T)) == size * sizeof(T);
+}
+
+template<typename T>
+static bool WriteColumn(CFile &file, const vector<T> &column)
+{
+  if (column.empty())
+    return true;
+  return file.Write(&column[0], column.size() * sizeof(T)) == (int)(column.size() * sizeof(T));
+}
+
+bool CMusicDatabaseSnapshot::Load(const CStdString &database, const Stamp &stamp)
+{
+  CStdString snapshotFile = GetSnapshotFile(database);
+  CFile file;
+  if (!file.Open(snapshotFile))
+    return false;
+
+  SnapshotHeader header;
+  if (file.Read(&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION)
+  {
+    CLog::Log(LOGDEBUG, "%s - ignoring %s, unknown format", __FUNCTION__, snapshotFile.c_str());
+    return false;
+  }
+  if (header.stamp != stamp)
+  {
+    CLog::Log(LOGDEBUG, "%s - ignoring %s, the library changed since it was saved", __FUNCTION__, snapshotFile.c_str());
+    return false;
+  }
+
+  Columns columns;
+  bool ok = ReadColumn(file, columns.idSong, header.songs) &&
+            ReadColumn(file, columns.idAlbum, header.songs) &&
+            ReadColumn(file, columns.idArtist, header.songs) &&
+            ReadColumn(file, columns.idGenre, header.songs) &&
+            ReadColumn(file, columns.year, header.songs) &&
+            ReadColumn(file, columns.duration, header.songs) &&
+            ReadColumn(file, columns.track, header.songs) &&
+            ReadColumn(file, columns.timesPlayed, header.songs) &&
+            ReadColumn(file, columns.rating, header.songs) &&
+            ReadColumn(file, columns.extraGenres, header.extraGenres) &&
+            ReadColumn(file, columns.albumYears, header.albumYears);
+  for (uint32_t i = 0; ok && i < header.genres; i++)
+  {
+    int32_t genre[2]; // id, length of the name
+    ok = file.Read(genre, sizeof(genre)) == sizeof(genre) && genre[1] >= 0;
+    if (ok)
+    {
+      vector<char> name;
+      ok = ReadColumn(file, name, genre[1]);
+      if (ok)
+        columns.genres[genre[0]] = name.empty() ? CStdString() : CStdString(&name[0], name.size());
+    }
+  }
+  if (!ok)
+  {
+    CLog::Log(LOGERROR, "%s - %s is truncated", __FUNCTION__, snapshotFile.c_str());
+    return false;
+  }
+
+  Set(database, stamp, columns);
+  CSingleLock lock(m_section);
+  m_dirty = false;
+  return true;
+}
+
+void CMusicDatabaseSnapshot::Flush()
+{
+  CSingleLock lock(m_section);
+  if (!m_valid || !m_dirty)
+    return;
+
+  SnapshotHeader header;
+  memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+  header.version = SNAPSHOT_VERSION;
+  header.stamp = m_stamp;
+  header.songs = m_columns.Size();
+  header.extraGenres = m_columns.extraGenres.size();
+  header.albumYears = m_columns.albumYears.size();
+  header.genres = m_columns.genres.size();
+
+  // write to a temporary file, so a failed write never leaves a partial snapshot behind
+  CStdString snapshotFile = GetSnapshotFile(m_database);
+  CStdString tempFile = snapshotFile + ".tmp";
+  CFile file;
+  if (!file.OpenForWrite(tempFile, true))
+  {
+    CLog::Log(LOGERROR, "%s - unable to write %s", __FUNCTION__, tempFile.c_str());
+    return;
+  }
+  bool ok = file.Write(&header, sizeof(header)) == sizeof(header) &&
+            WriteColumn(file, m_columns.idSong) &&
+            WriteColumn(file, m_columns.idAlbum) &&
+            WriteColumn(file, m_columns.idArtist) &&
+            WriteColumn(file, m_columns.idGenre) &&
+            WriteColumn(file, m_columns.year) &&
+            WriteColumn(file, m_columns.duration) &&
+            WriteColumn(file, m_columns.track) &&
+            WriteColumn(file, m_columns.timesPlayed) &&
+            WriteColumn(file, m_columns.rating) &&
+            WriteColumn(file, m_columns.extraGenres) &&
+            WriteColumn(file, m_columns.albumYears);
+  for (map<int, CStdString>::const_iterator it = m_columns.genres.begin(); ok && it != m_columns.genres.end(); ++it)
+  {
+    int32_t genre[2] = { it->first, (int32_t)it->second.size() };
+    ok = file.Write(genre, sizeof(genre)) == sizeof(genre) &&
+         (it->second.IsEmpty() || file.Write(it->second.c_str(), it->second.size()) == (int)it->second.size());
+  }
+  file.Close();
+
+  if (!ok || !CFile::Rename(tempFile, snapshotFile))
+  {
+    CLog::Log(LOGERROR, "%s - unable to write %s", __FUNCTION__, snapshotFile.c_str());
+    CFile::Delete(tempFile);
+    return;
+  }
+  m_dirty = false;
+}
+
+void CMusicDatabaseSnapshot::Invalidate()
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return;
+  m_valid = false;
+  m_dirty = false;
+  m_columns.Clear();
+  // the saved copy no longer matches either, and its stamp may not show it
+  CFile::Delete(GetSnapshotFile(m_database));
+}
+
+int CMusicDatabaseSnapshot::FindSong(int idSong) const
+{
+  vector<int>::const_iterator it = lower_bound(m_columns.idSong.begin(), m_columns.idSong.end(), idSong);
+  if (it == m_columns.idSong.end() || *it != idSong)
+    return -1;
+  return it - m_columns.idSong.begin();
+}
+
+void CMusicDatabaseSnapshot::IncrementTimesPlayed(int idSong)
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return;
+  int song = FindSong(idSong);
+  if (song < 0)
+    return;
+  m_columns.timesPlayed[song]++;
+  m_stamp.plays++;
+  m_dirty = true;
+}
+
+void CMusicDatabaseSnapshot::SetRating(int idSong, char rating)
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return;
+  int song = FindSong(idSong);
+  if (song < 0)
+    return;
+  m_stamp.ratings += (rating - '0') - (m_columns.rating[song] - '0');
+  m_columns.rating[song] = rating;
+  m_dirty = true;
+}
+
+// matches sqlite's LIKE without wildcards: case insensitive for ascii letters only
+static bool EqualsLike(const CStdString &left, const CStdString &right)
+{
+  if (left.size() != right.size())
+    return false;
+  for (size_t i = 0; i < left.size(); i++)
+  {
+    char l = left[i], r = right[i];
+    if (l >= 'A' && l <= 'Z') l += 'a' - 'A';
+    if (r >= 'A' && r <= 'Z') r += 'a' - 'A';
+    if (l != r)
+      return false;
+  }
+  return true;
+}
+
+namespace
+{
+  // a smart playlist rule in a form the columns can be tested against
+  struct SnapshotRule
+  {
+    CSmartPlaylistRule::DATABASE_FIELD field;
+    CSmartPlaylistRule::SEARCH_OPERATOR oper;
+    int value;
+    set<int> genres;         // genre rules: the matching genres
+    vector<int> extraSongs;  // genre rules: the songs with a matching extra genre, sorted
+  };
+}
+
+bool CMusicDatabaseSnapshot::MatchesRule(size_t song, int field, int oper, int value) const
+{
+  int column;
+  switch (field)
+  {
+  case CSmartPlaylistRule::FIELD_YEAR:        column = m_columns.year[song]; break;
+  case CSmartPlaylistRule::FIELD_TIME:        column = m_columns.duration[song]; break;
+  case CSmartPlaylistRule::FIELD_TRACKNUMBER: column = m_columns.track[song]; break;
+  case CSmartPlaylistRule::FIELD_PLAYCOUNT:   column = m_columns.timesPlayed[song]; break;
+  case CSmartPlaylistRule::FIELD_RATING:      column = m_columns.rating[song] - '0'; break;
+  default:
+    return false;
+  }
+  switch (oper)
+  {
+  case CSmartPlaylistRule::OPERATOR_EQUALS:        return column == value;
+  case CSmartPlaylistRule::OPERATOR_DOES_NOT_EQUAL: return column != value;
+  case CSmartPlaylistRule::OPERATOR_GREATER_THAN:  return column > value;
+  case CSmartPlaylistRule::OPERATOR_LESS_THAN:     return column < value;
+  default:
+    return false;
+  }
+}
+
+bool CMusicDatabaseSnapshot::GetSongIDs(const CSmartPlaylist *playlist, vector<int> &songIDs) const
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return false;
+
+  // translate the rules, giving up on any we can't evaluate the same way as the SQL would
+  vector<SnapshotRule> rules;
+  bool matchAll = true;
+  if (playlist)
+  {
+    if (!playlist->GetType().IsEmpty() && !playlist->GetType().Equals("songs") && !playlist->GetType().Equals("mixed"))
+      return false;
+    matchAll = playlist->GetMatchAllRules();
+    const vector<CSmartPlaylistRule> &playlistRules = playlist->GetRules();
+    for (vector<CSmartPlaylistRule>::const_iterator it = playlistRules.begin(); it != playlistRules.end(); ++it)
+    {
+      SnapshotRule rule;
+      rule.field = it->m_field;
+      rule.oper = it->m_operator;
+      rule.value = 0;
+      if (rule.oper == CSmartPlaylistRule::OPERATOR_AFTER)
+        rule.oper = CSmartPlaylistRule::OPERATOR_GREATER_THAN;
+      else if (rule.oper == CSmartPlaylistRule::OPERATOR_BEFORE)
+        rule.oper = CSmartPlaylistRule::OPERATOR_LESS_THAN;
+
+      if (rule.field == CSmartPlaylistRule::FIELD_GENRE)
+      {
+        if ((rule.oper != CSmartPlaylistRule::OPERATOR_EQUALS && rule.oper != CSmartPlaylistRule::OPERATOR_DOES_NOT_EQUAL) ||
+            it->m_parameter.find_first_of("%_") != CStdString::npos)
+          return false;
+        for (map<int, CStdString>::const_iterator genre = m_columns.genres.begin(); genre != m_columns.genres.end(); ++genre)
+        {
+          if (EqualsLike(genre->second, it->m_parameter))
+            rule.genres.insert(genre->first);
+        }
+        for (vector< pair<int, int> >::const_iterator extra = m_columns.extraGenres.begin(); extra != m_columns.extraGenres.end(); ++extra)
+        {
+          if (rule.genres.find(extra->second) != rule.genres.end())
+            rule.extraSongs.push_back(extra->first);
+        }
+      }
+      else
+      {
+        if (rule.oper != CSmartPlaylistRule::OPERATOR_EQUALS && rule.oper != CSmartPlaylistRule::OPERATOR_DOES_NOT_EQUAL &&
+            rule.oper != CSmartPlaylistRule::OPERATOR_GREATER_THAN && rule.oper != CSmartPlaylistRule::OPERATOR_LESS_THAN)
+          return false;
+        CStdString parameter = it->m_parameter;
+        if (rule.field == CSmartPlaylistRule::FIELD_TIME)
+          parameter.Format("%i", StringUtils::TimeStringToSeconds(it->m_parameter));
+        else if (rule.field != CSmartPlaylistRule::FIELD_YEAR && rule.field != CSmartPlaylistRule::FIELD_TRACKNUMBER &&
+                 rule.field != CSmartPlaylistRule::FIELD_PLAYCOUNT && rule.field != CSmartPlaylistRule::FIELD_RATING)
+          return false;
+        // only plain integers compare the same as numbers and as the text LIKE sees
+        rule.value = atoi(parameter.c_str());
+        CStdString canonical;
+        canonical.Format("%i", rule.value);
+        if (canonical != parameter)
+          return false;
+        // ratings are stored as a single character, so compare as text
+        if (rule.field == CSmartPlaylistRule::FIELD_RATING && (rule.value < 0 || rule.value > 9))
+          return false;
+      }
+      rules.push_back(rule);
+    }
+  }
+
+  songIDs.clear();
+  for (size_t song = 0; song < m_columns.Size(); song++)
+  {
+    bool match = matchAll;
+    for (vector<SnapshotRule>::const_iterator rule = rules.begin(); rule != rules.end(); ++rule)
+    {
+      bool ruleMatch;
+      if (rule->field == CSmartPlaylistRule::FIELD_GENRE)
+      {
+        ruleMatch = rule->genres.find(m_columns.idGenre[song]) != rule->genres.end() ||
+                    binary_search(rule->extraSongs.begin(), rule->extraSongs.end(), m_columns.idSong[song]);
+        if (rule->oper == CSmartPlaylistRule::OPERATOR_DOES_NOT_EQUAL)
+          ruleMatch = !ruleMatch;
+      }
+      else
+        ruleMatch = MatchesRule(song, rule->field, rule->oper, rule->value);
+
+      if (ruleMatch != matchAll)
+      {
+        match = ruleMatch;
+        break;
+      }
+    }
+    if (match || rules.empty())
+      songIDs.push_back(m_columns.idSong[song]);
+  }
+  return true;
+}
+
+bool CMusicDatabaseSnapshot::GetGenres(vector< pair<int, CStdString> > &genres) const
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return false;
+
+  set<int> used(m_columns.idGenre.begin(), m_columns.idGenre.end());
+  for (vector< pair<int, int> >::const_iterator it = m_columns.extraGenres.begin(); it != m_columns.extraGenres.end(); ++it)
+    used.insert(it->second);
+
+  genres.clear();
+  for (set<int>::const_iterator it = used.begin(); it != used.end(); ++it)
+  {
+    map<int, CStdString>::const_iterator genre = m_columns.genres.find(*it);
+    if (genre != m_columns.genres.end() && !genre->second.IsEmpty())
+      genres.push_back(*genre);
+  }
+  return true;
+}
+
+bool CMusicDatabaseSnapshot::GetYears(vector<int> &years) const
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return false;
+  years = m_columns.albumYears;
+  return true;
+}
+
+bool CMusicDatabaseSnapshot::GetRatingsAndPlayCounts(const vector< pair<int, int> > &songIDs, vector<int> &ratings, vector<int> &playCounts) const
+{
+  CSingleLock lock(m_section);
+  if (!m_valid)
+    return false;
+
+  ratings.assign(songIDs.size(), 0);
+  playCounts.assign(songIDs.size(), 0);
+  for (unsigned int i = 0; i < songIDs.size(); i++)
+  {
+    if (songIDs[i].first != 1)
+      continue;
+    int song = FindSong(songIDs[i].second);
+    if (song < 0)
+      continue;
+    ratings[i] = m_columns.rating[song] - '0';
+    playCounts[i] = m_columns.timesPlayed[song];
+  }
+  return true;
+}
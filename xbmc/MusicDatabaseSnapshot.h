@@ -0,0 +1,150 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include "utils/CriticalSection.h"
+
+#include <map>
+#include <vector>
+
+class CSmartPlaylist;
+
+/*!
+ \ingroup music
+ \brief Memory resident copy of the core columns of the music library.
+
+ Holds the ids, year, duration, track, play count and rating of every song, one
+ column per field in idSong order, plus the genres and album years. Genre and year
+ listings, party mode and smart playlists whose rules only involve those fields are
+ answered from it rather than by joining the song tables.
+
+ The snapshot is built by CMusicDatabase on first use and saved next to the
+ database, so later sessions load it with a few large reads. Play counts and
+ ratings are updated in place. Any other write to the song tables invalidates
+ it, and it's rebuilt the next time it's needed.
+
+ \sa CMusicDatabase::GetSnapshot
+ */
+class CMusicDatabaseSnapshot
+{
+public:
+  /*! \brief Summary of the song table, to tell whether a saved snapshot is still current.
+   */
+  struct Stamp
+  {
+    Stamp() : songs(0), maxSong(0), years(0), plays(0), ratings(0) {}
+    bool operator==(const Stamp &right) const;
+    bool operator!=(const Stamp &right) const { return !(*this == right); };
+
+    int64_t songs;    ///< number of songs
+    int64_t maxSong;  ///< highest idSong
+    int64_t years;    ///< sum of the song years
+    int64_t plays;    ///< sum of the play counts
+    int64_t ratings;  ///< sum of the ratings
+  };
+
+  /*! \brief The columns of the snapshot, one entry per song in idSong order.
+   */
+  struct Columns
+  {
+    void Clear();
+    size_t Size() const { return idSong.size(); };
+
+    std::vector<int> idSong;
+    std::vector<int> idAlbum;
+    std::vector<int> idArtist;
+    std::vector<int> idGenre;
+    std::vector<int> year;
+    std::vector<int> duration;
+    std::vector<int> track;
+    std::vector<int> timesPlayed;
+    std::vector<char> rating;
+    std::vector< std::pair<int, int> > extraGenres; ///< idSong, idGenre of the extra genres, in idSong order
+    std::vector<int> albumYears;                    ///< distinct non zero album years
+    std::map<int, CStdString> genres;               ///< genre names by idGenre
+  };
+
+  static CMusicDatabaseSnapshot &Get();
+
+  /*! \brief Whether the snapshot holds the library of the given database.
+   \param database path of the database file
+   */
+  bool IsCurrent(const CStdString &database) const;
+
+  /*! \brief Replace the snapshot with freshly read columns.
+   \param database path of the database file the columns were read from
+   \param stamp the stamp of the song table when the columns were read
+   \param columns the columns, which are swapped into the snapshot
+   */
+  void Set(const CStdString &database, const Stamp &stamp, Columns &columns);
+
+  /*! \brief Load the snapshot saved next to a database, if it matches the song table.
+   \param database path of the database file
+   \param stamp the current stamp of the song table
+   \return true if the saved snapshot was current and has been loaded
+   */
+  bool Load(const CStdString &database, const Stamp &stamp);
+
+  /*! \brief Save the snapshot next to its database, if it changed since it was last saved.
+   */
+  void Flush();
+
+  /*! \brief Drop the snapshot after a write it can't follow, such as songs being added or removed.
+   */
+  void Invalidate();
+
+  void IncrementTimesPlayed(int idSong);
+  void SetRating(int idSong, char rating);
+
+  /*! \brief Get the ids of the songs matching a smart playlist.
+   \param playlist the playlist, or NULL for all songs
+   \param songIDs [out] the matching songs
+   \return false if there is no snapshot or the playlist has rules it can't evaluate
+   */
+  bool GetSongIDs(const CSmartPlaylist *playlist, std::vector<int> &songIDs) const;
+
+  /*! \brief Get the genres which have songs, as for CMusicDatabase::GetGenresNav.
+   */
+  bool GetGenres(std::vector< std::pair<int, CStdString> > &genres) const;
+
+  /*! \brief Get the album years, as for CMusicDatabase::GetYearsNav.
+   */
+  bool GetYears(std::vector<int> &years) const;
+
+  /*! \brief Get the rating and play count of songs, as for CMusicDatabase::GetSongRatingsAndPlayCounts.
+   */
+  bool GetRatingsAndPlayCounts(const std::vector< std::pair<int, int> > &songIDs, std::vector<int> &ratings, std::vector<int> &playCounts) const;
+
+private:
+  CMusicDatabaseSnapshot();
+
+  static CStdString GetSnapshotFile(const CStdString &database);
+  int FindSong(int idSong) const;
+  bool MatchesRule(size_t song, int field, int oper, int value) const;
+
+  CCriticalSection m_section;
+  bool m_valid;
+  bool m_dirty;
+  CStdString m_database;
+  Stamp m_stamp;
+  Columns m_columns;
+};
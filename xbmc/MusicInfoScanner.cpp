@@ -45,6 +45,7 @@
 #include "LocalizeStrings.h"
 #include "StringUtils.h"
 #include "utils/TimeUtils.h"
+#include "utils/ScraperHttpCache.h"
 #include "utils/log.h"
 
 #include <algorithm>
@@ -82,6 +83,7 @@ void CMusicInfoScanner::Process()
 
     CUtil::ThumbCacheClear();
     g_directoryCache.ClearMusicThumbCache();
+    CScraperHttpCache::Get().Prune();
 
     if (m_scanType == 0) // load info from files
     {
@@ -237,7 +239,7 @@ void CMusicInfoScanner::FetchAlbumInfo(const CStdString& strDirectory)
   if (strDirectory.IsEmpty())
   {
     m_musicDatabase.Open();
-    m_musicDatabase.GetAlbumsNav("musicdb://3/",items,-1,-1,-1,-1);
+    m_musicDatabase.GetAlbumsNav("musicdb://3/",items,-1,-1);
     m_musicDatabase.Close();
   }
   else
@@ -432,6 +434,9 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
 
   CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
+  unsigned int tagsRead = 0;
+  unsigned int tagTime = CTimeUtils::GetTimeMS();
+
   // for every file found, but skip folder
   for (int i = 0; i < items.Size(); ++i)
   {
@@ -460,7 +465,10 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
       { // read the tag from a file
         auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->m_strPath));
         if (NULL != pLoader.get())
+        {
           pLoader->Load(pItem->m_strPath, tag);
+          tagsRead++;
+        }
       }
 
       // if we have the itemcount, notify our
@@ -507,6 +515,12 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
     }
   }
 
+  if (tagsRead)
+  {
+    tagTime = CTimeUtils::GetTimeMS() - tagTime;
+    CLog::Log(LOGDEBUG, "%s - Read %u tags in %u ms (%.1f tags/s) from %s", __FUNCTION__, tagsRead, tagTime, tagTime ? tagsRead * 1000.0f / tagTime : 0.0f, strDirectory.c_str());
+  }
+
   CheckForVariousArtists(songsToAdd);
   if (!items.HasThumbnail())
     UpdateFolderThumb(songsToAdd, items.m_strPath);
@@ -445,6 +445,11 @@ void CMusicInfoTag::AppendGenre(const CStdString &genre)
 
 CStdString CMusicInfoTag::Trim(const CStdString &value) const
 {
+  // hand back the value itself when there's nothing to trim, so strings shared by the
+  // database listings aren't copied
+  if (value.IsEmpty() || (value[0] != ' ' && value.find_first_of(" \n\r", value.size() - 1) == CStdString::npos))
+    return value;
+
   CStdString trimmedValue(value);
   trimmedValue.TrimLeft(' ');
   trimmedValue.TrimRight(" \n\r");
@@ -23,7 +23,7 @@
 #include "APEv2Tag.h"
 #include "Id3Tag.h"
 #include "AdvancedSettings.h"
-#include "FileSystem/File.h"
+#include "TagFileReader.h"
 #include "utils/log.h"
 
 using namespace MUSIC_INFO;
@@ -226,6 +226,15 @@ int CMusicInfoTagLoaderMP3::IsMp3FrameHeader(unsigned long head)
 
 //TODO: merge duplicate, but slitely different implemented) code and consts in IsMp3FrameHeader(above) and ReadDuration (below).
 
+// read up to size bytes from offset, returning the number of bytes read
+static unsigned int ReadAt(CTagFileReader &file, int64_t offset, unsigned char *buffer, unsigned int size)
+{
+  if (offset >= file.GetLength())
+    return 0;
+  size = (unsigned int)std::min((int64_t)size, file.GetLength() - offset);
+  return file.Read(offset, buffer, size) ? size : 0;
+}
+
 // Inspired by http://rockbox.haxx.se/ and http://www.xs4all.nl/~rwvtveer/scilla
 int CMusicInfoTagLoaderMP3::ReadDuration(const CStdString& strFileName)
 {
@@ -246,40 +255,42 @@ int CMusicInfoTagLoaderMP3::ReadDuration(const CStdString& strFileName)
     };
 
 
-  CFile file;
+  // the tags and first frames are fetched with a read at each end of the file,
+  // plus one past the ID3v2 tags if they're too large to fit in the head
+  CTagFileReader file;
   if (!file.Open(strFileName))
     return 0;
 
   /* Check if the file has an ID3v1 tag */
-  file.Seek(file.GetLength()-128, SEEK_SET);
-  file.Read(buffer, 3);
+  const char *id3v1 = file.GetData(file.GetLength() - 128, 3);
 
   bool hasid3v1=false;
-  if (buffer[0] == 'T' &&
-      buffer[1] == 'A' &&
-      buffer[2] == 'G')
+  if (id3v1 &&
+      id3v1[0] == 'T' &&
+      id3v1[1] == 'A' &&
+      id3v1[2] == 'G')
   {
     hasid3v1=true;
   }
 
   /* Check if the file has an ID3v2 tag (or multiple tags) */
   unsigned int id3v2Size = 0;
-  file.Seek(0, SEEK_SET);
-  file.Read(buffer, ID3V2HEADERSIZE);
+  if (ReadAt(file, 0, buffer, ID3V2HEADERSIZE) != ID3V2HEADERSIZE)
+    return 0;
   unsigned int size = IsID3v2Header(buffer, ID3V2HEADERSIZE);
   while (size)
   {
     id3v2Size += size;
-    if (id3v2Size != file.Seek(id3v2Size, SEEK_SET))
-      return 0;
-    if (ID3V2HEADERSIZE != file.Read(buffer, ID3V2HEADERSIZE))
+    if (ID3V2HEADERSIZE != ReadAt(file, id3v2Size, buffer, ID3V2HEADERSIZE))
       return 0;
     size = IsID3v2Header(buffer, ID3V2HEADERSIZE);
   }
 
   //skip any padding
   //already read ID3V2HEADERSIZE bytes so take it into account
-  int iScanSize = file.Read(buffer + ID3V2HEADERSIZE, SCANSIZE - ID3V2HEADERSIZE) + ID3V2HEADERSIZE;
+  int64_t filePos = id3v2Size + ID3V2HEADERSIZE;
+  int iScanSize = ReadAt(file, filePos, buffer + ID3V2HEADERSIZE, SCANSIZE - ID3V2HEADERSIZE) + ID3V2HEADERSIZE;
+  filePos += iScanSize - ID3V2HEADERSIZE;
   int iBufferDataStart;
   do
   {
@@ -296,7 +307,8 @@ int CMusicInfoTagLoaderMP3::ReadDuration(const CStdString& strFileName)
     if (iBufferDataStart == -1)
     {
       id3v2Size += iScanSize;
-      iScanSize = file.Read(buffer, SCANSIZE);
+      iScanSize = ReadAt(file, filePos, buffer, SCANSIZE);
+      filePos += iScanSize;
     }
     else
     {
@@ -311,7 +323,7 @@ int CMusicInfoTagLoaderMP3::ReadDuration(const CStdString& strFileName)
     iScanSize -= iBufferDataStart;
     memcpy(buffer, buffer + iBufferDataStart, iScanSize);
     //fill remainder of buffer with new data
-    iScanSize += file.Read(buffer + iScanSize, SCANSIZE - iScanSize);
+    iScanSize += ReadAt(file, filePos, buffer + iScanSize, SCANSIZE - iScanSize);
   }
 
   int firstFrameOffset = id3v2Size;
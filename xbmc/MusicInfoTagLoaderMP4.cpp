@@ -35,6 +35,8 @@ using namespace MUSIC_INFO;
 // -------------------------------------------------------------------------------------------------
 // Private data & functions purely to satisfy MP4 tag processing code...
 
+#define ILST_SEARCH_SIZE 4096
+
 #define MAKE_ATOM_NAME( a, b, c, d ) ( ( (a) << 24 ) | ( (b) << 16 ) | ( (c) << 8 ) | (d) )
 
 static const unsigned int g_MetaAtomName        = MAKE_ATOM_NAME( 'm', 'e', 't', 'a' );   // 'meta'
@@ -223,35 +225,18 @@ void CMusicInfoTagLoaderMP4::ParseTag( unsigned int metaKey, const char* pMetaDa
       break;
     }
 
-  case g_CoverArtAtomName:
-    {
-      // This cover-art handling is pretty much what was in the old MP4 tag processing code..
-
-      // note that according to http://atomicparsley.sourceforge.net/mpeg-4files.html the type
-      // of image (PNG=14 or JPG=13) is contained in pMetadata[-5] but we currently don't use this.
-      m_thumbSize = metaSize;
-      delete[] m_thumbData;
-      m_thumbData = new BYTE[m_thumbSize];
-      if (m_thumbData)
-        memcpy(m_thumbData, pMetaData, metaSize);
-      break;
-    }
   default:
     break;
   }
 }
 
 // Used to locate 'ilst' area within 'meta' atom in a really quick and dirty way. Ideally should
-// parse 'ilst' atom list, but this method seems to be reliable.
+// parse 'ilst' atom list, but this method seems to be reliable. The 'ilst' atom follows the
+// small 'hdlr' atom, so only the start of the 'meta' atom is searched.
 
-int CMusicInfoTagLoaderMP4::GetILSTOffset( const char* pBuffer, int bufferSize )
+int64_t CMusicInfoTagLoaderMP4::GetILSTOffset( int64_t metaOffset, int64_t metaSize )
 {
-  for ( int loop = 0; loop < bufferSize; loop++)
-  {
-    if ( strncmp( pBuffer + loop, "ilst", 4 ) == 0 )
-      return loop;
-  }
-  return 0;
+  return m_reader.Find( metaOffset, (unsigned int)std::min( metaSize, (int64_t)ILST_SEARCH_SIZE ), "ilst", 4 );
 }
 
 
@@ -262,34 +247,44 @@ int CMusicInfoTagLoaderMP4::GetILSTOffset( const char* pBuffer, int bufferSize )
 // working quickly. The code in that thread seems to be somewhat derived from work at www.getid3.org,
 // although it fails to credit them.
 //
-// I hope to make this particular function more readable/structured when time permits.
+// The atoms are parsed straight from the buffers of the tag reader, which holds the head and tail
+// of the file, so that all but the largest files need no further reads.
 
 int CMusicInfoTagLoaderMP4::ParseAtom( int64_t startOffset, int64_t stopOffset, CMusicInfoTag& tag )
 {
   int64_t       currentOffset;
-  int           atomSize;
+  int64_t       atomSize;
   unsigned int  atomName;
-  char          atomHeader[ 10 ];
 
   currentOffset = startOffset;
-  while ( currentOffset < stopOffset)
+  while ( currentOffset + 8 <= stopOffset)
   {
-    // Seek to the atom header
-    m_file.Seek( currentOffset, SEEK_SET );
-
-    // Read it in.. we only want the atom name & size.. they're always there..
-    m_file.Read( atomHeader, 8 );
+    // Read the atom header.. we only want the atom name & size.. they're always there..
+    const char* atomHeader = m_reader.GetData( currentOffset, 8 );
+    if ( !atomHeader )
+      break;
 
     // Now pull out the bits we need..
     atomSize = ReadUnsignedInt( &atomHeader[ 0 ] );
     atomName = ReadUnsignedInt( &atomHeader[ 4 ] );
+    int64_t dataOffset = currentOffset + 8;
+
+    // A size of 1 means the real size follows as 64 bits, as used by large 'mdat' atoms
+    if ( atomSize == 1 )
+    {
+      const char* largeSize = m_reader.GetData( dataOffset, 8 );
+      if ( !largeSize )
+        break;
+      atomSize = ( (int64_t)ReadUnsignedInt( largeSize ) << 32 ) | ReadUnsignedInt( largeSize + 4 );
+      dataOffset += 8;
+    }
 
     // See if it's a container atom.. if it is, then recursively call ParseAtom on it...
     for ( unsigned int containerAtom = 0; containerAtom < ( sizeof( g_ContainerAtoms ) / sizeof( unsigned int ) ); containerAtom++ )
     {
       if ( atomName == g_ContainerAtoms[ containerAtom ] )
       {
-        ParseAtom( m_file.GetPosition(), currentOffset + atomSize, tag );
+        ParseAtom( dataOffset, currentOffset + atomSize, tag );
         break;
       }
     }
@@ -297,21 +292,22 @@ int CMusicInfoTagLoaderMP4::ParseAtom( int64_t startOffset, int64_t stopOffset,
     // We're primarily interested in the 'meta' and 'mdhd' tags..
     if ( atomName == g_MetaAtomName )
     {
-      // Use auto_aptr for our workspace, so that it tidies up on any throw..
-      auto_aptr<char> atomBuffer( new char[ atomSize ] );
-
-      // Read the metadata in..
-      m_file.Read( atomBuffer.get(), atomSize - 4 ); // We've already read the size/name in...
+      int64_t metaEnd = currentOffset + atomSize;
 
-      // Look for the 'ilst' atom, and turn it into an offset within atomBuffer.
-      int nextTagPosition = GetILSTOffset( atomBuffer.get(), atomSize - 4 ) + 8;
+      // Look for the 'ilst' atom, and turn it into the offset of the first tag within it.
+      int64_t ilstOffset = GetILSTOffset( dataOffset, metaEnd - dataOffset );
+      int64_t nextTagPosition = ilstOffset + 8;
 
       // Now go through all of the tags we find.. processing is pretty much taken from source at http://www.getid3.org..
-      while ( ( nextTagPosition < ( atomSize - 4 ) ) && ( nextTagPosition > 8 ) )
+      while ( ilstOffset >= 0 && nextTagPosition + 20 <= metaEnd )
       {
-        int metaSize          = ReadUnsignedInt( atomBuffer.get() + ( nextTagPosition - 4 ) ) - 4;
-        unsigned int metaKey  = ReadUnsignedInt( atomBuffer.get() + nextTagPosition );
-        char* metaData        = ( atomBuffer.get() + nextTagPosition ) + 20;
+        const char* tagHeader = m_reader.GetData( nextTagPosition - 4, 8 );
+        if ( !tagHeader )
+          break;
+
+        int metaSize          = ReadUnsignedInt( tagHeader ) - 4;
+        unsigned int metaKey  = ReadUnsignedInt( tagHeader + 4 );
+        int64_t metaOffset    = nextTagPosition + 20;
 
         if (metaSize - 20 <= 0)
           break;
@@ -319,24 +315,37 @@ int CMusicInfoTagLoaderMP4::ParseAtom( int64_t startOffset, int64_t stopOffset,
         // This is where the next chunk of data will be, if present..
         nextTagPosition += ( metaSize + 4 );
 
+        if ( metaKey == g_CoverArtAtomName )
+        {
+          // Note where the art is, it's only read if the thumb isn't cached yet. According to
+          // http://atomicparsley.sourceforge.net/mpeg-4files.html the type of image (PNG=14 or JPG=13)
+          // is contained in the 4 bytes before the data, but we currently don't use this.
+          m_thumbOffset = metaOffset;
+          m_thumbSize = metaSize - 20;
+          continue;
+        }
 
         // Ok.. we've got some metadata to process. Go to it.
-        ParseTag( metaKey, metaData, metaSize - 20, tag );
+        const char* metaData = m_reader.GetData( metaOffset, metaSize - 20 );
+        if ( metaData )
+          ParseTag( metaKey, metaData, metaSize - 20, tag );
       }
     }
     else
       if ( atomName == g_MdhdAtomName )
       {
-        char mdhdData[ 20 ];
-        m_file.Read( mdhdData, sizeof( mdhdData ) );
-
-        unsigned int timeScale = ReadUnsignedInt( mdhdData+12 );
-        unsigned int duration  = ReadUnsignedInt( mdhdData+16 );
-        tag.SetDuration( duration / timeScale );
+        const char* mdhdData = m_reader.GetData( dataOffset, 20 );
+        if ( mdhdData )
+        {
+          unsigned int timeScale = ReadUnsignedInt( mdhdData+12 );
+          unsigned int duration  = ReadUnsignedInt( mdhdData+16 );
+          if ( timeScale )
+            tag.SetDuration( duration / timeScale );
+        }
       }
 
       // If we've got a zero sized atom, then it's all over.. force the offset to trigger a stop.
-      if ( atomSize == 0 )
+      if ( atomSize <= 0 )
         currentOffset = stopOffset;
       else
         currentOffset += atomSize;
@@ -363,8 +372,9 @@ bool CMusicInfoTagLoaderMP4::Load(const CStdString& strFileName, CMusicInfoTag&
     // Initially we say that we've not loaded any tag information
     tag.SetLoaded(false);
 
-    // Attempt to open the file..
-    if ( !m_file.Open( strFileName ) )
+    // Attempt to open the file.. the 'moov' atom is either at the start or the end of the file, so
+    // read a good sized block from both ends
+    if ( !m_reader.Open( strFileName, 131072, 131072 ) )
     {
       CLog::Log(LOGDEBUG, "Tag loader mp4: failed to open file %s", strFileName.c_str() );
       return false;
@@ -374,12 +384,12 @@ bool CMusicInfoTagLoaderMP4::Load(const CStdString& strFileName, CMusicInfoTag&
     tag.SetURL(strFileName);
 
     // Now go parse our atom data
-    m_thumbSize = false;
-    m_thumbData = NULL;
+    m_thumbOffset = 0;
+    m_thumbSize = 0;
     m_isCompilation = false;
-    ParseAtom( 0, m_file.GetLength(), tag );
+    ParseAtom( 0, m_reader.GetLength(), tag );
 
-    if (m_thumbData)
+    if (m_thumbSize)
     { // cache the thumb
       // if we don't have an album tag, cache with the full file path so that
       // other non-tagged files don't get this album image
@@ -388,9 +398,10 @@ bool CMusicInfoTagLoaderMP4::Load(const CStdString& strFileName, CMusicInfoTag&
         strCoverArt = CUtil::GetCachedAlbumThumb(tag.GetAlbum(), tag.GetAlbumArtist().IsEmpty() ? tag.GetArtist() : tag.GetAlbumArtist());
       else
         strCoverArt = CUtil::GetCachedMusicThumb(tag.GetURL());
-      if (!CUtil::ThumbExists(strCoverArt))
+      const BYTE *thumbData = NULL;
+      if (!CUtil::ThumbExists(strCoverArt) && (thumbData = (const BYTE *)m_reader.GetData( m_thumbOffset, m_thumbSize )))
       {
-        if (CPicture::CreateThumbnailFromMemory( m_thumbData, m_thumbSize, "", strCoverArt ) )
+        if (CPicture::CreateThumbnailFromMemory( thumbData, m_thumbSize, "", strCoverArt ) )
         {
           CUtil::ThumbCacheAdd( strCoverArt, true );
         }
@@ -400,7 +411,6 @@ bool CMusicInfoTagLoaderMP4::Load(const CStdString& strFileName, CMusicInfoTag&
           CUtil::ThumbCacheAdd( strCoverArt, false );
         }
       }
-      delete[] m_thumbData;
     }
 
     if (m_isCompilation)
@@ -409,7 +419,7 @@ bool CMusicInfoTagLoaderMP4::Load(const CStdString& strFileName, CMusicInfoTag&
         tag.SetAlbumArtist(g_localizeStrings.Get(340)); // Various Artists
     }
     // Close the file..
-    m_file.Close();
+    m_reader.Close();
 
     // Return to caller
     return true;
@@ -21,7 +21,7 @@
  */
 
 #include "ImusicInfoTagLoader.h"
-#include "FileSystem/File.h"
+#include "TagFileReader.h"
 
 namespace MUSIC_INFO
 {
@@ -37,13 +37,13 @@ public:
 private:
   unsigned int ReadUnsignedInt( const char* pData );
   void ParseTag( unsigned int metaKey, const char* pMetaData, int metaSize, CMusicInfoTag& tag);
-  int GetILSTOffset( const char* pBuffer, int bufferSize );
+  int64_t GetILSTOffset( int64_t metaOffset, int64_t metaSize );
   int ParseAtom( int64_t startOffset, int64_t stopOffset, CMusicInfoTag& tag );
 
+  int64_t m_thumbOffset;
   unsigned int m_thumbSize;
-  BYTE *m_thumbData;
   bool m_isCompilation;
 
-  XFILE::CFile m_file;
+  CTagFileReader m_reader;
 };
 }
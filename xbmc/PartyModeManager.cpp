@@ -31,13 +31,20 @@
 #include "GUIDialogOK.h"
 #include "PlayList.h"
 #include "Settings.h"
+#include "AdvancedSettings.h"
 #include "utils/TimeUtils.h"
 #include "utils/log.h"
 
+#include <math.h>
+#include <algorithm>
+#include <set>
+
 using namespace std;
 using namespace PLAYLIST;
 
 #define QUEUE_DEPTH       10
+// ids picked in a row that are no longer in the library before giving up on the database
+#define MAX_STALE_PICKS   10
 
 CPartyModeManager g_partyModeManager;
 
@@ -116,7 +123,10 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
         m_strCurrentFilterMusic = playlist.GetWhereClause(db);
 
       CLog::Log(LOGINFO, "PARTY MODE MANAGER: Registering filter:[%s]", m_strCurrentFilterMusic.c_str());
-      m_iMatchingSongs = (int)db.GetSongIDs(m_strCurrentFilterMusic, songIDs);
+      if (db.GetSongIDs(playlistLoaded ? &playlist : NULL, songIDs))
+        m_iMatchingSongs = (int)songIDs.size();
+      else
+        m_iMatchingSongs = (int)db.GetSongIDs(m_strCurrentFilterMusic, songIDs);
       if (m_iMatchingSongs < 1 && m_type.Equals("songs"))
       {
         pDialog->Close();
@@ -134,9 +144,9 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
     db.Close();
   }
 
+  vector< pair<int,int> > songIDs2;
   if (m_type.Equals("musicvideos") || m_type.Equals("mixed"))
   {
-    vector< pair<int,int> > songIDs2;
     CVideoDatabase db;
     if (db.Open())
     {
@@ -160,7 +170,6 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
       return false;
     }
     db.Close();
-    songIDs.insert(songIDs.end(),songIDs2.begin(),songIDs2.end());
   }
 
   // calculate history size
@@ -172,6 +181,7 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
     m_songsInHistory = 200;
 
   CLog::Log(LOGINFO,"PARTY MODE MANAGER: Matching songs = %i, History size = %i", m_iMatchingSongs, m_songsInHistory);
+  SetSampleIndex(songIDs, songIDs2);
   CLog::Log(LOGINFO,"PARTY MODE MANAGER: Party mode enabled!");
 
   int iPlaylist = m_bIsVideo ? PLAYLIST_VIDEO : PLAYLIST_MUSIC;
@@ -183,7 +193,9 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
   pDialog->SetLine(0, (m_bIsVideo ? 20252 : 20124));
   pDialog->Progress();
   // add initial songs
-  if (!AddInitialSongs(songIDs))
+  vector< pair<int,int> > allIDs(songIDs);
+  allIDs.insert(allIDs.end(), songIDs2.begin(), songIDs2.end());
+  if (!AddInitialSongs(allIDs))
   {
     pDialog->Close();
     return false;
@@ -324,6 +336,13 @@ bool CPartyModeManager::AddRandomSongs(int iSongs /* = 0 */)
     }
   }
 
+  // refetch the matching songs every so often, to pick up changes to the library
+  if (CTimeUtils::GetTimeMS() - m_sampleIndexTime > (unsigned int)g_advancedSettings.m_iMusicLibraryPartyModeRefresh * 60000)
+    RefreshSampleIndex();
+
+  unsigned int time = CTimeUtils::GetTimeMS();
+  int picked = m_iMatchingSongsPicked;
+
   // add songs to fill queue
   if (m_type.Equals("songs") || m_type.Equals("mixed"))
   {
@@ -331,25 +350,31 @@ bool CPartyModeManager::AddRandomSongs(int iSongs /* = 0 */)
     if (database.Open())
     {
       // Method:
-      // 1. Grab a random entry from the database using a where clause
-      // 2. Iterate on iSongs.
-
-      // Note: At present, this method is faster than the alternative, which is to grab
-      // all valid songids, then select a random number of them (as done in AddInitialSongs()).
-      // The reason for this is simply the number of songs we are requesting - we generally
-      // only want one here.  Any more than about 3 songs and it is more efficient
-      // to use the technique in AddInitialSongs.  As it's unlikely that we'll require
-      // more than 1 song at a time here, this method is faster.
+      // 1. Pick a random id from the sampling index, which avoids the history
+      // 2. Fetch the song by its id, dropping ids which have since been removed
+      // 3. Iterate on iSongs.
       bool error(false);
       for (int i = 0; i < iSongsToAdd; i++)
       {
-        pair<CStdString,CStdString> whereClause = GetWhereClauseWithHistory();
-        CFileItemPtr item(new CFileItem);
-        int songID;
-        if (database.GetRandomSong(item.get(), songID, whereClause.first))
+        CWeightedSampler::Item songID;
+        CFileItemList items;
+        int misses = 0;
+        while (items.Size() == 0 && misses < MAX_STALE_PICKS && m_songSampler.Pick(songID))
+        {
+          CStdString where;
+          where.Format("where songview.idsong = %i", songID.second);
+          database.GetSongsByWhere("", where, items);
+          if (items.Size() == 0)
+          { // gone from the library since the index was built, so don't pick it again
+            m_songSampler.Remove(songID);
+            m_iMatchingSongs--;
+            misses++;
+          }
+        }
+        if (items.Size())
         { // success
+          CFileItemPtr item(items[0]);
           Add(item);
-          AddToHistory(1,songID);
         }
         else
         {
@@ -378,25 +403,31 @@ bool CPartyModeManager::AddRandomSongs(int iSongs /* = 0 */)
     if (database.Open())
     {
       // Method:
-      // 1. Grab a random entry from the database using a where clause
-      // 2. Iterate on iSongs.
-
-      // Note: At present, this method is faster than the alternative, which is to grab
-      // all valid songids, then select a random number of them (as done in AddInitialSongs()).
-      // The reason for this is simply the number of songs we are requesting - we generally
-      // only want one here.  Any more than about 3 songs and it is more efficient
-      // to use the technique in AddInitialSongs.  As it's unlikely that we'll require
-      // more than 1 song at a time here, this method is faster.
+      // 1. Pick a random id from the sampling index, which avoids the history
+      // 2. Fetch the music video by its id, dropping ids which have since been removed
+      // 3. Iterate on iSongs.
       bool error(false);
       for (int i = 0; i < iVidsToAdd; i++)
       {
-        pair<CStdString,CStdString> whereClause = GetWhereClauseWithHistory();
-        CFileItemPtr item(new CFileItem);
-        int songID;
-        if (database.GetRandomMusicVideo(item.get(), songID, whereClause.second))
+        CWeightedSampler::Item videoID;
+        CFileItemList items;
+        int misses = 0;
+        while (items.Size() == 0 && misses < MAX_STALE_PICKS && m_videoSampler.Pick(videoID))
+        {
+          CStdString where;
+          where.Format("where idmvideo = %i", videoID.second);
+          database.GetMusicVideosByWhere("videodb://3/2/", where, items);
+          if (items.Size() == 0)
+          { // gone from the library since the index was built, so don't pick it again
+            m_videoSampler.Remove(videoID);
+            m_iMatchingSongs--;
+            misses++;
+          }
+        }
+        if (items.Size())
         { // success
+          CFileItemPtr item(items[0]);
           Add(item);
-          AddToHistory(2,songID);
         }
         else
         {
@@ -419,6 +450,8 @@ bool CPartyModeManager::AddRandomSongs(int iSongs /* = 0 */)
     }
     database.Close();
   }
+  if (m_iMatchingSongsPicked > picked)
+    CLog::Log(LOGDEBUG, "%s - picked %i songs in %u ms", __FUNCTION__, m_iMatchingSongsPicked - picked, CTimeUtils::GetTimeMS() - time);
   return true;
 }
 
@@ -561,7 +594,9 @@ void CPartyModeManager::ClearState()
   m_iRandomSongs = 0;
 
   m_songsInHistory = 0;
-  m_history.clear();
+  m_songSampler.Clear();
+  m_videoSampler.Clear();
+  m_sampleIndexTime = 0;
 }
 
 void CPartyModeManager::UpdateStats()
@@ -583,8 +618,29 @@ bool CPartyModeManager::AddInitialSongs(vector<pair<int,int> > &songIDs)
     if (iMissingSongs > (int)songIDs.size())
       return false; // can't do it if we have less songs than we need
 
+    // pick from songs and music videos in proportion to their numbers. The history only
+    // covers half the ids, so repeats are skipped here, and if the weights make the last few
+    // hard to find the queue is topped up from the rest in random order
+    set<pair<int,int> > chosen;
     vector<pair<int,int> > chosenSongIDs;
-    GetRandomSelection(songIDs, iMissingSongs, chosenSongIDs);
+    unsigned int total = m_songSampler.Size() + m_videoSampler.Size();
+    for (int attempt = 0; total && (int)chosenSongIDs.size() < iMissingSongs && attempt < iMissingSongs * 32; attempt++)
+    {
+      CWeightedSampler::Item item;
+      CWeightedSampler &sampler = (unsigned int)(rand() % total) < m_songSampler.Size() ? m_songSampler : m_videoSampler;
+      if (sampler.Pick(item) && chosen.insert(item).second)
+        chosenSongIDs.push_back(item);
+    }
+    if ((int)chosenSongIDs.size() < iMissingSongs)
+    {
+      vector<pair<int,int> > rest(songIDs);
+      random_shuffle(rest.begin(), rest.end());
+      for (unsigned int i = 0; i < rest.size() && (int)chosenSongIDs.size() < iMissingSongs; i++)
+      {
+        if (chosen.insert(rest[i]).second)
+          chosenSongIDs.push_back(rest[i]);
+      }
+    }
     CStdString sqlWhereMusic = "where songview.idsong in (";
     CStdString sqlWhereVideo = "where idmvideo in (";
 
@@ -615,7 +671,6 @@ bool CPartyModeManager::AddInitialSongs(vector<pair<int,int> > &songIDs)
       database.GetMusicVideosByWhere("videodb://3/2/", sqlWhereVideo, items);
     }
 
-    m_history = chosenSongIDs;
     items.Randomize(); //randomizing the initial list or they will be in database order
     for (int i = 0; i < items.Size(); i++)
     {
@@ -627,55 +682,66 @@ bool CPartyModeManager::AddInitialSongs(vector<pair<int,int> > &songIDs)
   return true;
 }
 
-pair<CStdString,CStdString> CPartyModeManager::GetWhereClauseWithHistory() const
+void CPartyModeManager::SetSampleIndex(const vector< pair<int,int> > &songIDs, const vector< pair<int,int> > &videoIDs)
 {
-  CStdString historyWhereMusic;
-  CStdString historyWhereVideo;
-  // now add this on to the normal where clause
-  if (m_history.size())
-  {
-    if (m_strCurrentFilterMusic.IsEmpty())
-      historyWhereMusic = "where songview.idsong not in (";
-    else
-      historyWhereMusic = m_strCurrentFilterMusic + " and songview.idsong not in (";
-    if (m_strCurrentFilterVideo.IsEmpty())
-      historyWhereVideo = "where idmvideo not in (";
-    else
-      historyWhereVideo = m_strCurrentFilterVideo + " and idmvideo not in (";
+  unsigned int time = CTimeUtils::GetTimeMS();
 
-    for (unsigned int i = 0; i < m_history.size(); i++)
+  // weight the songs by rating or play count if asked to, giving songs without
+  // either a base weight so that they still get picked
+  vector<float> weights;
+  int weighting = g_advancedSettings.m_iMusicLibraryPartyModeWeighting;
+  if (weighting && !songIDs.empty())
+  {
+    vector<int> ratings, playCounts;
+    CMusicDatabase db;
+    if (db.Open() && db.GetSongRatingsAndPlayCounts(songIDs, ratings, playCounts))
     {
-      CStdString number;
-      number.Format("%i,", m_history[i].second);
-      if (m_history[i].first == 1)
-        historyWhereMusic += number;
-      if (m_history[i].first == 2)
-        historyWhereVideo += number;
+      weights.resize(songIDs.size());
+      for (unsigned int i = 0; i < songIDs.size(); i++)
+        weights[i] = (weighting == 1) ? 1.0f + ratings[i] : 1.0f + (float)log(1.0 + playCounts[i]);
     }
-    historyWhereMusic.TrimRight(",");
-    historyWhereMusic += ")";
-    historyWhereVideo.TrimRight(",");
-    historyWhereVideo += ")";
   }
-  return make_pair(historyWhereMusic,historyWhereVideo);
-}
+  m_songSampler.Set(songIDs, weights);
+  m_videoSampler.Set(videoIDs, vector<float>());
 
-void CPartyModeManager::AddToHistory(int type, int songID)
-{
-  while (m_history.size() >= m_songsInHistory && m_songsInHistory)
-    m_history.erase(m_history.begin());
-  m_history.push_back(make_pair<int,int>(type,songID));
+  // songs and videos are picked separately, so each keeps its own history
+  m_songSampler.SetHistorySize(m_songsInHistory);
+  m_videoSampler.SetHistorySize(m_songsInHistory);
+
+  m_sampleIndexTime = CTimeUtils::GetTimeMS();
+  CLog::Log(LOGDEBUG, "%s - indexed %u songs and %u music videos in %u ms", __FUNCTION__, (unsigned int)songIDs.size(), (unsigned int)videoIDs.size(), m_sampleIndexTime - time);
 }
 
-void CPartyModeManager::GetRandomSelection(vector< pair<int,int> >& in, unsigned int number, vector< pair<int,int> >& out)
+bool CPartyModeManager::RefreshSampleIndex()
 {
-  // only works if we have < 32768 in the in vector
-  for (unsigned int i = 0; i < number; i++)
+  // a failed refresh keeps the old index until the next refresh is due, rather than being retried for every song added
+  m_sampleIndexTime = CTimeUtils::GetTimeMS();
+
+  // no ids back is either an error or nothing matching any more. In mixed mode one of
+  // the two may legitimately be empty, so only give up if both are
+  vector< pair<int,int> > songIDs, videoIDs;
+  if (m_type.Equals("songs") || m_type.Equals("mixed"))
+  {
+    CMusicDatabase db;
+    if (!db.Open())
+      return false;
+    db.GetSongIDs(m_strCurrentFilterMusic, songIDs);
+  }
+  if (m_type.Equals("musicvideos") || m_type.Equals("mixed"))
   {
-    int num = rand() % in.size();
-    out.push_back(in[num]);
-    in.erase(in.begin() + num);
+    CVideoDatabase db;
+    if (!db.Open())
+      return false;
+    db.GetMusicVideoIDs(m_strCurrentFilterVideo, videoIDs);
   }
+  if (songIDs.empty() && videoIDs.empty())
+  {
+    CLog::Log(LOGWARNING, "%s - no matching songs, keeping the previous index", __FUNCTION__);
+    return false;
+  }
+  m_iMatchingSongs = (int)(songIDs.size() + videoIDs.size());
+  SetSampleIndex(songIDs, videoIDs);
+  return true;
 }
 
 bool CPartyModeManager::IsEnabled(PartyModeContext context /* = PARTYMODECONTEXT_UNKNOWN */) const
@@ -21,6 +21,7 @@
  */
 
 #include "StdString.h"
+#include "utils/WeightedSampler.h"
 
 #include <boost/shared_ptr.hpp>
 
@@ -69,9 +70,8 @@ private:
   void OnError(int iError, const CStdString& strLogMessage);
   void ClearState();
   void UpdateStats();
-  std::pair<CStdString,CStdString> GetWhereClauseWithHistory() const;
-  void AddToHistory(int type, int songID);
-  void GetRandomSelection(std::vector< std::pair<int,int> > &in, unsigned int number, std::vector< std::pair<int, int> > &out);
+  void SetSampleIndex(const std::vector< std::pair<int,int> > &songIDs, const std::vector< std::pair<int,int> > &videoIDs);
+  bool RefreshSampleIndex();
 
   // state
   bool m_bEnabled;
@@ -89,9 +89,11 @@ private:
   int m_iRelaxedSongs;
   int m_iRandomSongs;
 
-  // history
+  // sampling index, with the history of picks that shouldn't be repeated
   unsigned int m_songsInHistory;
-  std::vector< std::pair<int,int> > m_history;
+  CWeightedSampler m_songSampler;
+  CWeightedSampler m_videoSampler;
+  unsigned int m_sampleIndexTime;
 };
 
 extern CPartyModeManager g_partyModeManager;
@@ -28,6 +28,7 @@
 #include "Util.h"
 #include "DllImageLib.h"
 #include "utils/log.h"
+#include "utils/TimeUtils.h"
 
 using namespace XFILE;
 
@@ -55,21 +56,25 @@ bool CPicture::CacheImage(const CStdString& sourceUrl, const CStdString& destFil
       CStdString data;
       if (http.Get(sourceUrl, data))
       {
+        unsigned int time = CTimeUtils::GetTimeMS();
         if (!dll.CreateThumbnailFromMemory((BYTE *)data.c_str(), data.GetLength(), CUtil::GetExtension(sourceUrl).c_str(), destFile.c_str(), width, height))
         {
           CLog::Log(LOGERROR, "%s Unable to create new image %s from image %s", __FUNCTION__, destFile.c_str(), sourceUrl.c_str());
           return false;
         }
+        CLog::Log(LOGDEBUG, "%s - decoded and resized %u bytes in %u ms", __FUNCTION__, (unsigned int)data.GetLength(), CTimeUtils::GetTimeMS() - time);
         return true;
       }
       return false;
     }
 
+    unsigned int time = CTimeUtils::GetTimeMS();
     if (!dll.CreateThumbnail(sourceUrl.c_str(), destFile.c_str(), width, height, g_guiSettings.GetBool("pictures.useexifrotation")))
     {
       CLog::Log(LOGERROR, "%s Unable to create new image %s from image %s", __FUNCTION__, destFile.c_str(), sourceUrl.c_str());
       return false;
     }
+    CLog::Log(LOGDEBUG, "%s - decoded and resized in %u ms", __FUNCTION__, CTimeUtils::GetTimeMS() - time);
     return true;
   }
   else
@@ -30,10 +30,105 @@
 #include "Util.h"
 #include "DateTime.h"
 #include "LocalizeStrings.h"
+#include "utils/CriticalSection.h"
+#include "utils/SingleLock.h"
+#include "utils/TimeUtils.h"
+
+#include <algorithm>
+#include <map>
 
 using namespace std;
 using namespace XFILE;
 
+// compiled where clauses kept, beyond which the cache is emptied
+#define MAX_COMPILED_PLAYLISTS 100
+
+/*!
+ \brief Compiled where clauses of smart playlists, see CSmartPlaylist::GetWhereClause().
+ An entry is valid while the playlists and folders it was built from are unchanged, and, for
+ clauses holding a date, until the day changes.
+ */
+class CSmartPlaylistCache
+{
+public:
+  static CSmartPlaylistCache &Get();
+
+  bool Find(const CStdString &key, CStdString &clause, CSmartPlaylistIncludes &includes);
+  void Add(const CStdString &key, const CStdString &clause, const CSmartPlaylistIncludes &includes);
+
+private:
+  struct Entry
+  {
+    CStdString clause;
+    CSmartPlaylistIncludes includes;
+    std::vector<int64_t> stamps;  ///< modification stamp of each of includes.files
+    CStdString date;              ///< the day the clause was compiled, if includes.dated
+  };
+
+  static int64_t GetStamp(const CStdString &file);
+
+  CCriticalSection m_section;
+  std::map<CStdString, Entry> m_entries;
+};
+
+CSmartPlaylistCache &CSmartPlaylistCache::Get()
+{
+  static CSmartPlaylistCache cache;
+  return cache;
+}
+
+bool CSmartPlaylistCache::Find(const CStdString &key, CStdString &clause, CSmartPlaylistIncludes &includes)
+{
+  CSingleLock lock(m_section);
+  map<CStdString, Entry>::iterator it = m_entries.find(key);
+  if (it == m_entries.end())
+    return false;
+
+  const Entry &entry = it->second;
+  bool valid = !entry.includes.dated || entry.date == CDateTime::GetCurrentDateTime().GetAsDBDate();
+  for (unsigned int i = 0; valid && i < entry.includes.files.size(); i++)
+    valid = GetStamp(entry.includes.files[i]) == entry.stamps[i];
+  if (!valid)
+  {
+    m_entries.erase(it);
+    return false;
+  }
+
+  clause = entry.clause;
+  includes = entry.includes;
+  return true;
+}
+
+void CSmartPlaylistCache::Add(const CStdString &key, const CStdString &clause, const CSmartPlaylistIncludes &includes)
+{
+  Entry entry;
+  entry.clause = clause;
+  entry.includes = includes;
+  entry.includes.parents.clear();
+
+  // playlists included from several places only need checking once
+  vector<CStdString> &files = entry.includes.files;
+  sort(files.begin(), files.end());
+  files.erase(unique(files.begin(), files.end()), files.end());
+  for (unsigned int i = 0; i < files.size(); i++)
+    entry.stamps.push_back(GetStamp(files[i]));
+  if (includes.dated)
+    entry.date = CDateTime::GetCurrentDateTime().GetAsDBDate();
+
+  CSingleLock lock(m_section);
+  if (m_entries.size() >= MAX_COMPILED_PLAYLISTS)
+    m_entries.clear();
+  m_entries[key] = entry;
+}
+
+int64_t CSmartPlaylistCache::GetStamp(const CStdString &file)
+{
+  struct __stat64 stat;
+  if (CFile::Stat(file, &stat) != 0)
+    return -1;
+  return (int64_t)stat.st_mtime ^ ((int64_t)stat.st_size << 32);
+}
+
 typedef struct
 {
   char string[17];
@@ -382,7 +477,7 @@ CStdString CSmartPlaylistRule::GetVideoResolutionQuery(void)
   return retVal;
 }
 
-CStdString CSmartPlaylistRule::GetWhereClause(CDatabase &db, const CStdString& strType)
+CStdString CSmartPlaylistRule::GetWhereClause(CDatabase &db, const CStdString& strType, CSmartPlaylistIncludes *includes)
 {
   SEARCH_OPERATOR op = m_operator;
   if ((strType == "tvshows" || strType == "episodes") && m_field == FIELD_YEAR)
@@ -454,6 +549,8 @@ CStdString CSmartPlaylistRule::GetWhereClause(CDatabase &db, const CStdString& s
       span.SetFromPeriod(m_parameter);
       date-=span;
       parameter = db.PrepareSQL(operatorString.c_str(), date.GetAsDBDate().c_str());
+      if (includes)
+        includes->dated = true;
     }
   }
   else if (m_field == FIELD_TIME)
@@ -561,7 +658,15 @@ CStdString CSmartPlaylistRule::GetWhereClause(CDatabase &db, const CStdString& s
   else if (m_field == FIELD_PLAYLIST)
   { // playlist field - grab our playlist and add to our where clause
     CStdString playlistFile = CSmartPlaylistDirectory::GetPlaylistByName(m_parameter, strType);
-    if (!playlistFile.IsEmpty())
+    if (includes)
+    { // the clause depends on which playlists are in the folder, and on the one included
+      includes->files.push_back(CSmartPlaylistDirectory::GetPlaylistFolder(strType));
+      if (!playlistFile.IsEmpty())
+        includes->files.push_back(playlistFile);
+    }
+    if (includes && find(includes->parents.begin(), includes->parents.end(), playlistFile) != includes->parents.end())
+      CLog::Log(LOGWARNING, "%s - playlist %s includes itself, ignoring the rule", __FUNCTION__, playlistFile.c_str());
+    else if (!playlistFile.IsEmpty())
     {
       CSmartPlaylist playlist;
       playlist.Load(playlistFile);
@@ -570,7 +675,7 @@ CStdString CSmartPlaylistRule::GetWhereClause(CDatabase &db, const CStdString& s
       if (playlist.GetType().Equals(strType) || (playlist.GetType().Equals("mixed") && (strType == "songs" || strType == "musicvideos")) || playlist.GetType().IsEmpty())
       {
         playlist.SetType(strType);
-        playlistQuery = playlist.GetWhereClause(db, false);
+        playlistQuery = playlist.GetWhereClause(db, false, includes);
       }
       if (m_operator == OPERATOR_DOES_NOT_EQUAL && playlist.GetType().Equals(strType))
         query.Format("NOT (%s)", playlistQuery.c_str());
@@ -793,6 +898,7 @@ bool CSmartPlaylist::Load(const CStdString &path)
   TiXmlElement *root = OpenAndReadName(path);
   if (!root)
     return false;
+  m_path = path;
 
   // encoding:
   CStdString encoding;
@@ -906,17 +1012,63 @@ void CSmartPlaylist::AddRule(const CSmartPlaylistRule &rule)
   m_playlistRules.push_back(rule);
 }
 
-CStdString CSmartPlaylist::GetWhereClause(CDatabase &db, bool needWhere /* = true */)
+CStdString CSmartPlaylist::GetWhereClause(CDatabase &db, bool needWhere /* = true */, CSmartPlaylistIncludes *includes /* = NULL */)
+{
+  CStdString key = GetCacheKey(db);
+  CStdString clause;
+  CSmartPlaylistIncludes compiled;
+  if (!CSmartPlaylistCache::Get().Find(key, clause, compiled))
+  {
+    unsigned int time = CTimeUtils::GetTimeMS();
+    if (includes)
+      compiled.parents = includes->parents;
+    if (!m_path.IsEmpty())
+      compiled.parents.push_back(m_path);
+    clause = CompileWhereClause(db, compiled);
+    CSmartPlaylistCache::Get().Add(key, clause, compiled);
+
+    unsigned int nested = 0;
+    for (vector<CStdString>::const_iterator it = compiled.files.begin(); it != compiled.files.end(); ++it)
+      if (CUtil::GetExtension(*it).Equals(".xsp"))
+        nested++;
+    CLog::Log(LOGDEBUG, "%s - compiled %s (%u rules, %u nested playlists) in %u ms", __FUNCTION__, m_playlistName.c_str(),
+              (unsigned int)m_playlistRules.size(), nested, CTimeUtils::GetTimeMS() - time);
+  }
+
+  // pass what the clause depends on to the playlist including this one
+  if (includes)
+  {
+    includes->files.insert(includes->files.end(), compiled.files.begin(), compiled.files.end());
+    includes->dated |= compiled.dated;
+  }
+
+  if (needWhere && !clause.IsEmpty())
+    return "WHERE " + clause;
+  return clause;
+}
+
+CStdString CSmartPlaylist::GetCacheKey(CDatabase &db) const
+{
+  // the rules, and the quoting of the database as that differs between sqlite and mysql
+  CStdString key = db.PrepareSQL("%s", "'") + "|" + m_playlistType + (m_matchAllRules ? "|all" : "|one");
+  for (vector<CSmartPlaylistRule>::const_iterator it = m_playlistRules.begin(); it != m_playlistRules.end(); ++it)
+  {
+    CStdString rule;
+    rule.Format("|%i,%i,", it->m_field, it->m_operator);
+    key += rule + it->m_parameter;
+  }
+  return key;
+}
+
+CStdString CSmartPlaylist::CompileWhereClause(CDatabase &db, CSmartPlaylistIncludes &includes)
 {
   CStdString rule, currentRule;
   for (vector<CSmartPlaylistRule>::iterator it = m_playlistRules.begin(); it != m_playlistRules.end(); ++it)
   {
     if (it != m_playlistRules.begin())
       rule += m_matchAllRules ? " AND " : " OR ";
-    else if (needWhere)
-      rule += "WHERE ";
     rule += "(";
-    currentRule = (*it).GetWhereClause(db, GetType());
+    currentRule = (*it).GetWhereClause(db, GetType(), &includes);
     // if we don't get a rule, we add '1' or '0' so the query is still valid and doesn't fail
     if (currentRule.IsEmpty())
       currentRule = m_matchAllRules ? "'1'" : "'0'";
@@ -26,6 +26,17 @@
 
 class CDatabase;
 
+/*!
+ \brief What a compiled where clause depends on, gathered while nested playlists are expanded.
+ */
+struct CSmartPlaylistIncludes
+{
+  CSmartPlaylistIncludes() : dated(false) {}
+  std::vector<CStdString> files;    ///< playlists and playlist folders the clause was built from
+  std::vector<CStdString> parents;  ///< playlists being expanded, outermost first, to catch loops
+  bool dated;                       ///< whether the clause holds today's date
+};
+
 class CSmartPlaylistRule
 {
 public:
@@ -113,7 +124,7 @@ public:
                     TEXTIN_FIELD
                   };
 
-  CStdString GetWhereClause(CDatabase &db, const CStdString& strType);
+  CStdString GetWhereClause(CDatabase &db, const CStdString& strType, CSmartPlaylistIncludes *includes = NULL);
   void TranslateStrings(const char *field, const char *oper, const char *parameter);
   static DATABASE_FIELD TranslateField(const char *field);
   static CStdString     TranslateField(DATABASE_FIELD field);
@@ -166,7 +177,15 @@ public:
   bool GetOrderAscending() const { return m_orderAscending; };
 
   void AddRule(const CSmartPlaylistRule &rule);
-  CStdString GetWhereClause(CDatabase &db, bool needWhere = true);
+
+  /*! \brief Get the SQL condition selecting the items of the playlist.
+   The rules are compiled once, with any playlists they include expanded inline, and the result
+   is cached until the rules, an included playlist or the day changes.
+   \param db the database the condition is for
+   \param needWhere whether to start the condition with WHERE
+   \param includes [in/out] used while expanding nested playlists, NULL otherwise
+   */
+  CStdString GetWhereClause(CDatabase &db, bool needWhere = true, CSmartPlaylistIncludes *includes = NULL);
   CStdString GetOrderClause(CDatabase &db);
 
   const std::vector<CSmartPlaylistRule> &GetRules() const;
@@ -175,6 +194,11 @@ public:
 private:
   friend class CGUIDialogSmartPlaylistEditor;
 
+  CStdString GetCacheKey(CDatabase &db) const;
+  CStdString CompileWhereClause(CDatabase &db, CSmartPlaylistIncludes &includes);
+
+  CStdString m_path;
+
   std::vector<CSmartPlaylistRule> m_playlistRules;
   CStdString m_playlistName;
   CStdString m_playlistType;
@@ -54,7 +54,7 @@ bool SSortFileItem::Ascending(const CFileItemPtr &left, const CFileItemPtr &righ
   if (left->SortsOnTop() || left->SortsOnBottom())
     return false; // both have either sort on top or sort on bottom -> leave as-is
   if (left->m_bIsFolder == right->m_bIsFolder)
-    return StringUtils::AlphaNumericCompare(left->GetSortLabel().c_str(),right->GetSortLabel().c_str()) < 0;
+    return StringUtils::CompareSortKeys(left->GetSortKey(),right->GetSortKey()) < 0;
   return left->m_bIsFolder;
 }
 
@@ -71,7 +71,7 @@ bool SSortFileItem::Descending(const CFileItemPtr &left, const CFileItemPtr &rig
   if (left->SortsOnTop() || left->SortsOnBottom())
     return false; // both have either sort on top or sort on bottom -> leave as-is
   if (left->m_bIsFolder == right->m_bIsFolder)
-    return StringUtils::AlphaNumericCompare(left->GetSortLabel().c_str(),right->GetSortLabel().c_str()) > 0;
+    return StringUtils::CompareSortKeys(left->GetSortKey(),right->GetSortKey()) > 0;
   return left->m_bIsFolder;
 }
 
@@ -87,7 +87,7 @@ bool SSortFileItem::IgnoreFoldersAscending(const CFileItemPtr &left, const CFile
     return !left->SortsOnBottom();
   if (left->SortsOnTop() || left->SortsOnBottom())
     return false; // both have either sort on top or sort on bottom -> leave as-is
-  return StringUtils::AlphaNumericCompare(left->GetSortLabel().c_str(),right->GetSortLabel().c_str()) < 0;
+  return StringUtils::CompareSortKeys(left->GetSortKey(),right->GetSortKey()) < 0;
 }
 
 bool SSortFileItem::IgnoreFoldersDescending(const CFileItemPtr &left, const CFileItemPtr &right)
@@ -102,7 +102,7 @@ bool SSortFileItem::IgnoreFoldersDescending(const CFileItemPtr &left, const CFil
     return !left->SortsOnBottom();
   if (left->SortsOnTop() || left->SortsOnBottom())
     return false; // both have either sort on top or sort on bottom -> leave as-is
-  return StringUtils::AlphaNumericCompare(left->GetSortLabel().c_str(),right->GetSortLabel().c_str()) > 0;
+  return StringUtils::CompareSortKeys(left->GetSortKey(),right->GetSortKey()) > 0;
 }
 
 void SSortFileItem::ByLabel(CFileItemPtr &item)
@@ -35,6 +35,7 @@
 
 #include <math.h>
 #include <sstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -193,6 +194,55 @@ int64_t StringUtils::AlphaNumericCompare(const char *left, const char *right)
   return 0; // files are the same
 }
 
+void StringUtils::AlphaNumericSortKey(const char *label, CStdString &key)
+{
+  // AlphaNumericCompare compares runs of up to 15 digits by value, and everything else as
+  // lowercased bytes. Each run of digits becomes a '0' marker (so it compares against other
+  // characters as any digit would) followed by its value as 8 big-endian bytes. Other
+  // characters are lowercased and stored as-is, so can never be mistaken for a marker.
+  const unsigned char *l = (const unsigned char *)label;
+  key.clear();
+  key.reserve(strlen(label));
+  while (*l)
+  {
+    if (*l >= '0' && *l <= '9')
+    {
+      const unsigned char *ld = l;
+      uint64_t num = 0;
+      while (*ld >= '0' && *ld <= '9' && ld < l + 15)
+      { // compare only up to 15 digits
+        num *= 10;
+        num += *ld++ - '0';
+      }
+      char value[9];
+      value[0] = '0';
+      for (int i = 8; i > 0; i--)
+      {
+        value[i] = (char)(num & 0xff);
+        num >>= 8;
+      }
+      key.append(value, 9);
+      l = ld;
+      continue;
+    }
+    unsigned char c = *l++;
+    if (c >= 'A' && c <= 'Z')
+      c += 'a'-'A';
+    key += (char)c;
+  }
+}
+
+int StringUtils::CompareSortKeys(const CStdString &left, const CStdString &right)
+{
+  size_t length = std::min(left.size(), right.size());
+  int result = memcmp(left.c_str(), right.c_str(), length);
+  if (result)
+    return result;
+  if (left.size() < right.size())
+    return -1;
+  return left.size() > right.size() ? 1 : 0;
+}
+
 int StringUtils::DateStringToYYYYMMDD(const CStdString &dateString)
 {
   CStdStringArray days;
@@ -44,6 +44,19 @@ public:
   static int SplitString(const CStdString& input, const CStdString& delimiter, CStdStringArray &results, unsigned int iMaxStrings = 0);
   static int FindNumber(const CStdString& strInput, const CStdString &strFind);
   static int64_t AlphaNumericCompare(const char *left, const char *right);
+
+  /*! \brief Build a binary key for a label, such that comparing keys with CompareSortKeys
+   orders them exactly as AlphaNumericCompare() orders the labels themselves.
+   \param label the label to build the key for
+   \param key [out] the key
+   \sa CompareSortKeys
+   */
+  static void AlphaNumericSortKey(const char *label, CStdString &key);
+
+  /*! \brief Compare two keys built by AlphaNumericSortKey()
+   \return < 0 if left sorts before right, > 0 if it sorts after and 0 if they're the same
+   */
+  static int CompareSortKeys(const CStdString &left, const CStdString &right);
   static long TimeStringToSeconds(const CStdString &timeString);
   static void RemoveCRLF(CStdString& strLine);
 
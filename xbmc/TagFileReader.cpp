@@ -0,0 +1,192 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "TagFileReader.h"
+#include "utils/log.h"
+
+#include <string.h>
+
+using namespace XFILE;
+using namespace MUSIC_INFO;
+using namespace std;
+
+// blocks outside the head and tail are read in at least this size, as
+// parsers tend to walk forward through them
+#define WINDOW_SIZE 65536
+
+CTagFileReader::CTagFileReader()
+{
+  m_length = 0;
+  m_tailStart = 0;
+  m_windowStart = 0;
+  m_reads = 0;
+}
+
+CTagFileReader::~CTagFileReader()
+{
+  Close();
+}
+
+bool CTagFileReader::Open(const CStdString &strFile, unsigned int headSize, unsigned int tailSize)
+{
+  Close();
+  if (!m_file.Open(strFile))
+    return false;
+
+  m_length = m_file.GetLength();
+  if (m_length < 0)
+    m_length = 0;
+
+  // small files are read in one go
+  if ((int64_t)headSize + tailSize >= m_length)
+  {
+    headSize = (unsigned int)m_length;
+    tailSize = 0;
+  }
+
+  m_head.resize(headSize);
+  if (headSize && !ReadFile(0, &m_head[0], headSize))
+    m_head.clear();
+
+  m_tailStart = m_length - tailSize;
+  m_tail.resize(tailSize);
+  if (tailSize && !ReadFile(m_tailStart, &m_tail[0], tailSize))
+    m_tail.clear();
+
+  return true;
+}
+
+void CTagFileReader::Close()
+{
+  m_file.Close();
+  m_length = 0;
+  m_head.clear();
+  m_tail.clear();
+  m_tailStart = 0;
+  m_window.clear();
+  m_windowStart = 0;
+  m_reads = 0;
+}
+
+const char *CTagFileReader::GetBuffered(int64_t offset, unsigned int size) const
+{
+  if (offset + size <= (int64_t)m_head.size())
+    return &m_head[0] + offset;
+  if (!m_tail.empty() && offset >= m_tailStart && offset + size <= m_tailStart + (int64_t)m_tail.size())
+    return &m_tail[0] + (offset - m_tailStart);
+  if (!m_window.empty() && offset >= m_windowStart && offset + size <= m_windowStart + (int64_t)m_window.size())
+    return &m_window[0] + (offset - m_windowStart);
+  return NULL;
+}
+
+const char *CTagFileReader::GetData(int64_t offset, unsigned int size)
+{
+  if (offset < 0 || size > MAX_BLOCK_SIZE || offset + size > m_length)
+    return NULL;
+
+  if (size == 0)
+    return "";
+
+  const char *data = GetBuffered(offset, size);
+  if (data)
+    return data;
+
+  unsigned int windowSize = (unsigned int)min((int64_t)max(size, (unsigned int)WINDOW_SIZE), m_length - offset);
+  m_window.resize(windowSize);
+  m_windowStart = offset;
+  if (!ReadFile(offset, &m_window[0], windowSize))
+  {
+    m_window.clear();
+    return NULL;
+  }
+  return &m_window[0];
+}
+
+bool CTagFileReader::Read(int64_t offset, void *buffer, unsigned int size)
+{
+  if (offset < 0 || offset + size > m_length)
+    return false;
+
+  const char *data = GetBuffered(offset, size);
+  if (data)
+  {
+    memcpy(buffer, data, size);
+    return true;
+  }
+  return ReadFile(offset, buffer, size);
+}
+
+int64_t CTagFileReader::Find(int64_t offset, unsigned int size, const char *match, unsigned int matchSize)
+{
+  if (offset + size > m_length)
+    size = (unsigned int)max((int64_t)0, m_length - offset);
+  if (matchSize == 0 || size < matchSize)
+    return -1;
+
+  const char *data = GetData(offset, size);
+  if (!data)
+    return -1;
+
+  for (unsigned int i = 0; i + matchSize <= size; i++)
+  {
+    if (data[i] == match[0] && memcmp(data + i, match, matchSize) == 0)
+      return offset + i;
+  }
+  return -1;
+}
+
+unsigned int CTagFileReader::ReadUnsignedBE(int64_t offset)
+{
+  const unsigned char *data = (const unsigned char *)GetData(offset, 4);
+  if (!data)
+    return 0;
+  return ((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | (unsigned int)data[3];
+}
+
+unsigned int CTagFileReader::ReadUnsignedLE(int64_t offset)
+{
+  const unsigned char *data = (const unsigned char *)GetData(offset, 4);
+  if (!data)
+    return 0;
+  return ((unsigned int)data[3] << 24) | ((unsigned int)data[2] << 16) | ((unsigned int)data[1] << 8) | (unsigned int)data[0];
+}
+
+bool CTagFileReader::ReadFile(int64_t offset, void *buffer, unsigned int size)
+{
+  m_reads++;
+  if (m_file.Seek(offset, SEEK_SET) != offset)
+    return false;
+
+  unsigned int total = 0;
+  while (total < size)
+  {
+    unsigned int read = m_file.Read((char *)buffer + total, size - total);
+    if (read == 0)
+      break;
+    total += read;
+  }
+  if (total < size)
+  {
+    CLog::Log(LOGDEBUG, "%s - short read of %u bytes at %"PRId64, __FUNCTION__, size, offset);
+    return false;
+  }
+  return true;
+}
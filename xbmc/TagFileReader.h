@@ -0,0 +1,108 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include "FileSystem/File.h"
+
+#include <vector>
+
+namespace MUSIC_INFO
+{
+
+/*!
+ \ingroup music
+ \brief Buffered access to the parts of a file that hold its tags.
+
+ Tags live at the head of a file (ID3v2, FLAC metadata, most MP4 atoms) or at its tail
+ (ID3v1, APEv2, MP4 files with the moov atom last). The reader fetches both ends with one
+ large read each when the file is opened, and parsers then address the file by offset and
+ work straight from those buffers. Anything outside them is fetched with a single read into
+ a window, so a tag costs one or two round trips on network shares rather than one per field.
+
+ Large blocks that are rarely needed, such as embedded art, should be recorded as an offset
+ and size while parsing and only read with Read() once it's known they're wanted.
+ */
+class CTagFileReader
+{
+public:
+  CTagFileReader();
+  ~CTagFileReader();
+
+  /*! \brief Open a file and read its head and tail.
+   \param strFile the file to open
+   \param headSize number of bytes to read from the start of the file
+   \param tailSize number of bytes to read from the end of the file
+   \return true if the file was opened
+   */
+  bool Open(const CStdString &strFile, unsigned int headSize = 65536, unsigned int tailSize = 8192);
+  void Close();
+
+  int64_t GetLength() const { return m_length; };
+
+  /*! \brief Get a pointer to a block of the file without copying it.
+   The block comes from the head or tail buffers if they hold it, and is read into the window
+   otherwise. Pointers into the window are only valid until the next call that reads the file.
+   \param offset offset of the block in the file
+   \param size size of the block, which may not exceed the maximum block size
+   \return pointer to the block, or NULL if it runs past the end of the file or couldn't be read
+   */
+  const char *GetData(int64_t offset, unsigned int size);
+
+  /*! \brief Copy a block of the file into a buffer.
+   Reads directly into the buffer if the block isn't held by the head or tail buffers.
+   \return true if the whole block was read
+   */
+  bool Read(int64_t offset, void *buffer, unsigned int size);
+
+  /*! \brief Find a byte string within a range of the file.
+   \return the offset of the first match, or -1 if there is none
+   */
+  int64_t Find(int64_t offset, unsigned int size, const char *match, unsigned int matchSize);
+
+  /*! \brief Read big and little endian integers, returning 0 past the end of the file.
+   */
+  unsigned int ReadUnsignedBE(int64_t offset);
+  unsigned int ReadUnsignedLE(int64_t offset);
+
+  /*! \brief Number of reads issued on the file since it was opened.
+   */
+  unsigned int GetReadCount() const { return m_reads; };
+
+  /*! \brief The largest block GetData() will return, to bound the reads a corrupt size can cause.
+   */
+  static const unsigned int MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+private:
+  const char *GetBuffered(int64_t offset, unsigned int size) const;
+  bool ReadFile(int64_t offset, void *buffer, unsigned int size);
+
+  XFILE::CFile m_file;
+  int64_t m_length;
+  std::vector<char> m_head;       ///< the file from offset 0
+  std::vector<char> m_tail;       ///< the file from m_tailStart to the end
+  int64_t m_tailStart;
+  std::vector<char> m_window;     ///< last block read outside of the head and tail
+  int64_t m_windowStart;
+  unsigned int m_reads;
+};
+
+}
@@ -27,6 +27,7 @@
 #include "Settings.h"
 #include "AdvancedSettings.h"
 #include "utils/log.h"
+#include "utils/TimeUtils.h"
 
 #include "Texture.h"
 #include "DDSImage.h"
@@ -115,7 +116,12 @@ bool CTextureCache::CDDSJob::DoWork()
   { // convert to DDS
     CDDSImage dds;
     CLog::Log(LOGDEBUG, "Creating DDS version of: %s", m_original.c_str());
-    return dds.Create(CUtil::ReplaceExtension(m_original, ".dds"), texture.GetWidth(), texture.GetHeight(), texture.GetPitch(), texture.GetPixels(), 40);
+    // thumbs are many and small, so try the fast colour fit first for those
+    bool fast = texture.GetWidth() * texture.GetHeight() <= (unsigned int)(2 * g_advancedSettings.m_thumbSize * g_advancedSettings.m_thumbSize);
+    unsigned int time = CTimeUtils::GetTimeMS();
+    bool success = dds.Create(CUtil::ReplaceExtension(m_original, ".dds"), texture.GetWidth(), texture.GetHeight(), texture.GetPitch(), texture.GetPixels(), 40, fast);
+    CLog::Log(LOGDEBUG, "%s - compressed %ux%u %s in %u ms", __FUNCTION__, texture.GetWidth(), texture.GetHeight(), fast ? "thumb" : "image", CTimeUtils::GetTimeMS() - time);
+    return success;
   }
   return false;
 }
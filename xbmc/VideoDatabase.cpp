@@ -54,17 +54,43 @@ using namespace VIDEO;
 using namespace ADDON;
 
 #define VIDEO_DATABASE_VIEW_TVSHOW "SELECT tvshow.*,path.strPath AS strPath," \
-                                   "counts.totalcount AS totalCount,counts.watchedcount AS watchedCount," \
-                                   "counts.totalcount=counts.watchedcount AS watched FROM tvshow " \
+                                   "counts.totalCount AS totalCount,counts.watchedCount AS watchedCount," \
+                                   "counts.totalCount=counts.watchedCount AS watched FROM tvshow " \
                                    "JOIN tvshowlinkpath ON tvshow.idShow=tvshowlinkpath.idShow " \
                                    "JOIN path ON path.idpath=tvshowlinkpath.idPath " \
-                                   "LEFT OUTER join (" \
-                                   "    SELECT tvshow.idShow AS idShow,count(1) AS totalcount,count(files.playCount) AS watchedcount FROM tvshow " \
-                                   "    JOIN tvshowlinkepisode ON tvshow.idShow=tvshowlinkepisode.idShow " \
-                                   "    JOIN episode ON episode.idEpisode=tvshowlinkepisode.idEpisode " \
-                                   "    JOIN files ON files.idFile=episode.idFile " \
-                                   "    GROUP BY tvshow.idShow" \
-                                   ") counts ON tvshow.idShow=counts.idShow "
+                                   "LEFT OUTER JOIN tvshowcounts counts ON tvshow.idShow=counts.idShow "
+
+// link tables whose per item movie counts are kept in movielinkcounts.
+// the type doubles as the link table prefix and the id column suffix.
+static const char *movieLinkTypes[] = { "genre", "country", "studio", "actor", "director", "writer" };
+
+// aggregates behind the materialized navigation counts, %s is an optional where clause
+#define VIDEO_DATABASE_SHOW_COUNTS   "select tvshowlinkepisode.idShow,count(1),count(files.playCount) from tvshowlinkepisode " \
+                                     "join episode on episode.idEpisode=tvshowlinkepisode.idEpisode " \
+                                     "join files on files.idFile=episode.idFile %s " \
+                                     "group by tvshowlinkepisode.idShow"
+#define VIDEO_DATABASE_SEASON_COUNTS "select tvshowlinkepisode.idShow,episode.c%02d+0,count(1),count(files.playCount) from tvshowlinkepisode " \
+                                     "join episode on episode.idEpisode=tvshowlinkepisode.idEpisode " \
+                                     "join files on files.idFile=episode.idFile %s " \
+                                     "group by tvshowlinkepisode.idShow,episode.c%02d+0"
+#define VIDEO_DATABASE_LINK_COUNTS   "select '%s',%slinkmovie.id%s,count(1),count(files.playCount) from %slinkmovie " \
+                                     "join movie on movie.idMovie=%slinkmovie.idMovie " \
+                                     "join files on files.idFile=movie.idFile %s " \
+                                     "group by %slinkmovie.id%s"
+
+// Only sorts whose order in SQL is the same as CFileItemList::Sort() are pushed down - titles
+// are sorted naturally there and the rating, year and mpaa sorts fall back on the label, which
+// SQL can't reproduce. The last played time is stored as "YYYY-MM-DD HH:MM:SS", so it orders
+// the same either way.
+static const DatabaseSortColumn movieSortColumns[] = {
+  { SORT_METHOD_LASTPLAYED,   "movieview.lastPlayed",   false },
+  { SORT_METHOD_NONE,         NULL,                     false }
+};
+
+static const DatabaseSortColumn episodeSortColumns[] = {
+  { SORT_METHOD_LASTPLAYED,   "episodeview.lastPlayed", false },
+  { SORT_METHOD_NONE,         NULL,                     false }
+};
 
 //********************************************************************************************************************************
 CVideoDatabase::CVideoDatabase(void)
@@ -325,6 +351,16 @@ bool CVideoDatabase::CreateTables()
     m_pDS->exec("CREATE TABLE setlinkmovie ( idSet integer, idMovie integer)\n");
     m_pDS->exec("CREATE UNIQUE INDEX ix_setlinkmovie_1 ON setlinkmovie ( idSet, idMovie)\n");
     m_pDS->exec("CREATE UNIQUE INDEX ix_setlinkmovie_2 ON setlinkmovie ( idMovie, idSet)\n");
+
+    CLog::Log(LOGINFO, "create navigation count tables");
+    m_pDS->exec("CREATE TABLE tvshowcounts ( idShow integer, totalCount integer, watchedCount integer)\n");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_tvshowcounts ON tvshowcounts ( idShow )\n");
+    m_pDS->exec("CREATE TABLE seasoncounts ( idShow integer, season integer, totalCount integer, watchedCount integer)\n");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_seasoncounts ON seasoncounts ( idShow, season )\n");
+    m_pDS->exec("CREATE TABLE movielinkcounts ( strType varchar(24), idItem integer, totalCount integer, watchedCount integer)\n");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_movielinkcounts ON movielinkcounts ( strType, idItem )\n");
+
+    CreateSearchIndex();
   }
   catch (...)
   {
@@ -1537,6 +1573,31 @@ void CVideoDatabase::GetMusicVideoInfo(const CStdString& strFilenameAndPath, CVi
   }
 }
 
+bool CVideoDatabase::GetScraperXml(CVideoInfoTag& details, bool isFolder /* = false */)
+{
+  if (details.m_iDbId < 0)
+    return false;
+  if (!details.m_strPictureURL.m_xml.IsEmpty() || !details.m_fanart.m_xml.IsEmpty())
+    return true;
+
+  VIDEODB_CONTENT_TYPE type = VIDEODB_CONTENT_MOVIES;
+  if (!details.m_strArtist.IsEmpty())
+    type = VIDEODB_CONTENT_MUSICVIDEOS;
+  else if (details.m_iSeason > -1 && !isFolder)
+    type = VIDEODB_CONTENT_EPISODES;
+  else if (!details.m_strShowTitle.IsEmpty())
+    type = VIDEODB_CONTENT_TVSHOWS;
+
+  // only take the scraper xml, the listed tag may carry counts the full details don't have
+  CVideoInfoTag full = GetDetailsByTypeAndId(type, details.m_iDbId);
+  if (full.m_iDbId < 0)
+    return false;
+  details.m_strPictureURL = full.m_strPictureURL;
+  details.m_fanart = full.m_fanart;
+  details.m_strEpisodeGuide = full.m_strEpisodeGuide;
+  return true;
+}
+
 void CVideoDatabase::AddGenreAndDirectorsAndStudios(const CVideoInfoTag& details, vector<int>& vecDirectors, vector<int>& vecGenres, vector<int>& vecStudios)
 {
   // add all directors
@@ -1706,6 +1767,11 @@ int CVideoDatabase::SetDetailsForMovie(const CStdString& strFilenameAndPath, con
     CStdString sql = "update movie set " + GetValueString(info, VIDEODB_ID_MIN, VIDEODB_ID_MAX, DbMovieOffsets);
     sql += PrepareSQL(" where idMovie=%i", idMovie);
     m_pDS->exec(sql.c_str());
+
+    vector< pair<CStdString, int> > links;
+    GetMovieLinks(idMovie, links);
+    UpdateMovieLinkCounts(links);
+    AddToSearchIndex(VIDEODB_CONTENT_MOVIES, idMovie, details.m_strTitle);
     CommitTransaction();
     return idMovie;
   }
@@ -1764,6 +1830,7 @@ int CVideoDatabase::SetDetailsForTvShow(const CStdString& strPath, const CVideoI
     CStdString sql = "update tvshow set " + GetValueString(details, VIDEODB_ID_TV_MIN, VIDEODB_ID_TV_MAX, DbTvShowOffsets);
     sql += PrepareSQL("where idShow=%i", idTvShow);
     m_pDS->exec(sql.c_str());
+    AddToSearchIndex(VIDEODB_CONTENT_TVSHOWS, idTvShow, details.m_strTitle);
     CommitTransaction();
     return idTvShow;
   }
@@ -1837,6 +1904,19 @@ int CVideoDatabase::SetDetailsForEpisode(const CStdString& strFilenameAndPath, c
     CStdString sql = "update episode set " + GetValueString(details, VIDEODB_ID_EPISODE_MIN, VIDEODB_ID_EPISODE_MAX, DbEpisodeOffsets);
     sql += PrepareSQL("where idEpisode=%i", idEpisode);
     m_pDS->exec(sql.c_str());
+
+    // the season may have changed, so refresh the counts of the show(s) the episode is in
+    vector<int> shows;
+    m_pDS->query(PrepareSQL("select idShow from tvshowlinkepisode where idEpisode=%i", idEpisode).c_str());
+    while (!m_pDS->eof())
+    {
+      shows.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    for (unsigned int i = 0; i < shows.size(); i++)
+      UpdateShowCounts(shows[i]);
+    AddToSearchIndex(VIDEODB_CONTENT_EPISODES, idEpisode, details.m_strTitle);
     CommitTransaction();
     return idEpisode;
   }
@@ -1908,6 +1988,7 @@ int CVideoDatabase::SetDetailsForMusicVideo(const CStdString& strFilenameAndPath
     CStdString sql = "update musicvideo set " + GetValueString(details, VIDEODB_ID_MUSICVIDEO_MIN, VIDEODB_ID_MUSICVIDEO_MAX, DbMusicVideoOffsets);
     sql += PrepareSQL(" where idMVideo=%i", idMVideo);
     m_pDS->exec(sql.c_str());
+    AddToSearchIndex(VIDEODB_CONTENT_MUSICVIDEOS, idMVideo, details.m_strTitle);
     CommitTransaction();
     return idMVideo;
   }
@@ -2294,6 +2375,10 @@ void CVideoDatabase::DeleteMovie(const CStdString& strFilenameAndPath, bool bKee
 
     BeginTransaction();
 
+    // the items this movie is linked to need their counts refreshed once it's gone
+    vector< pair<CStdString, int> > links;
+    GetMovieLinks(idMovie, links);
+
     CStdString strSQL;
     strSQL=PrepareSQL("delete from genrelinkmovie where idMovie=%i", idMovie);
     m_pDS->exec(strSQL.c_str());
@@ -2330,6 +2415,8 @@ void CVideoDatabase::DeleteMovie(const CStdString& strFilenameAndPath, bool bKee
 
       strSQL=PrepareSQL("delete from movielinktvshow where idMovie=%i", idMovie);
       m_pDS->exec(strSQL.c_str());
+
+      RemoveFromSearchIndex(VIDEODB_CONTENT_MOVIES, idMovie);
     }
     /*
     // work in progress
@@ -2341,6 +2428,8 @@ void CVideoDatabase::DeleteMovie(const CStdString& strFilenameAndPath, bool bKee
     }
     */
 
+    UpdateMovieLinkCounts(links);
+
     CStdString strPath, strFileName;
     SplitPath(strFilenameAndPath,strPath,strFileName);
     InvalidatePathHash(strPath);
@@ -2394,6 +2483,12 @@ void CVideoDatabase::DeleteTvShow(const CStdString& strPath, bool bKeepId /* = f
     strSQL=PrepareSQL("delete from studiolinktvshow where idShow=%i", idTvShow);
     m_pDS->exec(strSQL.c_str());
 
+    strSQL=PrepareSQL("delete from tvshowcounts where idShow=%i", idTvShow);
+    m_pDS->exec(strSQL.c_str());
+
+    strSQL=PrepareSQL("delete from seasoncounts where idShow=%i", idTvShow);
+    m_pDS->exec(strSQL.c_str());
+
     if (!bKeepThumb)
       DeleteThumbForItem(strPath,true);
 
@@ -2405,6 +2500,8 @@ void CVideoDatabase::DeleteTvShow(const CStdString& strPath, bool bKeepId /* = f
 
       strSQL=PrepareSQL("delete from movielinktvshow where idShow=%i", idTvShow);
       m_pDS->exec(strSQL.c_str());
+
+      RemoveFromSearchIndex(VIDEODB_CONTENT_TVSHOWS, idTvShow);
     }
 
     InvalidatePathHash(strPath);
@@ -2439,12 +2536,22 @@ void CVideoDatabase::DeleteEpisode(const CStdString& strFilenameAndPath, int idE
     strSQL=PrepareSQL("delete from directorlinkepisode where idEpisode=%i", idEpisode);
     m_pDS->exec(strSQL.c_str());
 
+    vector<int> shows;
     strSQL=PrepareSQL("select tvshowlinkepisode.idshow from tvshowlinkepisode where idEpisode=%i",idEpisode);
     m_pDS->query(strSQL.c_str());
+    while (!m_pDS->eof())
+    {
+      shows.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
 
     strSQL=PrepareSQL("delete from tvshowlinkepisode where idEpisode=%i", idEpisode);
     m_pDS->exec(strSQL.c_str());
 
+    for (unsigned int i = 0; i < shows.size(); i++)
+      UpdateShowCounts(shows[i]);
+
     if (!bKeepThumb)
       DeleteThumbForItem(strFilenameAndPath, false, idEpisode);
 
@@ -2458,6 +2565,8 @@ void CVideoDatabase::DeleteEpisode(const CStdString& strFilenameAndPath, int idE
 
       strSQL=PrepareSQL("delete from episode where idEpisode=%i", idEpisode);
       m_pDS->exec(strSQL.c_str());
+
+      RemoveFromSearchIndex(VIDEODB_CONTENT_EPISODES, idEpisode);
     }
 
   }
@@ -2507,6 +2616,8 @@ void CVideoDatabase::DeleteMusicVideo(const CStdString& strFilenameAndPath, bool
 
       strSQL=PrepareSQL("delete from musicvideo where idMVideo=%i", idMVideo);
       m_pDS->exec(strSQL.c_str());
+
+      RemoveFromSearchIndex(VIDEODB_CONTENT_MUSICVIDEOS, idMVideo);
     }
     /*
     // work in progress
@@ -2553,24 +2664,52 @@ void CVideoDatabase::DeleteSet(int idSet)
   }
 }
 
-void CVideoDatabase::GetDetailsFromDB(auto_ptr<Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset)
+// fields which hold few distinct values across a library, and so are shared between rows
+static bool IsRepeatedField(size_t offset)
+{
+  return offset == my_offsetof(CVideoInfoTag,m_strGenre)          ||
+         offset == my_offsetof(CVideoInfoTag,m_strStudio)         ||
+         offset == my_offsetof(CVideoInfoTag,m_strDirector)       ||
+         offset == my_offsetof(CVideoInfoTag,m_strWritingCredits) ||
+         offset == my_offsetof(CVideoInfoTag,m_strCountry)        ||
+         offset == my_offsetof(CVideoInfoTag,m_strMPAARating)     ||
+         offset == my_offsetof(CVideoInfoTag,m_strStatus)         ||
+         offset == my_offsetof(CVideoInfoTag,m_strRuntime);
+}
+
+// the scraper xml, which no listing shows - the info dialog and the scanner get the
+// full details through Get*Info() when they need it
+static bool IsScraperXmlField(size_t offset)
+{
+  return offset == my_offsetof(CVideoInfoTag,m_strPictureURL.m_xml)   ||
+         offset == my_offsetof(CVideoInfoTag,m_strPictureURL.m_spoof) ||
+         offset == my_offsetof(CVideoInfoTag,m_fanart.m_xml)          ||
+         offset == my_offsetof(CVideoInfoTag,m_strEpisodeGuide);
+}
+
+void CVideoDatabase::GetDetailsFromDB(auto_ptr<Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset, bool listing)
 {
   for (int i = min + 1; i < max; i++)
   {
     switch (offsets[i].type)
     {
     case VIDEODB_TYPE_STRING:
-      *(CStdString*)(((char*)&details)+offsets[i].offset) = pDS->fv(i+idxOffset).get_asString();
+      if (listing && IsScraperXmlField(offsets[i].offset))
+        break;
+      if (IsRepeatedField(offsets[i].offset))
+        *(CStdString*)(((char*)&details)+offsets[i].offset) = InternString(pDS->get_text(i+idxOffset));
+      else
+        *(CStdString*)(((char*)&details)+offsets[i].offset) = pDS->get_text(i+idxOffset);
       break;
     case VIDEODB_TYPE_INT:
     case VIDEODB_TYPE_COUNT:
-      *(int*)(((char*)&details)+offsets[i].offset) = pDS->fv(i+idxOffset).get_asInt();
+      *(int*)(((char*)&details)+offsets[i].offset) = pDS->get_int(i+idxOffset);
       break;
     case VIDEODB_TYPE_BOOL:
-      *(bool*)(((char*)&details)+offsets[i].offset) = pDS->fv(i+idxOffset).get_asBool();
+      *(bool*)(((char*)&details)+offsets[i].offset) = pDS->get_bool(i+idxOffset);
       break;
     case VIDEODB_TYPE_FLOAT:
-      *(float*)(((char*)&details)+offsets[i].offset) = pDS->fv(i+idxOffset).get_asFloat();
+      *(float*)(((char*)&details)+offsets[i].offset) = (float)pDS->get_double(i+idxOffset);
       break;
     }
   }
@@ -2665,15 +2804,15 @@ bool CVideoDatabase::GetStreamDetailsForFileId(CStreamDetails& details, int idFi
   return retVal;
 }
 
-CVideoInfoTag CVideoDatabase::GetDetailsForMovie(auto_ptr<Dataset> &pDS, bool needsCast /* = false */)
+CVideoInfoTag CVideoDatabase::GetDetailsForMovie(auto_ptr<Dataset> &pDS, bool needsCast /* = false */, bool listing /* = false */)
 {
   CVideoInfoTag details;
   details.Reset();
 
   DWORD time = CTimeUtils::GetTimeMS();
-  int idMovie = pDS->fv(0).get_asInt();
+  int idMovie = pDS->get_int(0);
 
-  GetDetailsFromDB(pDS, VIDEODB_ID_MIN, VIDEODB_ID_MAX, DbMovieOffsets, details);
+  GetDetailsFromDB(pDS, VIDEODB_ID_MIN, VIDEODB_ID_MAX, DbMovieOffsets, details, 2, listing);
 
   details.m_iDbId = idMovie;
   GetCommonDetails(pDS, details);
@@ -2730,7 +2869,7 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMovie(auto_ptr<Dataset> &pDS, bool ne
   return details;
 }
 
-CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(auto_ptr<Dataset> &pDS, bool needsCast /* = false */)
+CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(auto_ptr<Dataset> &pDS, bool needsCast /* = false */, bool listing /* = false */)
 {
   CVideoInfoTag details;
   details.Reset();
@@ -2738,9 +2877,9 @@ CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(auto_ptr<Dataset> &pDS, bool n
   DWORD time = CTimeUtils::GetTimeMS();
   int idTvShow = pDS->fv(0).get_asInt();
 
-  GetDetailsFromDB(pDS, VIDEODB_ID_TV_MIN, VIDEODB_ID_TV_MAX, DbTvShowOffsets, details, 1);
+  GetDetailsFromDB(pDS, VIDEODB_ID_TV_MIN, VIDEODB_ID_TV_MAX, DbTvShowOffsets, details, 1, listing);
   details.m_iDbId = idTvShow;
-  details.m_strPath = pDS->fv(VIDEODB_DETAILS_TVSHOW_PATH).get_asString();
+  details.m_strPath = InternString(pDS->fv(VIDEODB_DETAILS_TVSHOW_PATH).get_asString());
   details.m_iEpisode = m_pDS->fv(VIDEODB_DETAILS_TVSHOW_NUM_EPISODES).get_asInt();
   details.m_playCount = m_pDS->fv(VIDEODB_DETAILS_TVSHOW_NUM_WATCHED).get_asInt();
   details.m_strShowTitle = details.m_strTitle;
@@ -2767,23 +2906,24 @@ CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(auto_ptr<Dataset> &pDS, bool n
   return details;
 }
 
-CVideoInfoTag CVideoDatabase::GetDetailsForEpisode(auto_ptr<Dataset> &pDS, bool needsCast /* = false */)
+CVideoInfoTag CVideoDatabase::GetDetailsForEpisode(auto_ptr<Dataset> &pDS, bool needsCast /* = false */, bool listing /* = false */)
 {
   CVideoInfoTag details;
   details.Reset();
 
   DWORD time = CTimeUtils::GetTimeMS();
-  int idEpisode = pDS->fv(0).get_asInt();
+  int idEpisode = pDS->get_int(0);
 
-  GetDetailsFromDB(pDS, VIDEODB_ID_EPISODE_MIN, VIDEODB_ID_EPISODE_MAX, DbEpisodeOffsets, details);
+  GetDetailsFromDB(pDS, VIDEODB_ID_EPISODE_MIN, VIDEODB_ID_EPISODE_MAX, DbEpisodeOffsets, details, 2, listing);
   details.m_iDbId = idEpisode;
   GetCommonDetails(pDS, details);
   movieTime += CTimeUtils::GetTimeMS() - time; time = CTimeUtils::GetTimeMS();
 
-  details.m_strMPAARating = pDS->fv(VIDEODB_DETAILS_EPISODE_TVSHOW_MPAA).get_asString();
-  details.m_strShowTitle = pDS->fv(VIDEODB_DETAILS_EPISODE_TVSHOW_NAME).get_asString();
-  details.m_strStudio = pDS->fv(VIDEODB_DETAILS_EPISODE_TVSHOW_STUDIO).get_asString();
-  details.m_strPremiered = pDS->fv(VIDEODB_DETAILS_EPISODE_TVSHOW_AIRED).get_asString();
+  // these come from the show, so are the same for all of its episodes
+  details.m_strMPAARating = InternString(pDS->get_text(VIDEODB_DETAILS_EPISODE_TVSHOW_MPAA));
+  details.m_strShowTitle = InternString(pDS->get_text(VIDEODB_DETAILS_EPISODE_TVSHOW_NAME));
+  details.m_strStudio = InternString(pDS->get_text(VIDEODB_DETAILS_EPISODE_TVSHOW_STUDIO));
+  details.m_strPremiered = InternString(pDS->get_text(VIDEODB_DETAILS_EPISODE_TVSHOW_AIRED));
 
   GetStreamDetailsForFileId(details.m_streamDetails, details.m_iFileId);
 
@@ -2836,7 +2976,7 @@ CVideoInfoTag CVideoDatabase::GetDetailsForEpisode(auto_ptr<Dataset> &pDS, bool
   return details;
 }
 
-CVideoInfoTag CVideoDatabase::GetDetailsForMusicVideo(auto_ptr<Dataset> &pDS)
+CVideoInfoTag CVideoDatabase::GetDetailsForMusicVideo(auto_ptr<Dataset> &pDS, bool listing /* = false */)
 {
   CVideoInfoTag details;
   details.Reset();
@@ -2844,25 +2984,26 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMusicVideo(auto_ptr<Dataset> &pDS)
   DWORD time = CTimeUtils::GetTimeMS();
   int idMovie = pDS->fv(0).get_asInt();
 
-  GetDetailsFromDB(pDS, VIDEODB_ID_MUSICVIDEO_MIN, VIDEODB_ID_MUSICVIDEO_MAX, DbMusicVideoOffsets, details);
+  GetDetailsFromDB(pDS, VIDEODB_ID_MUSICVIDEO_MIN, VIDEODB_ID_MUSICVIDEO_MAX, DbMusicVideoOffsets, details, 2, listing);
   details.m_iDbId = idMovie;
   GetCommonDetails(pDS, details);
   movieTime += CTimeUtils::GetTimeMS() - time; time = CTimeUtils::GetTimeMS();
 
   GetStreamDetailsForFileId(details.m_streamDetails, details.m_iFileId);
 
-  details.m_strPictureURL.Parse();
+  if (!listing)
+    details.m_strPictureURL.Parse();
   return details;
 }
 
 void CVideoDatabase::GetCommonDetails(auto_ptr<Dataset> &pDS, CVideoInfoTag &details)
 {
-  details.m_iFileId = pDS->fv(VIDEODB_DETAILS_FILEID).get_asInt();
-  details.m_strPath = pDS->fv(VIDEODB_DETAILS_PATH).get_asString();
-  CStdString strFileName = pDS->fv(VIDEODB_DETAILS_FILE).get_asString();
+  details.m_iFileId = pDS->get_int(VIDEODB_DETAILS_FILEID);
+  details.m_strPath = InternString(pDS->get_text(VIDEODB_DETAILS_PATH));
+  CStdString strFileName = pDS->get_text(VIDEODB_DETAILS_FILE);
   ConstructPath(details.m_strFileNameAndPath,details.m_strPath,strFileName);
-  details.m_playCount = pDS->fv(VIDEODB_DETAILS_PLAYCOUNT).get_asInt();
-  details.m_lastPlayed = pDS->fv(VIDEODB_DETAILS_LASTPLAYED).get_asString();
+  details.m_playCount = pDS->get_int(VIDEODB_DETAILS_PLAYCOUNT);
+  details.m_lastPlayed = pDS->get_text(VIDEODB_DETAILS_LASTPLAYED);
 }
 
 /// \brief GetVideoSettings() obtains any saved video settings for the current file.
@@ -3304,6 +3445,18 @@ bool CVideoDatabase::UpdateOldVersion(int iVersion)
     {
       m_pDS->exec("DELETE FROM streamdetails"); //Roll the stream details as changed from minutes to seconds
     }
+    if (iVersion < 43)
+    {
+      m_pDS->exec("CREATE TABLE tvshowcounts ( idShow integer, totalCount integer, watchedCount integer)\n");
+      m_pDS->exec("CREATE UNIQUE INDEX ix_tvshowcounts ON tvshowcounts ( idShow )\n");
+      m_pDS->exec("CREATE TABLE seasoncounts ( idShow integer, season integer, totalCount integer, watchedCount integer)\n");
+      m_pDS->exec("CREATE UNIQUE INDEX ix_seasoncounts ON seasoncounts ( idShow, season )\n");
+      m_pDS->exec("CREATE TABLE movielinkcounts ( strType varchar(24), idItem integer, totalCount integer, watchedCount integer)\n");
+      m_pDS->exec("CREATE UNIQUE INDEX ix_movielinkcounts ON movielinkcounts ( strType, idItem )\n");
+      RebuildNavCounts();
+    }
+    if (iVersion < 44)
+      CreateSearchIndex();
   }
   catch (...)
   {
@@ -3379,7 +3532,16 @@ void CVideoDatabase::SetPlayCount(const CFileItem &item, int count, const CStdSt
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
-    CStdString strSQL;
+    // the navigation counts only change when the file flips between watched and unwatched
+    bool wasWatched = false;
+    CStdString strSQL = PrepareSQL("select playCount from files where idFile=%i", id);
+    if (m_pDS->query(strSQL.c_str()))
+    {
+      if (!m_pDS->eof())
+        wasWatched = m_pDS->fv(0).get_asInt() > 0;
+      m_pDS->close();
+    }
+
     if (count)
     {
       if (date.IsEmpty())
@@ -3396,6 +3558,9 @@ void CVideoDatabase::SetPlayCount(const CFileItem &item, int count, const CStdSt
     }
 
     m_pDS->exec(strSQL.c_str());
+
+    if (wasWatched != (count > 0))
+      UpdateCountsForFile(id);
   }
   catch (...)
   {
@@ -3446,6 +3611,8 @@ void CVideoDatabase::UpdateMovieTitle(int idMovie, const CStdString& strNewMovie
       strSQL = PrepareSQL("UPDATE sets SET strSet='%s' WHERE idSet=%i", strNewMovieTitle.c_str(), idMovie );
     }
     m_pDS->exec(strSQL.c_str());
+    if (iType != VIDEODB_CONTENT_MOVIE_SETS)
+      AddToSearchIndex(iType, idMovie, strNewMovieTitle);
   }
   catch (...)
   {
@@ -3505,8 +3672,8 @@ bool CVideoDatabase::GetNavCommon(const CStdString& strBaseDir, CFileItemList& i
     else
     {
       if (idContent == VIDEODB_CONTENT_MOVIES)
-        strSQL = PrepareSQL("select %s.id%s,%s.str%s,count(1),count(files.playCount) from %s join %slinkmovie on %s.id%s=%slinkmovie.id%s join movie on %slinkmovie.idMovie=movie.idMovie join files on files.idFile=movie.idFile group by %s.id%s",
-                           type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str());
+        strSQL = PrepareSQL("select %s.id%s,%s.str%s,movielinkcounts.totalCount,movielinkcounts.watchedCount from %s join movielinkcounts on movielinkcounts.idItem=%s.id%s where movielinkcounts.strType='%s' and movielinkcounts.totalCount > 0",
+                           type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str());
       else if (idContent == VIDEODB_CONTENT_TVSHOWS)
         strSQL = PrepareSQL("select distinct %s.id%s,%s.str%s from %s join %slinktvshow on %s.id%s=%slinktvshow.id%s join tvshow on %slinktvshow.idShow=tvshow.idShow",
                            type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str(), type.c_str());
@@ -3913,8 +4080,7 @@ bool CVideoDatabase::GetPeopleNav(const CStdString& strBaseDir, CFileItemList& i
     {
       if (idContent == VIDEODB_CONTENT_MOVIES)
       {
-        strSQL=PrepareSQL("select actors.idActor,actors.strActor,actors.strThumb,count(1),count(files.playCount) from actors join %slinkmovie on actors.idActor=%slinkmovie.id%s join movie on %slinkmovie.idMovie=movie.idMovie join files on files.idFile=movie.idFile", type.c_str(), type.c_str(), type.c_str(), type.c_str());
-        strSQL += " group by actors.idActor";
+        strSQL=PrepareSQL("select actors.idActor,actors.strActor,actors.strThumb,movielinkcounts.totalCount,movielinkcounts.watchedCount from actors join movielinkcounts on movielinkcounts.idItem=actors.idActor where movielinkcounts.strType='%s' and movielinkcounts.totalCount > 0", type.c_str());
       }
       else if (idContent == VIDEODB_CONTENT_TVSHOWS)
         strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor,actors.strThumb from actors,%slinktvshow,tvshow where actors.idActor=%slinktvshow.id%s and %slinktvshow.idShow=tvshow.idShow", type.c_str(), type.c_str(), type.c_str(), type.c_str());
@@ -4213,7 +4379,7 @@ bool CVideoDatabase::GetSeasonsNav(const CStdString& strBaseDir, CFileItemList&
     CStdString strIn = PrepareSQL("= %i", idShow);
     GetStackedTvShowList(idShow, strIn);
 
-    CStdString strSQL = PrepareSQL("select episode.c%02d,path.strPath,tvshow.c%02d,tvshow.c%02d,tvshow.c%02d,tvshow.c%02d,count(1),count(files.playCount) from episode join tvshowlinkepisode on tvshowlinkepisode.idEpisode=episode.idEpisode join tvshow on tvshow.idShow=tvshowlinkepisode.idShow join files on files.idFile=episode.idFile ", VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_GENRE, VIDEODB_ID_TV_STUDIOS, VIDEODB_ID_TV_MPAA);
+    CStdString strSQL = PrepareSQL("select seasoncounts.season,path.strPath,tvshow.c%02d,tvshow.c%02d,tvshow.c%02d,tvshow.c%02d,seasoncounts.totalCount,seasoncounts.watchedCount,seasoncounts.idShow from seasoncounts join tvshow on tvshow.idShow=seasoncounts.idShow ", VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_GENRE, VIDEODB_ID_TV_STUDIOS, VIDEODB_ID_TV_MPAA);
     CStdString joins = PrepareSQL(" join tvshowlinkpath on tvshowlinkpath.idShow = tvshow.idShow join path on path.idPath = tvshowlinkpath.idPath where tvshow.idShow %s ", strIn.c_str());
     CStdString extraJoins, extraWhere;
     if (idActor != -1)
@@ -4235,7 +4401,7 @@ bool CVideoDatabase::GetSeasonsNav(const CStdString& strBaseDir, CFileItemList&
     {
       extraWhere = PrepareSQL("and tvshow.c%02d like '%%%i%%'", VIDEODB_ID_TV_PREMIERED, idYear);
     }
-    strSQL += extraJoins + joins + extraWhere + PrepareSQL(" group by episode.c%02d", VIDEODB_ID_EPISODE_SEASON);
+    strSQL += extraJoins + joins + extraWhere;
 
     // run query
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
@@ -4252,102 +4418,75 @@ bool CVideoDatabase::GetSeasonsNav(const CStdString& strBaseDir, CFileItemList&
     CStdString showStudio = m_pDS->fv(4).get_asString();
     CStdString showMPAARating = m_pDS->fv(5).get_asString();
 
-    if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
+    // there is a row per show and season (and path of the show), so stacked
+    // shows have their seasons merged here
+    bool checkLocks = g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser;
+    map<int, CSeason> mapSeasons;
+    map<int, CSeason>::iterator it;
+    set< pair<int, int> > counted;
+    while (!m_pDS->eof())
     {
-      map<int, CSeason> mapSeasons;
-      map<int, CSeason>::iterator it;
-      while (!m_pDS->eof())
+      int iSeason = m_pDS->fv(0).get_asInt();
+      // check path
+      if (checkLocks && !g_passwordManager.IsDatabasePathUnlocked(CStdString(m_pDS->fv(1).get_asString()),g_settings.m_videoSources))
       {
-        int iSeason = m_pDS->fv(0).get_asInt();
-        it = mapSeasons.find(iSeason);
-        // check path
-        if (!g_passwordManager.IsDatabasePathUnlocked(CStdString(m_pDS->fv("path.strPath").get_asString()),g_settings.m_videoSources))
-        {
-          m_pDS->next();
-          continue;
-        }
-        if (it == mapSeasons.end())
-        {
-          CSeason season;
-          season.path = m_pDS->fv(1).get_asString();
-          season.genre = m_pDS->fv(3).get_asString();
-          season.numEpisodes = m_pDS->fv(6).get_asInt();
-          season.numWatched = m_pDS->fv(7).get_asInt();
-          mapSeasons.insert(make_pair(iSeason, season));
-        }
         m_pDS->next();
+        continue;
       }
-      m_pDS->close();
-
-      for (it=mapSeasons.begin();it != mapSeasons.end();++it)
+      if (!counted.insert(make_pair(m_pDS->fv(8).get_asInt(), iSeason)).second)
       {
-        int iSeason = it->first;
-        CStdString strLabel;
-        if (iSeason == 0)
-          strLabel = g_localizeStrings.Get(20381);
-        else
-          strLabel.Format(g_localizeStrings.Get(20358),iSeason);
-        CFileItemPtr pItem(new CFileItem(strLabel));
-        CStdString strDir;
-        strDir.Format("%ld/", it->first);
-        pItem->m_strPath=strBaseDir + strDir;
-        pItem->m_bIsFolder=true;
-        pItem->GetVideoInfoTag()->m_strTitle = strLabel;
-        pItem->GetVideoInfoTag()->m_iSeason = iSeason;
-        pItem->GetVideoInfoTag()->m_iDbId = idShow;
-        pItem->GetVideoInfoTag()->m_strPath = it->second.path;
-        pItem->GetVideoInfoTag()->m_strGenre = it->second.genre;
-        pItem->GetVideoInfoTag()->m_strStudio = showStudio;
-        pItem->GetVideoInfoTag()->m_strMPAARating = showMPAARating;
-        pItem->GetVideoInfoTag()->m_strShowTitle = showTitle;
-        pItem->GetVideoInfoTag()->m_iEpisode = it->second.numEpisodes;
-        pItem->SetProperty("totalepisodes", it->second.numEpisodes);
-        pItem->SetProperty("numepisodes", it->second.numEpisodes); // will be changed later to reflect watchmode setting
-        pItem->SetProperty("watchedepisodes", it->second.numWatched);
-        pItem->SetProperty("unwatchedepisodes", it->second.numEpisodes - it->second.numWatched);
-        pItem->GetVideoInfoTag()->m_playCount = (it->second.numEpisodes == it->second.numWatched) ? 1 : 0;
-        pItem->SetCachedSeasonThumb();
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, (pItem->GetVideoInfoTag()->m_playCount > 0) && (pItem->GetVideoInfoTag()->m_iEpisode > 0));
-        items.Add(pItem);
+        m_pDS->next();
+        continue;
       }
-    }
-    else
-    {
-      while (!m_pDS->eof())
+      it = mapSeasons.find(iSeason);
+      if (it == mapSeasons.end())
       {
-        int iSeason = m_pDS->fv(0).get_asInt();
-        CStdString strLabel;
-        if (iSeason == 0)
-          strLabel = g_localizeStrings.Get(20381);
-        else
-          strLabel.Format(g_localizeStrings.Get(20358),iSeason);
-        CFileItemPtr pItem(new CFileItem(strLabel));
-        CStdString strDir;
-        strDir.Format("%ld/", iSeason);
-        pItem->m_strPath=strBaseDir + strDir;
-        pItem->m_bIsFolder=true;
-        pItem->GetVideoInfoTag()->m_strTitle = strLabel;
-        pItem->GetVideoInfoTag()->m_iSeason = iSeason;
-        pItem->GetVideoInfoTag()->m_iDbId = idShow;
-        pItem->GetVideoInfoTag()->m_strPath = m_pDS->fv(1).get_asString();
-        pItem->GetVideoInfoTag()->m_strGenre = m_pDS->fv(3).get_asString();
-        pItem->GetVideoInfoTag()->m_strStudio = showStudio;
-        pItem->GetVideoInfoTag()->m_strMPAARating = showMPAARating;
-        pItem->GetVideoInfoTag()->m_strShowTitle = showTitle;
-        int totalEpisodes = m_pDS->fv(6).get_asInt();
-        int watchedEpisodes = m_pDS->fv(7).get_asInt();
-        pItem->GetVideoInfoTag()->m_iEpisode = totalEpisodes;
-        pItem->SetProperty("totalepisodes", totalEpisodes);
-        pItem->SetProperty("numepisodes", totalEpisodes); // will be changed later to reflect watchmode setting
-        pItem->SetProperty("watchedepisodes", watchedEpisodes);
-        pItem->SetProperty("unwatchedepisodes", totalEpisodes - watchedEpisodes);
-        pItem->GetVideoInfoTag()->m_playCount = (totalEpisodes == watchedEpisodes) ? 1 : 0;
-        pItem->SetCachedSeasonThumb();
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, (pItem->GetVideoInfoTag()->m_playCount > 0) && (pItem->GetVideoInfoTag()->m_iEpisode > 0));
-        items.Add(pItem);
-        m_pDS->next();
+        CSeason season;
+        season.path = m_pDS->fv(1).get_asString();
+        season.genre = m_pDS->fv(3).get_asString();
+        season.numEpisodes = m_pDS->fv(6).get_asInt();
+        season.numWatched = m_pDS->fv(7).get_asInt();
+        mapSeasons.insert(make_pair(iSeason, season));
       }
-      m_pDS->close();
+      else
+      {
+        it->second.numEpisodes += m_pDS->fv(6).get_asInt();
+        it->second.numWatched += m_pDS->fv(7).get_asInt();
+      }
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    for (it=mapSeasons.begin();it != mapSeasons.end();++it)
+    {
+      int iSeason = it->first;
+      CStdString strLabel;
+      if (iSeason == 0)
+        strLabel = g_localizeStrings.Get(20381);
+      else
+        strLabel.Format(g_localizeStrings.Get(20358),iSeason);
+      CFileItemPtr pItem(new CFileItem(strLabel));
+      CStdString strDir;
+      strDir.Format("%ld/", it->first);
+      pItem->m_strPath=strBaseDir + strDir;
+      pItem->m_bIsFolder=true;
+      pItem->GetVideoInfoTag()->m_strTitle = strLabel;
+      pItem->GetVideoInfoTag()->m_iSeason = iSeason;
+      pItem->GetVideoInfoTag()->m_iDbId = idShow;
+      pItem->GetVideoInfoTag()->m_strPath = it->second.path;
+      pItem->GetVideoInfoTag()->m_strGenre = it->second.genre;
+      pItem->GetVideoInfoTag()->m_strStudio = showStudio;
+      pItem->GetVideoInfoTag()->m_strMPAARating = showMPAARating;
+      pItem->GetVideoInfoTag()->m_strShowTitle = showTitle;
+      pItem->GetVideoInfoTag()->m_iEpisode = it->second.numEpisodes;
+      pItem->SetProperty("totalepisodes", it->second.numEpisodes);
+      pItem->SetProperty("numepisodes", it->second.numEpisodes); // will be changed later to reflect watchmode setting
+      pItem->SetProperty("watchedepisodes", it->second.numWatched);
+      pItem->SetProperty("unwatchedepisodes", it->second.numEpisodes - it->second.numWatched);
+      pItem->GetVideoInfoTag()->m_playCount = (it->second.numEpisodes == it->second.numWatched) ? 1 : 0;
+      pItem->SetCachedSeasonThumb();
+      pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, (pItem->GetVideoInfoTag()->m_playCount > 0) && (pItem->GetVideoInfoTag()->m_iEpisode > 0));
+      items.Add(pItem);
     }
     // now add any linked movies
     CStdString where = PrepareSQL("join movielinktvshow on movielinktvshow.idMovie=movieview.idMovie where movielinktvshow.idShow %s", strIn.c_str());
@@ -4361,7 +4500,7 @@ bool CVideoDatabase::GetSeasonsNav(const CStdString& strBaseDir, CFileItemList&
   return false;
 }
 
-bool CVideoDatabase::GetMoviesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idYear, int idActor, int idDirector, int idStudio, int idCountry, int idSet)
+bool CVideoDatabase::GetMoviesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idYear, int idActor, int idDirector, int idStudio, int idCountry, int idSet, DatabaseLimits *limits)
 {
   CStdString where;
   if (idGenre != -1)
@@ -4379,10 +4518,10 @@ bool CVideoDatabase::GetMoviesNav(const CStdString& strBaseDir, CFileItemList& i
   else if (idSet != -1)
     where = PrepareSQL("join setlinkmovie on setlinkmovie.idMovie=movieview.idMovie where setlinkmovie.idSet=%u",idSet);
 
-  return GetMoviesByWhere(strBaseDir, where, "", items, idSet == -1);
+  return GetMoviesByWhere(strBaseDir, where, "", items, idSet == -1, limits);
 }
 
-bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdString &where, const CStdString &order, CFileItemList& items, bool fetchSets)
+bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdString &where, const CStdString &order, CFileItemList& items, bool fetchSets, DatabaseLimits *limits)
 {
   try
   {
@@ -4393,7 +4532,8 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    CStdString strSQL = "select * from movieview ";
+    int numItems = items.Size();
+    CStdString movieWhere = where;
     if (fetchSets)
     {
       // not getting a set, so grab all sets that match this where clause first
@@ -4402,21 +4542,28 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
         setsWhere = " where movie.idMovie in (select movieview.idMovie from movieview " + where + ")";
       GetSetsNav("videodb://1/7/", items, VIDEODB_CONTENT_MOVIES, setsWhere);
       if (where.size())
-        strSQL += where + PrepareSQL(" and movieview.idMovie NOT in (select idMovie from setlinkmovie)");
+        movieWhere += PrepareSQL(" and movieview.idMovie NOT in (select idMovie from setlinkmovie)");
       else
-        strSQL += PrepareSQL("WHERE movieview.idMovie NOT IN (SELECT idMovie FROM setlinkmovie s1 JOIN(SELECT idSet, COUNT(1) AS c FROM setlinkmovie GROUP BY idSet HAVING c>1) s2 ON s2.idSet=s1.idSet)");
+        movieWhere = PrepareSQL("WHERE movieview.idMovie NOT IN (SELECT idMovie FROM setlinkmovie s1 JOIN(SELECT idSet, COUNT(1) AS c FROM setlinkmovie GROUP BY idSet HAVING c>1) s2 ON s2.idSet=s1.idSet)");
     }
-    else
-      strSQL += where;
+    CStdString strSQL = "select * from movieview " + movieWhere;
 
-    if (order.size())
+    // the database can only page the listing if it is all movies and none of them are
+    // hidden by source locks, otherwise the caller gets all of it
+    CStdString sqlOrder, sqlLimit;
+    if (limits && items.Size() == numItems &&
+        (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser) &&
+        PrepareLimits("movieview", movieWhere, movieSortColumns, "movieview.idMovie", *limits, sqlOrder, sqlLimit))
+    {
+      strSQL += " " + (sqlOrder.IsEmpty() ? order : sqlOrder) + sqlLimit;
+    }
+    else if (order.size())
       strSQL += " " + order;
 
-    // run query
+    // run query - rows are read from a cursor as we go, rather than all up front
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
+    if (!m_pDS->query_cursor(strSQL.c_str())) return false;
+    if (m_pDS->eof())
     {
       m_pDS->close();
       return true;
@@ -4426,10 +4573,9 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
               CTimeUtils::GetTimeMS() - time); time = CTimeUtils::GetTimeMS();
 
     // get data from returned rows
-    items.Reserve(iRowsFound);
     while (!m_pDS->eof())
     {
-      CVideoInfoTag movie = GetDetailsForMovie(m_pDS);
+      CVideoInfoTag movie = GetDetailsForMovie(m_pDS, false, true);
       if (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
           g_passwordManager.bMasterUser                                   ||
           g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, g_settings.m_videoSources))
@@ -4442,8 +4588,7 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
       m_pDS->next();
     }
 
-    CLog::Log(LOGDEBUG,"Time to retrieve movies from dataset = %d",
-              CTimeUtils::GetTimeMS() - time);
+    LogListingTime(__FUNCTION__, items.Size(), CTimeUtils::GetTimeMS() - time);
 
     // cleanup
     m_pDS->close();
@@ -4504,7 +4649,7 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const CStdS
     {
       int idShow = m_pDS->fv("tvshow.idShow").get_asInt();
 
-      CVideoInfoTag movie = GetDetailsForTvShow(m_pDS, false);
+      CVideoInfoTag movie = GetDetailsForTvShow(m_pDS, false, true);
       if (!g_advancedSettings.m_bVideoLibraryHideEmptySeries || movie.m_iEpisode > 0)
       {
         CFileItemPtr pItem(new CFileItem(movie));
@@ -4522,8 +4667,7 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const CStdS
       m_pDS->next();
     }
 
-    CLog::Log(LOGDEBUG,"Time to retrieve tvshows from dataset = %d",
-              CTimeUtils::GetTimeMS() - time);
+    LogListingTime(__FUNCTION__, items.Size(), CTimeUtils::GetTimeMS() - time);
 
     CStdString order(where);
     bool maintainOrder = order.ToLower().Find("order by") != -1;
@@ -4716,7 +4860,7 @@ void CVideoDatabase::Stack(CFileItemList& items, VIDEODB_CONTENT_TYPE type, bool
   }
 }
 
-bool CVideoDatabase::GetEpisodesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idYear, int idActor, int idDirector, int idShow, int idSeason)
+bool CVideoDatabase::GetEpisodesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, int idYear, int idActor, int idDirector, int idShow, int idSeason, DatabaseLimits *limits)
 {
   CStdString strIn = PrepareSQL("= %i", idShow);
   GetStackedTvShowList(idShow, strIn);
@@ -4743,7 +4887,11 @@ bool CVideoDatabase::GetEpisodesNav(const CStdString& strBaseDir, CFileItemList&
   CUtil::GetParentPath(strBaseDir,parent);
   CUtil::GetParentPath(parent,grandParent);
 
-  bool ret = GetEpisodesByWhere(grandParent, where, items);
+  // linked movies are added after the episodes, so only page in the database if there are none
+  if (limits && idSeason == -1 && GetRowCount("movielinktvshow", PrepareSQL("where idShow %s", strIn.c_str())) != 0)
+    limits = NULL;
+
+  bool ret = GetEpisodesByWhere(grandParent, where, items, true, limits);
 
   if (idSeason == -1)
   { // add any linked movies
@@ -4753,7 +4901,7 @@ bool CVideoDatabase::GetEpisodesNav(const CStdString& strBaseDir, CFileItemList&
   return ret;
 }
 
-bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStdString &where, CFileItemList& items, bool appendFullShowPath /* = true */)
+bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStdString &where, CFileItemList& items, bool appendFullShowPath /* = true */, DatabaseLimits *limits /* = NULL */)
 {
   try
   {
@@ -4765,12 +4913,14 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStd
     if (NULL == m_pDS.get()) return false;
 
     CStdString strSQL = "select * from episodeview " + where;
+    CStdString sqlOrder, sqlLimit;
+    if (limits && PrepareLimits("episodeview", where, episodeSortColumns, "episodeview.idEpisode", *limits, sqlOrder, sqlLimit))
+      strSQL += " " + sqlOrder + sqlLimit;
 
-    // run query
+    // run query - rows are read from a cursor as we go, rather than all up front
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
+    if (!m_pDS->query_cursor(strSQL.c_str())) return false;
+    if (m_pDS->eof())
     {
       m_pDS->close();
       return true;
@@ -4780,13 +4930,12 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStd
               CTimeUtils::GetTimeMS() - time); time = CTimeUtils::GetTimeMS();
 
     // get data from returned rows
-    items.Reserve(iRowsFound);
     while (!m_pDS->eof())
     {
       int idEpisode = m_pDS->fv("idEpisode").get_asInt();
       int idShow = m_pDS->fv("idShow").get_asInt();
 
-      CVideoInfoTag movie = GetDetailsForEpisode(m_pDS);
+      CVideoInfoTag movie = GetDetailsForEpisode(m_pDS, false, true);
       CFileItemPtr pItem(new CFileItem(movie));
       if (appendFullShowPath)
         pItem->m_strPath.Format("%s%ld/%ld/%ld",strBaseDir.c_str(), idShow, movie.m_iSeason,idEpisode);
@@ -4801,8 +4950,7 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStd
       m_pDS->next();
     }
 
-    CLog::Log(LOGDEBUG,"Time to retrieve episodes from dataset = %d",
-              CTimeUtils::GetTimeMS() - time);
+    LogListingTime(__FUNCTION__, items.Size(), CTimeUtils::GetTimeMS() - time);
 
     // cleanup
     m_pDS->close();
@@ -5615,7 +5763,7 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const CStd
     while (!m_pDS->eof())
     {
       int idMVideo = m_pDS->fv("idMVideo").get_asInt();
-      CVideoInfoTag musicvideo = GetDetailsForMusicVideo(m_pDS);
+      CVideoInfoTag musicvideo = GetDetailsForMusicVideo(m_pDS, true);
       if (!checkLocks || g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser ||
           g_passwordManager.IsDatabasePathUnlocked(musicvideo.m_strPath,g_settings.m_videoSources))
       {
@@ -5627,7 +5775,7 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const CStd
       m_pDS->next();
     }
 
-    CLog::Log(LOGDEBUG, "%s time to retrieve from dataset = %d", __FUNCTION__, CTimeUtils::GetTimeMS() - time); time = CTimeUtils::GetTimeMS();
+    LogListingTime(__FUNCTION__, items.Size(), CTimeUtils::GetTimeMS() - time);
 
     // cleanup
     m_pDS->close();
@@ -5766,12 +5914,18 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter = GetSearchIndexFilter(VIDEODB_CONTENT_MOVIES, "movie.idMovie", strSearch);
+    if (filter.IsEmpty())
+      filter = PrepareSQL("movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,strSearch.c_str());
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and ",VIDEODB_ID_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d from movie where ",VIDEODB_ID_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    CStdString folded = FoldSearchText(strSearch);
+
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -5791,6 +5945,9 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
         pItem->m_strPath.Format("videodb://1/7/%i/%i",m_pDS2->fv(0).get_asInt(),movieId);
 
       pItem->m_bIsFolder=false;
+      pItem->SetProperty("searchtype", "movie");
+      pItem->SetProperty("searchid", movieId);
+      pItem->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(1).get_asString()));
       items.Add(pItem);
       m_pDS2->close();
       m_pDS->next();
@@ -5812,12 +5969,18 @@ void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter = GetSearchIndexFilter(VIDEODB_CONTENT_TVSHOWS, "tvshow.idShow", strSearch);
+    if (filter.IsEmpty())
+      filter = PrepareSQL("tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,strSearch.c_str());
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and ",VIDEODB_ID_TV_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where ",VIDEODB_ID_TV_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    CStdString folded = FoldSearchText(strSearch);
+
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -5834,6 +5997,9 @@ void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList
       pItem->m_strPath="videodb://"+ strDir;
       pItem->m_bIsFolder=true;
       pItem->GetVideoInfoTag()->m_iDbId = m_pDS->fv("tvshow.idshow").get_asInt();
+      pItem->SetProperty("searchtype", "tvshow");
+      pItem->SetProperty("searchid", pItem->GetVideoInfoTag()->m_iDbId);
+      pItem->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(1).get_asString()));
       items.Add(pItem);
       m_pDS->next();
     }
@@ -5854,12 +6020,18 @@ void CVideoDatabase::GetEpisodesByName(const CStdString& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter = GetSearchIndexFilter(VIDEODB_CONTENT_EPISODES, "episode.idEpisode", strSearch);
+    if (filter.IsEmpty())
+      filter = PrepareSQL("episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,tvshowlinkepisode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshowlinkepisode,tvshow where files.idFile=episode.idFile and tvshowlinkepisode.idEpisode=episode.idEpisode and tvshowlinkepisode.idShow=tvshow.idShow and files.idPath=path.idPath and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,tvshowlinkepisode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshowlinkepisode,tvshow where files.idFile=episode.idFile and tvshowlinkepisode.idEpisode=episode.idEpisode and tvshowlinkepisode.idShow=tvshow.idShow and files.idPath=path.idPath and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,tvshowlinkepisode.idShow,tvshow.c%02d from episode,tvshowlinkepisode,tvshow where tvshowlinkepisode.idEpisode=episode.idEpisode and tvshow.idShow=tvshowlinkepisode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,tvshowlinkepisode.idShow,tvshow.c%02d from episode,tvshowlinkepisode,tvshow where tvshowlinkepisode.idEpisode=episode.idEpisode and tvshow.idShow=tvshowlinkepisode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    CStdString folded = FoldSearchText(strSearch);
+
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -5872,6 +6044,9 @@ void CVideoDatabase::GetEpisodesByName(const CStdString& strSearch, CFileItemLis
       CFileItemPtr pItem(new CFileItem(m_pDS->fv(1).get_asString()+" ("+m_pDS->fv(4).get_asString()+")"));
       pItem->m_strPath.Format("videodb://2/2/%ld/%ld/%ld",m_pDS->fv("tvshowlinkepisode.idShow").get_asInt(),m_pDS->fv(2).get_asInt(),m_pDS->fv(0).get_asInt());
       pItem->m_bIsFolder=false;
+      pItem->SetProperty("searchtype", "episode");
+      pItem->SetProperty("searchid", m_pDS->fv(0).get_asInt());
+      pItem->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(1).get_asString()));
       items.Add(pItem);
       m_pDS->next();
     }
@@ -5896,12 +6071,18 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter = GetSearchIndexFilter(VIDEODB_CONTENT_MUSICVIDEOS, "musicvideo.idMVideo", strSearch);
+    if (filter.IsEmpty())
+      filter = PrepareSQL("musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and ",VIDEODB_ID_MUSICVIDEO_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where ",VIDEODB_ID_MUSICVIDEO_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    CStdString folded = FoldSearchText(strSearch);
+
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -5917,6 +6098,9 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
 
       pItem->m_strPath="videodb://"+ strDir;
       pItem->m_bIsFolder=false;
+      pItem->SetProperty("searchtype", "musicvideo");
+      pItem->SetProperty("searchid", m_pDS->fv("musicvideo.idMVideo").get_asInt());
+      pItem->SetProperty("searchscore", GetSearchScore(folded, m_pDS->fv(1).get_asString()));
       items.Add(pItem);
       m_pDS->next();
     }
@@ -5928,6 +6112,28 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
   }
 }
 
+bool CVideoDatabase::Search(const CStdString& strSearch, CFileItemList& items)
+{
+  unsigned int time = CTimeUtils::GetTimeMS();
+  GetMoviesByName(strSearch, items);
+  GetTvShowsByName(strSearch, items);
+  GetEpisodesByName(strSearch, items);
+  GetMusicVideosByName(strSearch, items);
+
+  // best matches first, whatever their type
+  SortSearchResults(items);
+  LogSearchTime(__FUNCTION__, strSearch, items.Size(), CTimeUtils::GetTimeMS() - time);
+  return true;
+}
+
+void CVideoDatabase::PopulateSearchIndex()
+{
+  FillSearchIndex(VIDEODB_CONTENT_MOVIES, PrepareSQL("select idMovie, c%02d from movie", VIDEODB_ID_TITLE));
+  FillSearchIndex(VIDEODB_CONTENT_TVSHOWS, PrepareSQL("select idShow, c%02d from tvshow", VIDEODB_ID_TV_TITLE));
+  FillSearchIndex(VIDEODB_CONTENT_EPISODES, PrepareSQL("select idEpisode, c%02d from episode", VIDEODB_ID_EPISODE_TITLE));
+  FillSearchIndex(VIDEODB_CONTENT_MUSICVIDEOS, PrepareSQL("select idMVideo, c%02d from musicvideo", VIDEODB_ID_MUSICVIDEO_TITLE));
+}
+
 void CVideoDatabase::GetEpisodesByPlot(const CStdString& strSearch, CFileItemList& items)
 {
 // Alternative searching - not quite as fast though due to
@@ -6492,6 +6698,16 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const v
     sql = "delete from sets where idSet not in (select distinct idSet from setlinkmovie)";
     m_pDS->exec(sql.c_str());
 
+    // the bulk deletes above bypass the incremental updates
+    CLog::Log(LOGDEBUG, "%s Rebuilding navigation counts", __FUNCTION__);
+    RebuildNavCounts();
+
+    CLog::Log(LOGDEBUG, "%s Cleaning search index", __FUNCTION__);
+    PruneSearchIndex(VIDEODB_CONTENT_MOVIES, "movie", "idMovie");
+    PruneSearchIndex(VIDEODB_CONTENT_TVSHOWS, "tvshow", "idShow");
+    PruneSearchIndex(VIDEODB_CONTENT_EPISODES, "episode", "idEpisode");
+    PruneSearchIndex(VIDEODB_CONTENT_MUSICVIDEOS, "musicvideo", "idMVideo");
+
     CommitTransaction();
 
     if (pObserver)
@@ -6509,6 +6725,233 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const v
     progress->Close();
 }
 
+void CVideoDatabase::UpdateShowCounts(int idShow)
+{
+  if (NULL == m_pDB.get()) return;
+  if (NULL == m_pDS.get()) return;
+
+  CStdString where = PrepareSQL("where tvshowlinkepisode.idShow=%i", idShow);
+  m_pDS->exec(PrepareSQL("delete from tvshowcounts where idShow=%i", idShow).c_str());
+  m_pDS->exec(PrepareSQL("insert into tvshowcounts (idShow,totalCount,watchedCount) " VIDEO_DATABASE_SHOW_COUNTS, where.c_str()).c_str());
+  m_pDS->exec(PrepareSQL("delete from seasoncounts where idShow=%i", idShow).c_str());
+  m_pDS->exec(PrepareSQL("insert into seasoncounts (idShow,season,totalCount,watchedCount) " VIDEO_DATABASE_SEASON_COUNTS,
+                         VIDEODB_ID_EPISODE_SEASON, where.c_str(), VIDEODB_ID_EPISODE_SEASON).c_str());
+}
+
+void CVideoDatabase::GetMovieLinks(int idMovie, vector< pair<CStdString, int> > &links)
+{
+  if (NULL == m_pDB.get()) return;
+  if (NULL == m_pDS.get()) return;
+
+  for (unsigned int i = 0; i < sizeof(movieLinkTypes) / sizeof(movieLinkTypes[0]); i++)
+  {
+    const char *type = movieLinkTypes[i];
+    if (!m_pDS->query(PrepareSQL("select id%s from %slinkmovie where idMovie=%i", type, type, idMovie).c_str()))
+      continue;
+    while (!m_pDS->eof())
+    {
+      links.push_back(make_pair(CStdString(type), m_pDS->fv(0).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+  }
+}
+
+void CVideoDatabase::UpdateMovieLinkCounts(const vector< pair<CStdString, int> > &links)
+{
+  if (NULL == m_pDB.get()) return;
+  if (NULL == m_pDS.get()) return;
+
+  for (vector< pair<CStdString, int> >::const_iterator it = links.begin(); it != links.end(); ++it)
+  {
+    const char *type = it->first.c_str();
+    CStdString where = PrepareSQL("where %slinkmovie.id%s=%i", type, type, it->second);
+    m_pDS->exec(PrepareSQL("delete from movielinkcounts where strType='%s' and idItem=%i", type, it->second).c_str());
+    m_pDS->exec(PrepareSQL("insert into movielinkcounts (strType,idItem,totalCount,watchedCount) " VIDEO_DATABASE_LINK_COUNTS,
+                           type, type, type, type, type, where.c_str(), type, type).c_str());
+  }
+}
+
+void CVideoDatabase::UpdateCountsForFile(int idFile)
+{
+  if (NULL == m_pDB.get()) return;
+  if (NULL == m_pDS.get()) return;
+
+  try
+  {
+    vector<int> shows;
+    m_pDS->query(PrepareSQL("select tvshowlinkepisode.idShow from episode join tvshowlinkepisode on tvshowlinkepisode.idEpisode=episode.idEpisode where episode.idFile=%i", idFile).c_str());
+    while (!m_pDS->eof())
+    {
+      shows.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    vector<int> movies;
+    m_pDS->query(PrepareSQL("select idMovie from movie where idFile=%i", idFile).c_str());
+    while (!m_pDS->eof())
+    {
+      movies.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    for (unsigned int i = 0; i < shows.size(); i++)
+      UpdateShowCounts(shows[i]);
+
+    vector< pair<CStdString, int> > links;
+    for (unsigned int i = 0; i < movies.size(); i++)
+      GetMovieLinks(movies[i], links);
+    UpdateMovieLinkCounts(links);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%i) failed", __FUNCTION__, idFile);
+  }
+}
+
+void CVideoDatabase::RebuildNavCounts()
+{
+  if (NULL == m_pDB.get()) return;
+  if (NULL == m_pDS.get()) return;
+
+  unsigned int time = CTimeUtils::GetTimeMS();
+  m_pDS->exec("delete from tvshowcounts");
+  m_pDS->exec(PrepareSQL("insert into tvshowcounts (idShow,totalCount,watchedCount) " VIDEO_DATABASE_SHOW_COUNTS, "").c_str());
+  m_pDS->exec("delete from seasoncounts");
+  m_pDS->exec(PrepareSQL("insert into seasoncounts (idShow,season,totalCount,watchedCount) " VIDEO_DATABASE_SEASON_COUNTS,
+                         VIDEODB_ID_EPISODE_SEASON, "", VIDEODB_ID_EPISODE_SEASON).c_str());
+  m_pDS->exec("delete from movielinkcounts");
+  for (unsigned int i = 0; i < sizeof(movieLinkTypes) / sizeof(movieLinkTypes[0]); i++)
+  {
+    const char *type = movieLinkTypes[i];
+    m_pDS->exec(PrepareSQL("insert into movielinkcounts (strType,idItem,totalCount,watchedCount) " VIDEO_DATABASE_LINK_COUNTS,
+                           type, type, type, type, type, "", type, type).c_str());
+  }
+  CLog::Log(LOGDEBUG, "%s took %u ms", __FUNCTION__, CTimeUtils::GetTimeMS() - time);
+}
+
+bool CVideoDatabase::CheckNavCounts(bool repair /* = true */)
+{
+  if (NULL == m_pDB.get()) return false;
+  if (NULL == m_pDS.get()) return false;
+
+  try
+  {
+    // key is table:id[:season], value is total and watched count
+    typedef map<CStdString, pair<int, int> > CountMap;
+    CountMap expected, stored;
+
+    unsigned int time = CTimeUtils::GetTimeMS();
+    vector<CStdString> queries;
+    queries.push_back(PrepareSQL(VIDEO_DATABASE_SHOW_COUNTS, ""));
+    queries.push_back(PrepareSQL(VIDEO_DATABASE_SEASON_COUNTS, VIDEODB_ID_EPISODE_SEASON, "", VIDEODB_ID_EPISODE_SEASON));
+    for (unsigned int i = 0; i < sizeof(movieLinkTypes) / sizeof(movieLinkTypes[0]); i++)
+    {
+      const char *type = movieLinkTypes[i];
+      queries.push_back(PrepareSQL(VIDEO_DATABASE_LINK_COUNTS, type, type, type, type, type, "", type, type));
+    }
+    for (unsigned int i = 0; i < queries.size(); i++)
+    {
+      if (!m_pDS->query(queries[i].c_str()))
+        return false;
+      while (!m_pDS->eof())
+      {
+        CStdString key;
+        if (i == 0)
+          key.Format("tvshow:%i", m_pDS->fv(0).get_asInt());
+        else if (i == 1)
+          key.Format("season:%i:%i", m_pDS->fv(0).get_asInt(), m_pDS->fv(1).get_asInt());
+        else
+          key.Format("%s:%i", m_pDS->fv(0).get_asString().c_str(), m_pDS->fv(1).get_asInt());
+        expected[key] = make_pair(m_pDS->fv(2).get_asInt(), m_pDS->fv(3).get_asInt());
+        m_pDS->next();
+      }
+      m_pDS->close();
+    }
+    unsigned int aggregateTime = CTimeUtils::GetTimeMS() - time;
+
+    time = CTimeUtils::GetTimeMS();
+    m_pDS->query("select idShow,totalCount,watchedCount from tvshowcounts");
+    while (!m_pDS->eof())
+    {
+      CStdString key;
+      key.Format("tvshow:%i", m_pDS->fv(0).get_asInt());
+      stored[key] = make_pair(m_pDS->fv(1).get_asInt(), m_pDS->fv(2).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    m_pDS->query("select idShow,season,totalCount,watchedCount from seasoncounts");
+    while (!m_pDS->eof())
+    {
+      CStdString key;
+      key.Format("season:%i:%i", m_pDS->fv(0).get_asInt(), m_pDS->fv(1).get_asInt());
+      stored[key] = make_pair(m_pDS->fv(2).get_asInt(), m_pDS->fv(3).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    m_pDS->query("select strType,idItem,totalCount,watchedCount from movielinkcounts where totalCount > 0");
+    while (!m_pDS->eof())
+    {
+      CStdString key;
+      key.Format("%s:%i", m_pDS->fv(0).get_asString().c_str(), m_pDS->fv(1).get_asInt());
+      stored[key] = make_pair(m_pDS->fv(2).get_asInt(), m_pDS->fv(3).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    unsigned int storedTime = CTimeUtils::GetTimeMS() - time;
+
+    CLog::Log(LOGDEBUG, "%s - aggregating %u counts took %u ms, reading them materialized took %u ms",
+              __FUNCTION__, (unsigned int)expected.size(), aggregateTime, storedTime);
+
+    int mismatches = 0;
+    for (CountMap::const_iterator it = expected.begin(); it != expected.end(); ++it)
+    {
+      CountMap::const_iterator found = stored.find(it->first);
+      if (found == stored.end() || found->second != it->second)
+      {
+        if (mismatches++ < 10)
+          CLog::Log(LOGWARNING, "%s - %s should be %i/%i but is %i/%i", __FUNCTION__, it->first.c_str(),
+                    it->second.first, it->second.second,
+                    found == stored.end() ? 0 : found->second.first, found == stored.end() ? 0 : found->second.second);
+      }
+    }
+    for (CountMap::const_iterator it = stored.begin(); it != stored.end(); ++it)
+    {
+      if (expected.find(it->first) == expected.end())
+      {
+        if (mismatches++ < 10)
+          CLog::Log(LOGWARNING, "%s - %s is stale", __FUNCTION__, it->first.c_str());
+      }
+    }
+
+    if (mismatches == 0)
+      return true;
+
+    CLog::Log(LOGERROR, "%s - %i navigation counts are inconsistent%s", __FUNCTION__, mismatches, repair ? ", rebuilding" : "");
+    if (repair)
+    {
+      BeginTransaction();
+      try
+      {
+        RebuildNavCounts();
+        CommitTransaction();
+      }
+      catch (...)
+      {
+        RollbackTransaction();
+        throw;
+      }
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
 void CVideoDatabase::DumpToDummyFiles(const CStdString &path)
 {
   // get all tvshows
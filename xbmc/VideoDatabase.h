@@ -288,7 +288,7 @@ public:
     int playcount;
   };
 
-  class CSeason   // used for season retrieval for non-master users
+  class CSeason   // used to merge the seasons of stacked shows during season retrieval
   {
   public:
     CStdString path;
@@ -354,6 +354,13 @@ public:
   void GetTvShowInfo(const CStdString& strPath, CVideoInfoTag& details, int idTvShow = -1);
   bool GetEpisodeInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idEpisode = -1);
   void GetMusicVideoInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idMVideo=-1);
+  /*! \brief Fill in the scraper xml a library listing left out of a tag.
+   Fetches the thumb and fanart urls and the episode guide of the item, for callers that read them from a listed item.
+   \param details [in/out] tag of a library item
+   \param isFolder whether the item is a folder, to tell tv shows and seasons from episodes
+   \return true if the tag has its scraper xml, false if it isn't a library item
+   */
+  bool GetScraperXml(CVideoInfoTag& details, bool isFolder = false);
   bool GetStreamDetailsForFileId(CStreamDetails& details, int idFile) const;
 
   int GetPathId(const CStdString& strPath);
@@ -457,6 +464,12 @@ public:
   void GetEpisodesByName(const CStdString& strSearch, CFileItemList& items);
   void GetMusicVideosByName(const CStdString& strSearch, CFileItemList& items);
 
+  /*! \brief Search the titles of movies, tvshows, episodes and music videos.
+   \param strSearch the search
+   \param items [out] the matching items, best matches first
+   */
+  bool Search(const CStdString& strSearch, CFileItemList& items);
+
   void GetEpisodesByPlot(const CStdString& strSearch, CFileItemList& items);
   void GetMoviesByPlot(const CStdString& strSearch, CFileItemList& items);
 
@@ -479,10 +492,10 @@ public:
   bool GetSetsNav(const CStdString& strBaseDir, CFileItemList& items, int idContent=-1, const CStdString &where = "");
   bool GetMusicVideoAlbumsNav(const CStdString& strBaseDir, CFileItemList& items, int idArtist);
 
-  bool GetMoviesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idActor=-1, int idDirector=-1, int idStudio=-1, int idCountry=-1, int idSet=-1);
+  bool GetMoviesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idActor=-1, int idDirector=-1, int idStudio=-1, int idCountry=-1, int idSet=-1, DatabaseLimits *limits=NULL);
   bool GetTvShowsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idActor=-1, int idDirector=-1, int idStudio=-1);
   bool GetSeasonsNav(const CStdString& strBaseDir, CFileItemList& items, int idActor=-1, int idDirector=-1, int idGenre=-1, int idYear=-1, int idShow=-1);
-  bool GetEpisodesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idActor=-1, int idDirector=-1, int idShow=-1, int idSeason=-1);
+  bool GetEpisodesNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idActor=-1, int idDirector=-1, int idShow=-1, int idSeason=-1, DatabaseLimits *limits=NULL);
   bool GetMusicVideosNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre=-1, int idYear=-1, int idArtist=-1, int idDirector=-1, int idStudio=-1, int idAlbum=-1);
 
   bool GetRecentlyAddedMoviesNav(const CStdString& strBaseDir, CFileItemList& items);
@@ -495,6 +508,14 @@ public:
 
   void CleanDatabase(VIDEO::IVideoInfoScannerObserver* pObserver=NULL, const std::vector<int>* paths=NULL);
 
+  /*! \brief Verify the materialized navigation counts against the library
+   Aggregates the episode and movie counts from scratch and compares them with the
+   tvshowcounts, seasoncounts and movielinkcounts tables, logging any difference.
+   \param repair rebuild the tables if they are found to be inconsistent.
+   \return true if the tables were consistent, false otherwise.
+   */
+  bool CheckNavCounts(bool repair = true);
+
   /*! \brief Add a file to the database, if necessary
    If the file is already in the database, we simply return it's id.
    \param url - full path of the file to add.
@@ -518,9 +539,9 @@ public:
   CStdString GetCachedThumb(const CFileItem& item) const;
 
   // smart playlists and main retrieval work in these functions
-  bool GetMoviesByWhere(const CStdString& strBaseDir, const CStdString &where, const CStdString &order, CFileItemList& items, bool fetchSets = false);
+  bool GetMoviesByWhere(const CStdString& strBaseDir, const CStdString &where, const CStdString &order, CFileItemList& items, bool fetchSets = false, DatabaseLimits *limits = NULL);
   bool GetTvShowsByWhere(const CStdString& strBaseDir, const CStdString &where, CFileItemList& items);
-  bool GetEpisodesByWhere(const CStdString& strBaseDir, const CStdString &where, CFileItemList& items, bool appendFullShowPath = true);
+  bool GetEpisodesByWhere(const CStdString& strBaseDir, const CStdString &where, CFileItemList& items, bool appendFullShowPath = true, DatabaseLimits *limits = NULL);
   bool GetMusicVideosByWhere(const CStdString &baseDir, const CStdString &whereClause, CFileItemList& items, bool checkLocks = true);
 
   // partymode
@@ -587,22 +608,42 @@ protected:
   void AddGenreAndDirectorsAndStudios(const CVideoInfoTag& details, std::vector<int>& vecDirectors, std::vector<int>& vecGenres, std::vector<int>& vecStudios);
 
   void DeleteStreamDetails(int idFile);
+
+  /*! \brief Materialized navigation counts
+   tvshowcounts and seasoncounts hold the total and watched episodes per show and season,
+   movielinkcounts the total and watched movies per genre, country, studio, actor, director
+   and writer. They are refreshed for the affected items whenever episodes or movies are
+   added, removed or change their watched state, so the navigation queries needn't aggregate.
+   */
+  void UpdateShowCounts(int idShow);
+  void GetMovieLinks(int idMovie, std::vector< std::pair<CStdString, int> > &links);
+  void UpdateMovieLinkCounts(const std::vector< std::pair<CStdString, int> > &links);
+  void UpdateCountsForFile(int idFile);
+  void RebuildNavCounts();
+
   CVideoInfoTag GetDetailsByTypeAndId(VIDEODB_CONTENT_TYPE type, int id);
-  CVideoInfoTag GetDetailsForMovie(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false);
-  CVideoInfoTag GetDetailsForTvShow(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false);
-  CVideoInfoTag GetDetailsForEpisode(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false);
-  CVideoInfoTag GetDetailsForMusicVideo(std::auto_ptr<dbiplus::Dataset> &pDS);
+  /*! \brief Fill a tag from the current row of a details query.
+   \param needsCast also fetch the cast, sets and links, one query each
+   \param listing leave out the scraper xml (thumb and fanart urls, episode guide), which listings
+   don't show. GetScraperXml() fetches it when it is needed.
+   */
+  CVideoInfoTag GetDetailsForMovie(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false, bool listing = false);
+  CVideoInfoTag GetDetailsForTvShow(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false, bool listing = false);
+  CVideoInfoTag GetDetailsForEpisode(std::auto_ptr<dbiplus::Dataset> &pDS, bool needsCast = false, bool listing = false);
+  CVideoInfoTag GetDetailsForMusicVideo(std::auto_ptr<dbiplus::Dataset> &pDS, bool listing = false);
   void GetCommonDetails(std::auto_ptr<dbiplus::Dataset> &pDS, CVideoInfoTag &details);
   bool GetPeopleNav(const CStdString& strBaseDir, CFileItemList& items, const CStdString& type, int idContent=-1);
   bool GetNavCommon(const CStdString& strBaseDir, CFileItemList& items, const CStdString& type, int idContent=-1);
 
-  void GetDetailsFromDB(std::auto_ptr<dbiplus::Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
+  void GetDetailsFromDB(std::auto_ptr<dbiplus::Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2, bool listing = false);
   CStdString GetValueString(const CVideoInfoTag &details, int min, int max, const SDbTableOffsets *offsets) const;
 
 private:
   virtual bool CreateTables();
   virtual bool UpdateOldVersion(int version);
-  virtual int GetMinVersion() const { return 42; };
+  virtual void PopulateSearchIndex();
+  virtual int GetMinVersion() const { return 44; };
+  virtual bool UsesSearchIndex() const { return true; };
   const char *GetDefaultDBName() const { return "MyVideos34.db"; };
 
   void ConstructPath(CStdString& strDest, const CStdString& strPath, const CStdString& strFileName);
@@ -41,8 +41,13 @@
 #include "StringUtils.h"
 #include "LocalizeStrings.h"
 #include "utils/TimeUtils.h"
+#include "utils/JobManager.h"
+#include "utils/SingleLock.h"
+#include "utils/ScraperHttpCache.h"
 #include "utils/log.h"
 
+#include <deque>
+
 using namespace std;
 using namespace XFILE;
 using namespace ADDON;
@@ -50,6 +55,95 @@ using namespace ADDON;
 namespace VIDEO
 {
 
+  /*! \brief Looks up an item ahead of the scanner to fill the scraper page cache.
+   The lookup is run with a copy of the scraper, as scrapers hold their parser state. Its
+   results are thrown away: the scanner repeats the lookup, which then finds its pages cached.
+   */
+  class CScraperPrefetchJob : public CJob
+  {
+  public:
+    CScraperPrefetchJob(const ScraperPtr &scraper, const CStdString &name)
+      : m_scraper(scraper), m_name(name)
+    {
+    }
+
+    virtual const char *GetType() const { return "scraperprefetch"; };
+
+    virtual bool DoWork()
+    {
+      CIMDB imdb(m_scraper);
+      IMDB_MOVIELIST movielist;
+      if (imdb.FindMovie(m_name, movielist) <= 0 || movielist.empty())
+        return false;
+
+      CVideoInfoTag details;
+      return imdb.GetDetails(movielist[0], details);
+    }
+
+  private:
+    ScraperPtr m_scraper;
+    CStdString m_name;
+  };
+
+  /*! \brief Runs the lookups ahead of the scanner, a few at a time.
+   Unlike a CJobQueue, it waits on destruction for the lookups that are running, as the job
+   manager calls back into it once they are done. It lives on the stack of RetrieveVideoInfo().
+   */
+  class CScraperPrefetchQueue : public IJobCallback
+  {
+  public:
+    CScraperPrefetchQueue(unsigned int jobsAtOnce)
+      : m_jobsAtOnce(jobsAtOnce), m_running(0)
+    {
+    }
+
+    virtual ~CScraperPrefetchQueue()
+    {
+      // lookups that haven't started are dropped, the running ones can't be interrupted
+      CSingleLock lock(m_section);
+      for (deque<CJob *>::iterator it = m_queue.begin(); it != m_queue.end(); ++it)
+        delete *it;
+      m_queue.clear();
+      while (m_running > 0)
+      {
+        lock.Leave();
+        Sleep(10);
+        lock.Enter();
+      }
+    }
+
+    void AddJob(CJob *job)
+    {
+      CSingleLock lock(m_section);
+      m_queue.push_back(job);
+      StartJobs();
+    }
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+    {
+      CSingleLock lock(m_section);
+      m_running--;
+      StartJobs();
+    }
+
+  private:
+    void StartJobs()
+    {
+      while (m_running < m_jobsAtOnce && !m_queue.empty())
+      {
+        CJob *job = m_queue.front();
+        m_queue.pop_front();
+        m_running++;
+        CJobManager::GetInstance().AddJob(job, this, CJob::PRIORITY_LOW);
+      }
+    }
+
+    CCriticalSection m_section;
+    deque<CJob *> m_queue;
+    unsigned int m_jobsAtOnce;
+    unsigned int m_running;
+  };
+
   CVideoInfoScanner::CVideoInfoScanner()
   {
     m_bRunning = false;
@@ -80,6 +174,8 @@ namespace VIDEO
 
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Starting scan ..");
 
+      CScraperHttpCache::Get().Prune();
+
       // Reset progress vars
       m_currentItem = 0;
       m_itemCount = -1;
@@ -115,6 +211,8 @@ namespace VIDEO
             m_pObserver->OnStateChanged(COMPRESSING_DATABASE);
           m_database.Compress(false);
         }
+        if (g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG)
+          m_database.CheckNavCounts();
       }
 
       m_database.Close();
@@ -351,12 +449,37 @@ namespace VIDEO
     for (int i=LIBRARY_HAS_VIDEO;i<LIBRARY_HAS_MUSICVIDEOS+1;++i)
       g_infoManager.GetBool(i);
 
+    // lookups for the items ahead of the current one are run on a small pool of threads,
+    // so that by the time the scanner gets to an item its pages are mostly in the cache.
+    // A url given for the first item means this is a manual lookup of a single item.
+    CScraperHttpCache &httpCache = CScraperHttpCache::Get();
+    int threads = g_advancedSettings.m_iScraperThreads;
+    bool prefetch = !pURL && threads > 0 && items.Size() > 1 && httpCache.IsEnabled() && !httpCache.IsReplaying();
+    ScraperPtr prefetchScraper;
+    if (prefetch)
+    {
+      prefetchScraper = m_database.GetScraperForPath(items.m_strPath);
+      prefetch = prefetchScraper && (prefetchScraper->Content() == CONTENT_MOVIES || prefetchScraper->Content() == CONTENT_MUSICVIDEOS);
+    }
+    CScraperPrefetchQueue prefetchQueue(max(threads, 1));
+    int nextPrefetch = 1;
+
+    unsigned int hits, misses;
+    httpCache.ResetStats();
+    unsigned int tick = CTimeUtils::GetTimeMS();
+
     bool FoundSomeInfo = false;
     for (int i = 0; i < (int)items.Size(); ++i)
     {
       m_nfoReader.Close();
       CFileItemPtr pItem = items[i];
 
+      if (prefetch)
+      {
+        for (; nextPrefetch < items.Size() && nextPrefetch <= i + 2 * threads; nextPrefetch++)
+          QueuePrefetch(items[nextPrefetch], prefetchScraper, bDirNames, useLocal, prefetchQueue);
+      }
+
       // we do this since we may have a override per dir
       ScraperPtr info2 = m_database.GetScraperForPath(pItem->m_bIsFolder ? pItem->m_strPath : items.m_strPath);
       if (!info2) // skip
@@ -405,6 +528,10 @@ namespace VIDEO
       pURL = NULL;
     }
 
+    httpCache.GetStats(hits, misses);
+    CLog::Log(LOGDEBUG, "VideoInfoScanner: Looked up %i items in %s in %u ms, %u of %u pages cached",
+              items.Size(), items.m_strPath.c_str(), CTimeUtils::GetTimeMS() - tick, hits, hits + misses);
+
     if(pDlgProgress)
       pDlgProgress->ShowProgressBar(false);
 
@@ -413,6 +540,37 @@ namespace VIDEO
     return FoundSomeInfo;
   }
 
+  void CVideoInfoScanner::QueuePrefetch(const CFileItemPtr &pItem, const ScraperPtr &scraper, bool bDirNames, bool useLocal, CScraperPrefetchQueue &queue)
+  {
+    // only movies and music videos are looked up ahead, and only those that
+    // the scanner will look up online, as the checks below are made again there
+    if (pItem->m_bIsFolder || !pItem->IsVideo() || pItem->IsNFO() || pItem->IsPlayList())
+      return;
+
+    if (scraper->Content() == CONTENT_MOVIES)
+    {
+      if (m_database.HasMovieInfo(pItem->m_strPath))
+        return;
+    }
+    else if (scraper->Content() == CONTENT_MUSICVIDEOS)
+    {
+      if (m_database.HasMusicVideoInfo(pItem->m_strPath))
+        return;
+    }
+    else
+      return;
+
+    if (CUtil::ExcludeFileOrFolder(pItem->m_strPath, g_advancedSettings.m_moviesExcludeFromScanRegExps))
+      return;
+
+    if (useLocal && !GetnfoFile(pItem.get(), bDirNames).IsEmpty())
+      return;
+
+    ScraperPtr copy = boost::dynamic_pointer_cast<CScraper>(scraper->Clone(scraper));
+    if (copy)
+      queue.AddJob(new CScraperPrefetchJob(copy, pItem->GetMovieName(bDirNames)));
+  }
+
   INFO_RET CVideoInfoScanner::RetrieveInfoForTvShow(CFileItemPtr pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
   {
     long idTvShow = -1;
@@ -31,6 +31,8 @@ class CRegExp;
 
 namespace VIDEO
 {
+  class CScraperPrefetchQueue;
+
   typedef struct SScanSettings
   {
     SScanSettings() { parent_name = parent_name_root = noupdate = exclude = false; recurse = 1;}
@@ -127,6 +129,15 @@ namespace VIDEO
     virtual void Process();
     bool DoScan(const CStdString& strDirectory);
 
+    /*! \brief Queue a lookup of an item ahead of the scanner, if it will be looked up online.
+     \param pItem the item to look up.
+     \param scraper the scraper set on the folder holding the item.
+     \param bDirNames whether we should use folder or file names for lookups.
+     \param useLocal whether local .nfo files are used, and so whether items with one are skipped.
+     \param queue the queue of lookups to add to.
+     */
+    void QueuePrefetch(const CFileItemPtr &pItem, const ADDON::ScraperPtr &scraper, bool bDirNames, bool useLocal, CScraperPrefetchQueue &queue);
+
     INFO_RET RetrieveInfoForTvShow(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMovie(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMusicVideo(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
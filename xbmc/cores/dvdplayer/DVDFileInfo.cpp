@@ -27,6 +27,7 @@
 #include "FileSystem/StackDirectory.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/SingleLock.h"
 
 #include "DVDClock.h"
 #include "DVDFileInfo.h"
@@ -49,6 +50,134 @@
 #include "FileSystem/File.h"
 
 
+// number of keyframes tried before settling for a black or faded one
+#define THUMB_SEEK_ATTEMPTS 4
+
+/*
+ * Only decode keyframes, without the loop filter, and at the smallest resolution still
+ * larger than the thumb for the codecs which can decode at reduced resolution.
+ */
+static void GetThumbCodecOptions(const CDVDStreamInfo &hint, CDVDCodecOptions &options)
+{
+  options.push_back(CDVDCodecOption("skip_frame", "nokey"));
+  options.push_back(CDVDCodecOption("skip_loop_filter", "all"));
+
+  switch (hint.codec)
+  {
+  case CODEC_ID_MPEG1VIDEO:
+  case CODEC_ID_MPEG2VIDEO:
+  case CODEC_ID_MPEG4:
+  case CODEC_ID_MSMPEG4V3:
+  case CODEC_ID_H263:
+  case CODEC_ID_MJPEG:
+    {
+      int lowres = 0;
+      while (lowres < 2 && (hint.width >> (lowres + 1)) >= g_advancedSettings.m_thumbSize)
+        lowres++;
+      if (lowres)
+      {
+        CStdString value;
+        value.Format("%i", lowres);
+        options.push_back(CDVDCodecOption("lowres", value));
+      }
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/*
+ * Whether a picture is (nearly) black or a flat fade, from a sample of its luma plane.
+ */
+static bool IsBlankPicture(const DVDVideoPicture &picture)
+{
+  if (picture.format != DVDVideoPicture::FMT_YUV420P || !picture.data[0] || !picture.iWidth || !picture.iHeight)
+    return false;
+
+  uint64_t sum = 0, sumSquares = 0;
+  unsigned int samples = 0;
+  for (unsigned int y = picture.iHeight / 8; y < picture.iHeight - picture.iHeight / 8; y += 4)
+  {
+    const BYTE *line = picture.data[0] + y * picture.iLineSize[0];
+    for (unsigned int x = 0; x < picture.iWidth; x += 4)
+    {
+      sum += line[x];
+      sumSquares += line[x] * line[x];
+      samples++;
+    }
+  }
+  if (!samples)
+    return false;
+
+  double mean = (double)sum / samples;
+  double variance = (double)sumSquares / samples - mean * mean;
+  return mean < 24.0 || variance < 100.0;
+}
+
+/*
+ * Scale a decoded picture straight to the thumb size and save it.
+ */
+static bool CreateThumbFromPicture(const DVDVideoPicture &picture, const CStdString &strTarget)
+{
+  double aspect;
+  if (picture.iDisplayWidth && picture.iDisplayHeight)
+    aspect = (double)picture.iDisplayWidth / (double)picture.iDisplayHeight;
+  else
+    aspect = (double)picture.iWidth / (double)picture.iHeight;
+
+  int nWidth = g_advancedSettings.m_thumbSize;
+  int nHeight = (int)((double)g_advancedSettings.m_thumbSize / aspect);
+  if (nHeight > g_advancedSettings.m_thumbSize)
+  {
+    nHeight = g_advancedSettings.m_thumbSize;
+    nWidth = (int)((double)g_advancedSettings.m_thumbSize * aspect);
+  }
+
+  DllSwScale dllSwScale;
+  if (!dllSwScale.Load())
+    return false;
+
+  bool bOk = false;
+  BYTE *pOutBuf = new BYTE[nWidth * nHeight * 4];
+  struct SwsContext *context = dllSwScale.sws_getContext(picture.iWidth, picture.iHeight,
+        PIX_FMT_YUV420P, nWidth, nHeight, PIX_FMT_BGRA, SWS_FAST_BILINEAR | SwScaleCPUFlags(), NULL, NULL, NULL);
+  uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
+  int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
+  uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
+  int     dstStride[] = { nWidth*4, 0, 0, 0 };
+
+  if (context)
+  {
+    dllSwScale.sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
+    dllSwScale.sws_freeContext(context);
+
+    CPicture::CreateThumbnailFromSurface(pOutBuf, nWidth, nHeight, nWidth * 4, strTarget);
+    bOk = true;
+  }
+
+  dllSwScale.Unload();
+  delete [] pOutBuf;
+  return bOk;
+}
+
+/*
+ * Keep a running count of the thumbs extracted this session, to gauge the throughput at debug log level.
+ */
+static void LogThumbThroughput(unsigned int time)
+{
+  static CCriticalSection section;
+  static unsigned int thumbs = 0;
+  static uint64_t totalTime = 0;
+
+  CSingleLock lock(section);
+  thumbs++;
+  totalTime += time;
+  if (thumbs % 50 == 0)
+    CLog::Log(LOGDEBUG, "%s - extracted %u thumbs in %"PRIu64" ms of decoding, %.2f thumbs/s per worker", __FUNCTION__,
+              thumbs, totalTime, totalTime ? thumbs * 1000.0 / totalTime : 0.0);
+}
+
 bool CDVDFileInfo::GetFileDuration(const CStdString &path, int& duration)
 {
   std::auto_ptr<CDVDInputStream> input;
@@ -143,25 +272,30 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, const CStdString &str
     CDVDStreamInfo hint(*pDemuxer->GetStream(nVideoStream), true);
     hint.software = true;
 
-    if (hint.codec == CODEC_ID_MPEG2VIDEO || hint.codec == CODEC_ID_MPEG1VIDEO)
-    {
-      // libmpeg2 is not thread safe so use ffmepg for mpeg2/mpeg1 thumb extraction
-      CDVDCodecOptions dvdOptions;
-      pVideoCodec = CDVDFactoryCodec::OpenCodec(new CDVDVideoCodecFFmpeg(), hint, dvdOptions);
-    }
-    else
-    {
+    // ffmpeg is used for all codecs (libmpeg2 is not thread safe) so that only the
+    // keyframes get decoded, at reduced resolution where the codec supports it
+    CDVDCodecOptions dvdOptions;
+    GetThumbCodecOptions(hint, dvdOptions);
+    pVideoCodec = CDVDFactoryCodec::OpenCodec(new CDVDVideoCodecFFmpeg(), hint, dvdOptions);
+    if (!pVideoCodec)
       pVideoCodec = CDVDFactoryCodec::CreateVideoCodec( hint );
-    }
 
     if (pVideoCodec)
     {
       int nTotalLen = pDemuxer->GetStreamLength();
-      int nSeekTo = nTotalLen / 3;
 
-      CLog::Log(LOGDEBUG,"%s - seeking to pos %dms (total: %dms) in %s", __FUNCTION__, nSeekTo, nTotalLen, strPath.c_str());
-      if (pDemuxer->SeekTime(nSeekTo, true))
+      // try a few keyframes from a third of the way in, skipping black and faded ones
+      for (int attempt = 0; attempt < THUMB_SEEK_ATTEMPTS && !bOk; attempt++)
       {
+        int nSeekTo = nTotalLen / 3 + attempt * nTotalLen / 20;
+        bool bLastAttempt = attempt == THUMB_SEEK_ATTEMPTS - 1 || nSeekTo >= nTotalLen;
+
+        CLog::Log(LOGDEBUG,"%s - seeking to pos %dms (total: %dms) in %s", __FUNCTION__, nSeekTo, nTotalLen, strPath.c_str());
+        if (!pDemuxer->SeekTime(nSeekTo, true))
+          break;
+        if (attempt > 0)
+          pVideoCodec->Reset();
+
         DemuxPacket* pPacket = NULL;
         int iDecoderState = VC_ERROR;
         DVDVideoPicture picture;
@@ -200,39 +334,21 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, const CStdString &str
 
         if (iDecoderState & VC_PICTURE && !(picture.iFlags & DVP_FLAG_DROPPED))
         {
+          if (!bLastAttempt && IsBlankPicture(picture))
           {
-            int nWidth = g_advancedSettings.m_thumbSize;
-            double aspect = (double)picture.iWidth / (double)picture.iHeight;
-            int nHeight = (int)((double)g_advancedSettings.m_thumbSize / aspect);
-
-            DllSwScale dllSwScale;
-            dllSwScale.Load();
-
-            BYTE *pOutBuf = new BYTE[nWidth * nHeight * 4];
-            struct SwsContext *context = dllSwScale.sws_getContext(picture.iWidth, picture.iHeight,
-                  PIX_FMT_YUV420P, nWidth, nHeight, PIX_FMT_BGRA, SWS_FAST_BILINEAR | SwScaleCPUFlags(), NULL, NULL, NULL);
-            uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
-            int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
-            uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
-            int     dstStride[] = { nWidth*4, 0, 0, 0 };
-
-            if (context)
-            {
-              dllSwScale.sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
-              dllSwScale.sws_freeContext(context);
-
-              CPicture::CreateThumbnailFromSurface(pOutBuf, nWidth, nHeight, nWidth * 4, strTarget);
-              bOk = true;
-            }
-
-            dllSwScale.Unload();
-            delete [] pOutBuf;
+            CLog::Log(LOGDEBUG,"%s - skipping blank frame at %dms in %s", __FUNCTION__, nSeekTo, strPath.c_str());
+            continue;
           }
+          bOk = CreateThumbFromPicture(picture, strTarget);
         }
         else
         {
           CLog::Log(LOGDEBUG,"%s - decode failed in %s", __FUNCTION__, strPath.c_str());
+          break;
         }
+
+        if (bLastAttempt)
+          break;
       }
       delete pVideoCodec;
     }
@@ -252,6 +368,7 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, const CStdString &str
 
   int nTotalTime = CTimeUtils::GetTimeMS() - nTime;
   CLog::Log(LOGDEBUG,"%s - measured %d ms to extract thumb from file <%s> ", __FUNCTION__, nTotalTime, strPath.c_str());
+  LogThumbThroughput(nTotalTime);
   return bOk;
 }
 
@@ -14,7 +14,6 @@
 #define strcmpi _strcmpi
 #endif
 
-#define RESAMPLE_QUALITY 0
 #undef USE_EXIF_THUMBS
 
 // MS DirectX routines don't like loading .jpg less than 8x8 pixels.
@@ -180,7 +179,7 @@ int ResampleKeepAspect(CxImage &image, unsigned int width, unsigned int height,
   }
   if (bResize)
   {
-    if (!image.Resample(newwidth, newheight, RESAMPLE_QUALITY) || !image.IsValid())
+    if (!image.ResampleSeparable(newwidth, newheight) || !image.IsValid())
     {
       printf("PICTURE::SaveThumb: Unable to resample picture: Error:%s\n", image.GetLastError());
       return -1;
@@ -409,10 +408,15 @@ extern "C"
     CxImage image(dwImageType);
     try
     {
-      bool success = image.Decode(buffer, size, dwImageType);
+      // decode jpegs straight to (about) the thumb size, as is done when loading from file
+      int actualwidth = maxWidth * maxHeight;
+      int actualheight = 0;
+      bool success = image.Decode(buffer, size, dwImageType, actualwidth, actualheight);
       if (!success && dwImageType != CXIMAGE_FORMAT_UNKNOWN)
       { // try to decode with unknown imagetype
-        success = image.Decode(buffer, size, CXIMAGE_FORMAT_UNKNOWN);
+        actualwidth = maxWidth * maxHeight;
+        actualheight = 0;
+        success = image.Decode(buffer, size, CXIMAGE_FORMAT_UNKNOWN, actualwidth, actualheight);
       }
       if (!success || !image.IsValid())
       {
@@ -573,7 +577,7 @@ extern "C"
     }
     if (destwidth==-1)
       destwidth = (int) ((float)destheight * ((float)image.GetWidth()/(float)image.GetHeight())) ;
-    if (!image.Resample(destwidth, destheight, RESAMPLE_QUALITY) || !image.IsValid())
+    if (!image.ResampleSeparable(destwidth, destheight) || !image.IsValid())
     {
       printf("PICTURE::ConvertFile: Unable to resample picture: Error:%s\n", image.GetLastError());
       return 3;
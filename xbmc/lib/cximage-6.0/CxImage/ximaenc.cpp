@@ -700,6 +700,18 @@ bool CxImage::Decode(BYTE * buffer, DWORD size, DWORD imagetype)
 	CxMemFile file(buffer,size);
 	return Decode(&file,imagetype);
 }
+#ifdef XBMC
+/**
+ * Loads an image from memory buffer, downscaling jpegs while decoding.
+ * \param iWidth, iHeight: the size wanted (or the area in iWidth with iHeight 0),
+ *                         set to the original size of the image
+ */
+bool CxImage::Decode(BYTE * buffer, DWORD size, DWORD imagetype, int &iWidth, int &iHeight)
+{
+	CxMemFile file(buffer,size);
+	return Decode(&file,imagetype,iWidth,iHeight);
+}
+#endif
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * Loads an image from file handle.
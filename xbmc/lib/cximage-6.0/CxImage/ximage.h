@@ -520,6 +520,7 @@ public:
 	bool Load(const char * filename, DWORD imagetype, int &iWidth, int &iHeight);
 	bool Decode(FILE * hFile, DWORD imagetype, int &iWidth, int &iHeight);
 	bool Decode(CxFile * hFile, DWORD imagetype, int &iWidth, int &iHeight);
+	bool Decode(BYTE * buffer, DWORD size, DWORD imagetype, int &iWidth, int &iHeight);
 	bool Load(const char * filename, DWORD imagetype)
 	{
 		int iWidth=0;
@@ -607,6 +608,9 @@ public:
                 bool const optimizeRightAngles=true, bool const bKeepOriginalSize=false);
 	bool Rotate180(CxImage* iDst = NULL);
 	bool Resample(long newx, long newy, int mode = 1, CxImage* iDst = NULL);
+#ifdef XBMC
+	bool ResampleSeparable(long newx, long newy);
+#endif
 	bool Resample2(long newx, long newy, InterpolationMethod const inMethod=IM_BICUBIC2,
 				OverflowMethod const ofMethod=OM_REPEAT, CxImage* const iDst = NULL,
 				bool const disableAveraging=false);
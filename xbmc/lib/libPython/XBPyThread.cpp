@@ -46,6 +46,7 @@
 #include "GUIDialogKaiToast.h"
 #include "LocalizeStrings.h"
 #include "utils/log.h"
+#include "utils/TimeUtils.h"
 #include "utils/SingleLock.h"
 #include "Util.h"
 #include "addons/AddonManager.h"
@@ -82,9 +83,9 @@ int xbTrace(PyObject *obj, _frame *frame, int what, PyObject *arg)
   return -1;
 }
 
-XBPyThread::XBPyThread(XBPython *pExecuter, int id)
+XBPyThread::XBPyThread(XBPython *pExecuter, int id, unsigned int idleTimeout)
 {
-  CLog::Log(LOGDEBUG,"new python thread created. id=%d", id);
+  CLog::Log(LOGDEBUG,"new python thread created. id=%d%s", id, idleTimeout ? " (persistent)" : "");
   m_pExecuter   = pExecuter;
   m_threadState = NULL;
   m_id          = id;
@@ -92,6 +93,10 @@ XBPyThread::XBPyThread(XBPython *pExecuter, int id)
   m_argv        = NULL;
   m_source      = NULL;
   m_argc        = 0;
+  m_idleTimeout = idleTimeout;
+  m_idle        = false;
+  m_expired     = false;
+  m_scriptEvent = CreateEvent(NULL, false, false, NULL);
 }
 
 XBPyThread::~XBPyThread()
@@ -101,17 +106,26 @@ XBPyThread::~XBPyThread()
   StopThread();
   CLog::Log(LOGDEBUG,"python thread %d destructed", m_id);
   delete [] m_source;
+  freeArgv();
+  CloseHandle(m_scriptEvent);
+}
+
+void XBPyThread::freeArgv()
+{
   if (m_argv)
   {
     for (unsigned int i = 0; i < m_argc; i++)
       delete [] m_argv[i];
     delete [] m_argv;
   }
+  m_argv = NULL;
+  m_argc = 0;
 }
 
 int XBPyThread::evalFile(const CStdString &src)
 {
   m_type    = 'F';
+  m_file    = src;
   m_source  = new char[src.GetLength()+1];
   strcpy(m_source, src);
   Create();
@@ -129,6 +143,7 @@ int XBPyThread::evalString(const CStdString &src)
 
 int XBPyThread::setArgv(const std::vector<CStdString> &argv)
 {
+  freeArgv();
   m_argc = argv.size();
   m_argv = new char*[m_argc];
   for(unsigned int i = 0; i < m_argc; i++)
@@ -148,8 +163,6 @@ void XBPyThread::Process()
 {
   CLog::Log(LOGDEBUG,"Python thread: start processing");
 
-  int m_Py_file_input = Py_file_input;
-
   // get the global lock
   PyEval_AcquireLock();
   PyThreadState* state = Py_NewInterpreter();
@@ -164,6 +177,45 @@ void XBPyThread::Process()
 
   m_pExecuter->InitializeInterpreter();
 
+  // persistent threads run plugin after plugin, so pay for the common imports up front
+  if (isPersistent())
+    m_pExecuter->PreloadModules();
+
+  PyThreadState_Swap(NULL);
+  PyEval_ReleaseLock();
+
+  while (true)
+  {
+    runScript(state);
+
+    if (!isPersistent())
+      break;
+
+    // tell our executer this script is done, then wait around for the next one
+    m_pExecuter->setDone(m_id);
+    if (!waitForNextScript())
+      break;
+  }
+
+  PyEval_AcquireLock();
+  PyThreadState_Swap(state);
+
+  m_pExecuter->DeInitializeInterpreter();
+
+  Py_EndInterpreter(state);
+  PyThreadState_Swap(NULL);
+
+  PyEval_ReleaseLock();
+}
+
+void XBPyThread::runScript(PyThreadState *state)
+{
+  int m_Py_file_input = Py_file_input;
+  unsigned int startTime = CTimeUtils::GetTimeMS();
+
+  PyEval_AcquireLock();
+  PyThreadState_Swap(state);
+
   CLog::Log(LOGDEBUG, "%s - The source file to load is %s", __FUNCTION__, m_source);
 
   // get path from script file name and add python path's
@@ -196,6 +248,13 @@ void XBPyThread::Process()
   PyObject* module = PyImport_AddModule((char*)"__main__");
   PyObject* moduleDict = PyModule_GetDict(module);
 
+  // a reused interpreter must not leak the previous script's globals into this one
+  PyDict_Clear(moduleDict);
+  PyDict_SetItemString(moduleDict, "__builtins__", PyEval_GetBuiltins());
+  PyObject *name = PyString_FromString("__main__");
+  PyDict_SetItemString(moduleDict, "__name__", name);
+  Py_DECREF(name);
+
   // when we are done initing we store thread state so we can be aborted
   PyThreadState_Swap(NULL);
   PyEval_ReleaseLock();
@@ -343,15 +402,62 @@ void XBPyThread::Process()
     m_threadState = NULL;
   }
 
-  PyEval_AcquireLock();
-  PyThreadState_Swap(state);
+  CLog::Log(LOGDEBUG, "%s - %s ran for %u ms", __FUNCTION__, m_source, CTimeUtils::GetTimeMS() - startTime);
+}
 
-  m_pExecuter->DeInitializeInterpreter();
+bool XBPyThread::waitForNextScript()
+{
+  { CSingleLock lock(m_pExecuter->m_critSection);
+    if (m_stopping)
+    {
+      m_expired = true;
+      return false;
+    }
+    m_idle = true;
+  }
 
-  Py_EndInterpreter(state);
-  PyThreadState_Swap(NULL);
+  DWORD result = WaitForSingleObject(m_scriptEvent, m_idleTimeout);
 
-  PyEval_ReleaseLock();
+  CSingleLock lock(m_pExecuter->m_critSection);
+  if (m_stopping || m_bStop || (result != WAIT_OBJECT_0 && m_idle))
+  { // timed out (or asked to stop) without anyone handing us a new script
+    m_idle    = false;
+    m_expired = true;
+    CLog::Log(LOGDEBUG, "Python thread: releasing interpreter for %s", m_file.c_str());
+    return false;
+  }
+  // a script may have been handed over right as we timed out - make sure the event is consumed
+  ResetEvent(m_scriptEvent);
+  return true;
+}
+
+bool XBPyThread::reuse(int id, const CStdString &src, const std::vector<CStdString> &argv)
+{
+  CSingleLock lock(m_pExecuter->m_critSection);
+  if (!m_idle || m_expired || m_stopping)
+    return false;
+
+  m_id      = id;
+  m_type    = 'F';
+  delete [] m_source;
+  m_source  = new char[src.GetLength()+1];
+  strcpy(m_source, src);
+  setArgv(argv);
+  m_idle    = false;
+  SetEvent(m_scriptEvent);
+  return true;
+}
+
+bool XBPyThread::isIdle()
+{
+  CSingleLock lock(m_pExecuter->m_critSection);
+  return m_idle && !m_expired && !m_stopping;
+}
+
+bool XBPyThread::isExpired()
+{
+  CSingleLock lock(m_pExecuter->m_critSection);
+  return m_expired;
 }
 
 void XBPyThread::OnExit()
@@ -381,6 +487,7 @@ void XBPyThread::stop()
     return;
 
   m_stopping = true;
+  SetEvent(m_scriptEvent);
 
   if (m_threadState)
   {
@@ -45,7 +45,7 @@ class XBPython;
 class XBPyThread : public CThread
 {
 public:
-  XBPyThread(XBPython *pExecuter, int id);
+  XBPyThread(XBPython *pExecuter, int id, unsigned int idleTimeout = 0);
   virtual ~XBPyThread();
   int evalFile(const CStdString &src);
   int evalString(const CStdString &src);
@@ -53,6 +53,31 @@ public:
   bool isStopping();
   void stop();
 
+  /*! \brief Hand a new script to a persistent thread that is waiting for work
+   The interpreter (and any modules it has imported) is kept alive between scripts.
+   \param id the script id to run the file as
+   \param src the file to run
+   \param argv the arguments to pass to the script
+   \return true if the thread was idle and accepted the script, false otherwise
+   */
+  bool reuse(int id, const CStdString &src, const std::vector<CStdString> &argv);
+
+  /*! \brief Whether this thread keeps its interpreter alive between scripts
+   */
+  bool isPersistent() const { return m_idleTimeout > 0; };
+
+  /*! \brief Whether a persistent thread is idle and can accept a new script
+   */
+  bool isIdle();
+
+  /*! \brief Whether a persistent thread has timed out (or been stopped) and finished
+   */
+  bool isExpired();
+
+  /*! \brief The file this thread was created for
+   */
+  const CStdString &getSource() const { return m_file; };
+
 protected:
   XBPython      *m_pExecuter;
   PyThreadState *m_threadState;
@@ -64,6 +89,16 @@ protected:
   bool m_stopping;
   int  m_id;
 
+  unsigned int m_idleTimeout; // ms a persistent thread waits for another script before exiting
+  bool m_idle;
+  bool m_expired;
+  CStdString m_file;
+  HANDLE m_scriptEvent;
+
+  void runScript(PyThreadState *state);
+  bool waitForNextScript();
+  void freeArgv();
+
   virtual void OnStartup();
   virtual void Process();
   virtual void OnExit();
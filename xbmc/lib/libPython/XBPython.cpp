@@ -319,6 +319,19 @@ void XBPython::InitializeInterpreter()
   }
 }
 
+void XBPython::PreloadModules()
+{
+  if (PyRun_SimpleString(""
+        "import xbmc\n"
+        "import xbmcplugin\n"
+        "import xbmcgui\n"
+        "import xbmcaddon\n"
+        "") == -1)
+  {
+    CLog::Log(LOGERROR, "Python: failed to preload xbmc modules");
+  }
+}
+
 void XBPython::DeInitializeInterpreter()
 {
   DeinitXBMCModule();
@@ -463,12 +476,37 @@ void XBPython::FreeResources()
     PyList::iterator it = m_vecPyList.begin();
     while (it != m_vecPyList.end())
     {
+      if (!it->bPersistent)
+      {
+        lock.Leave(); //unlock here because the python thread might lock when it exits
+        delete it->pyThread;
+        lock.Enter();
+      }
+      it = m_vecPyList.erase(it);
+      FinalizeScript();
+    }
+    FreePool(false);
+  }
+}
+
+void XBPython::FreePool(bool expiredOnly)
+{
+  CSingleLock lock(m_critSection);
+  PyThreadPool::iterator it = m_vecPyPool.begin();
+  while (it != m_vecPyPool.end())
+  {
+    if (!expiredOnly || (*it)->isExpired())
+    {
+      XBPyThread *pyThread = *it;
+      it = m_vecPyPool.erase(it);
       lock.Leave(); //unlock here because the python thread might lock when it exits
-      delete it->pyThread;
+      delete pyThread;
       lock.Enter();
-      it = m_vecPyList.erase(it);
       FinalizeScript();
+      it = m_vecPyPool.begin();
     }
+    else
+      ++it;
   }
 }
 
@@ -497,13 +535,17 @@ void XBPython::Process()
       //delete scripts which are done
       if (it->bDone)
       {
-        delete it->pyThread;
+        if (!it->bPersistent)
+          delete it->pyThread;
         it = m_vecPyList.erase(it);
         FinalizeScript();
       }
       else ++it;
     }
 
+    // release persistent interpreters that have been idle for too long
+    FreePool(true);
+
     if(m_iDllScriptCounter == 0 && m_endtime + 10000 < CTimeUtils::GetTimeMS())
       Finalize();
   }
@@ -560,6 +602,64 @@ int XBPython::evalFile(const CStdString &src, const std::vector<CStdString> &arg
   inf.bDone     = false;
   inf.strFile   = src;
   inf.pyThread  = pyThread;
+  inf.bPersistent = false;
+
+  m_vecPyList.push_back(inf);
+
+  return m_nextid;
+}
+
+int XBPython::evalFilePooled(const CStdString &src, const std::vector<CStdString> &argv, unsigned int idleTimeout)
+{
+  if (!idleTimeout)
+    return evalFile(src, argv);
+
+  CSingleExit ex(g_graphicsContext);
+  CSingleLock lock(m_critSection);
+  // return if file doesn't exist
+  if (!XFILE::CFile::Exists(src))
+  {
+    CLog::Log(LOGERROR, "Python script \"%s\" does not exist", CSpecialProtocol::TranslatePath(src).c_str());
+    return -1;
+  }
+
+  // check if locked
+  if (g_settings.GetCurrentProfile().programsLocked() && !g_passwordManager.IsMasterLockUnlocked(true))
+    return -1;
+
+  Initialize();
+
+  if (!m_bInitialized) return -1;
+
+  m_nextid++;
+
+  // look for a warm interpreter for this script first
+  XBPyThread *pyThread = NULL;
+  for (PyThreadPool::iterator it = m_vecPyPool.begin(); it != m_vecPyPool.end(); ++it)
+  {
+    if ((*it)->getSource() == src && (*it)->reuse(m_nextid, src, argv))
+    {
+      pyThread = *it;
+      CLog::Log(LOGDEBUG, "%s - reusing warm interpreter for %s", __FUNCTION__, src.c_str());
+      break;
+    }
+  }
+
+  if (!pyThread)
+  { // none available - the pool thread holds its own reference on the python library
+    Initialize();
+    pyThread = new XBPyThread(this, m_nextid, idleTimeout);
+    pyThread->setArgv(argv);
+    pyThread->evalFile(src);
+    m_vecPyPool.push_back(pyThread);
+  }
+
+  PyElem inf;
+  inf.id        = m_nextid;
+  inf.bDone     = false;
+  inf.strFile   = src;
+  inf.pyThread  = pyThread;
+  inf.bPersistent = true;
 
   m_vecPyList.push_back(inf);
 
@@ -722,6 +822,7 @@ int XBPython::evalString(const CStdString &src, const std::vector<CStdString> &a
   inf.bDone     = false;
   inf.strFile   = "<string>";
   inf.pyThread  = pyThread;
+  inf.bPersistent = false;
 
   m_vecPyList.push_back(inf);
 
@@ -32,11 +32,13 @@ typedef struct {
   bool bDone;
   std::string strFile;
   XBPyThread *pyThread;
+  bool bPersistent; // pyThread is owned by the interpreter pool, not by this element
 }PyElem;
 
 class LibraryLoader;
 
 typedef std::vector<PyElem> PyList;
+typedef std::vector<XBPyThread*> PyThreadPool;
 typedef std::vector<PVOID> PlayerCallbackList;
 typedef std::vector<LibraryLoader*> PythonExtensionLibraries;
 
@@ -66,6 +68,17 @@ public:
   int GetPythonScriptId(int scriptPosition);
   int evalFile(const CStdString &src);
   int evalFile(const CStdString &src, const std::vector<CStdString> &argv);
+
+  /*! \brief Run a script on a warm, persistent interpreter if one is available
+   Scripts run this way share a sub-interpreter with previous runs of the same file, so modules
+   they import are only imported once. The interpreter is released once it has been idle for
+   the file's idle timeout (see CAdvancedSettings::GetPythonIdleTimeout).
+   \param src path to the script
+   \param argv arguments to pass to the script
+   \param idleTimeout time in ms to keep the interpreter alive between runs. 0 runs the script as evalFile does.
+   \return the id of the script, -1 on failure
+   */
+  int evalFilePooled(const CStdString &src, const std::vector<CStdString> &argv, unsigned int idleTimeout);
   int evalString(const CStdString &src, const std::vector<CStdString> &argv);
 
   bool isRunning(int scriptId);
@@ -85,6 +98,9 @@ public:
   // remove modules and references when interpreter done
   void DeInitializeInterpreter();
 
+  // import the xbmc modules up front so scripts run on a persistent interpreter don't pay for it
+  void PreloadModules();
+
   void RegisterExtensionLib(LibraryLoader *pLib);
   void UnregisterExtensionLib(LibraryLoader *pLib);
   void UnloadExtensionLibs();
@@ -104,6 +120,7 @@ public:
   CCriticalSection    m_critSection;
 private:
   bool              FileExist(const char* strFile);
+  void              FreePool(bool expiredOnly);
 
   int               m_nextid;
   PyThreadState*    m_mainThreadState;
@@ -116,6 +133,7 @@ private:
 
   //Vector with list of threads used for running scripts
   PyList              m_vecPyList;
+  PyThreadPool        m_vecPyPool;
   PlayerCallbackList  m_vecPlayerCallbackList;
   LibraryLoader*      m_pDll;
 
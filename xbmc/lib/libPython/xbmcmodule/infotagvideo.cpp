@@ -21,6 +21,7 @@
 
 #include "infotagvideo.h"
 #include "pyutil.h"
+#include "VideoDatabase.h"
 
 #ifndef __GNUC__
 #pragma code_seg("PY_TEXT")
@@ -115,6 +116,20 @@ namespace PYXBMC
 
   PyObject* InfoTagVideo_GetPictureURL(InfoTagVideo *self, PyObject *args)
   {
+    // library listings leave out the thumb urls, fetch them the first time they are asked for
+    if (self->infoTag.m_strPictureURL.m_url.empty())
+    {
+      if (self->infoTag.m_strPictureURL.m_xml.IsEmpty() && self->infoTag.m_iDbId > -1)
+      {
+        CVideoDatabase db;
+        if (db.Open())
+        {
+          db.GetScraperXml(self->infoTag);
+          db.Close();
+        }
+      }
+      self->infoTag.m_strPictureURL.Parse();
+    }
     return Py_BuildValue((char*)"s", self->infoTag.m_strPictureURL.GetFirstThumb().m_url.c_str());
   }
 
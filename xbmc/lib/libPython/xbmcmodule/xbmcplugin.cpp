@@ -169,43 +169,47 @@ namespace PYXBMC
   }
 
   PyDoc_STRVAR(endOfDirectory__doc__,
-    "endOfDirectory(handle[, succeeded, updateListing, cacheToDisc]) -- Callback function to tell XBMC that the end of the directory listing in a virtualPythonFolder module is reached.\n"
+    "endOfDirectory(handle[, succeeded, updateListing, cacheToDisc, cacheTTL]) -- Callback function to tell XBMC that the end of the directory listing in a virtualPythonFolder module is reached.\n"
     "\n"
     "handle           : integer - handle the plugin was started with.\n"
     "succeeded        : [opt] bool - True=script completed successfully(Default)/False=Script did not.\n"
     "updateListing    : [opt] bool - True=this folder should update the current listing/False=Folder is a subfolder(Default).\n"
     "cacheToDisc      : [opt] bool - True=Folder will cache if extended time(default)/False=this folder will never cache to disc.\n"
+    "cacheTTL         : [opt] integer - seconds XBMC may show this listing again without running the plugin (default 0=never).\n"
     "\n"
     "*Note, You can use the above as keywords for arguments and skip certain optional arguments.\n"
     "       Once you use a keyword, all following arguments require the keyword.\n"
     "\n"
     "example:\n"
-    "  - xbmcplugin.endOfDirectory(int(sys.argv[1]), cacheToDisc=False)\n");
+    "  - xbmcplugin.endOfDirectory(int(sys.argv[1]), cacheToDisc=False)\n"
+    "  - xbmcplugin.endOfDirectory(int(sys.argv[1]), cacheTTL=3600)\n");
 
   PyObject* XBMCPLUGIN_EndOfDirectory(PyTypeObject *type, PyObject *args, PyObject *kwds)
   {
-    static const char *keywords[] = { "handle", "succeeded", "updateListing", "cacheToDisc", NULL };
+    static const char *keywords[] = { "handle", "succeeded", "updateListing", "cacheToDisc", "cacheTTL", NULL };
     int handle = -1;
     char bSucceeded = true;
     char bUpdateListing = false;
     char bCacheToDisc = true;
+    int cacheTTL = 0;
     // parse arguments to constructor
     if (!PyArg_ParseTupleAndKeywords(
       args,
       kwds,
-      (char*)"i|bbb",
+      (char*)"i|bbbi",
       (char**)keywords,
       &handle,
       &bSucceeded,
       &bUpdateListing,
-      &bCacheToDisc
+      &bCacheToDisc,
+      &cacheTTL
       ))
     {
       return NULL;
     };
 
     // tell the directory class that we're done
-    XFILE::CPluginDirectory::EndOfDirectory(handle, 0 != bSucceeded, 0 != bUpdateListing, 0 != bCacheToDisc);
+    XFILE::CPluginDirectory::EndOfDirectory(handle, 0 != bSucceeded, 0 != bUpdateListing, 0 != bCacheToDisc, cacheTTL > 0 ? cacheTTL : 0);
 
     Py_INCREF(Py_None);
     return Py_None;
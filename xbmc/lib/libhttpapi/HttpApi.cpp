@@ -3,11 +3,17 @@
 #include "XBMChttp.h"
 #include "Application.h"
 #include "ApplicationMessenger.h"
+#include "SingleLock.h"
 
 #define MAX_PARAS 20
 
+// the messenger keeps a single response buffer, so calls from the webserver's
+// threads are made one at a time, or they could pick up each other's responses
+static CCriticalSection g_httpApiSection;
+
 CStdString CHttpApi::WebMethodCall(CStdString &command, CStdString &parameter)
 {
+  CSingleLock lock(g_httpApiSection);
   CStdString response = MethodCall(command, parameter);
   response.Format("%s%s%s", m_pXbmcHttp->incWebHeader ? "<html>\n" : "", response.c_str(), m_pXbmcHttp->incWebFooter ? "\n</html>\n" : "");
   return response;
@@ -15,6 +21,7 @@ CStdString CHttpApi::WebMethodCall(CStdString &command, CStdString &parameter)
 
 CStdString CHttpApi::MethodCall(CStdString &command, CStdString &parameter)
 {
+  CSingleLock lock(g_httpApiSection);
   if (parameter.IsEmpty())
     checkForFunctionTypeParas(command, parameter);
 
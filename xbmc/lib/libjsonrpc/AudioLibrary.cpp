@@ -69,12 +69,13 @@ JSON_STATUS CAudioLibrary::GetAlbums(const CStdString &method, ITransportLayer *
 
   int artistID = ParameterAsInt(param, -1, "artistid");
   int genreID  = ParameterAsInt(param, -1, "genreid");
-  int start = ParameterAsInt(param, -1, "start");
-  int end = ParameterAsInt(param, -1, "end");
+
+  DatabaseLimits limits;
+  ParseLimits(param, limits);
 
   CFileItemList items;
-  if (musicdatabase.GetAlbumsNav("", items, genreID, artistID, start, end))
-    HandleFileItemList("albumid", false, "albums", items, param, result);
+  if (musicdatabase.GetAlbumsNav("", items, genreID, artistID, &limits))
+    HandleFileItemList("albumid", false, "albums", items, param, result, &limits);
 
   musicdatabase.Close();
   return OK;
@@ -97,9 +98,29 @@ JSON_STATUS CAudioLibrary::GetSongs(const CStdString &method, ITransportLayer *t
   int albumID  = ParameterAsInt(param, -1, "albumid");
   int genreID  = ParameterAsInt(param, -1, "genreid");
 
+  DatabaseLimits limits;
+  ParseLimits(param, limits);
+
+  CFileItemList items;
+  if (musicdatabase.GetSongsNav("", items, genreID, artistID, albumID, &limits))
+    HandleFileItemList("songid", true, "songs", items, param, result, &limits);
+
+  musicdatabase.Close();
+  return OK;
+}
+
+JSON_STATUS CAudioLibrary::Search(const CStdString &method, ITransportLayer *transport, IClient *client, const Value &parameterObject, Value &result)
+{
+  if (!parameterObject.isObject() || !parameterObject["search"].isString())
+    return InvalidParams;
+
+  CMusicDatabase musicdatabase;
+  if (!musicdatabase.Open())
+    return InternalError;
+
   CFileItemList items;
-  if (musicdatabase.GetSongsNav("", items, genreID, artistID, albumID))
-    HandleFileItemList("songid", true, "songs", items, param, result);
+  if (musicdatabase.Search(parameterObject["search"].asString(), items))
+    HandleSearchResults(items, parameterObject, result);
 
   musicdatabase.Close();
   return OK;
@@ -25,6 +25,7 @@
 #include "VideoLibrary.h"
 #include "FileOperations.h"
 #include "../Util.h"
+#include "../Database.h"
 
 using namespace MUSIC_INFO;
 using namespace Json;
@@ -132,26 +133,38 @@ void CFileItemHandler::FillMusicDetails(const CMusicInfoTag *musicInfo, const CS
     result["rating"] = (int)(musicInfo->GetRating() - '0');
 }
 
-void CFileItemHandler::HandleFileItemList(const char *id, bool allowFile, const char *resultname, CFileItemList &items, const Value &parameterObject, Value &result)
+void CFileItemHandler::HandleFileItemList(const char *id, bool allowFile, const char *resultname, CFileItemList &items, const Value &parameterObject, Value &result, const DatabaseLimits *limits)
 {
   const Value param = parameterObject.isObject() ? parameterObject : Value(objectValue);
 
-  int size  = items.Size();
-  int start = param.get("start", 0).asInt(); 
-  int end   = param.get("end", size).asInt(); 
-  end = end < 0 ? 0 : end > size ? size : end;
-  start = start < 0 ? 0 : start > end ? end : start;
-
-  Sort(items, param);
+  int size, start, end, offset;
+  if (limits && limits->total >= 0)
+  { // the database has already sorted the listing and given us only the items asked for
+    size   = limits->total;
+    start  = limits->start;
+    end    = limits->start + items.Size();
+    offset = limits->start;
+  }
+  else
+  {
+    size  = items.Size();
+    start = param.get("start", 0).asInt(); 
+    end   = param.get("end", size).asInt(); 
+    end = end < 0 ? 0 : end > size ? size : end;
+    start = start < 0 ? 0 : start > end ? end : start;
+    offset = 0;
+
+    Sort(items, param);
+  }
 
   result["start"] = start;
   result["end"]   = end;
   result["total"] = size;
 
-  for (unsigned int i = start; i < end; i++)
+  for (int i = start; i < end; i++)
   {
     Value object;
-    CFileItemPtr item = items.Get(i);
+    CFileItemPtr item = items.Get(i - offset);
 
     if (allowFile)
     {
@@ -206,6 +219,33 @@ void CFileItemHandler::HandleFileItemList(const char *id, bool allowFile, const
   }
 }
 
+void CFileItemHandler::HandleSearchResults(CFileItemList &items, const Value &parameterObject, Value &result)
+{
+  const Value param = parameterObject.isObject() ? parameterObject : Value(objectValue);
+
+  // the items are ranked by the database, so they're only windowed here
+  int size  = items.Size();
+  int start = param.get("start", 0).asInt();
+  int end   = param.get("end", size).asInt();
+  end = end < 0 ? 0 : end > size ? size : end;
+  start = start < 0 ? 0 : start > end ? end : start;
+
+  result["start"] = start;
+  result["end"]   = end;
+  result["total"] = size;
+
+  for (int i = start; i < end; i++)
+  {
+    CFileItemPtr item = items.Get(i);
+    Value object;
+    object["type"]  = item->GetProperty("searchtype").c_str();
+    object["id"]    = item->GetPropertyInt("searchid");
+    object["label"] = item->GetLabel().c_str();
+    object["score"] = item->GetPropertyInt("searchscore");
+    result["results"].append(object);
+  }
+}
+
 bool CFileItemHandler::FillFileItemList(const Value &parameterObject, CFileItemList &list)
 {
   Value param = ForceObject(parameterObject);
@@ -228,6 +268,33 @@ bool CFileItemHandler::FillFileItemList(const Value &parameterObject, CFileItemL
   return true;
 }
 
+void CFileItemHandler::ParseLimits(const Value &parameterObject, DatabaseLimits &limits)
+{
+  const Value param = parameterObject.isObject() ? parameterObject : Value(objectValue);
+
+  limits.start = param.get("start", 0).asInt();
+  limits.end   = param.get("end", -1).asInt();
+  if (limits.end < 0 && param.isMember("end"))
+    limits.end = 0;
+
+  Value sort = param["sort"];
+  if (sort.isObject())
+  {
+    CStdString method = sort["method"].isString() ? sort["method"].asString() : "none";
+    CStdString order  = sort["order"].isString() ? sort["order"].asString() : "ascending";
+    bool ignorethe    = sort["ignorethe"].isBool() ? sort["ignorethe"].asBool() : false;
+
+    method = method.ToLower();
+    order  = order.ToLower();
+
+    if (!ParseSortMethods(method, ignorethe, order, limits.sortMethod, limits.sortOrder))
+    {
+      limits.sortMethod = SORT_METHOD_NONE;
+      limits.sortOrder  = SORT_ORDER_ASC;
+    }
+  }
+}
+
 bool CFileItemHandler::ParseSortMethods(const CStdString &method, const bool &ignorethe, const CStdString &order, SORT_METHOD &sortmethod, SORT_ORDER &sortorder)
 {
   if (order.Equals("ascending"))
@@ -27,6 +27,8 @@
 #include "../VideoInfoTag.h"
 #include "../MusicInfoTag.h"
 
+struct DatabaseLimits;
+
 namespace JSONRPC
 {
   class CFileItemHandler : public CJSONUtils
@@ -34,7 +36,9 @@ namespace JSONRPC
   protected:
     static void FillVideoDetails(const CVideoInfoTag *videoInfo, const CStdString &field, Json::Value &result);
     static void FillMusicDetails(const MUSIC_INFO::CMusicInfoTag *musicInfo, const CStdString &field, Json::Value &result);
-    static void HandleFileItemList(const char *id, bool allowFile, const char *resultname, CFileItemList &items, const Json::Value &parameterObject, Json::Value &result);
+    static void HandleFileItemList(const char *id, bool allowFile, const char *resultname, CFileItemList &items, const Json::Value &parameterObject, Json::Value &result, const DatabaseLimits *limits = NULL);
+    static void ParseLimits(const Json::Value &parameterObject, DatabaseLimits &limits);
+    static void HandleSearchResults(CFileItemList &items, const Json::Value &parameterObject, Json::Value &result);
 
     static bool FillFileItemList(const Json::Value &parameterObject, CFileItemList &list);
   private:
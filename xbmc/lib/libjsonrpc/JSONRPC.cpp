@@ -31,7 +31,9 @@
 #include "SystemOperations.h"
 #include "XBMCOperations.h"
 #include "AnnouncementManager.h"
+#include "JSONStreamWriter.h"
 #include "log.h"
+#include "TimeUtils.h"
 #include <string.h>
 
 using namespace ANNOUNCEMENT;
@@ -155,6 +157,7 @@ Command CJSONRPC::m_commands[] = {
   { "AudioLibrary.GetArtists",                      CAudioLibrary::GetArtists,                           Response,     ReadData,        "Retrieve all artists" },
   { "AudioLibrary.GetAlbums",                       CAudioLibrary::GetAlbums,                            Response,     ReadData,        "Retrieve all albums from specified artist or genre, Fields: album_description, album_theme, album_mood, album_style, album_type, album_label, album_artist, album_genre, album_rating, album_title" },
   { "AudioLibrary.GetSongs",                        CAudioLibrary::GetSongs,                             Response,     ReadData,        "Retrieve all songs from specified album, artist or genre" },
+  { "AudioLibrary.Search",                          CAudioLibrary::Search,                               Response,     ReadData,        "Search artists, albums and songs by name, best matches first. Parameter example { \"search\": \"beat\", \"start\": 0, \"end\": 10 }. start and end are optional" },
 
   { "AudioLibrary.ScanForContent",                  CAudioLibrary::ScanForContent,                       Response,     ScanLibrary,     "" },
 
@@ -166,6 +169,7 @@ Command CJSONRPC::m_commands[] = {
   { "VideoLibrary.GetEpisodes",                     CVideoLibrary::GetEpisodes,                          Response,     ReadData,        "Parameter example { \"tvshowid\": 0, \"season\": 1, \"fields\": [\"plot\"], \"sortmethod\": \"episode\", \"sortorder\": \"ascending\", \"start\": 0, \"end\": 3}. sortorder, sortmethod, start and end are optional" },
 
   { "VideoLibrary.GetMusicVideos",                  CVideoLibrary::GetMusicVideos,                       Response,     ReadData,        "Parameter example { \"artistid\": 0, \"albumid\": 0, \"fields\": [\"plot\"], \"sortmethod\": \"artistignorethe\", \"sortorder\": \"ascending\", \"start\": 0, \"end\": 3}. sortorder, sortmethod, start and end are optional" },
+  { "VideoLibrary.Search",                          CVideoLibrary::Search,                               Response,     ReadData,        "Search movies, tv shows, episodes and music videos by title, best matches first. Parameter example { \"search\": \"star\", \"start\": 0, \"end\": 10 }. start and end are optional" },
 
   { "VideoLibrary.GetRecentlyAddedMovies",          CVideoLibrary::GetRecentlyAddedMovies,               Response,     ReadData,        "Retrieve all recently added movies. Parameter example { \"fields\": [\"plot\"], \"sortmethod\": \"title\", \"sortorder\": \"ascending\", \"start\": 0, \"end\": 3}. fields, sortorder, sortmethod, start and end are optional" },
   { "VideoLibrary.GetRecentlyAddedEpisodes",        CVideoLibrary::GetRecentlyAddedEpisodes,             Response,     ReadData,        "Retrieve all recently added episodes. Parameter example { \"fields\": [\"plot\"], \"sortmethod\": \"title\", \"sortorder\": \"ascending\", \"start\": 0, \"end\": 3}. fields, sortorder, sortmethod, start and end are optional" },
@@ -297,7 +301,24 @@ JSON_STATUS CJSONRPC::Announce(const CStdString &method, ITransportLayer *transp
 
 CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client)
 {
-  Value inputroot, outputroot, result;
+  std::string str;
+  CJSONStreamWriter *writer = StreamMethodCall(inputString, transport, client);
+  writer->ReadAll(str);
+  delete writer;
+  return str;
+}
+
+CJSONStreamWriter *CJSONRPC::StreamMethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client)
+{
+  unsigned int startTime = CTimeUtils::GetTimeMS();
+  Value outputroot;
+  HandleMethodCall(inputString, transport, client, outputroot);
+  return new CJSONStreamWriter(outputroot, startTime);
+}
+
+void CJSONRPC::HandleMethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client, Value &outputroot)
+{
+  Value inputroot, result;
 
   JSON_STATUS errorCode = OK;
   Reader reader;
@@ -320,7 +341,7 @@ CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *
   switch (errorCode)
   {
     case OK:
-      outputroot["result"] = result;
+      outputroot["result"].swap(result);
       break;
     case ACK:
       outputroot["result"] = "OK";
@@ -350,10 +371,6 @@ CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *
       outputroot["error"]["message"] = "Internal error.";
       break;
   }
-
-  StyledWriter writer;
-  CStdString str = writer.write(outputroot);
-  return str;
 }
 
 JSON_STATUS CJSONRPC::InternalMethodCall(const CStdString& method, Value& o, Value &result, ITransportLayer *transport, IClient *client)
@@ -70,11 +70,21 @@ namespace JSONRPC
     const char* description;
   } Command;
 
+  class CJSONStreamWriter;
+
   class CJSONRPC
   {
   public:
     static CStdString MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client);
 
+    /*!
+     \brief Handle a request, leaving the response to be written out by the transport.
+     The response is serialized as it is read from the returned writer, so large
+     responses can be sent in chunks instead of being built as one string.
+     \return the writer for the response, to be deleted by the caller
+     */
+    static CJSONStreamWriter *StreamMethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client);
+
     static JSON_STATUS Introspect(const CStdString &method, ITransportLayer *transport, IClient *client, const Json::Value& parameterObject, Json::Value &result);
     static JSON_STATUS Version(const CStdString &method, ITransportLayer *transport, IClient *client, const Json::Value& parameterObject, Json::Value &result);
     static JSON_STATUS Permission(const CStdString &method, ITransportLayer *transport, IClient *client, const Json::Value& parameterObject, Json::Value &result);
@@ -83,6 +93,7 @@ namespace JSONRPC
     static JSON_STATUS SetAnnouncementFlags(const CStdString &method, ITransportLayer *transport, IClient *client, const Json::Value& parameterObject, Json::Value &result);
     static JSON_STATUS Announce(const CStdString &method, ITransportLayer *transport, IClient *client, const Json::Value& parameterObject, Json::Value &result);
   private:
+    static void HandleMethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client, Json::Value &outputroot);
     static JSON_STATUS InternalMethodCall(const CStdString& method, Json::Value& o, Json::Value &result, ITransportLayer *transport, IClient *client);
     static inline bool IsProperJSONRPC(const Json::Value& inputroot);
 
@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "JSONStreamWriter.h"
+#include <string.h>
+#include "TimeUtils.h"
+#include "log.h"
+
+using namespace JSONRPC;
+using namespace Json;
+
+CJSONStreamWriter::CJSONStreamWriter(Value &root, unsigned int startTime)
+{
+  m_root.swap(root);
+  m_offset    = 0;
+  m_finished  = false;
+  m_startTime = startTime;
+  m_firstRead = 0;
+  m_written   = 0;
+
+  WriteValue(&m_root);
+}
+
+CJSONStreamWriter::~CJSONStreamWriter()
+{
+  if (m_firstRead)
+    CLog::Log(LOGDEBUG, "JSONRPC: Wrote %u bytes, first after %u ms, last after %u ms",
+              m_written, m_firstRead - m_startTime, CTimeUtils::GetTimeMS() - m_startTime);
+}
+
+unsigned int CJSONStreamWriter::Read(char *buffer, unsigned int size)
+{
+  Fill(size);
+
+  unsigned int length = m_pending.size() - m_offset;
+  if (length > size)
+    length = size;
+  if (length == 0)
+    return 0;
+
+  memcpy(buffer, m_pending.c_str() + m_offset, length);
+  m_offset += length;
+
+  if (!m_firstRead)
+    m_firstRead = CTimeUtils::GetTimeMS();
+  m_written += length;
+  return length;
+}
+
+void CJSONStreamWriter::ReadAll(std::string &output)
+{
+  char buffer[16384];
+  unsigned int length;
+  while ((length = Read(buffer, sizeof(buffer))) > 0)
+    output.append(buffer, length);
+}
+
+void CJSONStreamWriter::Fill(unsigned int size)
+{
+  // drop what has already been read, there is never much left over
+  m_pending.erase(0, m_offset);
+  m_offset = 0;
+
+  while (m_pending.size() < size && !m_stack.empty())
+  {
+    Frame &frame = m_stack.back();
+    Value &value = *frame.value;
+
+    if (value.isArray())
+    {
+      // the previous element has been written, so free it
+      if (frame.index > 0)
+        value[frame.index - 1] = Value();
+
+      if (frame.index == value.size())
+      {
+        m_pending += ']';
+        m_stack.pop_back();
+        continue;
+      }
+      if (frame.index > 0)
+        m_pending += ',';
+      WriteValue(&value[frame.index++]); // may push, so frame is not valid after this
+    }
+    else
+    {
+      if (frame.index > 0)
+        value[frame.members[frame.index - 1]] = Value();
+
+      if (frame.index == frame.members.size())
+      {
+        m_pending += '}';
+        m_stack.pop_back();
+        continue;
+      }
+      const std::string &name = frame.members[frame.index++];
+      if (frame.index > 1)
+        m_pending += ',';
+      m_pending += valueToQuotedString(name.c_str());
+      m_pending += ':';
+      WriteValue(&value[name]);
+    }
+  }
+
+  if (m_stack.empty() && !m_finished)
+  {
+    // keep the trailing newline the other writers emit, line based clients rely on it
+    m_pending += '\n';
+    m_finished = true;
+  }
+}
+
+void CJSONStreamWriter::WriteValue(Value *value)
+{
+  switch (value->type())
+  {
+  case nullValue:
+    m_pending += "null";
+    break;
+  case intValue:
+    m_pending += valueToString(value->asInt());
+    break;
+  case uintValue:
+    m_pending += valueToString(value->asUInt());
+    break;
+  case realValue:
+    m_pending += valueToString(value->asDouble());
+    break;
+  case stringValue:
+    m_pending += valueToQuotedString(value->asCString());
+    break;
+  case booleanValue:
+    m_pending += valueToString(value->asBool());
+    break;
+  case arrayValue:
+  case objectValue:
+    {
+      m_stack.push_back(Frame());
+      Frame &frame = m_stack.back();
+      frame.value = value;
+      frame.index = 0;
+      if (value->isObject())
+      {
+        Value::Members members = value->getMemberNames();
+        frame.members.swap(members);
+        m_pending += '{';
+      }
+      else
+        m_pending += '[';
+    }
+    break;
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <string>
+#include <vector>
+#include "json/json.h"
+
+namespace JSONRPC
+{
+  /*!
+   \brief Writes a Json::Value as compact JSON, a chunk at a time.
+
+   Unlike Json::StyledWriter the document is never held as one string: each Read()
+   serializes only as much of the tree as is needed to fill the caller's buffer, so
+   a transport can start sending straight away. Parts of the tree are released once
+   they have been written, so the tree shrinks as the response goes out.
+   */
+  class CJSONStreamWriter
+  {
+  public:
+    /*!
+     \brief Take over a document to be written.
+     \param root the document; it is swapped out, leaving root null
+     \param startTime time (CTimeUtils::GetTimeMS) the request was received, for the timing log
+     */
+    CJSONStreamWriter(Json::Value &root, unsigned int startTime);
+    ~CJSONStreamWriter();
+
+    /*!
+     \brief Serialize the next part of the document.
+     \param buffer where to put the output
+     \param size size of buffer
+     \return the number of bytes written, 0 once the whole document has been read
+     */
+    unsigned int Read(char *buffer, unsigned int size);
+
+    /*!
+     \brief Serialize the whole (remaining) document into a string.
+     */
+    void ReadAll(std::string &output);
+  private:
+    struct Frame
+    {
+      Json::Value *value;
+      Json::Value::Members members;
+      unsigned int index;
+    };
+
+    void Fill(unsigned int size);
+    void WriteValue(Json::Value *value);
+
+    Json::Value        m_root;
+    std::vector<Frame> m_stack;
+    std::string        m_pending;
+    unsigned int       m_offset;
+    bool               m_finished;
+
+    unsigned int m_startTime;
+    unsigned int m_firstRead;
+    unsigned int m_written;
+  };
+}
@@ -2,11 +2,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <errno.h>
+#endif
+#if defined(_LINUX) && !defined(__APPLE__)
+#include <sys/epoll.h>
+#define HAS_EPOLL
+#endif
 #include "JSONRPC.h"
+#include "JSONStreamWriter.h"
 #include "json/json.h"
 #include "AnnouncementManager.h"
 #include "log.h"
 #include "SingleLock.h"
+#include "TimeUtils.h"
+#include "JobManager.h"
 
 #ifdef _WIN32
 extern "C" int inet_pton(int af, const char *src, void *dst);
@@ -19,7 +30,45 @@ using namespace ANNOUNCEMENT;
 //using namespace std; On VS2010, bind conflicts with std::bind
 using namespace Json;
 
-#define RECEIVEBUFFER 1024
+#define RECEIVEBUFFER 4096
+#define SENDBUFFER 16384
+
+// a client whose unsent output is over this size gets no announcements, and isn't read
+// from until it catches up
+#define MAX_CLIENT_BACKLOG (1024 * 1024)
+// as is a client with this many requests waiting to be handled
+#define MAX_CLIENT_REQUESTS 16
+// requests larger than this are dropped
+#define MAX_REQUEST_SIZE (1024 * 1024)
+
+#define POLL_READ  0x1
+#define POLL_WRITE 0x2
+
+#ifdef _WIN32
+// without a wakeup pipe, output queued from other threads is picked up by the next select
+#define POLL_TIMEOUT 100
+#else
+#define POLL_TIMEOUT 1000
+#endif
+
+static void SetNonBlocking(int socket)
+{
+#ifdef _WIN32
+  u_long nonblocking = 1;
+  ioctlsocket(socket, FIONBIO, &nonblocking);
+#else
+  fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+#endif
+}
+
+static bool WouldBlock()
+{
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -49,6 +98,9 @@ CTCPServer::CTCPServer(int port, bool nonlocal)
   m_port = port;
   m_nonlocal = nonlocal;
   m_ServerSocket = -1;
+  m_epoll = -1;
+  m_wakeup[0] = m_wakeup[1] = -1;
+  m_jobs = 0;
 }
 
 void CTCPServer::Process()
@@ -57,63 +109,126 @@ void CTCPServer::Process()
 
   while (!m_bStop)
   {
+    UpdateEvents();
+
+    // collect the sockets that are ready, along with what they are ready for
+    std::vector<std::pair<int, int> > ready;
+    int res;
+#ifdef HAS_EPOLL
+    struct epoll_event events[64];
+    res = epoll_wait(m_epoll, events, 64, POLL_TIMEOUT);
+    for (int i = 0; i < res; i++)
+    {
+      int flags = 0;
+      if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        flags |= POLL_READ; // errors and hangups show up when reading
+      if (events[i].events & EPOLLOUT)
+        flags |= POLL_WRITE;
+      int socket = events[i].data.fd; // epoll_event is packed, so copy before taking a reference
+      ready.push_back(std::make_pair(socket, flags));
+    }
+#else
     int             max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
+    fd_set          rfds, wfds;
+    struct timeval  to     = {POLL_TIMEOUT / 1000, (POLL_TIMEOUT % 1000) * 1000};
     FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
 
     FD_SET(m_ServerSocket, &rfds);
     max_fd = m_ServerSocket;
+    if (m_wakeup[0] >= 0)
+    {
+      FD_SET(m_wakeup[0], &rfds);
+      if (m_wakeup[0] > max_fd)
+        max_fd = m_wakeup[0];
+    }
 
     for (unsigned int i = 0; i < m_connections.size(); i++)
     {
-      FD_SET(m_connections[i].m_socket, &rfds);
-      if (m_connections[i].m_socket > max_fd)
-        max_fd = m_connections[i].m_socket;
+      int socket = m_connections[i]->m_socket;
+      if (m_connections[i]->m_events & POLL_READ)
+        FD_SET(socket, &rfds);
+      if (m_connections[i]->m_events & POLL_WRITE)
+        FD_SET(socket, &wfds);
+      if (socket > max_fd)
+        max_fd = socket;
     }
 
-    int res = select(max_fd+1, &rfds, NULL, NULL, &to);
+    res = select(max_fd+1, &rfds, &wfds, NULL, &to);
+    if (res > 0)
+    {
+      if (FD_ISSET(m_ServerSocket, &rfds))
+        ready.push_back(std::make_pair(m_ServerSocket, (int)POLL_READ));
+      if (m_wakeup[0] >= 0 && FD_ISSET(m_wakeup[0], &rfds))
+        ready.push_back(std::make_pair(m_wakeup[0], (int)POLL_READ));
+      for (unsigned int i = 0; i < m_connections.size(); i++)
+      {
+        int socket = m_connections[i]->m_socket;
+        int flags = (FD_ISSET(socket, &rfds) ? POLL_READ : 0) | (FD_ISSET(socket, &wfds) ? POLL_WRITE : 0);
+        if (flags)
+          ready.push_back(std::make_pair(socket, flags));
+      }
+    }
+#endif
+
+#ifndef _WIN32
+    if (res < 0 && errno == EINTR)
+      res = 0;
+#endif
     if (res < 0)
     {
       CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
       Sleep(1000);
       Initialize();
+      continue;
     }
-    else if (res > 0)
+
+    for (unsigned int i = 0; i < ready.size(); i++)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      int socket = ready[i].first;
+      if (socket == m_ServerSocket)
+      {
+        AcceptConnection();
+        continue;
+      }
+#ifndef _WIN32
+      if (socket == m_wakeup[0])
+      {
+        char buffer[64];
+        while (read(m_wakeup[0], buffer, sizeof(buffer)) > 0) {}
+        continue;
+      }
+#endif
+
+      unsigned int index = 0;
+      while (index < m_connections.size() && m_connections[index]->m_socket != socket)
+        index++;
+      if (index == m_connections.size())
+        continue;
+      CTCPClientPtr client = m_connections[index];
+
+      if (ready[i].second & POLL_WRITE)
       {
-        int socket = m_connections[i].m_socket;
-        if (FD_ISSET(socket, &rfds))
+        if (!client->Flush())
         {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          if (nread > 0)
-          {
-            m_connections[i].PushBuffer(this, buffer, nread);
-          }
-          if (nread <= 0)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i].Disconnect();
-            m_connections.erase(m_connections.begin() + i);
-          }
+          CloseConnection(index);
+          continue;
         }
       }
 
-      if (FD_ISSET(m_ServerSocket, &rfds))
+      if (ready[i].second & POLL_READ)
       {
-        CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-        CTCPClient newconnection;
-        newconnection.m_socket = accept(m_ServerSocket, &newconnection.m_cliaddr, &newconnection.m_addrlen);
-
-        if (newconnection.m_socket < 0)
-          CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed");
-        else
+        char buffer[RECEIVEBUFFER];
+        int nread = recv(socket, buffer, RECEIVEBUFFER, 0);
+        if (nread > 0)
+        {
+          client->PushBuffer(buffer, nread);
+          HandleNextRequest(client);
+        }
+        else if (nread == 0 || !WouldBlock())
         {
-          CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-          m_connections.push_back(newconnection);
+          CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+          CloseConnection(index);
         }
       }
     }
@@ -122,6 +237,99 @@ void CTCPServer::Process()
   Deinitialize();
 }
 
+void CTCPServer::AcceptConnection()
+{
+  CTCPClientPtr client(new CTCPClient());
+  client->m_socket = accept(m_ServerSocket, &client->m_cliaddr, &client->m_addrlen);
+  if (client->m_socket < 0)
+  {
+    if (!WouldBlock())
+      CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed");
+    return;
+  }
+
+  SetNonBlocking(client->m_socket);
+  client->m_events = POLL_READ;
+#ifdef HAS_EPOLL
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = client->m_socket;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, client->m_socket, &event);
+#endif
+
+  CSingleLock lock(m_critSection);
+  m_connections.push_back(client);
+  CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+}
+
+void CTCPServer::CloseConnection(unsigned int index)
+{
+  CSingleLock lock(m_critSection);
+  // closing the socket takes it out of the epoll set
+  m_connections[index]->Disconnect();
+  m_connections.erase(m_connections.begin() + index);
+}
+
+void CTCPServer::UpdateEvents()
+{
+  CSingleLock lock(m_critSection);
+  for (unsigned int i = 0; i < m_connections.size(); i++)
+  {
+    CTCPClient *client = m_connections[i].get();
+    int events = client->WantedEvents();
+    if (events == client->m_events)
+      continue;
+
+#ifdef HAS_EPOLL
+    struct epoll_event event = {};
+    event.events = ((events & POLL_READ) ? EPOLLIN : 0) | ((events & POLL_WRITE) ? EPOLLOUT : 0);
+    event.data.fd = client->m_socket;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, client->m_socket, &event);
+#endif
+    client->m_events = events;
+  }
+}
+
+void CTCPServer::WakeUp()
+{
+#ifndef _WIN32
+  if (m_wakeup[1] >= 0)
+  {
+    char c = 0;
+    write(m_wakeup[1], &c, 1);
+  }
+#endif
+}
+
+void CTCPServer::HandleNextRequest(const CTCPClientPtr &client)
+{
+  std::string request;
+  if (!client->NextRequest(request))
+    return;
+
+  // requests from remotes can be long library queries, so they make way for the GUI's own jobs
+  CSingleLock lock(m_critSection);
+  m_jobs++;
+  CJobManager::GetInstance().AddJob(new CRequestJob(this, client, request), this, CJob::PRIORITY_LOW);
+}
+
+void CTCPServer::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CRequestJob *request = (CRequestJob *)job;
+  CTCPClientPtr client = request->m_client;
+  if (request->m_response)
+  {
+    client->Queue(request->m_response);
+    request->m_response = NULL;
+  }
+
+  // send what we can straight away, the server thread picks up the rest
+  client->Flush();
+  client->RequestDone();
+  HandleNextRequest(client);
+  WakeUp();
+}
+
 bool CTCPServer::Download(const char *path, Json::Value *result)
 {
   return false;
@@ -142,24 +350,26 @@ void CTCPServer::Announce(EAnnouncementFlag flag, const char *sender, const char
   if (data)
     root["params"]["data"] = data;
 
-  StyledWriter writer;
-  std::string str = writer.write(root);
+  std::string str;
+  CJSONStreamWriter writer(root, CTimeUtils::GetTimeMS());
+  writer.ReadAll(str);
 
+  CSingleLock lock(m_critSection);
   for (unsigned int i = 0; i < m_connections.size(); i++)
   {
-    {
-      CSingleLock lock (m_connections[i].m_critSection);
-      if ((m_connections[i].GetAnnouncementFlags() & flag) == 0)
-        continue;
-    }
-
-    unsigned int sent = 0;
-    do
-    {
-      CSingleLock lock (m_connections[i].m_critSection);
-      sent += send(m_connections[i].m_socket, str.c_str(), str.size() - sent, sent);
-    } while (sent < str.size());
+    CTCPClient *client = m_connections[i].get();
+    if ((client->GetAnnouncementFlags() & flag) == 0)
+      continue;
+
+    // never wait on a client, one that is behind just misses out
+    if (client->Queue(str, false))
+      client->Flush();
+    else
+      CLog::Log(LOGDEBUG, "JSONRPC Server: Client is too far behind, dropped announcement %s", message);
   }
+  lock.Leave();
+
+  WakeUp();
 }
 
 bool CTCPServer::Initialize()
@@ -211,6 +421,41 @@ bool CTCPServer::Initialize()
     return false;
   }
 
+  SetNonBlocking(m_ServerSocket);
+
+#ifndef _WIN32
+  if (pipe(m_wakeup) < 0)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to create wakeup pipe");
+    m_wakeup[0] = m_wakeup[1] = -1;
+  }
+  else
+  {
+    SetNonBlocking(m_wakeup[0]);
+    SetNonBlocking(m_wakeup[1]);
+  }
+#endif
+
+#ifdef HAS_EPOLL
+  m_epoll = epoll_create(64);
+  if (m_epoll < 0)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to create epoll instance");
+    close(m_ServerSocket);
+    m_ServerSocket = -1;
+    return false;
+  }
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = m_ServerSocket;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_ServerSocket, &event);
+  if (m_wakeup[0] >= 0)
+  {
+    event.data.fd = m_wakeup[0];
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup[0], &event);
+  }
+#endif
+
   CAnnouncementManager::AddAnnouncer(this);
 
   CLog::Log(LOGINFO, "JSONRPC Server: Successfully initialized");
@@ -219,8 +464,13 @@ bool CTCPServer::Initialize()
 
 void CTCPServer::Deinitialize()
 {
+  // the announcement manager calls Announce() with its own lock held, which takes ours,
+  // so it mustn't be taken the other way round
+  CAnnouncementManager::RemoveAnnouncer(this);
+
+  CSingleLock lock(m_critSection);
   for (unsigned int i = 0; i < m_connections.size(); i++)
-    m_connections[i].Disconnect();
+    m_connections[i]->Disconnect();
 
   m_connections.clear();
 
@@ -230,29 +480,51 @@ void CTCPServer::Deinitialize()
     close(m_ServerSocket);
     m_ServerSocket = -1;
   }
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0)
+  {
+    close(m_epoll);
+    m_epoll = -1;
+  }
+#endif
+#ifndef _WIN32
+  for (int i = 0; i < 2; i++)
+  {
+    if (m_wakeup[i] >= 0)
+      close(m_wakeup[i]);
+    m_wakeup[i] = -1;
+  }
+#endif
 
-  CAnnouncementManager::RemoveAnnouncer(this);
+  // requests still being handled refer back to us
+  while (m_jobs > 0)
+  {
+    lock.Leave();
+    Sleep(10);
+    lock.Enter();
+  }
 }
 
 CTCPServer::CTCPClient::CTCPClient()
 {
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = -1;
-  m_beginBrackets = 0;
-  m_endBrackets = 0;
+  m_events = 0;
+  m_depth = 0;
+  m_inString = false;
+  m_escaped = false;
+  m_busy = false;
+  m_outputOffset = 0;
+  m_outputSize = 0;
 
   m_addrlen = sizeof(struct sockaddr);
 }
 
-CTCPServer::CTCPClient::CTCPClient(const CTCPClient& client)
+CTCPServer::CTCPClient::~CTCPClient()
 {
-  Copy(client);
-}
-
-CTCPServer::CTCPClient& CTCPServer::CTCPClient::operator=(const CTCPClient& client)
-{
-  Copy(client);
-  return *this;
+  Disconnect();
+  for (unsigned int i = 0; i < m_output.size(); i++)
+    delete m_output[i].writer;
 }
 
 int CTCPServer::CTCPClient::GetPermissionFlags()
@@ -271,27 +543,150 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
   return true;
 }
 
-void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
+void CTCPServer::CTCPClient::PushBuffer(const char *buffer, int length)
 {
+  CSingleLock lock (m_critSection);
   for (int i = 0; i < length; i++)
   {
     char c = buffer[i];
+    if (m_depth == 0)
+    {
+      // skip anything between requests
+      if (c != '{' && c != '[')
+        continue;
+      m_buffer.clear();
+    }
     m_buffer.push_back(c);
-    if (c == '{')
-      m_beginBrackets++;
-    else if (c == '}')
-      m_endBrackets++;
-    if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
+
+    // track nesting outside of strings, so braces in values don't end the request early
+    if (m_inString)
+    {
+      if (m_escaped)
+        m_escaped = false;
+      else if (c == '\\')
+        m_escaped = true;
+      else if (c == '"')
+        m_inString = false;
+    }
+    else if (c == '"')
+      m_inString = true;
+    else if (c == '{' || c == '[')
+      m_depth++;
+    else if ((c == '}' || c == ']') && --m_depth == 0)
     {
-      std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-      CSingleLock lock (m_critSection);
-      send(m_socket, line.c_str(), line.size(), 0);
-      m_beginBrackets = m_endBrackets = 0;
+      m_requests.push_back(m_buffer);
       m_buffer.clear();
     }
+
+    if (m_buffer.size() > MAX_REQUEST_SIZE)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Dropped request exceeding %d bytes", MAX_REQUEST_SIZE);
+      m_buffer.clear();
+      m_depth = 0;
+      m_inString = m_escaped = false;
+    }
   }
 }
 
+bool CTCPServer::CTCPClient::NextRequest(std::string &request)
+{
+  CSingleLock lock (m_critSection);
+  // requests are handled one at a time, so responses go out in order
+  if (m_busy || m_requests.empty() || m_socket < 0)
+    return false;
+
+  request = m_requests.front();
+  m_requests.pop_front();
+  m_busy = true;
+  return true;
+}
+
+void CTCPServer::CTCPClient::RequestDone()
+{
+  CSingleLock lock (m_critSection);
+  m_busy = false;
+}
+
+bool CTCPServer::CTCPClient::Queue(const std::string &data, bool force)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket < 0 || (!force && m_outputSize > MAX_CLIENT_BACKLOG))
+    return false;
+
+  COutput output;
+  output.data = data;
+  output.writer = NULL;
+  m_output.push_back(output);
+  m_outputSize += data.size();
+  return true;
+}
+
+void CTCPServer::CTCPClient::Queue(CJSONStreamWriter *writer)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket < 0)
+  {
+    delete writer;
+    return;
+  }
+
+  COutput output;
+  output.writer = writer;
+  m_output.push_back(output);
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  while (!m_output.empty() && m_socket >= 0)
+  {
+    COutput &output = m_output.front();
+    if (m_outputOffset == output.data.size())
+    {
+      m_outputOffset = 0;
+      output.data.clear();
+      if (output.writer)
+      {
+        // serialize the next part of the response
+        char chunk[SENDBUFFER];
+        unsigned int size = output.writer->Read(chunk, sizeof(chunk));
+        if (size > 0)
+        {
+          output.data.assign(chunk, size);
+          m_outputSize += size;
+          continue;
+        }
+        delete output.writer;
+      }
+      m_output.pop_front();
+      continue;
+    }
+
+    int sent = send(m_socket, output.data.c_str() + m_outputOffset, output.data.size() - m_outputOffset, 0);
+    if (sent < 0 && WouldBlock())
+      return true;
+    if (sent <= 0)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to send to client");
+      return false;
+    }
+    m_outputOffset += sent;
+    m_outputSize -= sent;
+  }
+  return true;
+}
+
+int CTCPServer::CTCPClient::WantedEvents()
+{
+  CSingleLock lock (m_critSection);
+  int events = 0;
+  if (m_outputSize <= MAX_CLIENT_BACKLOG && m_requests.size() < MAX_CLIENT_REQUESTS)
+    events |= POLL_READ;
+  if (!m_output.empty())
+    events |= POLL_WRITE;
+  return events;
+}
+
 void CTCPServer::CTCPClient::Disconnect()
 {
   if (m_socket > 0)
@@ -303,14 +698,25 @@ void CTCPServer::CTCPClient::Disconnect()
   }
 }
 
-void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
+CTCPServer::CRequestJob::CRequestJob(CTCPServer *server, const CTCPClientPtr &client, const std::string &request)
+{
+  m_server = server;
+  m_client = client;
+  m_request = request;
+  m_response = NULL;
+}
+
+CTCPServer::CRequestJob::~CRequestJob()
 {
-  m_socket            = client.m_socket;
-  m_cliaddr           = client.m_cliaddr;
-  m_addrlen           = client.m_addrlen;
-  m_announcementflags = client.m_announcementflags;
-  m_beginBrackets     = client.m_beginBrackets;
-  m_endBrackets       = client.m_endBrackets;
-  m_buffer            = client.m_buffer;
+  delete m_response;
+
+  // the server waits for all jobs to be gone before it goes away
+  CSingleLock lock(m_server->m_critSection);
+  m_server->m_jobs--;
 }
 
+bool CTCPServer::CRequestJob::DoWork()
+{
+  m_response = CJSONRPC::StreamMethodCall(m_request, m_server, m_client.get());
+  return true;
+}
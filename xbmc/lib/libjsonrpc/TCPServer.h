@@ -9,14 +9,19 @@
 #endif
 #include <string>
 #include <vector>
+#include <deque>
+#include <boost/shared_ptr.hpp>
 #include "IAnnouncer.h"
 #include "ITransportLayer.h"
 #include "Thread.h"
 #include "CriticalSection.h"
+#include "Job.h"
 
 namespace JSONRPC
 {
-  class CTCPServer : public ITransportLayer, public ANNOUNCEMENT::IAnnouncer, public CThread
+  class CJSONStreamWriter;
+
+  class CTCPServer : public ITransportLayer, public ANNOUNCEMENT::IAnnouncer, public CThread, public IJobCallback
   {
   public:
     static void StartServer(int port, bool nonlocal);
@@ -26,6 +31,7 @@ namespace JSONRPC
     virtual int GetCapabilities();
 
     virtual void Announce(ANNOUNCEMENT::EAnnouncementFlag flag, const char *sender, const char *message, const char *data);
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
   protected:
     void Process();
   private:
@@ -37,32 +43,94 @@ namespace JSONRPC
     {
     public:
       CTCPClient();
-      //Copying a CCriticalSection is not allowed, so copy everything but that
-      //when adding a member variable, make sure to copy it in CTCPClient::Copy
-      CTCPClient(const CTCPClient& client);
-      CTCPClient& operator=(const CTCPClient& client);
+      virtual ~CTCPClient();
       virtual int  GetPermissionFlags();
       virtual int  GetAnnouncementFlags();
       virtual bool SetAnnouncementFlags(int flags);
-      void PushBuffer(CTCPServer *host, const char *buffer, int length);
+
+      /*! \brief Add received data, moving each complete request onto the request queue */
+      void PushBuffer(const char *buffer, int length);
+      /*! \brief Take the next request off the queue, unless one is already being handled */
+      bool NextRequest(std::string &request);
+      void RequestDone();
+
+      /*! \brief Queue output for the client.
+       \param force queue it even if the client is not keeping up with its output
+       \return false if the output was dropped
+       */
+      bool Queue(const std::string &data, bool force);
+      void Queue(CJSONStreamWriter *writer);
+      /*! \brief Send as much of the queued output as the socket takes without blocking.
+       \return false if the connection failed
+       */
+      bool Flush();
+
+      /*! \brief The events to poll the socket for (POLL_READ, POLL_WRITE) */
+      int WantedEvents();
       void Disconnect();
 
       int m_socket;
       struct sockaddr m_cliaddr;
       socklen_t m_addrlen;
+      int m_events; ///< the events the socket is currently polled for
       CCriticalSection m_critSection;
 
     private:
-      void Copy(const CTCPClient& client);
+      // there is always exactly one instance per connection
+      CTCPClient(const CTCPClient& client);
+      CTCPClient& operator=(const CTCPClient& client);
+
+      struct COutput
+      {
+        std::string data;
+        CJSONStreamWriter *writer; ///< the rest of a response, serialized as it is sent
+      };
+
       int m_announcementflags;
-      int m_beginBrackets, m_endBrackets;
+
+      // incremental framing of requests
       std::string m_buffer;
+      int m_depth;
+      bool m_inString;
+      bool m_escaped;
+
+      std::deque<std::string> m_requests;
+      bool m_busy;
+
+      std::deque<COutput> m_output;
+      unsigned int m_outputOffset;
+      unsigned int m_outputSize;
+    };
+    typedef boost::shared_ptr<CTCPClient> CTCPClientPtr;
+
+    class CRequestJob : public CJob
+    {
+    public:
+      CRequestJob(CTCPServer *server, const CTCPClientPtr &client, const std::string &request);
+      virtual ~CRequestJob();
+      virtual bool DoWork();
+
+      CTCPServer *m_server;
+      CTCPClientPtr m_client;
+      std::string m_request;
+      CJSONStreamWriter *m_response;
     };
 
-    std::vector<CTCPClient> m_connections;
+    void AcceptConnection();
+    void CloseConnection(unsigned int index);
+    void HandleNextRequest(const CTCPClientPtr &client);
+    void UpdateEvents();
+    void WakeUp();
+
+    std::vector<CTCPClientPtr> m_connections;
+    CCriticalSection m_critSection;
+    unsigned int m_jobs;
+
     int m_ServerSocket;
     int m_port;
     bool m_nonlocal;
+    int m_epoll;
+    int m_wakeup[2];
 
     static CTCPServer *ServerInstance;
   };
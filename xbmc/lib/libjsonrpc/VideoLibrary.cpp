@@ -39,9 +39,12 @@ JSON_STATUS CVideoLibrary::GetMovies(const CStdString &method, ITransportLayer *
 
 //  int genreID = parameterObject.get("genreid", -1).asInt();
 
+  DatabaseLimits limits;
+  ParseLimits(parameterObject, limits);
+
   CFileItemList items;
-  if (videodatabase.GetMoviesNav("videodb://", items))
-    HandleFileItemList("movieid", true, "movies", items, parameterObject, result);
+  if (videodatabase.GetMoviesNav("videodb://", items, -1, -1, -1, -1, -1, -1, -1, &limits))
+    HandleFileItemList("movieid", true, "movies", items, parameterObject, result, &limits);
 
   videodatabase.Close();
   return OK;
@@ -105,9 +108,12 @@ JSON_STATUS CVideoLibrary::GetEpisodes(const CStdString &method, ITransportLayer
   if (!videodatabase.Open())
     return InternalError;
 
+  DatabaseLimits limits;
+  ParseLimits(param, limits);
+
   CFileItemList items;
-  if (videodatabase.GetEpisodesNav("videodb://", items, -1, -1, -1, -1, tvshowID, season))
-    HandleFileItemList("episodeid", true, "episodes", items, param, result);
+  if (videodatabase.GetEpisodesNav("videodb://", items, -1, -1, -1, -1, tvshowID, season, &limits))
+    HandleFileItemList("episodeid", true, "episodes", items, param, result, &limits);
 
   videodatabase.Close();
   return OK;
@@ -137,6 +143,23 @@ JSON_STATUS CVideoLibrary::GetMusicVideos(const CStdString &method, ITransportLa
   return OK;
 }
 
+JSON_STATUS CVideoLibrary::Search(const CStdString &method, ITransportLayer *transport, IClient *client, const Value &parameterObject, Value &result)
+{
+  if (!parameterObject.isObject() || !parameterObject["search"].isString())
+    return InvalidParams;
+
+  CVideoDatabase videodatabase;
+  if (!videodatabase.Open())
+    return InternalError;
+
+  CFileItemList items;
+  if (videodatabase.Search(parameterObject["search"].asString(), items))
+    HandleSearchResults(items, parameterObject, result);
+
+  videodatabase.Close();
+  return OK;
+}
+
 JSON_STATUS CVideoLibrary::GetRecentlyAddedMovies(const CStdString &method, ITransportLayer *transport, IClient *client, const Value &parameterObject, Value &result)
 {
   CVideoDatabase videodatabase;
@@ -348,6 +348,11 @@ const field_value Dataset::get_field_value(int index) {
   //return fv;
 }
 
+const char *Dataset::get_text(int index) {
+  text_value = get_field_value(index).get_asString();
+  return text_value.c_str();
+}
+
 const field_value Dataset::f_old(const char *f_name) {
   if (ds_state != dsInactive)
     for (int unsigned i=0; i < fields_object->size(); i++) 
@@ -176,6 +176,7 @@ protected:
   ParamList plist;              // Paramlist for locate
   bool fbof, feof;
   bool autocommit;		// for transactions
+  std::string text_value;	// backing store for get_text()
 
 
 /* Variables to store SQL statements */
@@ -273,6 +274,12 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, but opens a forward-only cursor where the backend supports it: rows are fetched
+   as next() is called instead of all being read into memory first. Only first() and next()
+   may be used to move around, and num_rows() counts the rows fetched so far.
+   Backends without cursor support run an ordinary query. */
+  virtual bool query_cursor(const char *sql) { return query(sql); }
+  bool query_cursor(const std::string &sql) { return query_cursor(sql.c_str()); }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -350,6 +357,16 @@ public:
   const field_value fv(const char *f) { return get_field_value(f); }
   const field_value fv(int index) { return get_field_value(index); }
 
+/* Typed access to fields of the current record, converting as field_value does.
+   These skip the field_value copy that fv() makes, and on a cursor read straight from
+   the backend. The pointer from get_text() is valid until the next get_text() call
+   or until the record changes. */
+  virtual const char *get_text(int index);
+  virtual int get_int(int index) { return get_field_value(index).get_asInt(); }
+  virtual int64_t get_int64(int index) { return get_field_value(index).get_asInt64(); }
+  virtual double get_double(int index) { return get_field_value(index).get_asDouble(); }
+  virtual bool get_bool(int index) { return get_field_value(index).get_asBool(); }
+
 /* ------------ for transaction ------------------- */
   void set_autocommit(bool v) { autocommit = v; }
   bool get_autocommit() { return autocommit; }
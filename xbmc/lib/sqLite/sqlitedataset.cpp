@@ -87,6 +87,7 @@ SqliteDatabase::SqliteDatabase() {
 
   active = false;	
   _in_transaction = false;		// for transaction
+  read_only = false;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -205,7 +206,8 @@ int SqliteDatabase::connect() {
   {
 
     disconnect();
-    if (sqlite3_open(db_fullpath.c_str(), &conn)==SQLITE_OK)
+    int flags = read_only ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    if (sqlite3_open_v2(db_fullpath.c_str(), &conn, flags, NULL)==SQLITE_OK)
     {
       sqlite3_busy_handler(conn, busy_callback, NULL);
       char* err=NULL;
@@ -217,7 +219,14 @@ int SqliteDatabase::connect() {
       return DB_CONNECTION_OK;
     }
 
-    CLog::Log(LOGERROR, "Unable to open database: %s (%u)", db_fullpath.c_str(), GetLastError());
+    // sqlite hands back a handle even when the open fails
+    sqlite3_close(conn);
+    conn = NULL;
+
+    if (read_only)
+      CLog::Log(LOGDEBUG, "Unable to open database read only: %s", db_fullpath.c_str());
+    else
+      CLog::Log(LOGERROR, "Unable to open database: %s (%u)", db_fullpath.c_str(), GetLastError());
     return DB_CONNECTION_NONE;
   }
   catch(...)
@@ -354,6 +363,8 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  cursor_mode = false;
 }
 
 
@@ -362,9 +373,12 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  cursor_mode = false;
 }
 
  SqliteDataset::~SqliteDataset(){
+   if (cursor) sqlite3_finalize(cursor);
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -562,6 +576,184 @@ bool SqliteDataset::query(const string &q){
   return query(q.c_str());
 }
 
+bool SqliteDataset::query_cursor(const char *query) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  std::string qry = query;
+  int fs = qry.find("select");
+  int fS = qry.find("SELECT");
+  if (!( fs >= 0 || fS >=0))
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  #ifdef __APPLE__
+  if (db->setErr(sqlite3_prepare(handle(),query,-1,&cursor, NULL),query) != SQLITE_OK)
+  #else
+  if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&cursor, NULL),query) != SQLITE_OK)
+  #endif
+  {
+    cursor = NULL;
+    throw DbErrors(db->getErrorMsg());
+  }
+  cursor_sql = query;
+  cursor_mode = true;
+
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(cursor);
+  result.record_header.resize(numColumns);
+  fields_object->resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    result.record_header[i].name = sqlite3_column_name(cursor, i);
+    (*fields_object)[i].props = result.record_header[i];
+  }
+
+  active = true;
+  ds_state = dsSelect;
+  frecno = -1;
+  step_cursor();
+  fbof = feof;
+  return true;
+}
+
+void SqliteDataset::step_cursor() {
+  int ret = sqlite3_step(cursor);
+  if (ret == SQLITE_ROW)
+  {
+    frecno++;
+    feof = false;
+    return;
+  }
+
+  // out of rows - done with the statement
+  feof = true;
+  ret = sqlite3_finalize(cursor);
+  cursor = NULL;
+  if (db->setErr(ret, cursor_sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+field_value SqliteDataset::cursor_value(int index) {
+  if (index < 0 || index >= (int)result.record_header.size())
+    throw DbErrors("Field index not found: %d",index);
+
+  // same conversions as query() makes
+  field_value v;
+  switch (sqlite3_column_type(cursor, index))
+  {
+  case SQLITE_INTEGER:
+    v.set_asInt64(sqlite3_column_int64(cursor, index));
+    break;
+  case SQLITE_FLOAT:
+    v.set_asDouble(sqlite3_column_double(cursor, index));
+    break;
+  case SQLITE_TEXT:
+  case SQLITE_BLOB:
+    v.set_asString((const char *)sqlite3_column_text(cursor, index));
+    break;
+  case SQLITE_NULL:
+  default:
+    v.set_asString("");
+    v.set_isNull();
+    break;
+  }
+  return v;
+}
+
+const field_value SqliteDataset::get_field_value(const char *f_name) {
+  if (!cursor || ds_state != dsSelect)
+    return Dataset::get_field_value(f_name);
+
+  const char* name=strstr(f_name, ".");
+  if (name) name++;
+  for (unsigned int i=0; i < result.record_header.size(); i++)
+  {
+    if (str_compare(result.record_header[i].name.c_str(), f_name)==0 || (name && str_compare(result.record_header[i].name.c_str(), name)==0))
+      return cursor_value(i);
+  }
+  throw DbErrors("Field not found: %s",f_name);
+}
+
+const field_value SqliteDataset::get_field_value(int index) {
+  if (!cursor || ds_state != dsSelect)
+    return Dataset::get_field_value(index);
+  return cursor_value(index);
+}
+
+const char *SqliteDataset::get_text(int index) {
+  if (cursor && ds_state == dsSelect && index >= 0 && index < (int)result.record_header.size())
+  {
+    switch (sqlite3_column_type(cursor, index))
+    {
+    case SQLITE_INTEGER:
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+      return (const char *)sqlite3_column_text(cursor, index);
+    case SQLITE_NULL:
+      return "";
+    }
+  }
+  return Dataset::get_text(index);
+}
+
+int SqliteDataset::get_int(int index) {
+  if (cursor && ds_state == dsSelect && index >= 0 && index < (int)result.record_header.size())
+  {
+    switch (sqlite3_column_type(cursor, index))
+    {
+    case SQLITE_INTEGER:
+      return (int)sqlite3_column_int64(cursor, index);
+    case SQLITE_TEXT:
+      return atoi((const char *)sqlite3_column_text(cursor, index));
+    case SQLITE_NULL:
+      return 0;
+    }
+  }
+  return Dataset::get_int(index);
+}
+
+int64_t SqliteDataset::get_int64(int index) {
+  if (cursor && ds_state == dsSelect && index >= 0 && index < (int)result.record_header.size())
+  {
+    if (sqlite3_column_type(cursor, index) == SQLITE_INTEGER)
+      return sqlite3_column_int64(cursor, index);
+  }
+  return Dataset::get_int64(index);
+}
+
+double SqliteDataset::get_double(int index) {
+  if (cursor && ds_state == dsSelect && index >= 0 && index < (int)result.record_header.size())
+  {
+    switch (sqlite3_column_type(cursor, index))
+    {
+    case SQLITE_INTEGER:
+      return (double)sqlite3_column_int64(cursor, index);
+    case SQLITE_FLOAT:
+      return sqlite3_column_double(cursor, index);
+    }
+  }
+  return Dataset::get_double(index);
+}
+
+bool SqliteDataset::get_bool(int index) {
+  if (cursor && ds_state == dsSelect && index >= 0 && index < (int)result.record_header.size())
+  {
+    switch (sqlite3_column_type(cursor, index))
+    {
+    case SQLITE_INTEGER:
+      return sqlite3_column_int64(cursor, index) != 0;
+    case SQLITE_TEXT:
+      {
+        const char *text = (const char *)sqlite3_column_text(cursor, index);
+        return strcmp(text, "True") == 0 || strcmp(text, "true") == 0 || strcmp(text, "1") == 0;
+      }
+    case SQLITE_NULL:
+      return false;
+    }
+  }
+  return Dataset::get_bool(index);
+}
+
 void SqliteDataset::open(const string &sql) {
 	set_select_sql(sql);
 	open();
@@ -579,6 +771,12 @@ void SqliteDataset::open() {
 
 void SqliteDataset::close() {
   Dataset::close();
+  if (cursor)
+  {
+    sqlite3_finalize(cursor);
+    cursor = NULL;
+  }
+  cursor_mode = false;
   result.clear();
   edit_object->clear();
   fields_object->clear();
@@ -598,6 +796,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (cursor_mode) // only know about the rows fetched so far
+    return frecno + 1;
   return result.records.size();
 }
 
@@ -613,21 +813,38 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (cursor_mode)
+  {
+    if (frecno > 0)
+      throw DbErrors("Can't rewind a forward-only cursor");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (cursor_mode)
+    throw DbErrors("Can't seek on a forward-only cursor");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (cursor_mode)
+    throw DbErrors("Can't rewind a forward-only cursor");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (cursor_mode)
+  {
+    fbof = false;
+    if (cursor)
+      step_cursor();
+    return;
+  }
 #ifdef _XBOX
   free_row();
 #endif
@@ -650,6 +867,8 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (cursor_mode)
+    throw DbErrors("Can't seek on a forward-only cursor");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -48,6 +48,7 @@ protected:
 /* connect descriptor */
   sqlite3 *conn;
   bool _in_transaction;
+  bool read_only;
   int last_err;
 
 public:
@@ -60,6 +61,8 @@ public:
 
 /* func. returns connection handle with SQLite-server */
   sqlite3 *getHandle() {  return conn; }
+/* sets whether the next connect() opens the database read only */
+  void setReadOnly(bool readOnly) { read_only = readOnly; }
 /* func. returns current status about SQLite-server connection */
   virtual int status();
   virtual int setErr(int err_code,const char * qry);
@@ -107,9 +110,18 @@ protected:
   result_set exec_res;
   bool autorefresh;
   char* errmsg;
+/* statement of an open forward-only cursor, NULL when the results are held in memory */
+  sqlite3_stmt *cursor;
+  bool cursor_mode;
+  std::string cursor_sql;
   
   sqlite3* handle();
 
+/* fetches the next row of the cursor */
+  void step_cursor();
+/* value of a field of the cursor's current row */
+  field_value cursor_value(int index);
+
 /* Makes direct queries to database */
   virtual void make_query(StringList &_sql);
 /* Makes direct inserts into database */
@@ -149,6 +161,8 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+/* as query, but steps through the rows as next() is called */
+  virtual bool query_cursor(const char *query);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -171,6 +185,13 @@ or insert() operations default = false) */
 /* Go to record No (starting with 0) */
   virtual bool seek(int pos=0);
 
+  virtual const field_value get_field_value(const char *f_name);
+  virtual const field_value get_field_value(int index);
+  virtual const char *get_text(int index);
+  virtual int get_int(int index);
+  virtual int64_t get_int64(int index);
+  virtual double get_double(int index);
+  virtual bool get_bool(int index);
 
 };
 } //namespace
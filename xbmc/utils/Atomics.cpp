@@ -73,8 +73,8 @@ long cas(volatile long* pAddr, long expectedVal, long swapVal)
 
 long cas(volatile long* pAddr, long expectedVal, long swapVal)
 {
-  // TODO: ARM Assembler
-  return 0;
+  // gcc provides these through the kernel helpers on armv5 and ldrex/strex on armv6+
+  return __sync_val_compare_and_swap(pAddr, expectedVal, swapVal);
 }
 
 #else // Linux / OSX86 (GCC)
@@ -190,8 +190,7 @@ long AtomicIncrement(volatile long* pAddr)
 
 long AtomicIncrement(volatile long* pAddr)
 {
-  // TODO: ARM Assembler
-  return 0;
+  return __sync_add_and_fetch(pAddr, 1);
 }
 
 #else // Linux / OSX86 (GCC)
@@ -254,8 +253,7 @@ long AtomicAdd(volatile long* pAddr, long amount)
 
 long AtomicAdd(volatile long* pAddr, long amount)
 {
-  // TODO: ARM Assembler
-  return 0;
+  return __sync_add_and_fetch(pAddr, amount);
 }
 
 #else // Linux / OSX86 (GCC)
@@ -317,8 +315,7 @@ long AtomicDecrement(volatile long* pAddr)
 
 long AtomicDecrement(volatile long* pAddr)
 {
-  // TODO: ARM Assembler
-  return 0;
+  return __sync_sub_and_fetch(pAddr, 1);
 }
 
 #else // Linux / OSX86 (GCC)
@@ -382,8 +379,7 @@ long AtomicSubtract(volatile long* pAddr, long amount)
 
 long AtomicSubtract(volatile long* pAddr, long amount)
 {
-  // TODO: ARM Assembler
-  return 0;
+  return __sync_sub_and_fetch(pAddr, amount);
 }
 
 #else // Linux / OSX86 (GCC)
@@ -25,10 +25,18 @@
 #include "GUISettings.h"
 #include "LangInfo.h"
 #include "SingleLock.h"
+#include "Atomics.h"
 #include "log.h"
 
 #include <errno.h>
 #include <iconv.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAS_SSE2_UTF8
+#endif
 
 #ifdef __APPLE__
 #ifdef __POWERPC__
@@ -46,18 +54,21 @@
 #endif
 
 
-static iconv_t m_iconvStringCharsetToFontCharset = (iconv_t)-1;
-static iconv_t m_iconvSubtitleCharsetToW         = (iconv_t)-1;
-static iconv_t m_iconvUtf8ToStringCharset        = (iconv_t)-1;
-static iconv_t m_iconvStringCharsetToUtf8        = (iconv_t)-1;
-static iconv_t m_iconvUcs2CharsetToStringCharset = (iconv_t)-1;
-static iconv_t m_iconvUtf32ToStringCharset       = (iconv_t)-1;
-static iconv_t m_iconvWtoUtf8                    = (iconv_t)-1;
-static iconv_t m_iconvUtf16LEtoW                 = (iconv_t)-1;
-static iconv_t m_iconvUtf16BEtoUtf8              = (iconv_t)-1;
-static iconv_t m_iconvUtf16LEtoUtf8              = (iconv_t)-1;
-static iconv_t m_iconvUtf8toW                    = (iconv_t)-1;
-static iconv_t m_iconvUcs2CharsetToUtf8          = (iconv_t)-1;
+enum ConverterType
+{
+  SubtitleCharsetToW = 0,
+  Utf8ToStringCharset,
+  StringCharsetToUtf8,
+  Ucs2CharsetToStringCharset,
+  Utf32ToStringCharset,
+  WtoUtf8,
+  Utf16LEtoW,
+  Utf16BEtoUtf8,
+  Utf16LEtoUtf8,
+  Utf8toW,
+  Ucs2CharsetToUtf8,
+  NumConverterTypes
+};
 
 static FriBidiCharSet m_stringFribidiCharset     = FRIBIDI_CHAR_SET_NOT_FOUND;
 
@@ -74,6 +85,223 @@ CCharsetConverter g_charsetConverter;
 #define ICONV_PREPARE(iconv) iconv=(iconv_t)-1
 #define ICONV_SAFE_CLOSE(iconv) if (iconv!=(iconv_t)-1) { iconv_close(iconv); iconv=(iconv_t)-1; }
 
+/*!
+ \brief A set of iconv handles, one per conversion type.
+
+ iconv handles carry conversion state so can't be shared between threads without locking. Each
+ thread gets its own set (on win32 a single set is shared under m_critSection), opened lazily.
+ reset() bumps the generation so each set closes its handles when the gui charsets change.
+ */
+class CConverterSet
+{
+public:
+  CConverterSet() : m_generation(0)
+  {
+    for (int i = 0; i < NumConverterTypes; i++)
+      ICONV_PREPARE(m_handles[i]);
+  }
+  ~CConverterSet()
+  {
+    Close();
+  }
+  void Close()
+  {
+    for (int i = 0; i < NumConverterTypes; i++)
+      ICONV_SAFE_CLOSE(m_handles[i]);
+  }
+  iconv_t m_handles[NumConverterTypes];
+  long    m_generation;
+};
+
+static volatile long m_converterGeneration = 1;
+
+#ifdef _WIN32
+static CConverterSet m_sharedConverters;
+#else
+static pthread_once_t m_converterKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t  m_converterKey;
+
+static void DeleteConverterSet(void *set)
+{
+  delete (CConverterSet *)set;
+}
+
+static void MakeConverterKey()
+{
+  pthread_key_create(&m_converterKey, DeleteConverterSet);
+}
+#endif
+
+/*!
+ \brief Grants the calling thread use of its iconv handles for the lifetime of the object.
+ */
+class CConverterLock
+{
+public:
+  CConverterLock()
+#ifdef _WIN32
+    : m_lock(m_critSection)
+#endif
+  {
+#ifdef _WIN32
+    m_set = &m_sharedConverters;
+#else
+    pthread_once(&m_converterKeyOnce, MakeConverterKey);
+    m_set = (CConverterSet *)pthread_getspecific(m_converterKey);
+    if (!m_set)
+    {
+      m_set = new CConverterSet;
+      pthread_setspecific(m_converterKey, m_set);
+    }
+#endif
+    if (m_set->m_generation != m_converterGeneration)
+    {
+      m_set->Close();
+      m_set->m_generation = m_converterGeneration;
+    }
+  }
+
+  iconv_t &operator[](ConverterType type) { return m_set->m_handles[type]; }
+
+private:
+#ifdef _WIN32
+  CSingleLock    m_lock;
+#endif
+  CConverterSet *m_set;
+};
+
+// true if none of the bytes have the high bit set
+static bool isAscii(const char *buf, size_t len)
+{
+  const unsigned char *ptr = (const unsigned char *)buf;
+  const unsigned char *end = ptr + len;
+#ifdef HAS_SSE2_UTF8
+  for (; ptr + 16 <= end; ptr += 16)
+  {
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ptr)))
+      return false;
+  }
+#else
+  for (; ptr + sizeof(unsigned long) <= end; ptr += sizeof(unsigned long))
+  {
+    unsigned long word;
+    memcpy(&word, ptr, sizeof(word));
+    if (word & ((unsigned long)-1 / 0xff * 0x80))
+      return false;
+  }
+#endif
+  for (; ptr < end; ptr++)
+  {
+    if (*ptr & 0x80)
+      return false;
+  }
+  return true;
+}
+
+/*!
+ \brief Decode UTF-8 straight into wchar_t without going through iconv.
+
+ Runs of ASCII are widened 16 bytes at a time where SSE2 is available. Stops at the first NUL as
+ the iconv based conversion does. Overlong forms, surrogates and code points beyond U+10FFFF are
+ rejected in the same way iconv rejects them, leaving the caller to fall back to iconv.
+ \return false if the input is not valid UTF-8.
+ */
+static bool decodeUtf8ToW(const CStdStringA& utf8String, CStdStringW &wString)
+{
+  const unsigned char *src = (const unsigned char *)utf8String.c_str();
+  const unsigned char *end = src + strlen((const char *)src);
+
+  // each byte produces at most one wchar_t (4 byte sequences produce a surrogate pair on win32)
+  wchar_t *dst = wString.GetBuffer(end - src + 1);
+  wchar_t *start = dst;
+  bool valid = true;
+
+  while (valid && src < end)
+  {
+#ifdef HAS_SSE2_UTF8
+    while (src + 16 <= end)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)src);
+      if (_mm_movemask_epi8(chunk))
+        break;
+      __m128i zero = _mm_setzero_si128();
+      __m128i lo = _mm_unpacklo_epi8(chunk, zero);
+      __m128i hi = _mm_unpackhi_epi8(chunk, zero);
+      if (sizeof(wchar_t) == 2)
+      {
+        _mm_storeu_si128((__m128i *)dst, lo);
+        _mm_storeu_si128((__m128i *)(dst + 8), hi);
+      }
+      else
+      {
+        _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(dst + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i *)(dst + 12), _mm_unpackhi_epi16(hi, zero));
+      }
+      src += 16;
+      dst += 16;
+    }
+    if (src >= end)
+      break;
+#endif
+    unsigned int c = *src++;
+    if (c < 0x80)
+    {
+      *dst++ = (wchar_t)c;
+      continue;
+    }
+
+    unsigned int trailing, min;
+    if ((c & 0xe0) == 0xc0)
+    {
+      c &= 0x1f; trailing = 1; min = 0x80;
+    }
+    else if ((c & 0xf0) == 0xe0)
+    {
+      c &= 0x0f; trailing = 2; min = 0x800;
+    }
+    else if ((c & 0xf8) == 0xf0)
+    {
+      c &= 0x07; trailing = 3; min = 0x10000;
+    }
+    else
+    {
+      valid = false;
+      break;
+    }
+
+    if ((unsigned int)(end - src) < trailing)
+    {
+      valid = false;
+      break;
+    }
+    for (; trailing; trailing--)
+    {
+      if ((*src & 0xc0) != 0x80)
+        break;
+      c = (c << 6) | (*src++ & 0x3f);
+    }
+    if (trailing || c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+    {
+      valid = false;
+      break;
+    }
+
+    if (sizeof(wchar_t) == 2 && c >= 0x10000)
+    {
+      c -= 0x10000;
+      *dst++ = (wchar_t)(0xd800 | (c >> 10));
+      *dst++ = (wchar_t)(0xdc00 | (c & 0x3ff));
+    }
+    else
+      *dst++ = (wchar_t)c;
+  }
+
+  wString.ReleaseBuffer(valid ? dst - start : 0);
+  return valid;
+}
+
 size_t iconv_const (void* cd, const char** inbuf, size_t *inbytesleft,
                     char* * outbuf, size_t *outbytesleft)
 {
@@ -146,6 +374,16 @@ using namespace std;
 
 static void logicalToVisualBiDi(const CStdStringA& strSource, CStdStringA& strDest, FriBidiCharSet fribidiCharset, FriBidiCharType base = FRIBIDI_TYPE_LTR, bool* bWasFlipped =NULL)
 {
+  // a single line of plain ASCII has nothing to reorder or shape, so spare ourselves the lock.
+  // Not so with a right-to-left base, where the neutrals (punctuation, spaces) are still moved
+  if (base != FRIBIDI_TYPE_RTL && strSource.Find('\n') < 0 && isAscii(strSource.c_str(), strSource.size()))
+  {
+    if (bWasFlipped)
+      *bWasFlipped = false;
+    strDest = strSource;
+    return;
+  }
+
   // libfribidi is not threadsafe, so make sure we make it so
   CSingleLock lock(m_critSection);
 
@@ -341,17 +579,8 @@ void CCharsetConverter::reset(void)
 {
   CSingleLock lock(m_critSection);
 
-  ICONV_SAFE_CLOSE(m_iconvStringCharsetToFontCharset);
-  ICONV_SAFE_CLOSE(m_iconvUtf8ToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvStringCharsetToUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUcs2CharsetToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvSubtitleCharsetToW);
-  ICONV_SAFE_CLOSE(m_iconvWtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf16BEtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf16LEtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf32ToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvUtf8toW);
-  ICONV_SAFE_CLOSE(m_iconvUcs2CharsetToUtf8);
+  // converter handles are per thread - have each thread reopen its handles on next use
+  AtomicIncrement(&m_converterGeneration);
 
   m_stringFribidiCharset = FRIBIDI_CHAR_SET_NOT_FOUND;
 
@@ -376,21 +605,32 @@ void CCharsetConverter::utf8ToW(const CStdStringA& utf8String, CStdStringW &wStr
     CStdStringA strFlipped;
     FriBidiCharType charset = forceLTRReadingOrder ? FRIBIDI_TYPE_LTR : FRIBIDI_TYPE_PDF;
     logicalToVisualBiDi(utf8String, strFlipped, FRIBIDI_CHAR_SET_UTF8, charset, bWasFlipped);
-    CSingleLock lock(m_critSection);
-    convert(m_iconvUtf8toW,sizeof(wchar_t),UTF8_SOURCE,WCHAR_CHARSET,strFlipped,wString);
+    utf8ToWInternal(strFlipped, wString);
   }
   else
-  {
-    CSingleLock lock(m_critSection);
-    convert(m_iconvUtf8toW,sizeof(wchar_t),UTF8_SOURCE,WCHAR_CHARSET,utf8String,wString);
-  }
+    utf8ToWInternal(utf8String, wString);
+}
+
+void CCharsetConverter::utf8ToWInternal(const CStdStringA& utf8String, CStdStringW &wString)
+{
+#ifdef __APPLE__
+  // UTF-8-MAC composes decomposed characters, so only plain ASCII can skip iconv
+  if (isAscii(utf8String.c_str(), utf8String.size()) && decodeUtf8ToW(utf8String, wString))
+    return;
+#else
+  if (decodeUtf8ToW(utf8String, wString))
+    return;
+#endif
+
+  CConverterLock converters;
+  convert(converters[Utf8toW],sizeof(wchar_t),UTF8_SOURCE,WCHAR_CHARSET,utf8String,wString);
 }
 
 void CCharsetConverter::subtitleCharsetToW(const CStdStringA& strSource, CStdStringW& strDest)
 {
   // No need to flip hebrew/arabic as mplayer does the flipping
-  CSingleLock lock(m_critSection);
-  convert(m_iconvSubtitleCharsetToW,sizeof(wchar_t),g_langInfo.GetSubtitleCharSet(),WCHAR_CHARSET,strSource,strDest);
+  CConverterLock converters;
+  convert(converters[SubtitleCharsetToW],sizeof(wchar_t),g_langInfo.GetSubtitleCharSet(),WCHAR_CHARSET,strSource,strDest);
 }
 
 void CCharsetConverter::fromW(const CStdStringW& strSource,
@@ -418,8 +658,8 @@ void CCharsetConverter::toW(const CStdStringA& strSource,
 
 void CCharsetConverter::utf8ToStringCharset(const CStdStringA& strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
-  convert(m_iconvUtf8ToStringCharset,1,UTF8_SOURCE,g_langInfo.GetGuiCharSet(),strSource,strDest);
+  CConverterLock converters;
+  convert(converters[Utf8ToStringCharset],1,UTF8_SOURCE,g_langInfo.GetGuiCharSet(),strSource,strDest);
 }
 
 void CCharsetConverter::utf8ToStringCharset(CStdStringA& strSourceDest)
@@ -481,43 +721,57 @@ void CCharsetConverter::unknownToUTF8(const CStdStringA &source, CStdStringA &de
     dest = source;
   else
   {
-    CSingleLock lock(m_critSection);
-    convert(m_iconvStringCharsetToUtf8, UTF8_DEST_MULTIPLIER, g_langInfo.GetGuiCharSet(), "UTF-8//IGNORE", source, dest);
+    CConverterLock converters;
+    convert(converters[StringCharsetToUtf8], UTF8_DEST_MULTIPLIER, g_langInfo.GetGuiCharSet(), "UTF-8//IGNORE", source, dest);
   }
 }
 
 void CCharsetConverter::wToUTF8(const CStdStringW& strSource, CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  convert(m_iconvWtoUtf8,UTF8_DEST_MULTIPLIER,WCHAR_CHARSET,"UTF-8",strSource,strDest);
+  // plain ASCII is the same in UTF-8, so just narrow it
+  size_t length = wcslen(strSource.c_str());
+  size_t i = 0;
+  while (i < length && (unsigned int)strSource[i] < 0x80)
+    i++;
+  if (i == length)
+  {
+    char *dst = strDest.GetBuffer(length + 1);
+    for (i = 0; i < length; i++)
+      dst[i] = (char)strSource[i];
+    strDest.ReleaseBuffer(length);
+    return;
+  }
+
+  CConverterLock converters;
+  convert(converters[WtoUtf8],UTF8_DEST_MULTIPLIER,WCHAR_CHARSET,"UTF-8",strSource,strDest);
 }
 
 void CCharsetConverter::utf16BEtoUTF8(const CStdString16& strSource, CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16BEtoUtf8,UTF8_DEST_MULTIPLIER,"UTF-16BE","UTF-8",strSource,strDest))
+  CConverterLock converters;
+  if(!convert_checked(converters[Utf16BEtoUtf8],UTF8_DEST_MULTIPLIER,"UTF-16BE","UTF-8",strSource,strDest))
     strDest.empty();
 }
 
 void CCharsetConverter::utf16LEtoUTF8(const CStdString16& strSource,
                                       CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16LEtoUtf8,UTF8_DEST_MULTIPLIER,"UTF-16LE","UTF-8",strSource,strDest))
+  CConverterLock converters;
+  if(!convert_checked(converters[Utf16LEtoUtf8],UTF8_DEST_MULTIPLIER,"UTF-16LE","UTF-8",strSource,strDest))
     strDest.empty();
 }
 
 void CCharsetConverter::ucs2ToUTF8(const CStdString16& strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUcs2CharsetToUtf8,UTF8_DEST_MULTIPLIER,"UCS-2LE","UTF-8",strSource,strDest))
+  CConverterLock converters;
+  if(!convert_checked(converters[Ucs2CharsetToUtf8],UTF8_DEST_MULTIPLIER,"UCS-2LE","UTF-8",strSource,strDest))
     strDest.empty();
 }
 
 void CCharsetConverter::utf16LEtoW(const CStdString16& strSource, CStdStringW &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16LEtoW,sizeof(wchar_t),"UTF-16LE",WCHAR_CHARSET,strSource,strDest))
+  CConverterLock converters;
+  if(!convert_checked(converters[Utf16LEtoW],sizeof(wchar_t),"UTF-16LE",WCHAR_CHARSET,strSource,strDest))
     strDest.empty();
 }
 
@@ -538,22 +792,23 @@ void CCharsetConverter::ucs2CharsetToStringCharset(const CStdStringW& strSource,
       s++;
     }
   }
-  CSingleLock lock(m_critSection);
-  convert(m_iconvUcs2CharsetToStringCharset,4,"UTF-16LE",
+  CConverterLock converters;
+  convert(converters[Ucs2CharsetToStringCharset],4,"UTF-16LE",
           g_langInfo.GetGuiCharSet(),strCopy,strDest);
 }
 
 void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
+  CConverterLock converters;
+  iconv_t &iconvUtf32ToStringCharset = converters[Utf32ToStringCharset];
 
-  if (m_iconvUtf32ToStringCharset == (iconv_t) - 1)
+  if (iconvUtf32ToStringCharset == (iconv_t) - 1)
   {
     CStdString strCharset=g_langInfo.GetGuiCharSet();
-    m_iconvUtf32ToStringCharset = iconv_open(strCharset.c_str(), "UTF-32LE");
+    iconvUtf32ToStringCharset = iconv_open(strCharset.c_str(), "UTF-32LE");
   }
 
-  if (m_iconvUtf32ToStringCharset != (iconv_t) - 1)
+  if (iconvUtf32ToStringCharset != (iconv_t) - 1)
   {
     const unsigned long* ptr=strSource;
     while (*ptr) ptr++;
@@ -563,7 +818,7 @@ void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CSt
     char *dst = strDest.GetBuffer(inBytes);
     size_t outBytes = inBytes;
 
-    if (iconv_const(m_iconvUtf32ToStringCharset, &src, &inBytes, &dst, &outBytes) == (size_t)-1)
+    if (iconv_const(iconvUtf32ToStringCharset, &src, &inBytes, &dst, &outBytes) == (size_t)-1)
     {
       CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
       strDest.ReleaseBuffer();
@@ -571,7 +826,7 @@ void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CSt
       return;
     }
 
-    if (iconv(m_iconvUtf32ToStringCharset, NULL, NULL, &dst, &outBytes) == (size_t)-1)
+    if (iconv(iconvUtf32ToStringCharset, NULL, NULL, &dst, &outBytes) == (size_t)-1)
     {
       CLog::Log(LOGERROR, "%s failed cleanup", __FUNCTION__);
       strDest.ReleaseBuffer();
@@ -586,6 +841,9 @@ void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CSt
 // Taken from RFC2640
 bool CCharsetConverter::isValidUtf8(const char *buf, unsigned int len)
 {
+  if (isAscii(buf, len))
+    return true;
+
   const unsigned char *endbuf = (unsigned char*)buf + len;
   unsigned char byte2mask=0x00, c;
   int trailing=0; // trailing (continuation) bytes to follow
@@ -80,6 +80,8 @@ public:
 
   CStdString utf8Left(const CStdStringA &source, int num_chars);
 private:
+  void utf8ToWInternal(const CStdStringA& utf8String, CStdStringW &wString);
+
   CStdString EMPTY;
 };
 
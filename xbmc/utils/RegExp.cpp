@@ -21,15 +21,132 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <map>
 #include "RegExp.h"
 #include "StdString.h"
+#include "CriticalSection.h"
+#include "SingleLock.h"
 #include "log.h"
 
 using namespace PCRE;
+using namespace std;
+
+// JIT compiling needs PCRE 8.20 or later
+#ifdef PCRE_STUDY_JIT_COMPILE
+#define REGEXP_STUDY_JIT PCRE_STUDY_JIT_COMPILE
+#define REGEXP_FREE_STUDY(extra) pcre_free_study(extra)
+#else
+#define REGEXP_STUDY_JIT 0
+#define REGEXP_FREE_STUDY(extra) pcre_free(extra)
+#endif
+
+// the cache is emptied when it reaches this size, which only happens when patterns are
+// built on the fly. Instances keep the code they hold, so this is always safe
+#define MAX_CACHED_PATTERNS 1000
+
+/*!
+ \brief A compiled pattern and its study data, shared by the CRegExp instances using it.
+ The code is never changed once compiled, so it can be matched against from several threads.
+ */
+class CRegExpCode
+{
+public:
+  CRegExpCode(pcre *re, pcre_extra *extra, bool studied)
+  {
+    m_re = re;
+    m_extra = extra;
+    m_studied = studied;
+  }
+  ~CRegExpCode()
+  {
+    if (m_extra)
+      REGEXP_FREE_STUDY(m_extra);
+    pcre_free(m_re);
+  }
+
+  pcre *m_re;
+  pcre_extra *m_extra;
+  bool m_studied;
+};
+
+typedef boost::shared_ptr<CRegExpCode> RegExpCodePtr;
+
+/*!
+ \brief Process-wide cache of compiled patterns.
+ A pattern is compiled plainly the first time it's asked for, as many are only used once.
+ When it's asked for again it is recompiled with study data (and JIT code, where available)
+ and that replaces the cached entry; instances holding the first copy carry on using it.
+ */
+class CRegExpCache
+{
+public:
+  static CRegExpCache &Get()
+  {
+    static CRegExpCache cache;
+    return cache;
+  }
+
+  RegExpCodePtr GetCode(const char *pattern, int options)
+  {
+    Key key(pattern, options);
+    bool study = false;
+    {
+      CSingleLock lock(m_section);
+      map<Key, RegExpCodePtr>::iterator it = m_patterns.find(key);
+      if (it != m_patterns.end())
+      {
+        if (it->second->m_studied)
+          return it->second;
+        study = true;
+      }
+    }
+
+    // compile outside of the lock, so that other threads needn't wait on it
+    RegExpCodePtr code = Compile(pattern, options, study);
+    if (!code)
+      return code;
+
+    CSingleLock lock(m_section);
+    if (m_patterns.size() >= MAX_CACHED_PATTERNS)
+      m_patterns.clear();
+    m_patterns[key] = code;
+    return code;
+  }
+
+private:
+  typedef pair<string, int> Key;
+
+  static RegExpCodePtr Compile(const char *pattern, int options, bool study)
+  {
+    const char *errMsg = NULL;
+    int errOffset      = 0;
+    pcre *re = pcre_compile(pattern, options, &errMsg, &errOffset, NULL);
+    if (!re)
+    {
+      CLog::Log(LOGERROR, "PCRE: %s. Compilation failed at offset %d in expression '%s'",
+                errMsg, errOffset, pattern);
+      return RegExpCodePtr();
+    }
+
+    pcre_extra *extra = NULL;
+    if (study)
+    {
+      // a failed study only loses the speedup, so isn't an error
+      extra = pcre_study(re, REGEXP_STUDY_JIT, &errMsg);
+      if (errMsg)
+        CLog::Log(LOGDEBUG, "PCRE: %s. Study failed for expression '%s'", errMsg, pattern);
+    }
+    return RegExpCodePtr(new CRegExpCode(re, extra, study));
+  }
+
+  CCriticalSection m_section;
+  map<Key, RegExpCodePtr> m_patterns;
+};
 
 CRegExp::CRegExp(bool caseless)
 {
   m_re          = NULL;
+  m_extra       = NULL;
   m_iOptions    = PCRE_DOTALL;
   if(caseless)
     m_iOptions |= PCRE_CASELESS;
@@ -41,29 +158,26 @@ CRegExp::CRegExp(bool caseless)
 CRegExp::CRegExp(const CRegExp& re)
 {
   m_re = NULL;
+  m_extra = NULL;
   m_iOptions = re.m_iOptions;
   *this = re;
 }
 
 const CRegExp& CRegExp::operator=(const CRegExp& re)
 {
-  size_t size;
   Cleanup();
   m_pattern = re.m_pattern;
   if (re.m_re)
   {
-    if (pcre_fullinfo(re.m_re, NULL, PCRE_INFO_SIZE, &size) >= 0)
-    {
-      if ((m_re = (pcre*)malloc(size)))
-      {
-        memcpy(m_re, re.m_re, size);
-        memcpy(m_iOvector, re.m_iOvector, OVECCOUNT*sizeof(int));
-        m_iMatchCount = re.m_iMatchCount;
-        m_bMatched = re.m_bMatched;
-        m_subject = re.m_subject;
-        m_iOptions = re.m_iOptions;
-      }
-    }
+    // the compiled code is shared, not copied
+    m_code = re.m_code;
+    m_re = re.m_re;
+    m_extra = re.m_extra;
+    memcpy(m_iOvector, re.m_iOvector, OVECCOUNT*sizeof(int));
+    m_iMatchCount = re.m_iMatchCount;
+    m_bMatched = re.m_bMatched;
+    m_subject = re.m_subject;
+    m_iOptions = re.m_iOptions;
   }
   return *this;
 }
@@ -73,6 +187,13 @@ CRegExp::~CRegExp()
   Cleanup();
 }
 
+void CRegExp::Cleanup()
+{
+  m_code.reset();
+  m_re = NULL;
+  m_extra = NULL;
+}
+
 CRegExp* CRegExp::RegComp(const char *re)
 {
   if (!re)
@@ -80,19 +201,17 @@ CRegExp* CRegExp::RegComp(const char *re)
 
   m_bMatched         = false;
   m_iMatchCount      = 0;
-  const char *errMsg = NULL;
-  int errOffset      = 0;
 
   Cleanup();
 
-  m_re = pcre_compile(re, m_iOptions, &errMsg, &errOffset, NULL);
-  if (!m_re)
+  m_code = CRegExpCache::Get().GetCode(re, m_iOptions);
+  if (!m_code)
   {
     m_pattern.clear();
-    CLog::Log(LOGERROR, "PCRE: %s. Compilation failed at offset %d in expression '%s'",
-              errMsg, errOffset, re);
     return NULL;
   }
+  m_re = m_code->m_re;
+  m_extra = m_code->m_extra;
 
   m_pattern = re;
 
@@ -117,7 +236,16 @@ int CRegExp::RegFind(const char* str, int startoffset)
   }
 
   m_subject = str;
-  int rc = pcre_exec(m_re, NULL, str, strlen(str), startoffset, 0, m_iOvector, OVECCOUNT);
+  int length = strlen(str);
+  int rc = pcre_exec(m_re, m_extra, str, length, startoffset, 0, m_iOvector, OVECCOUNT);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+  if (rc == PCRE_ERROR_JIT_STACKLIMIT)
+  { // the JIT stack is small, so deeply recursive matches are rerun by the interpreter
+    pcre_extra extra = *m_extra;
+    extra.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+    rc = pcre_exec(m_re, &extra, str, length, startoffset, 0, m_iOvector, OVECCOUNT);
+  }
+#endif
 
   if (rc<1)
   {
@@ -144,7 +272,7 @@ int CRegExp::GetCaptureTotal()
 {
   int c = -1;
   if (m_re)
-    pcre_fullinfo(m_re, NULL, PCRE_INFO_CAPTURECOUNT, &c);
+    pcre_fullinfo(m_re, m_extra, PCRE_INFO_CAPTURECOUNT, &c);
   return c;
 }
 
@@ -25,6 +25,7 @@
 
 #include <string>
 #include <vector>
+#include <boost/shared_ptr.hpp>
 
 namespace PCRE {
 #ifdef _WIN32
@@ -39,6 +40,16 @@ namespace PCRE {
 // OVEVCOUNT must be a multiple of 3
 const int OVECCOUNT=(20+1)*3;
 
+class CRegExpCode;
+
+/*!
+ \brief A PCRE regular expression.
+
+ Compiled patterns are shared by all instances, and between threads: RegComp() takes them from
+ a process-wide cache keyed by the pattern and options, so a pattern is compiled once however
+ many times it is used. Patterns that are used again are also studied and, where PCRE supports
+ it, JIT compiled.
+ */
 class CRegExp
 {
 public:
@@ -69,10 +80,12 @@ public:
   const CRegExp& operator= (const CRegExp& re);
 
 private:
-  void Cleanup() { if (m_re) { PCRE::pcre_free(m_re); m_re = NULL; } }
+  void Cleanup();
 
 private:
-  PCRE::pcre* m_re;
+  boost::shared_ptr<CRegExpCode> m_code;
+  PCRE::pcre* m_re;             ///< compiled pattern, owned by m_code
+  PCRE::pcre_extra* m_extra;    ///< study data, owned by m_code
   int         m_iOvector[OVECCOUNT];
   int         m_iMatchCount;
   int         m_iOptions;
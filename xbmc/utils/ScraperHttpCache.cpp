@@ -0,0 +1,198 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "ScraperHttpCache.h"
+#include "AdvancedSettings.h"
+#include "Crc32.h"
+#include "FileItem.h"
+#include "FileSystem/File.h"
+#include "FileSystem/Directory.h"
+#include "SingleLock.h"
+#include "TimeUtils.h"
+#include "Util.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <time.h>
+
+using namespace XFILE;
+using namespace std;
+
+CScraperHttpCache::CScraperHttpCache()
+{
+  m_hits = 0;
+  m_misses = 0;
+}
+
+CScraperHttpCache &CScraperHttpCache::Get()
+{
+  static CScraperHttpCache cache;
+  return cache;
+}
+
+CStdString CScraperHttpCache::GetKey(const CStdString &context, const CStdString &version, const CStdString &url, bool post)
+{
+  CStdString key;
+  key.Format("%s %s %s %s", context.c_str(), version.c_str(), post ? "POST" : "GET", url.c_str());
+  return key;
+}
+
+bool CScraperHttpCache::IsEnabled() const
+{
+  return g_advancedSettings.m_iScraperCacheTTL > 0 || g_advancedSettings.m_bScraperReplay;
+}
+
+bool CScraperHttpCache::IsReplaying() const
+{
+  return g_advancedSettings.m_bScraperReplay;
+}
+
+CStdString CScraperHttpCache::GetCacheFile(const CStdString &key) const
+{
+  Crc32 crc;
+  crc.Compute(key);
+  CStdString file;
+  file.Format("scrapers/http/%08x.cache", (unsigned int)crc);
+  return CUtil::AddFileToFolder(g_advancedSettings.m_cachePath, file);
+}
+
+bool CScraperHttpCache::Lookup(const CStdString &key, string &page)
+{
+  if (!IsEnabled())
+    return false;
+
+  CStdString strFile = GetCacheFile(key);
+  bool found = false;
+  struct __stat64 st;
+  if (CFile::Stat(strFile, &st) == 0 &&
+     (IsReplaying() || time(NULL) - (time_t)st.st_mtime < (time_t)g_advancedSettings.m_iScraperCacheTTL * 3600))
+  {
+    // the file holds the key, a null, then the page. A key that doesn't
+    // match is another request that hashes the same, and counts as a miss
+    CFile file;
+    if (file.Open(strFile))
+    {
+      int64_t length = file.GetLength();
+      if (length > (int64_t)key.size() && length < 0x7fffffff)
+      {
+        string data;
+        data.resize((size_t)length);
+        if (file.Read(&data[0], length) == length &&
+            data.compare(0, key.size(), key) == 0 && data[key.size()] == '\0')
+        {
+          page.assign(data, key.size() + 1, string::npos);
+          found = true;
+        }
+      }
+      file.Close();
+    }
+  }
+
+  CSingleLock lock(m_section);
+  if (found)
+    m_hits++;
+  else
+    m_misses++;
+  return found;
+}
+
+void CScraperHttpCache::Store(const CStdString &key, const string &page)
+{
+  if (g_advancedSettings.m_iScraperCacheTTL <= 0 || IsReplaying())
+    return;
+
+  // writes are serialized so that threads fetching the same page don't interleave
+  CSingleLock lock(m_section);
+  CStdString strFolder = CUtil::AddFileToFolder(g_advancedSettings.m_cachePath, "scrapers");
+  if (!CDirectory::Exists(strFolder))
+    CDirectory::Create(strFolder);
+  strFolder = CUtil::AddFileToFolder(strFolder, "http");
+  if (!CDirectory::Exists(strFolder))
+    CDirectory::Create(strFolder);
+
+  CFile file;
+  if (file.OpenForWrite(GetCacheFile(key), true))
+  {
+    file.Write(key.c_str(), key.size() + 1);
+    file.Write(page.data(), page.size());
+    file.Close();
+  }
+}
+
+void CScraperHttpCache::Prune()
+{
+  if (IsReplaying())
+    return;
+
+  CStdString strFolder = CUtil::AddFileToFolder(g_advancedSettings.m_cachePath, "scrapers/http/");
+  if (!CDirectory::Exists(strFolder))
+    return;
+
+  CFileItemList items;
+  CDirectory::GetDirectory(strFolder, items, ".cache", false);
+  time_t expiry = time(NULL) - (time_t)max(g_advancedSettings.m_iScraperCacheTTL, 0) * 3600;
+  int deleted = 0;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    struct __stat64 st;
+    if (CFile::Stat(items[i]->m_strPath, &st) == 0 && (time_t)st.st_mtime < expiry)
+    {
+      CFile::Delete(items[i]->m_strPath);
+      deleted++;
+    }
+  }
+  if (deleted)
+    CLog::Log(LOGDEBUG, "%s - deleted %i of %i cached pages", __FUNCTION__, deleted, items.Size());
+}
+
+void CScraperHttpCache::WaitForHost(const CStdString &host)
+{
+  int interval = g_advancedSettings.m_iScraperHostInterval;
+  if (interval <= 0 || host.IsEmpty())
+    return;
+
+  // book the next slot for this host, then sleep until it comes round outside of the lock
+  unsigned int wait = 0;
+  {
+    CSingleLock lock(m_section);
+    unsigned int now = CTimeUtils::GetTimeMS();
+    map<CStdString, unsigned int>::iterator it = m_nextFetch.find(host);
+    if (it != m_nextFetch.end() && (int)(it->second - now) > 0)
+      wait = it->second - now;
+    m_nextFetch[host] = now + wait + interval;
+  }
+  if (wait)
+    Sleep(wait);
+}
+
+void CScraperHttpCache::GetStats(unsigned int &hits, unsigned int &misses) const
+{
+  CSingleLock lock(m_section);
+  hits = m_hits;
+  misses = m_misses;
+}
+
+void CScraperHttpCache::ResetStats()
+{
+  CSingleLock lock(m_section);
+  m_hits = 0;
+  m_misses = 0;
+}
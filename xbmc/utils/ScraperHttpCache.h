@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include "CriticalSection.h"
+
+#include <map>
+#include <string>
+
+/*!
+ \brief On-disk cache of the pages fetched by scrapers, and the rate limit on fetching them.
+
+ Pages are keyed by the scraper, its version and the request (method, url and post data), so
+ that updating a scraper doesn't reuse pages fetched for the old one. They are kept for the
+ number of hours set by <scraper><cachettl> in advancedsettings.xml. It defaults to 0, which
+ turns the cache off, so that refreshing an item always fetches its pages again.
+
+ With <scraper><replay> set, pages are only ever answered from the cache, whatever their age,
+ and nothing is fetched. A scan can then be recorded once and replayed offline, which gives
+ repeatable timings of the scrapers themselves.
+
+ Fetches to the same host are spaced at least <scraper><hostinterval> ms apart, however many
+ threads are scraping.
+ */
+class CScraperHttpCache
+{
+public:
+  static CScraperHttpCache &Get();
+
+  /*! \brief Build the key a request is cached under.
+   \param context the scraper id
+   \param version the scraper version
+   \param url the url, including any options
+   \param post whether the request is a POST
+   */
+  static CStdString GetKey(const CStdString &context, const CStdString &version, const CStdString &url, bool post);
+
+  /*! \brief Whether pages are being cached, or answered from a recorded cache.
+   */
+  bool IsEnabled() const;
+  bool IsReplaying() const;
+
+  /*! \brief Fetch a page from the cache.
+   \param key the key of the request, from GetKey()
+   \param page [out] the page
+   \return true if the page was cached and hasn't expired
+   */
+  bool Lookup(const CStdString &key, std::string &page);
+
+  /*! \brief Store a page in the cache.
+   */
+  void Store(const CStdString &key, const std::string &page);
+
+  /*! \brief Delete cached pages that have expired. Nothing is deleted while replaying.
+   */
+  void Prune();
+
+  /*! \brief Wait until a fetch from the given host is allowed.
+   Threads waiting on the same host are queued up one interval apart.
+   */
+  void WaitForHost(const CStdString &host);
+
+  /*! \brief Number of lookups answered from the cache, and missed, since the last ResetStats().
+   */
+  void GetStats(unsigned int &hits, unsigned int &misses) const;
+  void ResetStats();
+
+private:
+  CScraperHttpCache();
+
+  CStdString GetCacheFile(const CStdString &key) const;
+
+  mutable CCriticalSection m_section;
+  std::map<CStdString, unsigned int> m_nextFetch; ///< host -> earliest time of its next fetch
+  unsigned int m_hits;
+  unsigned int m_misses;
+};
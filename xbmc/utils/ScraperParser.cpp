@@ -27,6 +27,7 @@
 #include "addons/Scraper.h"
 #include "Util.h"
 #include "log.h"
+#include "TimeUtils.h"
 #include "CharsetConverter.h"
 
 #include <sstream>
@@ -381,8 +382,10 @@ const CStdString CScraperParser::Parse(const CStdString& strTag,
   pChildElement->QueryIntAttribute("dest",&iResult);
   TiXmlElement* pChildStart = pChildElement->FirstChildElement("RegExp");
   m_scraper = scraper;
+  unsigned int tick = CTimeUtils::GetTimeMS();
   ParseNext(pChildStart);
   CStdString tmp = m_param[iResult-1];
+  CLog::Log(LOGDEBUG,"%s: %s parsed in %u ms",__FUNCTION__,strTag.c_str(),CTimeUtils::GetTimeMS() - tick);
 
   const char* szClearBuffers = pChildElement->Attribute("clearbuffers");
   if (!szClearBuffers || stricmp(szClearBuffers,"no") != 0)
@@ -29,6 +29,8 @@
 #include "FileSystem/FileZip.h"
 #include "Picture.h"
 #include "Util.h"
+#include "ScraperHttpCache.h"
+#include "utils/log.h"
 
 #include <cstring>
 #include <sstream>
@@ -174,7 +176,7 @@ const CScraperUrl::SUrlEntry CScraperUrl::GetSeasonThumb(int season) const
   return result;
 }
 
-bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CFileCurl& http, const CStdString& cacheContext)
+bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CFileCurl& http, const CStdString& cacheContext, const CStdString& cacheVersion)
 {
   CURL url(scrURL.m_url);
   http.SetReferer(scrURL.m_spoof);
@@ -201,8 +203,19 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CFil
     }
   }
 
+  CScraperHttpCache &httpCache = CScraperHttpCache::Get();
+  CStdString strKey = CScraperHttpCache::GetKey(cacheContext, cacheVersion, scrURL.m_url, scrURL.m_post);
+  if (httpCache.Lookup(strKey, strHTML))
+    return true;
+  if (httpCache.IsReplaying())
+  {
+    CLog::Log(LOGDEBUG, "%s - %s isn't in the replayed cache", __FUNCTION__, scrURL.m_url.c_str());
+    return false;
+  }
+
   CStdString strHTML1(strHTML);
 
+  httpCache.WaitForHost(url.GetHostName());
   if (scrURL.m_post)
   {
     CStdString strOptions = url.GetOptions();
@@ -230,6 +243,8 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CFil
     }
   }
 
+  httpCache.Store(strKey, strHTML);
+
   if (!scrURL.m_cache.IsEmpty())
   {
     CStdString strCachePath;
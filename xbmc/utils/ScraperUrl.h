@@ -73,8 +73,12 @@ public:
    */
   void GetThumbURLs(std::vector<CStdString> &thumbs, int season = -1) const;
   void Clear();
+  /*! \brief fetch a page, from the scraper cache if it holds it
+   \param cacheContext the scraper id, which the cache is kept under
+   \param cacheVersion the scraper version, so that pages fetched for an older version aren't reused
+   */
   static bool Get(const SUrlEntry&, std::string&, XFILE::CFileCurl& http,
-                 const CStdString& cacheContext);
+                 const CStdString& cacheContext, const CStdString& cacheVersion = "");
   static bool DownloadThumbnail(const CStdString &thumb, const SUrlEntry& entry);
 
   CStdString m_xml;
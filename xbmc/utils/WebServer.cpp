@@ -22,6 +22,7 @@
 #include "WebServer.h"
 #ifdef HAS_WEB_SERVER
 #include "../lib/libjsonrpc/JSONRPC.h"
+#include "../lib/libjsonrpc/JSONStreamWriter.h"
 #include "../lib/libhttpapi/HttpApi.h"
 #include "../FileSystem/File.h"
 #include "../FileSystem/Directory.h"
@@ -29,7 +30,15 @@
 #include "log.h"
 #include "SingleLock.h"
 #include "DateTime.h"
+#include "TimeUtils.h"
+#include "Atomics.h"
+#include "../AdvancedSettings.h"
+#include "../FileSystem/SpecialProtocol.h"
+#include "../URL.h"
 #include "addons/AddonManager.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
 
 #ifdef _WIN32
 #pragma comment(lib, "../../lib/libmicrohttpd_win32/lib/libmicrohttpd.dll.lib")
@@ -41,6 +50,19 @@
 #define NOT_SUPPORTED       "<html><head><title>Not Supported</title></head><body>The method you are trying to use is not supported by this server</body></html>"
 #define DEFAULT_PAGE        "index.html"
 
+#define JSONRPC_RESPONSE_BLOCK_SIZE 16384
+#define FILE_RESPONSE_BLOCK_SIZE    65536
+
+// sendfile() backed responses for files on the local filesystem
+#if !defined(_WIN32) && (MHD_VERSION >= 0x00090900)
+#define HAS_WEB_SERVER_SENDFILE
+#endif
+#ifdef MHD_SIZE_UNKNOWN
+#define JSONRPC_RESPONSE_SIZE_UNKNOWN MHD_SIZE_UNKNOWN
+#else
+#define JSONRPC_RESPONSE_SIZE_UNKNOWN -1
+#endif
+
 using namespace ADDON;
 using namespace XFILE;
 using namespace std;
@@ -52,6 +74,7 @@ CWebServer::CWebServer()
   m_daemon = NULL;
   m_needcredentials = true;
   m_Credentials64Encoded = "eGJtYzp4Ym1j"; // xbmc:xbmc
+  m_activeRequests = 0;
 }
 
 int CWebServer::FillArgumentMap(void *cls, enum MHD_ValueKind kind, const char *key, const char *value) 
@@ -116,7 +139,19 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
   CStdString strURL = url;
   CStdString originalURL = url;
   HTTPMethod methodType = GetMethod(method);
-  
+
+  ConnectionContext *context = (ConnectionContext *)(*con_cls);
+  if (context == NULL)
+  {
+    context = new ConnectionContext();
+    context->postStarted = false;
+    context->startTime = CTimeUtils::GetTimeMS();
+    context->responseSize = 0;
+    context->url = originalURL;
+    *con_cls = context;
+    AtomicIncrement(&server->m_activeRequests);
+  }
+
   if (!IsAuthenticated(server, connection)) 
     return AskForAuthentication(connection);
 
@@ -127,7 +162,7 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
   if (strURL.Equals("/jsonrpc"))
   {
     if (methodType == POST)
-      return JSONRPC(server, con_cls, connection, upload_data, upload_data_size);
+      return JSONRPC(server, context, connection, upload_data, upload_data_size);
     else
       return CreateMemoryDownloadResponse(connection, (void *)PAGE_JSONRPC_INFO, strlen(PAGE_JSONRPC_INFO));
   }
@@ -142,7 +177,7 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
   {
     strURL = strURL.Right(strURL.length() - 5);
     CUtil::URLDecode(strURL);
-    return CreateFileDownloadResponse(connection, strURL);
+    return CreateFileDownloadResponse(connection, context, strURL);
   }
 
 #ifdef HAS_WEB_INTERFACE
@@ -160,7 +195,7 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
     else
       return CreateRedirect(connection, originalURL += "/");
   }
-  return CreateFileDownloadResponse(connection, strURL);
+  return CreateFileDownloadResponse(connection, context, strURL);
 
 #endif
 
@@ -180,46 +215,47 @@ CWebServer::HTTPMethod CWebServer::GetMethod(const char *method)
 }
 
 #if (MHD_VERSION >= 0x00040001)
-int CWebServer::JSONRPC(CWebServer *server, void **con_cls, struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size)
+int CWebServer::JSONRPC(CWebServer *server, ConnectionContext *context, struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size)
 #else
-int CWebServer::JSONRPC(CWebServer *server, void **con_cls, struct MHD_Connection *connection, const char *upload_data, unsigned int *upload_data_size)
+int CWebServer::JSONRPC(CWebServer *server, ConnectionContext *context, struct MHD_Connection *connection, const char *upload_data, unsigned int *upload_data_size)
 #endif
 {
 #ifdef HAS_JSONRPC
-  if ((*con_cls) == NULL)
+  if (!context->postStarted)
   {
-    *con_cls = new CStdString();
+    context->postStarted = true;
 
     return MHD_YES;
   }
   if (*upload_data_size) 
   {
-    CStdString *post = (CStdString *)(*con_cls);
-    if (*upload_data_size + post->size() > MAX_STRING_POST_SIZE)
+    if (*upload_data_size + context->postData.size() > MAX_STRING_POST_SIZE)
     {
       CLog::Log(LOGERROR, "WebServer: Stopped uploading post since it exceeded size limitations");
       return MHD_NO;
     }
     else
     {
-      post->append(upload_data, *upload_data_size);
+      context->postData.append(upload_data, *upload_data_size);
       *upload_data_size = 0;
       return MHD_YES;
     }
   }
   else
   {
-    CStdString *jsoncall = (CStdString *)(*con_cls);
-
     CHTTPClient client;
-    CStdString jsonresponse = CJSONRPC::MethodCall(*jsoncall, server, &client);
-
-    struct MHD_Response *response = MHD_create_response_from_data(jsonresponse.length(), (void *) jsonresponse.c_str(), MHD_NO, MHD_YES);
+    CJSONStreamWriter *writer = CJSONRPC::StreamMethodCall(context->postData, server, &client);
+    context->postData.clear();
+
+    // the response is serialized as MHD asks for it, and sent chunked
+    struct MHD_Response *response = MHD_create_response_from_callback(JSONRPC_RESPONSE_SIZE_UNKNOWN,
+                                                                      JSONRPC_RESPONSE_BLOCK_SIZE,
+                                                                      &CWebServer::JSONRPCReaderCallback, writer,
+                                                                      &CWebServer::JSONRPCReaderFreeCallback);
     int ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
     MHD_add_response_header(response, "Content-Type", "application/json");
     MHD_destroy_response(response);
 
-    delete jsoncall;
     return ret;
   }
 #else
@@ -254,18 +290,128 @@ int CWebServer::CreateRedirect(struct MHD_Connection *connection, const CStdStri
   return ret;
 }
 
-int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, const CStdString &strURL)
+int CWebServer::GetRequestedRange(struct MHD_Connection *connection, uint64_t size, uint64_t &start, uint64_t &end)
+{
+  start = 0;
+  end = size ? size - 1 : 0;
+
+  // we don't hand out validators, so any conditional range gets the full entity
+  const char *range = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Range");
+  if (range == NULL || size == 0 || MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "If-Range") != NULL)
+    return MHD_HTTP_OK;
+
+  CStdString value = range;
+  value.Trim();
+  if (!value.Left(6).Equals("bytes="))
+    return MHD_HTTP_OK;
+  value = value.Mid(6);
+  value.Trim();
+
+  // multiple ranges would need a multipart/byteranges body, just send everything
+  if (value.Find(',') >= 0)
+    return MHD_HTTP_OK;
+
+  int dash = value.Find('-');
+  if (dash < 0)
+    return MHD_HTTP_OK;
+
+  CStdString first = value.Left(dash);
+  CStdString last = value.Mid(dash + 1);
+  first.Trim();
+  last.Trim();
+  if (first.IsEmpty() && last.IsEmpty())
+    return MHD_HTTP_OK;
+  if (first.find_first_not_of("0123456789") != CStdString::npos ||
+      last.find_first_not_of("0123456789") != CStdString::npos)
+    return MHD_HTTP_OK;
+
+  if (first.IsEmpty())
+  { // suffix range, the last n bytes
+    uint64_t suffix = strtoull(last.c_str(), NULL, 10);
+    if (suffix == 0)
+      return MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE;
+    start = suffix < size ? size - suffix : 0;
+    return MHD_HTTP_PARTIAL_CONTENT;
+  }
+
+  start = strtoull(first.c_str(), NULL, 10);
+  if (start >= size)
+    return MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE;
+  if (!last.IsEmpty())
+  {
+    uint64_t requestedEnd = strtoull(last.c_str(), NULL, 10);
+    if (requestedEnd < start)
+      return MHD_HTTP_OK;
+    if (requestedEnd < end)
+      end = requestedEnd;
+  }
+  return MHD_HTTP_PARTIAL_CONTENT;
+}
+
+struct MHD_Response *CWebServer::CreateLocalFileResponse(const CStdString &strURL, uint64_t start, uint64_t length)
+{
+#ifdef HAS_WEB_SERVER_SENDFILE
+  CStdString path = CSpecialProtocol::TranslatePath(strURL);
+  CURL url(path);
+  if (!url.IsLocal())
+    return NULL;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  // MHD owns the descriptor from here on and sends it with sendfile() where it can
+  struct MHD_Response *response = MHD_create_response_from_fd_at_offset(length, fd, start);
+  if (response == NULL)
+    close(fd);
+  return response;
+#else
+  return NULL;
+#endif
+}
+
+int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, ConnectionContext *context, const CStdString &strURL)
 {
   int ret = MHD_NO;
   CFile *file = new CFile();
 
   if (file->Open(strURL, READ_NO_CACHE))
   {
-    struct MHD_Response *response;
-    response = MHD_create_response_from_callback ( file->GetLength(),
-                                                   2048,
-                                                   &CWebServer::ContentReaderCallback, file,
-                                                   &CWebServer::ContentReaderFreeCallback); 
+    uint64_t size = file->GetLength();
+    uint64_t start, end;
+    int status = GetRequestedRange(connection, size, start, end);
+    if (status == MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE)
+    {
+      file->Close();
+      delete file;
+
+      CStdString contentRange;
+      contentRange.Format("bytes */%"PRIu64, size);
+      struct MHD_Response *response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
+      MHD_add_response_header(response, "Content-Range", contentRange.c_str());
+      ret = MHD_queue_response(connection, status, response);
+      MHD_destroy_response(response);
+      return ret;
+    }
+
+    uint64_t length = size ? end - start + 1 : 0;
+    struct MHD_Response *response = CreateLocalFileResponse(strURL, start, length);
+    if (response)
+    {
+      file->Close();
+      delete file;
+    }
+    else
+    {
+      FileReader *reader = new FileReader;
+      reader->file = file;
+      reader->start = start;
+      reader->length = length;
+      response = MHD_create_response_from_callback ( length,
+                                                     FILE_RESPONSE_BLOCK_SIZE,
+                                                     &CWebServer::ContentReaderCallback, reader,
+                                                     &CWebServer::ContentReaderFreeCallback); 
+    }
 
     CStdString ext = CUtil::GetExtension(strURL);
     ext = ext.ToLower();
@@ -276,8 +422,17 @@ int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, co
     CDateTime expiryTime = CDateTime::GetCurrentDateTime();
     expiryTime += CDateTimeSpan(1, 0, 0, 0);
     MHD_add_response_header(response, "Expires", expiryTime.GetAsRFC1123DateTime());
+    MHD_add_response_header(response, "Accept-Ranges", "bytes");
+
+    if (status == MHD_HTTP_PARTIAL_CONTENT)
+    {
+      CStdString contentRange;
+      contentRange.Format("bytes %"PRIu64"-%"PRIu64"/%"PRIu64, start, end, size);
+      MHD_add_response_header(response, "Content-Range", contentRange.c_str());
+    }
 
-    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    context->responseSize = length;
+    ret = MHD_queue_response(connection, status, response);
 
     MHD_destroy_response(response);
   }
@@ -333,9 +488,15 @@ int CWebServer::ContentReaderCallback(void *cls, uint64_t pos, char *buf, int ma
 int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 #endif
 {
-  CFile *file = (CFile *)cls;
-  if((unsigned int)pos != file->GetPosition())
-    file->Seek(pos);
+  FileReader *reader = (FileReader *)cls;
+  if (pos >= reader->length)
+    return -1;
+  if ((uint64_t)max > reader->length - pos)
+    max = reader->length - pos;
+
+  CFile *file = reader->file;
+  if ((int64_t)(reader->start + pos) != file->GetPosition())
+    file->Seek(reader->start + pos);
   unsigned res = file->Read(buf, max);
   if(res == 0)
     return -1;
@@ -344,10 +505,57 @@ int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 
 void CWebServer::ContentReaderFreeCallback(void *cls)
 {
-  CFile *file = (CFile *)cls;
-  file->Close();
+  FileReader *reader = (FileReader *)cls;
+  reader->file->Close();
 
-  delete file;
+  delete reader->file;
+  delete reader;
+}
+
+void CWebServer::RequestCompleted(void *cls, struct MHD_Connection *connection, void **con_cls, enum MHD_RequestTerminationCode toe)
+{
+  CWebServer *server = (CWebServer *)cls;
+  ConnectionContext *context = (ConnectionContext *)(*con_cls);
+  if (context == NULL)
+    return;
+
+  long active = AtomicDecrement(&server->m_activeRequests);
+  if (context->responseSize > 0)
+  {
+    unsigned int elapsed = CTimeUtils::GetTimeMS() - context->startTime;
+    CLog::Log(LOGDEBUG, "WebServer: %s %s, %"PRIu64" bytes in %u ms (%.1f KiB/s), %ld requests active",
+              context->url.c_str(), toe == MHD_REQUEST_TERMINATED_COMPLETED_OK ? "completed" : "aborted",
+              context->responseSize, elapsed, elapsed ? context->responseSize * 1000.0 / 1024.0 / elapsed : 0.0, active);
+  }
+
+  delete context;
+  *con_cls = NULL;
+}
+
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::JSONRPCReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::JSONRPCReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::JSONRPCReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+#ifdef HAS_JSONRPC
+  CJSONStreamWriter *writer = (CJSONStreamWriter *)cls;
+  unsigned int res = writer->Read(buf, max);
+  if (res == 0)
+    return -1;
+  return res;
+#else
+  return -1;
+#endif
+}
+
+void CWebServer::JSONRPCReaderFreeCallback(void *cls)
+{
+#ifdef HAS_JSONRPC
+  delete (CJSONStreamWriter *)cls;
+#endif
 }
 
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
@@ -358,6 +566,8 @@ struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
   unsigned int timeout = 60 * 60 * 24;
   // MHD_USE_THREAD_PER_CONNECTION = one thread per connection
   // MHD_USE_SELECT_INTERNALLY = use main thread for each connection, can only handle one request at a time [unless you set the thread pool size]
+  // with a thread pool each worker runs its own select loop over its share of the (keep-alive) connections
+  unsigned int poolSize = g_advancedSettings.m_webserverThreadPoolSize;
 
   return MHD_start_daemon(flags,
                           port,
@@ -366,8 +576,9 @@ struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
                           &CWebServer::AnswerToConnection,
                           this,
 #if (MHD_VERSION >= 0x00040002)
-                          MHD_OPTION_THREAD_POOL_SIZE, 1,
+                          MHD_OPTION_THREAD_POOL_SIZE, poolSize,
 #endif
+                          MHD_OPTION_NOTIFY_COMPLETED, &CWebServer::RequestCompleted, this,
                           MHD_OPTION_CONNECTION_LIMIT, 512,
                           MHD_OPTION_CONNECTION_TIMEOUT, timeout,
                           MHD_OPTION_END);
@@ -382,7 +593,7 @@ bool CWebServer::Start(int port, const CStdString &username, const CStdString &p
 
     m_running = m_daemon != NULL;
     if (m_running)
-      CLog::Log(LOGNOTICE, "WebServer: Started the webserver");
+      CLog::Log(LOGNOTICE, "WebServer: Started the webserver with %d worker threads", g_advancedSettings.m_webserverThreadPoolSize);
     else
       CLog::Log(LOGERROR, "WebServer: Failed to start the webserver");
   }
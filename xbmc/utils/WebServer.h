@@ -42,6 +42,11 @@
 #include "../lib/libjsonrpc/ITransportLayer.h"
 #include "CriticalSection.h"
 
+namespace XFILE
+{
+  class CFile;
+}
+
 class CWebServer : public JSONRPC::ITransportLayer
 {
 public:
@@ -61,6 +66,27 @@ private:
     GET,
     HEAD
   };
+  /*! \brief Per request state, handed to MHD as the connection's con_cls
+   Created on the first call of AnswerToConnection for a request and freed in RequestCompleted.
+   */
+  struct ConnectionContext
+  {
+    CStdString postData;       ///< accumulated POST body (jsonrpc)
+    bool       postStarted;    ///< true once the POST header has been acknowledged
+    unsigned int startTime;    ///< time the request arrived, in ms
+    uint64_t   responseSize;   ///< number of body bytes queued for the response
+    CStdString url;
+  };
+
+  /*! \brief Range of a file being streamed through ContentReaderCallback
+   */
+  struct FileReader
+  {
+    XFILE::CFile *file;
+    uint64_t      start;       ///< offset in the file of the first byte of the response
+    uint64_t      length;      ///< number of bytes in the response
+  };
+
   struct MHD_Daemon* StartMHD(unsigned int flags, int port);
   static int AskForAuthentication (struct MHD_Connection *connection);
   static bool IsAuthenticated (CWebServer *server, struct MHD_Connection *connection);
@@ -73,24 +99,36 @@ private:
   static int ContentReaderCallback (void *cls, size_t pos, char *buf, int max);
 #endif
 
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t JSONRPCReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int JSONRPCReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int JSONRPCReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
+
 #if (MHD_VERSION >= 0x00040001)
-  static int JSONRPC(CWebServer *server, void **con_cls, struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size);
+  static int JSONRPC(CWebServer *server, ConnectionContext *context, struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size);
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
                         const char *version, const char *upload_data,
                         size_t *upload_data_size, void **con_cls);
 #else   //libmicrohttpd < 0.4.0
-  static int JSONRPC(CWebServer *server, void **con_cls, struct MHD_Connection *connection, const char *upload_data, unsigned int *upload_data_size);
+  static int JSONRPC(CWebServer *server, ConnectionContext *context, struct MHD_Connection *connection, const char *upload_data, unsigned int *upload_data_size);
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
                         const char *version, const char *upload_data,
                         unsigned int *upload_data_size, void **con_cls);
 #endif
   static void ContentReaderFreeCallback (void *cls);
+  static void RequestCompleted (void *cls, struct MHD_Connection *connection, void **con_cls, enum MHD_RequestTerminationCode toe);
+  static void JSONRPCReaderFreeCallback (void *cls);
   static int HttpApi(struct MHD_Connection *connection);
   static HTTPMethod GetMethod(const char *method);
   static int CreateRedirect(struct MHD_Connection *connection, const CStdString &strURL);
-  static int CreateFileDownloadResponse(struct MHD_Connection *connection, const CStdString &strURL);
+  static int CreateFileDownloadResponse(struct MHD_Connection *connection, ConnectionContext *context, const CStdString &strURL);
+  static int GetRequestedRange(struct MHD_Connection *connection, uint64_t size, uint64_t &start, uint64_t &end);
+  static struct MHD_Response *CreateLocalFileResponse(const CStdString &strURL, uint64_t start, uint64_t length);
   static int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method);
   static int CreateMemoryDownloadResponse(struct MHD_Connection *connection, void *data, size_t size);
 
@@ -103,6 +141,7 @@ private:
   bool m_running, m_needcredentials;
   CStdString m_Credentials64Encoded;
   CCriticalSection m_critSection;
+  long m_activeRequests;
 
   class CHTTPClient : public JSONRPC::IClient
   {
@@ -0,0 +1,184 @@
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "WeightedSampler.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+
+// picks that land in the history are retried this many times before
+// accepting a repeat, which only happens with very skewed weights
+#define MAX_PICK_ATTEMPTS 32
+
+CWeightedSampler::CWeightedSampler()
+{
+  m_historySize = 0;
+}
+
+void CWeightedSampler::Set(const vector<Item> &items, const vector<float> &weights)
+{
+  m_items = items;
+  m_weights = weights;
+  BuildTable();
+}
+
+void CWeightedSampler::BuildTable()
+{
+  m_probability.clear();
+  m_alias.clear();
+
+  unsigned int size = m_items.size();
+  if (!size || m_weights.size() != size)
+    return; // uniform
+
+  // Vose's alias method: scale the weights so they average 1, then pair each
+  // index below 1 with one above it, which makes up the rest of its column
+  double total = 0;
+  for (unsigned int i = 0; i < size; i++)
+    total += max(m_weights[i], 0.0f);
+  if (total <= 0)
+    return;
+
+  vector<double> scaled(size);
+  vector<unsigned int> small, large;
+  for (unsigned int i = 0; i < size; i++)
+  {
+    scaled[i] = max(m_weights[i], 0.0f) * size / total;
+    if (scaled[i] < 1.0)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+
+  m_probability.resize(size, 1.0f);
+  m_alias.resize(size);
+  for (unsigned int i = 0; i < size; i++)
+    m_alias[i] = i;
+
+  while (!small.empty() && !large.empty())
+  {
+    unsigned int less = small.back(); small.pop_back();
+    unsigned int more = large.back(); large.pop_back();
+    m_probability[less] = (float)scaled[less];
+    m_alias[less] = more;
+    scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+    if (scaled[more] < 1.0)
+      small.push_back(more);
+    else
+      large.push_back(more);
+  }
+  // whatever is left over is 1 up to rounding errors
+}
+
+bool CWeightedSampler::Remove(const Item &item)
+{
+  vector<Item>::iterator it = find(m_items.begin(), m_items.end(), item);
+  if (it == m_items.end())
+    return false;
+
+  if (m_weights.size() == m_items.size())
+    m_weights.erase(m_weights.begin() + (it - m_items.begin()));
+  m_items.erase(it);
+  BuildTable();
+
+  if (m_inHistory.erase(item))
+    m_history.erase(find(m_history.begin(), m_history.end(), item));
+  return true;
+}
+
+void CWeightedSampler::Clear()
+{
+  m_items.clear();
+  m_weights.clear();
+  m_probability.clear();
+  m_alias.clear();
+  ClearHistory();
+}
+
+void CWeightedSampler::SetHistorySize(unsigned int size)
+{
+  m_historySize = size;
+  while (m_history.size() > m_historySize)
+  {
+    m_inHistory.erase(m_history.front());
+    m_history.pop_front();
+  }
+}
+
+bool CWeightedSampler::Pick(Item &item)
+{
+  if (m_items.empty())
+    return false;
+
+  unsigned int index = PickIndex();
+  for (int attempt = 1; attempt < MAX_PICK_ATTEMPTS && m_inHistory.find(m_items[index]) != m_inHistory.end(); attempt++)
+    index = PickIndex();
+
+  item = m_items[index];
+  AddToHistory(item);
+  return true;
+}
+
+void CWeightedSampler::AddToHistory(const Item &item)
+{
+  // never remember more than half the items, or picks would run out of candidates
+  unsigned int historySize = min(m_historySize, (unsigned int)m_items.size() / 2);
+  if (!historySize)
+    return;
+
+  if (m_inHistory.find(item) != m_inHistory.end())
+    return;
+  while (m_history.size() >= historySize)
+  {
+    m_inHistory.erase(m_history.front());
+    m_history.pop_front();
+  }
+  m_history.push_back(item);
+  m_inHistory.insert(item);
+}
+
+void CWeightedSampler::ClearHistory()
+{
+  m_history.clear();
+  m_inHistory.clear();
+}
+
+unsigned int CWeightedSampler::PickIndex() const
+{
+  unsigned int index = RandomIndex(m_items.size());
+  if (!m_probability.empty() && RandomFraction() >= m_probability[index])
+    index = m_alias[index];
+  return index;
+}
+
+unsigned int CWeightedSampler::RandomIndex(unsigned int size)
+{
+  // RAND_MAX may be as low as 32767, so combine two calls for large libraries
+  unsigned int random = ((unsigned int)(rand() & 0x7fff) << 15) | (unsigned int)(rand() & 0x7fff);
+  return random % size;
+}
+
+float CWeightedSampler::RandomFraction()
+{
+  return (float)(rand() & 0x7fff) / 32768.0f;
+}
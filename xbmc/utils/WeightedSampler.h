@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+/*!
+ \brief Random picks from a fixed set of ids, in constant time.
+
+ The ids are held as (type, id) pairs, as used by party mode. Each id can be given a weight,
+ and is then picked with a probability proportional to it, using an alias table. Recently
+ picked ids are kept in a history window and are not picked again until they drop out of it.
+ */
+class CWeightedSampler
+{
+public:
+  typedef std::pair<int, int> Item;
+
+  CWeightedSampler();
+
+  /*! \brief Replace the ids to pick from. The history is kept.
+   \param items the ids
+   \param weights the weight of each id, or empty to pick them all with the same probability
+   */
+  void Set(const std::vector<Item> &items, const std::vector<float> &weights);
+  void Clear();
+
+  /*! \brief Stop picking an id, such as one that has gone from the library since the ids were set.
+   Rebuilds the alias table, so this is linear in the number of ids.
+   \return false if the id wasn't there
+   */
+  bool Remove(const Item &item);
+
+  unsigned int Size() const { return m_items.size(); };
+
+  /*! \brief Set the number of picks that are remembered, and so not repeated.
+   The window is limited to half of the ids, so that picks don't run out of candidates.
+   */
+  void SetHistorySize(unsigned int size);
+
+  /*! \brief Pick an id which isn't in the history, and add it to the history.
+   \return false if there are no ids to pick from
+   */
+  bool Pick(Item &item);
+
+  /*! \brief Add an id picked by other means to the history.
+   */
+  void AddToHistory(const Item &item);
+  void ClearHistory();
+
+private:
+  void BuildTable();
+  unsigned int PickIndex() const;
+  static unsigned int RandomIndex(unsigned int size);
+  static float RandomFraction();
+
+  std::vector<Item> m_items;
+  std::vector<float> m_weights;       ///< as given to Set(), for rebuilding the table on Remove()
+  std::vector<float> m_probability;   ///< alias table: probability of keeping the index picked
+  std::vector<unsigned int> m_alias;  ///< alias table: index to use otherwise
+
+  unsigned int m_historySize;
+  std::deque<Item> m_history;
+  std::set<Item> m_inHistory;
+};
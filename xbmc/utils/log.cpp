@@ -31,6 +31,7 @@
 #include "Settings.h"
 #include "AdvancedSettings.h"
 #include "Thread.h"
+#include "Atomics.h"
 
 FILE*       CLog::m_file            = NULL;
 int         CLog::m_repeatCount     = 0;
@@ -38,6 +39,8 @@ int         CLog::m_repeatLogLevel  = -1;
 CStdString* CLog::m_repeatLine      = NULL;
 
 static CCriticalSection critSec;
+static CStdString*      logPath     = NULL;
+static int64_t          logFileSize = 0;
 
 static char levelNames[][8] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
@@ -48,6 +51,218 @@ static char levelNames[][8] =
 #define LINE_ENDING "\n"
 #endif
 
+// size of the buffer on the logging thread's stack that messages are formatted into
+#define LOG_FORMAT_BUFFER 4096
+
+/*!
+ \brief A log line on its way from the logging thread to the log writer thread
+ */
+struct LogRecord
+{
+  SYSTEMTIME time;
+  uint64_t   threadId;
+  int        level;
+  CStdString data;
+};
+
+/*!
+ \brief Bounded multiple-producer, single-consumer ring of log records
+
+ Each slot carries a sequence number telling producers and the consumer whose turn it is, so
+ pushing a record only costs a compare-and-swap on the write position. When the ring is full
+ the record is dropped rather than blocking the caller.
+ */
+class CLogRing
+{
+public:
+  CLogRing(unsigned int size)
+  {
+    // round up to a power of 2 so positions can be masked
+    unsigned int slots = 2;
+    while (slots < size)
+      slots <<= 1;
+    m_cells = new Cell[slots];
+    m_mask = slots - 1;
+    for (unsigned int i = 0; i < slots; i++)
+      m_cells[i].sequence = i;
+    m_enqueuePos = 0;
+    m_dequeuePos = 0;
+    m_dropped = 0;
+  }
+
+  ~CLogRing()
+  {
+    delete[] m_cells;
+  }
+
+  bool Push(LogRecord &record)
+  {
+    long pos = m_enqueuePos;
+    Cell *cell;
+    while (true)
+    {
+      cell = &m_cells[pos & m_mask];
+      long diff = cell->sequence - pos;
+      if (diff == 0)
+      { // slot is free - try and claim it
+        long prev = cas(&m_enqueuePos, pos, pos + 1);
+        if (prev == pos)
+          break;
+        pos = prev;
+      }
+      else if (diff < 0)
+      { // ring is full
+        AtomicIncrement(&m_dropped);
+        return false;
+      }
+      else
+        pos = m_enqueuePos;
+    }
+    cell->record.time     = record.time;
+    cell->record.threadId = record.threadId;
+    cell->record.level    = record.level;
+    cell->record.data.swap(record.data);
+    // publish the slot to the writer (cas doubles as the memory barrier)
+    cas(&cell->sequence, pos, pos + 1);
+    return true;
+  }
+
+  // only ever called from the writer thread
+  bool Pop(LogRecord &record)
+  {
+    Cell *cell = &m_cells[m_dequeuePos & m_mask];
+    long seq = cas(&cell->sequence, m_dequeuePos + 1, m_dequeuePos + 1);
+    if (seq - (m_dequeuePos + 1) < 0)
+      return false; // empty
+
+    record.time     = cell->record.time;
+    record.threadId = cell->record.threadId;
+    record.level    = cell->record.level;
+    record.data.swap(cell->record.data);
+    cell->record.data.clear();
+    // hand the slot back to the producers
+    cas(&cell->sequence, m_dequeuePos + 1, m_dequeuePos + m_mask + 1);
+    m_dequeuePos++;
+    return true;
+  }
+
+  long TakeDropped()
+  {
+    long dropped = m_dropped;
+    while (dropped)
+    {
+      long prev = cas(&m_dropped, dropped, 0);
+      if (prev == dropped)
+        break;
+      dropped = prev;
+    }
+    return dropped;
+  }
+
+  long GetDropped() const { return m_dropped; }
+
+private:
+  struct Cell
+  {
+    volatile long sequence;
+    LogRecord     record;
+  };
+  Cell          *m_cells;
+  long           m_mask;
+  volatile long  m_enqueuePos;
+  long           m_dequeuePos;
+  volatile long  m_dropped;
+};
+
+/*!
+ \brief Background thread that drains the log ring and writes it out in batches
+ */
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter(unsigned int ringSize) : m_ring(ringSize)
+  {
+    m_wakeEvent = CreateEvent(NULL, false, false, NULL);
+  }
+
+  virtual ~CLogWriter()
+  {
+    StopThread();
+    CloseHandle(m_wakeEvent);
+  }
+
+  bool Push(LogRecord &record)
+  {
+    if (!m_ring.Push(record))
+      return false;
+    // errors should hit the disc right away in case we're about to go down
+    if (record.level >= LOGERROR)
+      SetEvent(m_wakeEvent);
+    return true;
+  }
+
+  long GetDropped() const { return m_ring.GetDropped(); }
+
+  void Flush()
+  {
+    CSingleLock waitLock(critSec);
+    if (!CLog::m_file)
+      return;
+
+    MEMORYSTATUS stat;
+    GlobalMemoryStatus(&stat);
+
+    LogRecord record;
+    bool written = false;
+    CStdString strHeader;
+    while (m_ring.Pop(record))
+    {
+      strHeader.Format("%02.2d:%02.2d:%02.2d T:%"PRIu64" M:%9"PRIu64" ", record.time.wHour, record.time.wMinute, record.time.wSecond, record.threadId, (uint64_t)stat.dwAvailPhys);
+      CLog::WriteLogString(record.level, strHeader, record.data);
+      written = true;
+    }
+
+    long dropped = m_ring.TakeDropped();
+    if (dropped)
+    {
+      SYSTEMTIME time;
+      GetLocalTime(&time);
+      strHeader.Format("%02.2d:%02.2d:%02.2d T:%"PRIu64" M:%9"PRIu64" ", time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), (uint64_t)stat.dwAvailPhys);
+      CStdString strData;
+      strData.Format("Log ring full - dropped %ld lines", dropped);
+      CLog::WriteLogString(LOGWARNING, strHeader, strData);
+      written = true;
+    }
+
+    if (written)
+    {
+      fflush(CLog::m_file);
+      CLog::CheckRotate();
+    }
+  }
+
+protected:
+  virtual void Process()
+  {
+    SetName("LogWriter");
+    while (!m_bStop)
+    {
+      WaitForSingleObject(m_wakeEvent, 100);
+      Flush();
+    }
+    Flush();
+  }
+
+private:
+  CLogRing m_ring;
+  HANDLE   m_wakeEvent;
+};
+
+static CLogWriter* logWriter = NULL;
+// callers between reading logWriter and finishing their push, so Close() knows when it can delete it
+static volatile long logWriterUsers = 0;
+// set once Close() has started, after which lines are written directly rather than through a writer
+static bool logClosing = false;
 
 CLog::CLog()
 {}
@@ -57,6 +272,19 @@ CLog::~CLog()
 
 void CLog::Close()
 {
+  CLogWriter *writer = NULL;
+  { CSingleLock waitLock(critSec);
+    logClosing = true;
+    writer = logWriter;
+    logWriter = NULL;
+  }
+  // wait for anyone still pushing to the writer, then stop it, which flushes
+  // anything still in the ring. Lines logged meanwhile, such as the writer
+  // thread's own exit, go straight to the file as logClosing is set
+  while (logWriterUsers > 0)
+    Sleep(1);
+  delete writer;
+
   CSingleLock waitLock(critSec);
   if (m_file)
   {
@@ -65,14 +293,141 @@ void CLog::Close()
   }
   delete m_repeatLine;
   m_repeatLine = NULL;
+  delete logPath;
+  logPath = NULL;
+}
+
+long CLog::GetDroppedCount()
+{
+  CSingleLock waitLock(critSec);
+  return logWriter ? logWriter->GetDropped() : 0;
+}
+
+void CLog::WriteLogString(int loglevel, const CStdString &strHeader, CStdString &strData)
+{
+  if (m_repeatLogLevel == loglevel && *m_repeatLine == strData)
+  {
+    m_repeatCount++;
+    return;
+  }
+  else if (m_repeatCount)
+  {
+    CStdString strPrefix2, strData2;
+    strPrefix2.Format("%s%7s: ", strHeader.c_str(), levelNames[m_repeatLogLevel]);
+
+    strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
+    fwrite(strPrefix2.c_str(),strPrefix2.size(),1,m_file);
+    fwrite(strData2.c_str(),strData2.size(),1,m_file);
+    logFileSize += strPrefix2.size() + strData2.size();
+#if !defined(_LINUX) && (defined(_DEBUG) || defined(PROFILE))
+    OutputDebugString(strData2.c_str());
+#endif
+    m_repeatCount = 0;
+  }
+
+  *m_repeatLine     = strData;
+  m_repeatLogLevel  = loglevel;
+
+  unsigned int length = 0;
+  while ( length != strData.length() )
+  {
+    length = strData.length();
+    strData.TrimRight(" ");
+    strData.TrimRight('\n');
+    strData.TrimRight("\r");
+  }
+
+  if (!length)
+    return;
+
+#if !defined(_LINUX) && (defined(_DEBUG) || defined(PROFILE))
+  OutputDebugString(strData.c_str());
+  OutputDebugString("\n");
+#endif
+
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  strData.Replace("\n", LINE_ENDING"                                            ");
+  strData += LINE_ENDING;
+
+  CStdString strPrefix;
+  strPrefix.Format("%s%7s: ", strHeader.c_str(), levelNames[loglevel]);
+
+  fwrite(strPrefix.c_str(),strPrefix.size(),1,m_file);
+  fwrite(strData.c_str(),strData.size(),1,m_file);
+  logFileSize += strPrefix.size() + strData.size();
 }
 
+void CLog::CheckRotate()
+{
+  // must be called with critSec held
+  if (g_advancedSettings.m_logMaxSize <= 0 || !m_file || !logPath)
+    return;
+
+  if (logFileSize < (int64_t)g_advancedSettings.m_logMaxSize * 1024 * 1024)
+    return;
+
+  // start over: xbmc.log becomes xbmc.old.log, and a fresh xbmc.log is opened
+  fclose(m_file);
+  m_file = NULL;
+  OpenLogFile();
+}
 
 void CLog::Log(int loglevel, const char *format, ... )
 {
   if (g_advancedSettings.m_logLevel > LOG_LEVEL_NORMAL ||
      (g_advancedSettings.m_logLevel > LOG_LEVEL_NONE && loglevel >= LOGNOTICE))
   {
+    if (g_advancedSettings.m_logAsync)
+    {
+      // count ourselves in before reading the writer, so Close() waits for our push
+      AtomicIncrement(&logWriterUsers);
+      CLogWriter *writer = logWriter;
+      if (!writer)
+      {
+        CSingleLock waitLock(critSec);
+        if (!m_file)
+        {
+          AtomicDecrement(&logWriterUsers);
+          return;
+        }
+        // once closing, lines are written directly below rather than starting a new writer
+        if (!logWriter && !logClosing)
+        {
+          logWriter = new CLogWriter(g_advancedSettings.m_logRingSize);
+          logWriter->Create();
+        }
+        writer = logWriter;
+      }
+
+      if (writer)
+      {
+        // format on our own stack, then hand the line over to the writer thread
+        LogRecord record;
+        GetLocalTime(&record.time);
+        record.threadId = (uint64_t)CThread::GetCurrentThreadId();
+        record.level    = loglevel;
+
+        char buffer[LOG_FORMAT_BUFFER];
+        va_list va;
+        va_start(va, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, va);
+        va_end(va);
+        if (length >= 0 && length < (int)sizeof(buffer))
+          record.data.assign(buffer, length);
+        else
+        { // too long for the stack buffer
+          va_start(va, format);
+          record.data.FormatV(format, va);
+          va_end(va);
+        }
+
+        writer->Push(record);
+        AtomicDecrement(&logWriterUsers);
+        return;
+      }
+      AtomicDecrement(&logWriterUsers);
+    }
+
     CSingleLock waitLock(critSec);
     if (!m_file)
       return;
@@ -83,9 +438,9 @@ void CLog::Log(int loglevel, const char *format, ... )
     MEMORYSTATUS stat;
     GlobalMemoryStatus(&stat);
 
-    CStdString strPrefix, strData;
+    CStdString strHeader, strData;
 
-    strPrefix.Format("%02.2d:%02.2d:%02.2d T:%"PRIu64" M:%9"PRIu64" %7s: ", time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), (uint64_t)stat.dwAvailPhys, levelNames[loglevel]);
+    strHeader.Format("%02.2d:%02.2d:%02.2d T:%"PRIu64" M:%9"PRIu64" ", time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), (uint64_t)stat.dwAvailPhys);
 
     strData.reserve(16384);
     va_list va;
@@ -93,52 +448,9 @@ void CLog::Log(int loglevel, const char *format, ... )
     strData.FormatV(format,va);
     va_end(va);
 
-    if (m_repeatLogLevel == loglevel && *m_repeatLine == strData)
-    {
-      m_repeatCount++;
-      return;
-    }
-    else if (m_repeatCount)
-    {
-      CStdString strPrefix2, strData2;
-      strPrefix2.Format("%02.2d:%02.2d:%02.2d T:%"PRIu64" M:%9"PRIu64" %7s: ", time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), (uint64_t)stat.dwAvailPhys, levelNames[m_repeatLogLevel]);
-
-      strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
-      fwrite(strPrefix2.c_str(),strPrefix2.size(),1,m_file);
-      fwrite(strData2.c_str(),strData2.size(),1,m_file);
-#if !defined(_LINUX) && (defined(_DEBUG) || defined(PROFILE))
-      OutputDebugString(strData2.c_str());
-#endif
-      m_repeatCount = 0;
-    }
-    
-    *m_repeatLine     = strData;
-    m_repeatLogLevel  = loglevel;
-
-    unsigned int length = 0;
-    while ( length != strData.length() )
-    {
-      length = strData.length();
-      strData.TrimRight(" ");
-      strData.TrimRight('\n');
-      strData.TrimRight("\r");
-    }
-
-    if (!length)
-      return;
-
-#if !defined(_LINUX) && (defined(_DEBUG) || defined(PROFILE))
-    OutputDebugString(strData.c_str());
-    OutputDebugString("\n");
-#endif
-
-    /* fixup newline alignment, number of spaces should equal prefix length */
-    strData.Replace("\n", LINE_ENDING"                                            ");
-    strData += LINE_ENDING;
-
-    fwrite(strPrefix.c_str(),strPrefix.size(),1,m_file);
-    fwrite(strData.c_str(),strData.size(),1,m_file);
+    WriteLogString(loglevel, strHeader, strData);
     fflush(m_file);
+    CheckRotate();
   }
 #ifndef _LINUX
 #if defined(_DEBUG) || defined(PROFILE)
@@ -168,46 +480,58 @@ bool CLog::Init(const char* path)
   CSingleLock waitLock(critSec);
   if (!m_file)
   {
-    // g_settings.m_logFolder is initialized in the CSettings constructor
-    // and changed in CApplication::Create()
-#ifdef _WIN32
-    CStdStringW pathW;
-    g_charsetConverter.utf8ToW(path, pathW, false);
-    CStdStringW strLogFile, strLogFileOld;
+    if (!logPath)
+      logPath = new CStdString;
+    *logPath = path;
+    OpenLogFile();
+    logClosing = false;
+  }
 
-    strLogFile.Format(L"%sxbmc.log", pathW);
-    strLogFileOld.Format(L"%sxbmc.old.log", pathW);
+  if (!m_repeatLine)
+    m_repeatLine = new CStdString;
 
-    struct __stat64 info;
-    if (_wstat64(strLogFileOld.c_str(),&info) == 0 &&
-        !::DeleteFileW(strLogFileOld.c_str()))
-      return false;
-    if (_wstat64(strLogFile.c_str(),&info) == 0 &&
-        !::MoveFileW(strLogFile.c_str(),strLogFileOld.c_str()))
-      return false;
+  return m_file != NULL;
+}
 
-    m_file = _wfsopen(strLogFile.c_str(),L"wb", _SH_DENYWR);
+bool CLog::OpenLogFile()
+{
+  // must be called with critSec held
+  // g_settings.m_logFolder is initialized in the CSettings constructor
+  // and changed in CApplication::Create()
+#ifdef _WIN32
+  CStdStringW pathW;
+  g_charsetConverter.utf8ToW(*logPath, pathW, false);
+  CStdStringW strLogFile, strLogFileOld;
+
+  strLogFile.Format(L"%sxbmc.log", pathW);
+  strLogFileOld.Format(L"%sxbmc.old.log", pathW);
+
+  struct __stat64 info;
+  if (_wstat64(strLogFileOld.c_str(),&info) == 0 &&
+      !::DeleteFileW(strLogFileOld.c_str()))
+    return false;
+  if (_wstat64(strLogFile.c_str(),&info) == 0 &&
+      !::MoveFileW(strLogFile.c_str(),strLogFileOld.c_str()))
+    return false;
+
+  m_file = _wfsopen(strLogFile.c_str(),L"wb", _SH_DENYWR);
 #else
-    CStdString strLogFile, strLogFileOld;
+  CStdString strLogFile, strLogFileOld;
 
-    strLogFile.Format("%sxbmc.log", path);
-    strLogFileOld.Format("%sxbmc.old.log", path);
+  strLogFile.Format("%sxbmc.log", logPath->c_str());
+  strLogFileOld.Format("%sxbmc.old.log", logPath->c_str());
 
-    struct stat64 info;
-    if (stat64(strLogFileOld.c_str(),&info) == 0 &&
-        remove(strLogFileOld.c_str()) != 0)
-      return false;
-    if (stat64(strLogFile.c_str(),&info) == 0 &&
-        rename(strLogFile.c_str(),strLogFileOld.c_str()) != 0)
-      return false;
+  struct stat64 info;
+  if (stat64(strLogFileOld.c_str(),&info) == 0 &&
+      remove(strLogFileOld.c_str()) != 0)
+    return false;
+  if (stat64(strLogFile.c_str(),&info) == 0 &&
+      rename(strLogFile.c_str(),strLogFileOld.c_str()) != 0)
+    return false;
 
-    m_file = fopen(strLogFile.c_str(),"wb");
+  m_file = fopen(strLogFile.c_str(),"wb");
 #endif
-  }
-
-  if (!m_repeatLine)
-    m_repeatLine = new CStdString;
-
+  logFileSize = 0;
   return m_file != NULL;
 }
 
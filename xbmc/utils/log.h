@@ -47,17 +47,30 @@
 #define ATTRIB_LOG_FORMAT
 #endif
 
+class CLogWriter;
+
 class CLog
 {
+  friend class CLogWriter;
+
   static FILE*       m_file;
   static int         m_repeatCount;
   static int         m_repeatLogLevel;
   static CStdString* m_repeatLine;
+
+  static void WriteLogString(int loglevel, const CStdString &strHeader, CStdString &strData);
+  static void CheckRotate();
+  static bool OpenLogFile();
 public:
   CLog();
   virtual ~CLog(void);
   static void Close();
   static void Log(int loglevel, const char *format, ... ) ATTRIB_LOG_FORMAT;
+
+  /*! \brief Number of log lines dropped because the asynchronous log ring was full
+   \sa CAdvancedSettings::m_logAsync
+   */
+  static long GetDroppedCount();
   static void DebugLog(const char *format, ...);
   static void MemDump(char *pData, int length);
   static void DebugLogMemory();